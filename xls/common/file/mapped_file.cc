@@ -0,0 +1,114 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+
+#include "xls/common/file/file_descriptor.h"
+#include "xls/common/status/error_code_to_status.h"
+
+namespace xls {
+namespace {
+
+absl::Status ErrNoToStatusWithFilename(int errno_value,
+                                       const std::filesystem::path& file_name) {
+  xabsl::StatusBuilder builder = ErrnoToStatus(errno_value);
+  builder << file_name.string();
+  return std::move(builder);
+}
+
+}  // namespace
+
+xabsl::StatusOr<MappedFile> MappedFile::Open(
+    const std::filesystem::path& file_name) {
+  FileDescriptor fd(open(file_name.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  struct stat st;
+  if (fstat(fd.get(), &st) != 0) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    // Pipes and character devices can't be mapped, and they and /proc files
+    // report a size of zero regardless of their contents, so read them to the
+    // end. This also covers genuinely empty files, which can't be mapped.
+    std::string buffer;
+    char chunk[64 * 1024];
+    while (true) {
+      ssize_t bytes_read = read(fd.get(), chunk, sizeof(chunk));
+      if (bytes_read == 0) {
+        break;
+      }
+      if (bytes_read < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return ErrNoToStatusWithFilename(errno, file_name);
+      }
+      buffer.append(chunk, bytes_read);
+    }
+    return MappedFile(std::move(buffer));
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (data == MAP_FAILED) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  // The advice is only a hint, so failure is not an error.
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  // The mapping stays valid after the file descriptor is closed.
+  return MappedFile(data, st.st_size);
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(other.data_),
+      size_(other.size_),
+      buffer_(std::move(other.buffer_)) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.buffer_.clear();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    Unmap();
+    data_ = other.data_;
+    size_ = other.size_;
+    buffer_ = std::move(other.buffer_);
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.buffer_.clear();
+  }
+  return *this;
+}
+
+void MappedFile::Unmap() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace xls
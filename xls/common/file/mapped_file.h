@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_FILE_MAPPED_FILE_H_
+#define XLS_COMMON_FILE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "xls/common/status/statusor.h"
+
+namespace xls {
+
+// A file mapped read-only into memory, which is unmapped when the object goes
+// out of scope. Unlike GetFileContents, the file is not copied: pages are read
+// in by the kernel as the contents are accessed, so a large file can be
+// scanned front to back without holding a copy of it in the heap.
+//
+// Only regular files of known size can be mapped. Anything else, such as a
+// pipe, /dev/stdin or a /proc file, reports a size of zero, so it is read into
+// a buffer instead.
+//
+// Example usage:
+//
+//   XLS_ASSIGN_OR_RETURN(MappedFile file, MappedFile::Open(path));
+//   XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(file.contents()));
+class MappedFile {
+ public:
+  // Maps the file at "file_name", or reads it if it can't be mapped.
+  // The mapping is advised for sequential access.
+  static xabsl::StatusOr<MappedFile> Open(
+      const std::filesystem::path& file_name);
+
+  ~MappedFile();
+
+  // MappedFile is movable but not copyable.
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Returns the contents of the file, which are valid for the lifetime of this
+  // object.
+  absl::string_view contents() const {
+    if (data_ == nullptr) {
+      return buffer_;
+    }
+    return absl::string_view(static_cast<const char*>(data_), size_);
+  }
+
+ private:
+  MappedFile(void* data, size_t size) : data_(data), size_(size) {}
+  explicit MappedFile(std::string buffer) : buffer_(std::move(buffer)) {}
+  void Unmap();
+
+  // Null for a file which was read into buffer_ rather than mapped.
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  std::string buffer_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_FILE_MAPPED_FILE_H_
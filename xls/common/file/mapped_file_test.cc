@@ -0,0 +1,86 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(MappedFileTest, ContentsMatchFile) {
+  std::string content = "package p\n\nfn f() -> bits[1] {\n}\n";
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent(content));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  EXPECT_EQ(file.contents(), content);
+}
+
+TEST(MappedFileTest, EmptyFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file, TempFile::CreateWithContent(""));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  EXPECT_TRUE(file.contents().empty());
+}
+
+TEST(MappedFileTest, MoveTransfersMapping) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent("abc"));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  MappedFile moved = std::move(file);
+  EXPECT_EQ(moved.contents(), "abc");
+  EXPECT_TRUE(file.contents().empty());  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(MappedFileTest, ReadsPipe) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  std::string content = "package p\n";
+  ASSERT_EQ(write(fds[1], content.data(), content.size()), content.size());
+  close(fds[1]);
+  // Pipes report a size of zero, but are still read in full.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      MappedFile file,
+      MappedFile::Open(absl::StrCat("/proc/self/fd/", fds[0])));
+  close(fds[0]);
+  EXPECT_EQ(file.contents(), content);
+  MappedFile moved = std::move(file);
+  EXPECT_EQ(moved.contents(), content);
+}
+
+TEST(MappedFileTest, ReadsProcFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file,
+                           MappedFile::Open("/proc/self/status"));
+  EXPECT_THAT(file.contents(), HasSubstr("Name:"));
+}
+
+TEST(MappedFileTest, NonexistentFile) {
+  EXPECT_THAT(MappedFile::Open("/nonexistent_path___/file").status(),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("nonexistent_path___")));
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,7 +14,9 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <algorithm>
 #include <limits>
+#include <utility>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
@@ -26,52 +28,106 @@
 
 namespace xls {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
-  // Leaf node 0.
-  nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
-                           /*m=*/0));
-  // Leaf node 1.
+namespace {
+
+// Returns the sum of the given minterm counts, saturating at INT32_MAX.
+int32 AddMinterms(int64 a, int64 b) {
+  return std::min(a + b, static_cast<int64>(std::numeric_limits<int32>::max()));
+}
+
+// The initial number of entries in the if-then-else cache.
+constexpr int64 kInitialIteCacheSize = 1024;
+
+}  // namespace
+
+BinaryDecisionDiagram::BinaryDecisionDiagram(int64 max_ite_cache_size) {
+  XLS_CHECK_GT(max_ite_cache_size, 0);
+  // Round down to a power of two so the cache can be indexed by masking.
+  max_ite_cache_size_ = 1;
+  while (max_ite_cache_size_ * 2 <= max_ite_cache_size) {
+    max_ite_cache_size_ *= 2;
+  }
+  ite_cache_.resize(std::min(kInitialIteCacheSize, max_ite_cache_size_));
+
+  // The leaf node one (and, complemented, zero).
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
-                           /*m=*/1));
+                           /*m=*/1, /*cm=*/0));
+  peak_size_ = size();
 }
 
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
                                                     BddNodeIndex high,
                                                     BddNodeIndex low) {
+  if (low == high) {
+    return low;
+  }
+  // The high child is never complemented. Instead, create the node for the
+  // inverse expression and return the complemented edge to it.
+  bool complemented = IsComplemented(high);
+  if (complemented) {
+    high = Complement(high);
+    low = Complement(low);
+  }
   NodeKey key = std::make_tuple(var, high, low);
   auto it = node_map_.find(key);
   if (it != node_map_.end()) {
-    return it->second;
+    return complemented ? Complement(it->second) : it->second;
   }
-  if (low == high) {
-    return low;
+  // Compute the number of minterms that the new node (and its inverse) will
+  // have. Use int64s to avoid overflowing and saturate at INT32_MAX.
+  BddNode node(var, high, low,
+               AddMinterms(minterm_count(high), minterm_count(low)),
+               AddMinterms(minterm_count(Complement(high)),
+                           minterm_count(Complement(low))));
+  int32 node_id;
+  if (free_nodes_.empty()) {
+    node_id = nodes_.size();
+    nodes_.push_back(node);
+  } else {
+    node_id = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node_id] = node;
   }
-  // Compute the number of minterms that the new node will have. Use int64s to
-  // avoid overflowing and saturate at INT32_MAX.
-  int32 minterms =
-      std::min(static_cast<int64>(GetNode(low).minterm_count) +
-                   GetNode(high).minterm_count,
-               static_cast<int64>(std::numeric_limits<int32>::max()));
-  nodes_.emplace_back(var, high, low, minterms);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+  BddNodeIndex node_index = BddNodeIndex(node_id << 1);
   node_map_[key] = node_index;
-  return node_index;
+  peak_size_ = std::max(peak_size_, size());
+  MaybeGrowIteCache();
+  return complemented ? Complement(node_index) : node_index;
 }
 
 BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
-                                             bool value) {
-  if (expr == zero() || expr == one()) {
+                                             bool value) const {
+  if (Regular(expr) == one()) {
     return expr;
   }
 
   const BddNode& node = GetNode(expr);
   XLS_CHECK_LE(var, node.variable);
   if (node.variable == var) {
-    return value ? node.high : node.low;
+    BddNodeIndex child = value ? node.high : node.low;
+    return IsComplemented(expr) ? Complement(child) : child;
   }
   return expr;
 }
 
+BinaryDecisionDiagram::IteCacheEntry& BinaryDecisionDiagram::GetIteCacheEntry(
+    BddNodeIndex cond, BddNodeIndex if_true, BddNodeIndex if_false) {
+  uint64 hash = static_cast<uint32>(cond.value()) * 0x9e3779b97f4a7c15ULL;
+  hash = (hash ^ static_cast<uint32>(if_true.value())) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ static_cast<uint32>(if_false.value())) * 0x94d049bb133111ebULL;
+  return ite_cache_[(hash >> 32) & (ite_cache_.size() - 1)];
+}
+
+void BinaryDecisionDiagram::MaybeGrowIteCache() {
+  if (ite_cache_.size() >= max_ite_cache_size_ ||
+      ite_cache_.size() >= size()) {
+    return;
+  }
+  // The cache is lossy, so its contents can simply be dropped.
+  int64 new_size = std::min<int64>(2 * ite_cache_.size(), max_ite_cache_size_);
+  ite_cache_.assign(new_size, IteCacheEntry());
+}
+
 BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                                BddNodeIndex if_true,
                                                BddNodeIndex if_false) {
@@ -81,32 +137,62 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   if (cond == zero()) {
     return if_false;
   }
-  if (if_true == one() && if_false == zero()) {
-    return cond;
+  // Within each branch the value of the condition is known.
+  if (if_true == cond) {
+    if_true = one();
+  } else if (if_true == Complement(cond)) {
+    if_true = zero();
+  }
+  if (if_false == cond) {
+    if_false = zero();
+  } else if (if_false == Complement(cond)) {
+    if_false = one();
   }
   if (if_true == if_false) {
     return if_true;
   }
-  auto key = std::make_tuple(cond, if_true, if_false);
-  auto it = ite_map_.find(key);
-  if (it != ite_map_.end()) {
-    return it->second;
+  if (if_true == one() && if_false == zero()) {
+    return cond;
+  }
+  if (if_true == zero() && if_false == one()) {
+    return Complement(cond);
   }
 
-  // The expression is non-trivial and has not been computed before. Recursively
-  // decompose the expression by peeling away the first variable and performing
-  // a Shannon decomposition.
+  // Rewrite the expression into a canonical form so equivalent expressions
+  // share a cache entry. And(a, b) and Or(a, b) are commutative, the condition
+  // is made uncomplemented by swapping the branches, and the if-true branch is
+  // made uncomplemented by complementing both branches and the result.
+  if (if_false == zero() && if_true < cond) {
+    std::swap(cond, if_true);
+  } else if (if_true == one() && if_false < cond) {
+    std::swap(cond, if_false);
+  }
+  if (IsComplemented(cond)) {
+    cond = Complement(cond);
+    std::swap(if_true, if_false);
+  }
+  bool complement_result = IsComplemented(if_true);
+  if (complement_result) {
+    if_true = Complement(if_true);
+    if_false = Complement(if_false);
+  }
+
+  ++ite_cache_lookups_;
+  const IteCacheEntry& entry = GetIteCacheEntry(cond, if_true, if_false);
+  if (entry.cond == cond && entry.if_true == if_true &&
+      entry.if_false == if_false) {
+    ++ite_cache_hits_;
+    return complement_result ? Complement(entry.result) : entry.result;
+  }
+
+  // The expression is non-trivial and has not been computed before (or has
+  // been evicted from the cache). Recursively decompose the expression by
+  // peeling away the first variable and performing a Shannon decomposition.
 
   // First, find the lowest-index variable amongst all expressions. In all paths
   // through the BDD the variable indices are strictly increasing.
-  BddVariable min_var = GetNode(cond).variable;
-  // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
-  }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
-  }
+  BddVariable min_var = std::min(
+      {TopVariable(cond), TopVariable(if_true), TopVariable(if_false)});
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
   // the identity:
@@ -119,24 +205,24 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   BddNodeIndex false_cofactor = IfThenElse(Restrict(cond, min_var, false),
                                            Restrict(if_true, min_var, false),
                                            Restrict(if_false, min_var, false));
-
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
   BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
-  ite_map_[key] = expr;
-  return expr;
+
+  // The recursive calls may have overwritten or resized the cache, so look up
+  // the entry again.
+  IteCacheEntry& new_entry = GetIteCacheEntry(cond, if_true, if_false);
+  new_entry.cond = cond;
+  new_entry.if_true = if_true;
+  new_entry.if_false = if_false;
+  new_entry.result = expr;
+  return complement_result ? Complement(expr) : expr;
 }
 
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
-  return GetOrCreateNode(var, one(), zero());
-}
-
-BddNodeIndex BinaryDecisionDiagram::Not(BddNodeIndex expr) {
-  return IfThenElse(expr, zero(), one());
+  BddNodeIndex node = GetOrCreateNode(var, one(), zero());
+  variable_base_nodes_.push_back(node);
+  return node;
 }
 
 BddNodeIndex BinaryDecisionDiagram::Or(BddNodeIndex a, BddNodeIndex b) {
@@ -147,6 +233,62 @@ BddNodeIndex BinaryDecisionDiagram::And(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, b, zero());
 }
 
+void BinaryDecisionDiagram::GarbageCollect(
+    absl::Span<const BddNodeIndex> roots) {
+  // Mark every node reachable from the roots and variables. Nodes which are
+  // already free are marked too so they aren't freed twice.
+  std::vector<bool> marked(nodes_.size(), false);
+  for (int32 node_id : free_nodes_) {
+    marked[node_id] = true;
+  }
+  marked[0] = true;
+  std::vector<int32> worklist;
+  auto mark = [&](BddNodeIndex expr) {
+    int32 node_id = expr.value() >> 1;
+    if (!marked[node_id]) {
+      marked[node_id] = true;
+      worklist.push_back(node_id);
+    }
+  };
+  for (BddNodeIndex root : roots) {
+    mark(root);
+  }
+  for (BddNodeIndex base_node : variable_base_nodes_) {
+    mark(base_node);
+  }
+  while (!worklist.empty()) {
+    const BddNode& node = nodes_[worklist.back()];
+    worklist.pop_back();
+    mark(node.high);
+    mark(node.low);
+  }
+
+  // Sweep.
+  for (int32 node_id = 1; node_id < nodes_.size(); ++node_id) {
+    if (!marked[node_id]) {
+      const BddNode& node = nodes_[node_id];
+      node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+      nodes_[node_id] = BddNode();
+      free_nodes_.push_back(node_id);
+    }
+  }
+  // Cached results may refer to freed nodes.
+  ite_cache_.assign(ite_cache_.size(), IteCacheEntry());
+  ++garbage_collection_count_;
+  XLS_VLOG(2) << absl::StreamFormat(
+      "BDD garbage collection: %d live nodes, %d free", size(),
+      free_nodes_.size());
+}
+
+int64 BinaryDecisionDiagram::MemoryUsage() const {
+  return nodes_.capacity() * sizeof(BddNode) +
+         free_nodes_.capacity() * sizeof(int32) +
+         variable_base_nodes_.capacity() * sizeof(BddNodeIndex) +
+         node_map_.bucket_count() *
+             (sizeof(std::pair<const NodeKey, BddNodeIndex>) + 1) +
+         ite_cache_.capacity() * sizeof(IteCacheEntry);
+}
+
 xabsl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
     BddNodeIndex expr,
     const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const {
@@ -165,15 +307,16 @@ xabsl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
                   << variable_values.at(node);
     }
   }
-  while (result != zero() && result != one()) {
-    BddNodeIndex var_node = GetVariableBaseNode(GetNode(result).variable);
+  while (Regular(result) != one()) {
+    const BddNode& node = GetNode(result);
+    BddNodeIndex var_node = GetVariableBaseNode(node.variable);
     if (!variable_values.contains(var_node)) {
       return absl::InvalidArgumentError(
           absl::StrFormat("Missing value for BDD variable %d (node index %d)",
-                          GetNode(result).variable.value(), var_node.value()));
+                          node.variable.value(), var_node.value()));
     }
-    result = variable_values.at(var_node) ? GetNode(result).high
-                                          : GetNode(result).low;
+    BddNodeIndex child = variable_values.at(var_node) ? node.high : node.low;
+    result = IsComplemented(result) ? Complement(child) : child;
   }
   XLS_VLOG(2) << "  result = " << (result == one() ? true : false);
   return result == one();
@@ -205,10 +348,12 @@ void BinaryDecisionDiagram::ToStringDnfHelper(BddNodeIndex expr,
   }
 
   const BddNode& node = GetNode(expr);
+  BddNodeIndex high = IsComplemented(expr) ? Complement(node.high) : node.high;
+  BddNodeIndex low = IsComplemented(expr) ? Complement(node.low) : node.low;
   terms->push_back(absl::StrCat("x", node.variable.value()));
-  ToStringDnfHelper(node.high, minterms_to_emit, terms, str);
+  ToStringDnfHelper(high, minterms_to_emit, terms, str);
   terms->back() = absl::StrCat("!x", node.variable.value());
-  ToStringDnfHelper(node.low, minterms_to_emit, terms, str);
+  ToStringDnfHelper(low, minterms_to_emit, terms, str);
   terms->pop_back();
 }
 
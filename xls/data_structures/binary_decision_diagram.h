@@ -15,7 +15,13 @@
 #ifndef XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 #define XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "xls/common/integral_types.h"
 #include "xls/common/status/statusor.h"
 #include "xls/common/strong_int.h"
@@ -30,9 +36,19 @@ namespace xls {
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+// As in that paper, edges may be complemented: an expression and its inverse
+// share the same nodes, so Not() is constant-time and allocates nothing. There
+// is a single leaf node (one); zero is the complemented edge to it. To keep
+// the representation canonical the high child of a node is never a
+// complemented edge. The if-then-else computed table is a fixed-size, lossy
+// cache, and nodes no longer reachable from any expression of interest can be
+// reclaimed with GarbageCollect().
 
 // For efficiency variables and nodes are referred to by indices into vector
-// data members in the BDD.
+// data members in the BDD. A BddNodeIndex is an edge in the BDD: the index of
+// the node shifted left by one, with the low bit set if the edge is
+// complemented.
 DEFINE_STRONG_INT_TYPE(BddVariable, int32);
 DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32);
 
@@ -40,9 +56,18 @@ DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32);
 // children corresponding to when the variable is true (high) and when it is
 // false (low).
 struct BddNode {
-  BddNode() : variable(0), high(0), low(0), minterm_count(0) {}
-  BddNode(BddVariable v, BddNodeIndex h, BddNodeIndex l, int32 m)
-      : variable(v), high(h), low(l), minterm_count(m) {}
+  BddNode()
+      : variable(0),
+        high(0),
+        low(0),
+        minterm_count(0),
+        complement_minterm_count(0) {}
+  BddNode(BddVariable v, BddNodeIndex h, BddNodeIndex l, int32 m, int32 cm)
+      : variable(v),
+        high(h),
+        low(l),
+        minterm_count(m),
+        complement_minterm_count(cm) {}
 
   BddVariable variable;
   BddNodeIndex high;
@@ -52,28 +77,37 @@ struct BddNode {
   // sum-of-products form of the boolean function, or equivalently a path to the
   // leaf node '1' from the BDD node. Saturates at INT32_MAX.
   int32 minterm_count;
+  // Number of minterms in the inverse of the expression (paths to '0').
+  // Saturates at INT32_MAX.
+  int32 complement_minterm_count;
 };
 
 class BinaryDecisionDiagram {
  public:
-  // Creates an empty BDD. Initialize the BDD contains only the nodes
-  // corresponding to zero and one.
-  BinaryDecisionDiagram();
+  // The default maximum number of entries in the if-then-else computed table.
+  static constexpr int64 kDefaultMaxIteCacheSize = 1 << 20;
+
+  // Creates an empty BDD. Initially the BDD contains only the leaf node,
+  // corresponding to one (and, complemented, to zero). The if-then-else cache
+  // grows with the number of nodes up to 'max_ite_cache_size' entries, beyond
+  // which older results are overwritten.
+  explicit BinaryDecisionDiagram(
+      int64 max_ite_cache_size = kDefaultMaxIteCacheSize);
 
   // Adds a new variable to the BDD and returns the node corresponding the
   // variable's value.
   BddNodeIndex NewVariable();
 
   // Returns the inverse of the given expression.
-  BddNodeIndex Not(BddNodeIndex expr);
+  BddNodeIndex Not(BddNodeIndex expr) { return Complement(expr); }
 
   // Returns the OR/AND of the given expressions.
   BddNodeIndex And(BddNodeIndex a, BddNodeIndex b);
   BddNodeIndex Or(BddNodeIndex a, BddNodeIndex b);
 
   // Returns the leaf node corresponding to zero or one.
-  BddNodeIndex zero() const { return BddNodeIndex(0); }
-  BddNodeIndex one() const { return BddNodeIndex(1); }
+  BddNodeIndex zero() const { return BddNodeIndex(1); }
+  BddNodeIndex one() const { return BddNodeIndex(0); }
 
   // Evaluates the given expression with the given variable values. The keys in
   // the map are the *node* indices of the respective variable (value returned
@@ -83,20 +117,26 @@ class BinaryDecisionDiagram {
       BddNodeIndex expr,
       const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const;
 
-  // Returns the BDD node with the given index.
+  // Returns the BDD node the given expression refers to. If the expression is
+  // complemented, the node (and so its children) is that of the expression's
+  // inverse.
   const BddNode& GetNode(BddNodeIndex node_index) const {
-    return nodes_.at(node_index.value());
+    return nodes_.at(node_index.value() >> 1);
   }
 
-  // Returns the number of nodes in the graph.
-  int64 size() const { return nodes_.size(); }
+  // Returns the number of (live) nodes in the graph.
+  int64 size() const { return nodes_.size() - free_nodes_.size(); }
+
+  // Returns the largest number of nodes the graph has held at once.
+  int64 peak_size() const { return peak_size_; }
 
   // Returns the number of variables in the graph.
   int64 variable_count() const { return next_var_.value(); }
 
   // Returns the number of minterms in the given expression.
   int64 minterm_count(BddNodeIndex expr) const {
-    return GetNode(expr).minterm_count;
+    return IsComplemented(expr) ? GetNode(expr).complement_minterm_count
+                                : GetNode(expr).minterm_count;
   }
 
   // Returns the given expression in disjunctive normal form (sum of products).
@@ -108,10 +148,50 @@ class BinaryDecisionDiagram {
   // variable. The expression of a base node is exactly equal to the value of
   // the variable.
   bool IsVariableBaseNode(BddNodeIndex expr) const {
-    return GetNode(expr).high == one() && GetNode(expr).low == zero();
+    return !IsComplemented(expr) && GetNode(expr).high == one() &&
+           GetNode(expr).low == zero();
   }
 
+  // Frees every node which is not reachable from 'roots' (or from the base
+  // node of a variable) for reuse by later operations, and empties the
+  // if-then-else cache. Expressions not reachable from 'roots' are invalid
+  // afterwards; all others are unchanged.
+  void GarbageCollect(absl::Span<const BddNodeIndex> roots);
+
+  // Statistics about the BDD, e.g., for tuning.
+  int64 garbage_collection_count() const { return garbage_collection_count_; }
+  int64 ite_cache_lookups() const { return ite_cache_lookups_; }
+  int64 ite_cache_hits() const { return ite_cache_hits_; }
+
+  // Returns an estimate of the number of bytes of memory held by the BDD.
+  int64 MemoryUsage() const;
+
  private:
+  // An entry in the if-then-else computed table. Empty entries have a
+  // condition of one, which never needs to be cached.
+  struct IteCacheEntry {
+    BddNodeIndex cond = BddNodeIndex(0);
+    BddNodeIndex if_true;
+    BddNodeIndex if_false;
+    BddNodeIndex result;
+  };
+
+  static bool IsComplemented(BddNodeIndex expr) { return expr.value() & 1; }
+  static BddNodeIndex Complement(BddNodeIndex expr) {
+    return BddNodeIndex(expr.value() ^ 1);
+  }
+  static BddNodeIndex Regular(BddNodeIndex expr) {
+    return BddNodeIndex(expr.value() & ~1);
+  }
+
+  // Returns the variable at the root of the given expression. Leaves order
+  // after all variables.
+  BddVariable TopVariable(BddNodeIndex expr) const {
+    return Regular(expr) == one()
+               ? BddVariable(std::numeric_limits<int32>::max())
+               : GetNode(expr).variable;
+  }
+
   // Helper for constructing a DNF string respresentation.
   void ToStringDnfHelper(BddNodeIndex expr, int64* minterms_to_emit,
                          std::vector<std::string>* terms,
@@ -124,23 +204,37 @@ class BinaryDecisionDiagram {
 
   // Returns the node equal to given expression with the given variable
   // set to the given value.
-  BddNodeIndex Restrict(BddNodeIndex expr, BddVariable var, bool value);
+  BddNodeIndex Restrict(BddNodeIndex expr, BddVariable var, bool value) const;
 
   // Returns the node corresponding to the given if-then-else expression.
   BddNodeIndex IfThenElse(BddNodeIndex cond, BddNodeIndex if_true,
                           BddNodeIndex if_false);
 
+  // Returns the cache entry for the given if-then-else expression.
+  IteCacheEntry& GetIteCacheEntry(BddNodeIndex cond, BddNodeIndex if_true,
+                                  BddNodeIndex if_false);
+
+  // Grows the if-then-else cache (dropping its contents) if it is small
+  // relative to the number of nodes.
+  void MaybeGrowIteCache();
+
   // Returns the node corresponding to the value of the given variable.
   BddNodeIndex GetVariableBaseNode(BddVariable variable) const {
-    return node_map_.at({variable, one(), zero()});
+    return variable_base_nodes_.at(variable.value());
   }
 
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
-  // The vector of all the nodes in the BDD.
+  // The vector of all the nodes in the BDD, and the indices of entries which
+  // have been garbage collected and may be reused.
   std::vector<BddNode> nodes_;
+  std::vector<int32> free_nodes_;
+  int64 peak_size_ = 0;
+
+  // The base node of each variable, indexed by variable.
+  std::vector<BddNodeIndex> variable_base_nodes_;
 
   // A map from BDD node content (variable id, high child, low child) to the
   // index of the respective node. This map is used to ensure that no duplicate
@@ -148,11 +242,15 @@ class BinaryDecisionDiagram {
   using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
   absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
 
-  // A map from if-then-else expression to the node corresponding to that
-  // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
-  using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+  // The if-then-else computed table, a direct-mapped cache from (condition,
+  // if-true, if-false) to the resulting expression. Its size is a power of two
+  // no larger than max_ite_cache_size_.
+  std::vector<IteCacheEntry> ite_cache_;
+  int64 max_ite_cache_size_;
+
+  int64 garbage_collection_count_ = 0;
+  int64 ite_cache_lookups_ = 0;
+  int64 ite_cache_hits_ = 0;
 };
 
 }  // namespace xls
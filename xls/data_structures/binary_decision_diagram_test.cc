@@ -85,6 +85,88 @@ TEST(BinaryDecisionDiagramTest, BddSize) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, NotDoesNotCreateNodes) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex var1 = bdd.NewVariable();
+  BddNodeIndex var2 = bdd.NewVariable();
+  BddNodeIndex var1_and_var2 = bdd.And(var1, var2);
+
+  int64 before_size = bdd.size();
+  BddNodeIndex not_and = bdd.Not(var1_and_var2);
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_EQ(bdd.Not(not_and), var1_and_var2);
+  EXPECT_EQ(bdd.Not(bdd.zero()), bdd.one());
+
+  EXPECT_FALSE(bdd.IsVariableBaseNode(bdd.Not(var1)));
+  EXPECT_EQ(bdd.minterm_count(not_and), 2);
+  EXPECT_THAT(bdd.Evaluate(not_and, {{var1, true}, {var2, true}}),
+              IsOkAndHolds(false));
+  EXPECT_THAT(bdd.Evaluate(not_and, {{var1, true}, {var2, false}}),
+              IsOkAndHolds(true));
+}
+
+TEST(BinaryDecisionDiagramTest, GarbageCollect) {
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> vars;
+  for (int64 i = 0; i < 8; ++i) {
+    vars.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex kept = bdd.Or(bdd.And(vars[0], vars[1]), vars[7]);
+  BddNodeIndex garbage = bdd.zero();
+  for (int64 i = 0; i < 8; ++i) {
+    garbage = bdd.Or(bdd.And(garbage, bdd.Not(vars[i])),
+                     bdd.And(bdd.Not(garbage), vars[i]));
+  }
+  int64 before_size = bdd.size();
+  std::string kept_string = bdd.ToStringDnf(kept);
+
+  bdd.GarbageCollect({kept});
+  EXPECT_LT(bdd.size(), before_size);
+  EXPECT_EQ(bdd.garbage_collection_count(), 1);
+  EXPECT_EQ(bdd.ToStringDnf(kept), kept_string);
+  EXPECT_EQ(bdd.minterm_count(kept), 3);
+  for (int64 i = 0; i < 8; ++i) {
+    EXPECT_TRUE(bdd.IsVariableBaseNode(vars[i]));
+  }
+
+  // Expressions built after collection reuse the freed nodes and are still
+  // canonical.
+  EXPECT_EQ(bdd.Or(vars[7], bdd.And(vars[1], vars[0])), kept);
+  BddNodeIndex parity = bdd.zero();
+  for (int64 i = 0; i < 8; ++i) {
+    parity = bdd.Or(bdd.And(parity, bdd.Not(vars[i])),
+                    bdd.And(bdd.Not(parity), vars[i]));
+  }
+  EXPECT_EQ(bdd.minterm_count(parity), 128);
+  EXPECT_LE(bdd.peak_size(), before_size);
+  absl::flat_hash_map<BddNodeIndex, bool> values;
+  for (int64 i = 0; i < 8; ++i) {
+    values[vars[i]] = i == 3;
+  }
+  EXPECT_THAT(bdd.Evaluate(parity, values), IsOkAndHolds(true));
+  EXPECT_THAT(bdd.Evaluate(kept, values), IsOkAndHolds(false));
+}
+
+TEST(BinaryDecisionDiagramTest, TinyIteCache) {
+  // A single-entry cache evicts almost every result; the BDD must still be
+  // canonical.
+  BinaryDecisionDiagram bdd(/*max_ite_cache_size=*/1);
+  std::vector<BddNodeIndex> vars;
+  for (int64 i = 0; i < 6; ++i) {
+    vars.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex a = bdd.zero();
+  BddNodeIndex b = bdd.zero();
+  for (int64 i = 0; i < 6; ++i) {
+    a = bdd.Or(a, bdd.And(vars[i], vars[(i + 1) % 6]));
+    b = bdd.Or(bdd.And(vars[(i + 1) % 6], vars[i]), b);
+  }
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(bdd.Not(a),
+            bdd.And(bdd.Not(b), bdd.Not(bdd.And(vars[0], vars[1]))));
+  EXPECT_GT(bdd.ite_cache_lookups(), bdd.ite_cache_hits());
+}
+
 TEST(BinaryDecisionDiagramTest, ToString) {
   BinaryDecisionDiagram bdd;
   BddNodeIndex x0 = bdd.NewVariable();
@@ -22,11 +22,29 @@
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
 
+// Number of 64-bit words of storage an InlineBitmap holds inline, i.e., without
+// a heap allocation. Bitmaps of up to 64 * XLS_INLINE_BITMAP_WORDS bits never
+// allocate. May be overridden at build time (e.g., with
+// --copt=-DXLS_INLINE_BITMAP_WORDS=4) to trade object size against
+// allocations for wider values.
+#ifndef XLS_INLINE_BITMAP_WORDS
+#define XLS_INLINE_BITMAP_WORDS 2
+#endif
+
 namespace xls {
 
-// A bitmap that has 64-bits of inline storage by default.
+// A bitmap that has XLS_INLINE_BITMAP_WORDS 64-bit words (128 bits by default)
+// of inline storage.
+//
+// Bits beyond bit_count() in the last word of storage are always zero, so
+// users operating on whole words (see GetWord() and SetWord()) need not mask
+// them off.
 class InlineBitmap {
  public:
+  static constexpr int64 kInlineWords = XLS_INLINE_BITMAP_WORDS;
+  static_assert(kInlineWords >= 2,
+                "InlineBitmap must hold at least 128 bits inline");
+
   static InlineBitmap FromWord(uint64 word, int64 bit_count, bool fill) {
     InlineBitmap result(bit_count, fill);
     if (bit_count != 0) {
@@ -40,6 +58,9 @@ class InlineBitmap {
         data_(CeilOfRatio(bit_count, kWordBits),
               fill ? -1ULL : 0ULL) {
     XLS_DCHECK_GE(bit_count, 0);
+    if (fill && bit_count != 0) {
+      MaskLastWord();
+    }
   }
 
   bool operator==(const InlineBitmap& other) const {
@@ -58,6 +79,16 @@ class InlineBitmap {
   }
   bool operator!=(const InlineBitmap& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const InlineBitmap& bitmap) {
+    h = H::combine(std::move(h), bitmap.bit_count_);
+    for (int64 wordno = 0; wordno < bitmap.word_count(); ++wordno) {
+      h = H::combine(std::move(h),
+                     bitmap.data_[wordno] & bitmap.MaskForWord(wordno));
+    }
+    return h;
+  }
+
   int64 bit_count() const { return bit_count_; }
   bool IsAllOnes() const {
     for (int64 wordno = 0; wordno < word_count(); ++wordno) {
@@ -106,6 +137,16 @@ class InlineBitmap {
     return data_[wordno];
   }
 
+  // Sets the 64-bit word "wordno" of the bitmap. For the last word, any bits of
+  // "value" beyond bit_count() are ignored.
+  void SetWord(int64 wordno, uint64 value) {
+    XLS_DCHECK_LT(wordno, word_count());
+    data_[wordno] = value & MaskForWord(wordno);
+  }
+
+  // Returns the number of 64-bit words backing the bitmap.
+  int64 word_count() const { return data_.size(); }
+
   // Sets a byte in the data underlying the bitmap.
   //
   // Setting byte i as {b_7, b_6, b_5, ..., b_0} sets the bit at i*8 to b_0, the
@@ -136,7 +177,6 @@ class InlineBitmap {
  private:
   static constexpr int64 kWordBits = 64;
   static constexpr int64 kWordBytes = 8;
-  int64 word_count() const { return data_.size(); }
 
   void MaskLastWord() {
     int64 last_wordno = word_count() - 1;
@@ -151,7 +191,7 @@ class InlineBitmap {
   }
 
   int64 bit_count_;
-  absl::InlinedVector<uint64, 1> data_;
+  absl::InlinedVector<uint64, kInlineWords> data_;
 };
 
 }  // namespace xls
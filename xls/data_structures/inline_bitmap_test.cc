@@ -162,5 +162,42 @@ TEST(InlineBitmapTest, BytesAndWords) {
   }
 }
 
+TEST(InlineBitmapTest, SetWord) {
+  InlineBitmap b(/*bit_count=*/100);
+  EXPECT_EQ(b.word_count(), 2);
+  b.SetWord(0, 0x123456789abcdef0);
+  b.SetWord(1, 0xffffffffffffffff);
+  EXPECT_EQ(b.GetWord(0), 0x123456789abcdef0) << std::hex << b.GetWord(0);
+  // Bits past the bit count are dropped.
+  EXPECT_EQ(b.GetWord(1), 0xfffffffff) << std::hex << b.GetWord(1);
+  EXPECT_FALSE(b.IsAllOnes());
+  b.SetWord(0, 0xffffffffffffffff);
+  EXPECT_TRUE(b.IsAllOnes());
+
+  // The same holds for bitmaps filled on construction.
+  InlineBitmap filled(/*bit_count=*/100, /*fill=*/true);
+  EXPECT_EQ(filled.GetWord(1), 0xfffffffff) << std::hex << filled.GetWord(1);
+  EXPECT_EQ(filled, b);
+}
+
+TEST(InlineBitmapTest, CopyAndMove) {
+  // Widths held inline and widths spilling to the heap.
+  for (int64 bit_count :
+       {int64{0}, int64{64}, 64 * InlineBitmap::kInlineWords,
+        64 * InlineBitmap::kInlineWords + 1}) {
+    InlineBitmap original(bit_count, /*fill=*/true);
+    InlineBitmap copy = original;
+    EXPECT_EQ(copy, original);
+    InlineBitmap moved = std::move(copy);
+    EXPECT_EQ(moved, original);
+    EXPECT_TRUE(moved.IsAllOnes());
+
+    moved = InlineBitmap(bit_count);
+    EXPECT_TRUE(moved.IsAllZeroes());
+    EXPECT_EQ(moved.bit_count(), bit_count);
+    EXPECT_TRUE(original.IsAllOnes());
+  }
+}
+
 }  // namespace
 }  // namespace xls
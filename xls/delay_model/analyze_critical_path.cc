@@ -18,13 +18,14 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/node_map.h"
 
 namespace xls {
 
 xabsl::StatusOr<std::vector<CriticalPathEntry>> AnalyzeCriticalPath(
     Function* f, absl::optional<int64> clock_period_ps,
     const DelayEstimator& delay_estimator) {
-  absl::flat_hash_map<Node*, std::pair<int64, bool>> node_to_output_delay;
+  NodeMap<std::pair<int64, bool>> node_to_output_delay(f);
 
   auto get_max_operands_delay = [&](Node* node) {
     int64 earliest = 0;
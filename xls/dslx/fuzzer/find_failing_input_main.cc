@@ -29,6 +29,7 @@
 #include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/jit/llvm_ir_jit.h"
+#include "xls/tools/ir_file.h"
 
 const char kUsage[] = R"(
 Runs an IR function with a set of inputs through both the JIT and the
@@ -46,16 +47,19 @@ ABSL_FLAG(
     std::string, test_only_inject_jit_result, "",
     "Test-only flag for injecting the result produced by the JIT. Used to "
     "force mismatches between JIT and interpreter for testing purposed.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
 
 absl::Status RealMain(absl::string_view ir_path,
                       absl::string_view inputs_path) {
-  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(std::string inputs_text, GetFileContents(inputs_path));
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir_text, ir_path));
+                       ReadPackageFile(ir_path, ir_format));
   XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
 
   std::vector<std::vector<Value>> inputs;
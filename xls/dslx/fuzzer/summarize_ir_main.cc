@@ -12,14 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "absl/flags/flag.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dslx/fuzzer/sample_summary.pb.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
+#include "xls/tools/ir_file.h"
 
 const char kUsage[] = R"(
 Appends a summary of a given IR to the specified Protobuf summary
@@ -37,6 +38,8 @@ ABSL_FLAG(std::string, tag, "",
           "String describing the provenance of the sample. Example: "
           "\"before-opt\".");
 ABSL_FLAG(std::string, summary_file, "", "Summary file to append to.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -74,12 +77,10 @@ fuzzer::SampleSummaries SummarizePackage(Package* package) {
 }
 
 absl::Status RealMain(absl::string_view input_path) {
-  if (input_path == "-") {
-    input_path = "/dev/stdin";
-  }
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
-  std::unique_ptr<Package> package;
-  XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackage(contents, input_path));
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ReadPackageFile(input_path, ir_format));
 
   fuzzer::SampleSummaries summaries = SummarizePackage(package.get());
 
@@ -243,13 +243,19 @@ Bits Bits::Slice(int64 start, int64 width) const {
   XLS_CHECK_GE(width, 0);
   XLS_CHECK_LE(start + width, bit_count())
       << "start: " << start << " width: " << width;
-  Bits result(width);
-  for (int64 i = 0; i < width; ++i) {
-    if (Get(start + i)) {
-      result.bitmap_.Set(i, true);
+  // Copy a word at a time, gathering each result word from (at most) two
+  // source words.
+  InlineBitmap result(width);
+  int64 word_offset = start / 64;
+  int64 bit_offset = start % 64;
+  for (int64 i = 0; i < result.word_count(); ++i) {
+    uint64 word = bitmap_.GetWord(word_offset + i) >> bit_offset;
+    if (bit_offset != 0 && word_offset + i + 1 < bitmap_.word_count()) {
+      word |= bitmap_.GetWord(word_offset + i + 1) << (64 - bit_offset);
     }
+    result.SetWord(i, word);
   }
-  return result;
+  return Bits(std::move(result));
 }
 
 std::string Bits::ToString(FormatPreference preference,
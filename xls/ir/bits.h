@@ -19,6 +19,7 @@
 #include <cmath>
 #include <numeric>
 #include <string>
+#include <utility>
 
 #include "absl/base/casts.h"
 #include "absl/strings/str_format.h"
@@ -79,6 +80,11 @@ class Bits {
   // are ignored.
   static Bits FromBytes(absl::Span<const uint8> bytes, int64 bit_count);
 
+  // Constructs a Bits object which takes ownership of the given bitmap.
+  static Bits FromBitmap(InlineBitmap bitmap) {
+    return Bits(std::move(bitmap));
+  }
+
   // Note: we flatten into the pushbuffer with the MSb pushed first.
   void FlattenTo(BitPushBuffer* buffer) const {
     for (int64 i = 0; i < bit_count(); ++i) {
@@ -158,11 +164,18 @@ class Bits {
   }
 
   ABSL_MUST_USE_RESULT
-  Bits UpdateWithSet(int64 index, bool value) const {
+  Bits UpdateWithSet(int64 index, bool value) const& {
     Bits clone = *this;
     clone.bitmap_.Set(index, value);
     return clone;
   }
+  // As above, but reuses the storage of an expiring value rather than copying
+  // it.
+  ABSL_MUST_USE_RESULT
+  Bits UpdateWithSet(int64 index, bool value) && {
+    bitmap_.Set(index, value);
+    return std::move(*this);
+  }
 
   // Returns whether the bits are all zeros/ones.
   bool IsAllOnes() const { return bitmap_.IsAllOnes(); }
@@ -220,11 +233,19 @@ class Bits {
   // (Zero-bit values get 0 by convention.)
   xabsl::StatusOr<uint64> WordToUint64(int64 word_number) const;
 
+  // Returns the underlying bitmap, e.g., for word-at-a-time operations.
+  const InlineBitmap& bitmap() const { return bitmap_; }
+
   // Returns whether this "bits" object is identical to the other in both
   // bit_count() and held value.
   bool operator==(const Bits& other) const { return bitmap_ == other.bitmap_; }
   bool operator!=(const Bits& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const Bits& bits) {
+    return H::combine(std::move(h), bits.bitmap_);
+  }
+
   // Slices a range of bits from the Bits object. 'start' is the first index in
   // the slice. 'start' is zero-indexed with zero being the LSb (same indexing
   // as Get/Set). 'width' is the number of bits to slice out and is the
@@ -246,7 +267,7 @@ class Bits {
   friend xabsl::StatusOr<Bits> UBitsWithStatus(uint64, int64);
   friend xabsl::StatusOr<Bits> SBitsWithStatus(int64, int64);
 
-  explicit Bits(InlineBitmap&& bitmap) : bitmap_(bitmap) {}
+  explicit Bits(InlineBitmap&& bitmap) : bitmap_(std::move(bitmap)) {}
 
   InlineBitmap bitmap_;
 };
@@ -271,8 +292,18 @@ class BitsRope {
   //
   // So b.Get(0) is now at result.Get(2).
   void push_back(const Bits& bits) {
-    for (int64 i = 0; i < bits.bit_count(); ++i) {
-      bitmap_.Set(index_ + i, bits.Get(i));
+    // Copy a word at a time, splitting each source word across (at most) two
+    // destination words. The destination is zero-initialized and filled from
+    // the LSb up, so OR-ing into it suffices.
+    const InlineBitmap& source = bits.bitmap_;
+    int64 offset = index_ % 64;
+    for (int64 i = 0; i < source.word_count(); ++i) {
+      uint64 word = source.GetWord(i);
+      int64 wordno = index_ / 64 + i;
+      bitmap_.SetWord(wordno, bitmap_.GetWord(wordno) | (word << offset));
+      if (offset != 0 && wordno + 1 < bitmap_.word_count()) {
+        bitmap_.SetWord(wordno + 1, word >> (64 - offset));
+      }
     }
     index_ += bits.bit_count();
   }
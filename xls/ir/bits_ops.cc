@@ -14,18 +14,178 @@
 
 #include "xls/ir/bits_ops.h"
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/base/config.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/int128.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/math_util.h"
 #include "xls/ir/big_int.h"
 
 namespace xls {
 namespace bits_ops {
 namespace {
 
+constexpr int64 kWordBits = 64;
+
+// Returns the "wordno"-th 64-bit word of "bits", treating the value as zero- or
+// (if "sign_extend" is true) sign-extended to an arbitrary width. "wordno" may
+// be past the end of the value.
+uint64 GetExtendedWord(const Bits& bits, int64 wordno, bool sign_extend) {
+  const InlineBitmap& bitmap = bits.bitmap();
+  bool fill = sign_extend && bits.msb();
+  if (wordno >= bitmap.word_count()) {
+    return fill ? Mask(kWordBits) : 0;
+  }
+  uint64 word = bitmap.GetWord(wordno);
+  int64 remainder = bits.bit_count() % kWordBits;
+  if (fill && wordno == bitmap.word_count() - 1 && remainder != 0) {
+    word |= ~Mask(remainder);
+  }
+  return word;
+}
+
+// Returns a + b + *carry, setting *carry to the carry out. *carry must be zero
+// or one.
+inline uint64 AddWithCarry(uint64 a, uint64 b, uint64* carry) {
+#if ABSL_HAVE_BUILTIN(__builtin_addcll)
+  unsigned long long carry_out;  // NOLINT(runtime/int)
+  uint64 sum = __builtin_addcll(a, b, *carry, &carry_out);
+  *carry = carry_out;
+  return sum;
+#else
+  uint64 sum;
+  bool carry_out = __builtin_add_overflow(a, b, &sum);
+  carry_out |= __builtin_add_overflow(sum, *carry, &sum);
+  *carry = carry_out ? 1 : 0;
+  return sum;
+#endif
+}
+
+// Applies "f" to each pair of corresponding words of "lhs" and "rhs", which
+// must have the same bit count.
+template <typename F>
+Bits WordwiseOp(const Bits& lhs, const Bits& rhs, F f) {
+  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
+  InlineBitmap result(lhs.bit_count());
+  for (int64 i = 0; i < result.word_count(); ++i) {
+    result.SetWord(i, f(lhs.bitmap().GetWord(i), rhs.bitmap().GetWord(i)));
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Returns lhs + rhs, or lhs - rhs (i.e., lhs + ~rhs + 1) if "subtract" is
+// true, modulo 2^bit_count.
+Bits AddWords(const Bits& lhs, const Bits& rhs, bool subtract) {
+  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
+  InlineBitmap result(lhs.bit_count());
+  uint64 carry = subtract ? 1 : 0;
+  for (int64 i = 0; i < result.word_count(); ++i) {
+    uint64 rhs_word = rhs.bitmap().GetWord(i);
+    result.SetWord(i, AddWithCarry(lhs.bitmap().GetWord(i),
+                                   subtract ? ~rhs_word : rhs_word, &carry));
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Returns the words of "bits" as a vector, which is faster to index than the
+// bitmap in inner loops.
+absl::InlinedVector<uint64, 4> GetWords(const Bits& bits) {
+  absl::InlinedVector<uint64, 4> words(bits.bitmap().word_count());
+  for (int64 i = 0; i < words.size(); ++i) {
+    words[i] = bits.bitmap().GetWord(i);
+  }
+  return words;
+}
+
+// Returns the low "result_bit_count" bits of the unsigned product of "lhs" and
+// "rhs". Schoolbook multiplication on 64-bit words with 128-bit partial
+// products.
+Bits UMulWords(const Bits& lhs, const Bits& rhs, int64 result_bit_count) {
+  absl::InlinedVector<uint64, 4> lhs_words = GetWords(lhs);
+  absl::InlinedVector<uint64, 4> rhs_words = GetWords(rhs);
+  int64 word_count = CeilOfRatio(result_bit_count, kWordBits);
+  absl::InlinedVector<uint64, 4> product(word_count, 0);
+  for (int64 i = 0; i < std::min<int64>(lhs_words.size(), word_count); ++i) {
+    uint64 lhs_word = lhs_words[i];
+    if (lhs_word == 0) {
+      continue;
+    }
+    int64 rhs_word_count = std::min<int64>(rhs_words.size(), word_count - i);
+    uint64 carry = 0;
+    for (int64 j = 0; j < rhs_word_count; ++j) {
+      absl::uint128 partial = absl::uint128(lhs_word) * rhs_words[j] +
+                              product[i + j] + carry;
+      product[i + j] = absl::Uint128Low64(partial);
+      carry = absl::Uint128High64(partial);
+    }
+    // No earlier row has reached this word yet, so it is still zero.
+    if (i + rhs_word_count < word_count) {
+      product[i + rhs_word_count] = carry;
+    }
+  }
+  InlineBitmap result(result_bit_count);
+  for (int64 i = 0; i < word_count; ++i) {
+    result.SetWord(i, product[i]);
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Compares "lhs" and "rhs" as unsigned or (if "is_signed") signed values,
+// which may have different bit counts. Returns a negative value, zero or a
+// positive value if "lhs" is less than, equal to or greater than "rhs".
+int CompareWords(const Bits& lhs, const Bits& rhs, bool is_signed) {
+  if (is_signed && lhs.msb() != rhs.msb()) {
+    return lhs.msb() ? -1 : 1;
+  }
+  // With equal signs, comparing the sign-extended values as unsigned numbers
+  // gives the signed result.
+  int64 word_count =
+      std::max(lhs.bitmap().word_count(), rhs.bitmap().word_count());
+  for (int64 i = word_count - 1; i >= 0; --i) {
+    uint64 lhs_word = GetExtendedWord(lhs, i, is_signed);
+    uint64 rhs_word = GetExtendedWord(rhs, i, is_signed);
+    if (lhs_word != rhs_word) {
+      return lhs_word < rhs_word ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// Shifts "bits" right by "shift_amount" (at most bits.bit_count()), filling
+// with the MSb if "sign_extend" is true, or with zeros otherwise.
+Bits ShiftRightWords(const Bits& bits, int64 shift_amount, bool sign_extend) {
+  int64 word_shift = shift_amount / kWordBits;
+  int64 bit_shift = shift_amount % kWordBits;
+  InlineBitmap result(bits.bit_count());
+  for (int64 i = 0; i < result.word_count(); ++i) {
+    uint64 word = GetExtendedWord(bits, i + word_shift, sign_extend);
+    if (bit_shift != 0) {
+      word = (word >> bit_shift) |
+             (GetExtendedWord(bits, i + word_shift + 1, sign_extend)
+              << (kWordBits - bit_shift));
+    }
+    result.SetWord(i, word);
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Returns "bits" zero- or (if "sign_extend" is true) sign-extended to
+// "new_bit_count" bits, which must be at least bits.bit_count().
+Bits ExtendWords(const Bits& bits, int64 new_bit_count, bool sign_extend) {
+  XLS_CHECK_GE(new_bit_count, bits.bit_count());
+  InlineBitmap result(new_bit_count);
+  for (int64 i = 0; i < result.word_count(); ++i) {
+    result.SetWord(i, GetExtendedWord(bits, i, sign_extend));
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
 // Converts the given bits value to signed value of the given bit count. Uses
 // truncation or sign-extension to narrow/widen the value.
-Bits TruncateOrSignExtend(const Bits& bits, int64 bit_count) {
+Bits TruncateOrSignExtend(Bits bits, int64 bit_count) {
   if (bits.bit_count() == bit_count) {
     return bits;
   } else if (bits.bit_count() < bit_count) {
@@ -38,17 +198,7 @@ Bits TruncateOrSignExtend(const Bits& bits, int64 bit_count) {
 }  // namespace
 
 Bits And(const Bits& lhs, const Bits& rhs) {
-  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
-  if (lhs.bit_count() <= 64) {
-    return UBits(lhs.ToUint64().value() & rhs.ToUint64().value(),
-                 lhs.bit_count());
-  }
-  std::vector<uint8> bytes = lhs.ToBytes();
-  std::vector<uint8> rhs_bytes = rhs.ToBytes();
-  for (int64 i = 0; i < bytes.size(); ++i) {
-    bytes[i] = bytes[i] & rhs_bytes[i];
-  }
-  return Bits::FromBytes(bytes, lhs.bit_count());
+  return WordwiseOp(lhs, rhs, [](uint64 a, uint64 b) { return a & b; });
 }
 
 Bits NaryAnd(absl::Span<const Bits> operands) {
@@ -60,19 +210,7 @@ Bits NaryAnd(absl::Span<const Bits> operands) {
 }
 
 Bits Or(const Bits& lhs, const Bits& rhs) {
-  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
-  if (lhs.bit_count() <= 64) {
-    uint64 lhs_int = lhs.ToUint64().value();
-    uint64 rhs_int = rhs.ToUint64().value();
-    uint64 result = (lhs_int | rhs_int);
-    return UBits(result, lhs.bit_count());
-  }
-  std::vector<uint8> bytes = lhs.ToBytes();
-  std::vector<uint8> rhs_bytes = rhs.ToBytes();
-  for (int64 i = 0; i < bytes.size(); ++i) {
-    bytes[i] = bytes[i] | rhs_bytes[i];
-  }
-  return Bits::FromBytes(bytes, lhs.bit_count());
+  return WordwiseOp(lhs, rhs, [](uint64 a, uint64 b) { return a | b; });
 }
 
 Bits NaryOr(absl::Span<const Bits> operands) {
@@ -84,19 +222,7 @@ Bits NaryOr(absl::Span<const Bits> operands) {
 }
 
 Bits Xor(const Bits& lhs, const Bits& rhs) {
-  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
-  if (lhs.bit_count() <= 64) {
-    uint64 lhs_int = lhs.ToUint64().value();
-    uint64 rhs_int = rhs.ToUint64().value();
-    uint64 result = (lhs_int ^ rhs_int);
-    return UBits(result, lhs.bit_count());
-  }
-  std::vector<uint8> bytes = lhs.ToBytes();
-  std::vector<uint8> rhs_bytes = rhs.ToBytes();
-  for (int64 i = 0; i < bytes.size(); ++i) {
-    bytes[i] = bytes[i] ^ rhs_bytes[i];
-  }
-  return Bits::FromBytes(bytes, lhs.bit_count());
+  return WordwiseOp(lhs, rhs, [](uint64 a, uint64 b) { return a ^ b; });
 }
 
 Bits NaryXor(absl::Span<const Bits> operands) {
@@ -108,18 +234,7 @@ Bits NaryXor(absl::Span<const Bits> operands) {
 }
 
 Bits Nand(const Bits& lhs, const Bits& rhs) {
-  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
-  if (lhs.bit_count() <= 64) {
-    return UBits(~(lhs.ToUint64().value() & rhs.ToUint64().value()) &
-                     Mask(lhs.bit_count()),
-                 lhs.bit_count());
-  }
-  std::vector<uint8> bytes = lhs.ToBytes();
-  std::vector<uint8> rhs_bytes = rhs.ToBytes();
-  for (int64 i = 0; i < bytes.size(); ++i) {
-    bytes[i] = ~(bytes[i] & rhs_bytes[i]);
-  }
-  return Bits::FromBytes(bytes, lhs.bit_count());
+  return WordwiseOp(lhs, rhs, [](uint64 a, uint64 b) { return ~(a & b); });
 }
 
 Bits NaryNand(absl::Span<const Bits> operands) {
@@ -131,18 +246,7 @@ Bits NaryNand(absl::Span<const Bits> operands) {
 }
 
 Bits Nor(const Bits& lhs, const Bits& rhs) {
-  XLS_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
-  if (lhs.bit_count() <= 64) {
-    return UBits(~(lhs.ToUint64().value() | rhs.ToUint64().value()) &
-                     Mask(lhs.bit_count()),
-                 lhs.bit_count());
-  }
-  std::vector<uint8> bytes = lhs.ToBytes();
-  std::vector<uint8> rhs_bytes = rhs.ToBytes();
-  for (int64 i = 0; i < bytes.size(); ++i) {
-    bytes[i] = ~(bytes[i] | rhs_bytes[i]);
-  }
-  return Bits::FromBytes(bytes, lhs.bit_count());
+  return WordwiseOp(lhs, rhs, [](uint64 a, uint64 b) { return ~(a | b); });
 }
 
 Bits NaryNor(absl::Span<const Bits> operands) {
@@ -154,15 +258,7 @@ Bits NaryNor(absl::Span<const Bits> operands) {
 }
 
 Bits Not(const Bits& bits) {
-  if (bits.bit_count() <= 64) {
-    return UBits((~bits.ToUint64().value()) & Mask(bits.bit_count()),
-                 bits.bit_count());
-  }
-  std::vector<uint8> bytes = bits.ToBytes();
-  for (uint8& byte : bytes) {
-    byte = ~byte;
-  }
-  return Bits::FromBytes(bytes, bits.bit_count());
+  return WordwiseOp(bits, bits, [](uint64 a, uint64) { return ~a; });
 }
 
 Bits AndReduce(const Bits& operand) {
@@ -188,10 +284,7 @@ Bits Add(const Bits& lhs, const Bits& rhs) {
     uint64 result = (lhs_int + rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-
-  Bits sum = BigInt::Add(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                 .ToSignedBits();
-  return TruncateOrSignExtend(sum, lhs.bit_count());
+  return AddWords(lhs, rhs, /*subtract=*/false);
 }
 
 Bits Sub(const Bits& lhs, const Bits& rhs) {
@@ -202,9 +295,7 @@ Bits Sub(const Bits& lhs, const Bits& rhs) {
     uint64 result = (lhs_int - rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-  Bits diff = BigInt::Sub(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                  .ToSignedBits();
-  return TruncateOrSignExtend(diff, lhs.bit_count());
+  return AddWords(lhs, rhs, /*subtract=*/true);
 }
 
 Bits Mul(const Bits& lhs, const Bits& rhs) {
@@ -215,13 +306,9 @@ Bits Mul(const Bits& lhs, const Bits& rhs) {
     uint64 result = (lhs_int * rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(SignExtend(lhs, lhs.bit_count())),
-                  BigInt::MakeSigned(SignExtend(rhs, lhs.bit_count())));
-  return product.ToSignedBitsWithBitCount(lhs.bit_count() * 2)
-      .value()
-      .Slice(0, lhs.bit_count());
+  // The low bits of a product are the same whether the operands are treated
+  // as signed or unsigned.
+  return UMulWords(lhs, rhs, lhs.bit_count());
 }
 
 Bits SMul(const Bits& lhs, const Bits& rhs) {
@@ -232,10 +319,24 @@ Bits SMul(const Bits& lhs, const Bits& rhs) {
     int64 result = lhs_int * rhs_int;
     return SBits(result, result_width);
   }
-
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return product.ToSignedBitsWithBitCount(result_width).value();
+  // Interpreted as unsigned, a negative n-bit operand x has the value
+  // x + 2^n. So the unsigned product is off from the signed product by the
+  // other operand shifted left by n (modulo 2^result_width), for each negative
+  // operand.
+  Bits product = UMulWords(lhs, rhs, result_width);
+  if (lhs.msb()) {
+    product = AddWords(
+        product,
+        ShiftLeftLogical(ZeroExtend(rhs, result_width), lhs.bit_count()),
+        /*subtract=*/true);
+  }
+  if (rhs.msb()) {
+    product = AddWords(
+        product,
+        ShiftLeftLogical(ZeroExtend(lhs, result_width), rhs.bit_count()),
+        /*subtract=*/true);
+  }
+  return product;
 }
 
 Bits UMul(const Bits& lhs, const Bits& rhs) {
@@ -246,10 +347,30 @@ Bits UMul(const Bits& lhs, const Bits& rhs) {
     uint64 result = lhs_int * rhs_int;
     return UBits(result, result_width);
   }
+  return UMulWords(lhs, rhs, result_width);
+}
+
+Bits SMul(const Bits& lhs, const Bits& rhs, int64 result_width) {
+  if (result_width >= lhs.bit_count() + rhs.bit_count()) {
+    return SignExtend(SMul(lhs, rhs), result_width);
+  }
+  // The low bits of a two's complement product depend only on the low bits
+  // of the operands, so multiply the operands as "result_width"-bit values.
+  auto fit = [&](const Bits& operand) {
+    return operand.bit_count() >= result_width
+               ? operand.Slice(0, result_width)
+               : SignExtend(operand, result_width);
+  };
+  return UMulWords(fit(lhs), fit(rhs), result_width);
+}
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return product.ToUnsignedBitsWithBitCount(result_width).value();
+Bits UMul(const Bits& lhs, const Bits& rhs, int64 result_width) {
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64 && result_width <= 64) {
+    uint64 product = lhs.ToUint64().value() * rhs.ToUint64().value();
+    return Bits::FromBitmap(
+        InlineBitmap::FromWord(product, result_width, /*fill=*/false));
+  }
+  return UMulWords(lhs, rhs, result_width);
 }
 
 Bits UDiv(const Bits& lhs, const Bits& rhs) {
@@ -271,7 +392,7 @@ Bits SDiv(const Bits& lhs, const Bits& rhs) {
     if (SLessThan(lhs, UBits(0, lhs.bit_count()))) {
       // Divide by zero and lhs is negative.  Return largest magnitude negative
       // number: 0b1000...000.
-      return Concat({UBits(1, 1), UBits(0, lhs.bit_count() - 1)});
+      return Bits::PowerOfTwo(lhs.bit_count() - 1, lhs.bit_count());
     } else {
       // Divide by zero and lhs is non-negative. Return largest positive number:
       // 0b0111...111.
@@ -284,7 +405,7 @@ Bits SDiv(const Bits& lhs, const Bits& rhs) {
 }
 
 bool UEqual(const Bits& lhs, const Bits& rhs) {
-  return BigInt::MakeUnsigned(lhs) == BigInt::MakeUnsigned(rhs);
+  return CompareWords(lhs, rhs, /*is_signed=*/false) == 0;
 }
 
 bool UEqual(const Bits& lhs, int64 rhs) {
@@ -301,12 +422,11 @@ bool UGreaterThan(const Bits& lhs, const Bits& rhs) {
 }
 
 bool ULessThanOrEqual(const Bits& lhs, const Bits& rhs) {
-  return UEqual(lhs, rhs) ||
-         BigInt::LessThan(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
+  return CompareWords(lhs, rhs, /*is_signed=*/false) <= 0;
 }
 
 bool ULessThan(const Bits& lhs, const Bits& rhs) {
-  return BigInt::LessThan(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
+  return CompareWords(lhs, rhs, /*is_signed=*/false) < 0;
 }
 
 bool UGreaterThanOrEqual(const Bits& lhs, int64 rhs) {
@@ -330,7 +450,7 @@ bool ULessThan(const Bits& lhs, int64 rhs) {
 }
 
 bool SEqual(const Bits& lhs, const Bits& rhs) {
-  return BigInt::MakeSigned(lhs) == BigInt::MakeSigned(rhs);
+  return CompareWords(lhs, rhs, /*is_signed=*/true) == 0;
 }
 
 bool SEqual(const Bits& lhs, int64 rhs) { return SEqual(lhs, SBits(rhs, 64)); }
@@ -344,14 +464,14 @@ bool SGreaterThan(const Bits& lhs, const Bits& rhs) {
 }
 
 bool SLessThanOrEqual(const Bits& lhs, const Bits& rhs) {
-  return SEqual(lhs, rhs) || SLessThan(lhs, rhs);
+  return CompareWords(lhs, rhs, /*is_signed=*/true) <= 0;
 }
 
 bool SLessThan(const Bits& lhs, const Bits& rhs) {
   if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
     return lhs.ToInt64().value() < rhs.ToInt64().value();
   }
-  return BigInt::LessThan(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
+  return CompareWords(lhs, rhs, /*is_signed=*/true) < 0;
 }
 
 bool SGreaterThanOrEqual(const Bits& lhs, int64 rhs) {
@@ -372,16 +492,12 @@ bool SLessThan(const Bits& lhs, int64 rhs) {
 
 Bits ZeroExtend(const Bits& bits, int64 new_bit_count) {
   XLS_CHECK_GE(new_bit_count, 0);
-  XLS_CHECK_GE(new_bit_count, bits.bit_count());
-  return Concat({UBits(0, new_bit_count - bits.bit_count()), bits});
+  return ExtendWords(bits, new_bit_count, /*sign_extend=*/false);
 }
 
 Bits SignExtend(const Bits& bits, int64 new_bit_count) {
   XLS_CHECK_GE(new_bit_count, 0);
-  XLS_CHECK_GE(new_bit_count, bits.bit_count());
-  const int64 ext_width = new_bit_count - bits.bit_count();
-  return Concat(
-      {bits.msb() ? Bits::AllOnes(ext_width) : Bits(ext_width), bits});
+  return ExtendWords(bits, new_bit_count, /*sign_extend=*/true);
 }
 
 Bits Concat(absl::Span<const Bits> inputs) {
@@ -403,30 +519,36 @@ Bits Negate(const Bits& bits) {
     return UBits((-bits.ToInt64().value()) & Mask(bits.bit_count()),
                  bits.bit_count());
   }
-  Bits negated = BigInt::Negate(BigInt::MakeSigned(bits)).ToSignedBits();
-  return TruncateOrSignExtend(negated, bits.bit_count());
+  return AddWords(Bits(bits.bit_count()), bits, /*subtract=*/true);
 }
 
 Bits ShiftLeftLogical(const Bits& bits, int64 shift_amount) {
   XLS_CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat(
-      {bits.Slice(0, bits.bit_count() - shift_amount), UBits(0, shift_amount)});
+  int64 word_shift = shift_amount / kWordBits;
+  int64 bit_shift = shift_amount % kWordBits;
+  InlineBitmap result(bits.bit_count());
+  for (int64 i = word_shift; i < result.word_count(); ++i) {
+    uint64 word = bits.bitmap().GetWord(i - word_shift) << bit_shift;
+    if (bit_shift != 0 && i > word_shift) {
+      word |= bits.bitmap().GetWord(i - word_shift - 1) >>
+              (kWordBits - bit_shift);
+    }
+    result.SetWord(i, word);
+  }
+  return Bits::FromBitmap(std::move(result));
 }
 
 Bits ShiftRightLogical(const Bits& bits, int64 shift_amount) {
   XLS_CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat({UBits(0, shift_amount),
-                 bits.Slice(shift_amount, bits.bit_count() - shift_amount)});
+  return ShiftRightWords(bits, shift_amount, /*sign_extend=*/false);
 }
 
 Bits ShiftRightArith(const Bits& bits, int64 shift_amount) {
   XLS_CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat(
-      {bits.msb() ? Bits::AllOnes(shift_amount) : UBits(0, shift_amount),
-       bits.Slice(shift_amount, bits.bit_count() - shift_amount)});
+  return ShiftRightWords(bits, shift_amount, /*sign_extend=*/true);
 }
 
 Bits OneHotLsbToMsb(const Bits& bits) {
@@ -448,9 +570,11 @@ Bits OneHotMsbToLsb(const Bits& bits) {
 }
 
 Bits Reverse(const Bits& bits) {
-  auto bits_vector = bits.ToBitVector();
-  std::reverse(bits_vector.begin(), bits_vector.end());
-  return Bits(bits_vector);
+  InlineBitmap result(bits.bit_count());
+  for (int64 i = 0; i < bits.bit_count(); ++i) {
+    result.Set(bits.bit_count() - i - 1, bits.Get(i));
+  }
+  return Bits::FromBitmap(std::move(result));
 }
 
 }  // namespace bits_ops
@@ -51,6 +51,12 @@ Bits Sub(const Bits& lhs, const Bits& rhs);
 Bits SMul(const Bits& lhs, const Bits& rhs);
 Bits UMul(const Bits& lhs, const Bits& rhs);
 
+// As above, but the result is truncated or extended to "result_width" bits,
+// as for an XLS smul/umul node. Only the needed bits are computed, so no
+// wider intermediate product is built.
+Bits SMul(const Bits& lhs, const Bits& rhs, int64 result_width);
+Bits UMul(const Bits& lhs, const Bits& rhs, int64 result_width);
+
 // Performs an (un)signed divide with round toward zero. The width of the lhs
 // and rhs must be equal, and the returned result is the same width as the
 // inputs. For UDiv, if the rhs is zero the result is all ones. For SDiv, if the
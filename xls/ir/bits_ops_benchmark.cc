@@ -0,0 +1,280 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the word-at-a-time bits_ops kernels against reference
+// implementations built on BigInt and bit-at-a-time slicing (i.e., how these
+// operations used to be implemented), and checks that the two agree.
+
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/big_int.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+
+const char* kUsage = R"(
+Measures the throughput of bits_ops kernels over a range of bit widths, and
+checks their results against reference implementations. Usage:
+
+   bits_ops_benchmark --widths=1,64,128,4096
+)";
+
+ABSL_FLAG(std::vector<std::string>, widths,
+          std::vector<std::string>({"1", "8", "63", "64", "65", "128", "256",
+                                    "512", "1024", "2048", "4096"}),
+          "Comma-separated list of bit widths to measure.");
+ABSL_FLAG(int64, operand_count, 64,
+          "Number of distinct random operand pairs per width.");
+ABSL_FLAG(absl::Duration, min_time, absl::Milliseconds(100),
+          "Minimum time to spend measuring each operation at each width.");
+
+namespace xls {
+namespace {
+
+// Reference implementations.
+
+Bits TruncateOrSignExtend(const Bits& bits, int64 bit_count) {
+  if (bits.bit_count() < bit_count) {
+    return bits_ops::SignExtend(bits, bit_count);
+  }
+  return bits.Slice(0, bit_count);
+}
+
+Bits ReferenceAdd(const Bits& lhs, const Bits& rhs) {
+  return TruncateOrSignExtend(
+      BigInt::Add(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+          .ToSignedBits(),
+      lhs.bit_count());
+}
+
+Bits ReferenceSub(const Bits& lhs, const Bits& rhs) {
+  return TruncateOrSignExtend(
+      BigInt::Sub(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+          .ToSignedBits(),
+      lhs.bit_count());
+}
+
+Bits ReferenceUMul(const Bits& lhs, const Bits& rhs) {
+  return BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToUnsignedBitsWithBitCount(lhs.bit_count() + rhs.bit_count())
+      .value();
+}
+
+Bits ReferenceSMul(const Bits& lhs, const Bits& rhs) {
+  return BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+      .ToSignedBitsWithBitCount(lhs.bit_count() + rhs.bit_count())
+      .value();
+}
+
+Bits ReferenceConcat(const Bits& lhs, const Bits& rhs) {
+  InlineBitmap bitmap(lhs.bit_count() + rhs.bit_count());
+  for (int64 i = 0; i < rhs.bit_count(); ++i) {
+    bitmap.Set(i, rhs.Get(i));
+  }
+  for (int64 i = 0; i < lhs.bit_count(); ++i) {
+    bitmap.Set(rhs.bit_count() + i, lhs.Get(i));
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+// Shifts "bits" by "amount" bit-at-a-time; right shifts fill with "fill".
+Bits ReferenceShift(const Bits& bits, int64 amount, bool left, bool fill) {
+  InlineBitmap bitmap(bits.bit_count());
+  for (int64 i = 0; i < bits.bit_count(); ++i) {
+    int64 source = left ? i - amount : i + amount;
+    bitmap.Set(i, source < 0                   ? false
+                  : source >= bits.bit_count() ? fill
+                                               : bits.Get(source));
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+Bits ReferenceULessThan(const Bits& lhs, const Bits& rhs) {
+  return UBits(
+      BigInt::LessThan(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs)),
+      1);
+}
+
+Bits ReferenceSLessThan(const Bits& lhs, const Bits& rhs) {
+  return UBits(
+      BigInt::LessThan(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs)), 1);
+}
+
+Bits ReferenceUEqual(const Bits& lhs, const Bits& rhs) {
+  return UBits(BigInt::MakeUnsigned(lhs) == BigInt::MakeUnsigned(rhs), 1);
+}
+
+// Shift by an amount which isn't a multiple of the word size, and which is
+// within the width for all but the narrowest values.
+int64 ShiftAmount(const Bits& bits) { return bits.bit_count() * 3 / 5; }
+
+// A binary operation under test, along with its reference implementation.
+struct Operation {
+  std::string name;
+  std::function<Bits(const Bits&, const Bits&)> kernel;
+  std::function<Bits(const Bits&, const Bits&)> reference;
+};
+
+std::vector<Operation> GetOperations() {
+  return {
+      {"add", bits_ops::Add, ReferenceAdd},
+      {"sub", bits_ops::Sub, ReferenceSub},
+      {"umul", bits_ops::UMul, ReferenceUMul},
+      {"smul", bits_ops::SMul, ReferenceSMul},
+      {"concat",
+       [](const Bits& lhs, const Bits& rhs) {
+         return bits_ops::Concat({lhs, rhs});
+       },
+       ReferenceConcat},
+      {"shll",
+       [](const Bits& lhs, const Bits& rhs) {
+         return bits_ops::ShiftLeftLogical(lhs, ShiftAmount(lhs));
+       },
+       [](const Bits& lhs, const Bits& rhs) {
+         return ReferenceShift(lhs, ShiftAmount(lhs), /*left=*/true,
+                               /*fill=*/false);
+       }},
+      {"shrl",
+       [](const Bits& lhs, const Bits& rhs) {
+         return bits_ops::ShiftRightLogical(lhs, ShiftAmount(lhs));
+       },
+       [](const Bits& lhs, const Bits& rhs) {
+         return ReferenceShift(lhs, ShiftAmount(lhs), /*left=*/false,
+                               /*fill=*/false);
+       }},
+      {"shra",
+       [](const Bits& lhs, const Bits& rhs) {
+         return bits_ops::ShiftRightArith(lhs, ShiftAmount(lhs));
+       },
+       [](const Bits& lhs, const Bits& rhs) {
+         return ReferenceShift(lhs, ShiftAmount(lhs), /*left=*/false,
+                               /*fill=*/lhs.msb());
+       }},
+      {"ult",
+       [](const Bits& lhs, const Bits& rhs) {
+         return UBits(bits_ops::ULessThan(lhs, rhs), 1);
+       },
+       ReferenceULessThan},
+      {"slt",
+       [](const Bits& lhs, const Bits& rhs) {
+         return UBits(bits_ops::SLessThan(lhs, rhs), 1);
+       },
+       ReferenceSLessThan},
+      {"eq",
+       [](const Bits& lhs, const Bits& rhs) {
+         return UBits(bits_ops::UEqual(lhs, rhs), 1);
+       },
+       ReferenceUEqual},
+  };
+}
+
+Bits RandomBits(int64 bit_count, std::minstd_rand* bitgen) {
+  InlineBitmap bitmap(bit_count);
+  for (int64 i = 0; i < bitmap.word_count(); ++i) {
+    bitmap.SetWord(i, (uint64{(*bitgen)()} << 32) ^ (*bitgen)());
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+// Returns the average time per call of "f" over all operand pairs.
+absl::Duration TimeOperation(
+    const std::function<Bits(const Bits&, const Bits&)>& f,
+    const std::vector<std::pair<Bits, Bits>>& operands) {
+  absl::Duration min_time = absl::GetFlag(FLAGS_min_time);
+  int64 calls = 0;
+  absl::Time start = absl::Now();
+  absl::Duration elapsed;
+  do {
+    for (const auto& pair : operands) {
+      f(pair.first, pair.second);
+    }
+    calls += operands.size();
+    elapsed = absl::Now() - start;
+  } while (elapsed < min_time);
+  return elapsed / calls;
+}
+
+absl::Status RealMain() {
+  int64 operand_count = absl::GetFlag(FLAGS_operand_count);
+  XLS_RET_CHECK_GT(operand_count, 0);
+  std::minstd_rand bitgen;
+  std::vector<Operation> operations = GetOperations();
+
+  std::cout << absl::StreamFormat("%-8s %6s %14s %14s %9s\n", "op", "width",
+                                  "reference", "kernel", "speedup");
+  for (const std::string& width_str : absl::GetFlag(FLAGS_widths)) {
+    int64 width;
+    XLS_RET_CHECK(absl::SimpleAtoi(width_str, &width))
+        << "Invalid width: " << width_str;
+    XLS_RET_CHECK_GT(width, 0);
+    std::vector<std::pair<Bits, Bits>> operands;
+    for (int64 i = 0; i < operand_count; ++i) {
+      operands.push_back({RandomBits(width, &bitgen),
+                          RandomBits(width, &bitgen)});
+    }
+    // Make sure equal, all-ones and sign-bit-set operands are covered too.
+    operands.push_back({operands[0].first, operands[0].first});
+    operands.push_back({Bits::AllOnes(width), Bits::AllOnes(width)});
+    operands.push_back({Bits::PowerOfTwo(width - 1, width), Bits(width)});
+
+    for (const Operation& op : operations) {
+      for (const auto& pair : operands) {
+        Bits expected = op.reference(pair.first, pair.second);
+        Bits actual = op.kernel(pair.first, pair.second);
+        if (actual != expected) {
+          return absl::InternalError(absl::StrFormat(
+              "%s(%s, %s) = %s, expected %s", op.name,
+              pair.first.ToString(FormatPreference::kHex),
+              pair.second.ToString(FormatPreference::kHex),
+              actual.ToString(FormatPreference::kHex),
+              expected.ToString(FormatPreference::kHex)));
+        }
+      }
+      absl::Duration reference_time = TimeOperation(op.reference, operands);
+      absl::Duration kernel_time = TimeOperation(op.kernel, operands);
+      std::cout << absl::StreamFormat(
+          "%-8s %6d %14s %14s %8.2fx\n", op.name, width,
+          absl::FormatDuration(reference_time),
+          absl::FormatDuration(kernel_time),
+          absl::FDivDuration(reference_time, kernel_time));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
@@ -14,8 +14,12 @@
 
 #include "xls/ir/bits_ops.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_format.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/number_parser.h"
@@ -203,6 +207,46 @@ TEST(BitsOpsTest, SMul) {
             "0004_b168");
 }
 
+TEST(BitsOpsTest, MulWithResultWidth) {
+  // Each product must equal the full-width product truncated or extended to
+  // the result width.
+  std::vector<Bits> operands = {Bits(),
+                                UBits(0, 1),
+                                UBits(1, 1),
+                                UBits(100, 7),
+                                SBits(-3, 8),
+                                UBits(0x123456789abcdef0ULL, 64),
+                                Bits::AllOnes(64),
+                                Bits::AllOnes(65),
+                                Bits::PowerOfTwo(99, 100),
+                                bits_ops::Concat({UBits(0xabc, 12),
+                                                  UBits(0x1234567, 64),
+                                                  UBits(0x7654321, 52)})};
+  for (const Bits& lhs : operands) {
+    for (const Bits& rhs : operands) {
+      for (int64 width : {0, 1, 7, 64, 65, 128, 200, 300}) {
+        Bits umul = bits_ops::UMul(lhs, rhs);
+        Bits smul = bits_ops::SMul(lhs, rhs);
+        std::string context = absl::StrFormat(
+            "%s * %s to %d bits", lhs.ToString(), rhs.ToString(), width);
+        if (width <= umul.bit_count()) {
+          EXPECT_EQ(bits_ops::UMul(lhs, rhs, width), umul.Slice(0, width))
+              << context;
+          EXPECT_EQ(bits_ops::SMul(lhs, rhs, width), smul.Slice(0, width))
+              << context;
+        } else {
+          EXPECT_EQ(bits_ops::UMul(lhs, rhs, width),
+                    bits_ops::ZeroExtend(umul, width))
+              << context;
+          EXPECT_EQ(bits_ops::SMul(lhs, rhs, width),
+                    bits_ops::SignExtend(smul, width))
+              << context;
+        }
+      }
+    }
+  }
+}
+
 TEST(BitsOpsTest, UDiv) {
   EXPECT_EQ(bits_ops::UDiv(UBits(100, 64), UBits(5, 64)), UBits(20, 64));
   EXPECT_EQ(bits_ops::UDiv(UBits(100, 32), UBits(7, 32)), UBits(14, 32));
@@ -562,6 +606,71 @@ TEST(BitsOpsTest, ShiftRightArith) {
   EXPECT_EQ(b6_shifted, SBits(-1, 2));
 }
 
+// Shifts of multi-word values, by amounts which are not a multiple of the
+// word size.
+TEST(BitsOpsTest, WideShifts) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Bits parsed,
+      ParseNumber("0x1234_5678_9abc_def0_0fed_cba9_8765_4321_ffff"));
+  Bits wide = bits_ops::ZeroExtend(parsed, 144);
+  EXPECT_EQ(
+      bits_ops::ShiftLeftLogical(wide, 68).ToString(FormatPreference::kHex),
+      "0xfedc_ba98_7654_321f_fff0_0000_0000_0000_0000");
+  EXPECT_EQ(
+      bits_ops::ShiftRightLogical(wide, 68).ToString(FormatPreference::kHex),
+      "0x123_4567_89ab_cdef_00fe");
+  EXPECT_EQ(
+      bits_ops::ShiftRightArith(wide, 68).ToString(FormatPreference::kHex),
+      "0x123_4567_89ab_cdef_00fe");
+
+  Bits negative = wide.UpdateWithSet(143, true);
+  EXPECT_EQ(
+      bits_ops::ShiftRightArith(negative, 68).ToString(FormatPreference::kHex),
+      "0xffff_ffff_ffff_ffff_f923_4567_89ab_cdef_00fe");
+  EXPECT_EQ(bits_ops::ShiftRightArith(negative, 144), Bits::AllOnes(144));
+  EXPECT_EQ(bits_ops::ShiftRightLogical(negative, 144), Bits(144));
+  EXPECT_EQ(bits_ops::ShiftLeftLogical(negative, 144), Bits(144));
+}
+
+TEST(BitsOpsTest, WideMultiply) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Bits parsed,
+      ParseNumber("0x1234_5678_9abc_def0_0fed_cba9_8765_4321_ffff"));
+  Bits lhs = bits_ops::ZeroExtend(parsed, 144);
+  Bits rhs = Bits::AllOnes(80);
+  EXPECT_EQ(bits_ops::UMul(lhs, rhs).ToString(FormatPreference::kHex),
+            "0x1234_5678_9abc_def0_0fed_b975_30ec_a865_210e_f012_3456_789a_"
+            "bcde_0001");
+  // As a signed value, "rhs" is -1.
+  EXPECT_EQ(bits_ops::SMul(lhs, rhs).ToString(FormatPreference::kHex),
+            "0xffff_ffff_ffff_ffff_ffff_edcb_a987_6543_210f_f012_3456_789a_"
+            "bcde_0001");
+  EXPECT_EQ(bits_ops::SMul(lhs, rhs),
+            bits_ops::SignExtend(bits_ops::Negate(lhs), 224));
+}
+
+TEST(BitsOpsTest, WideComparisons) {
+  Bits wide_zero(300);
+  Bits wide_one = UBits(1, 300);
+  Bits wide_max = Bits::AllOnes(300);
+  Bits wide_high = Bits::PowerOfTwo(299, 300);
+
+  // Operands of different widths are zero- (or sign-) extended.
+  EXPECT_TRUE(bits_ops::UEqual(wide_one, UBits(1, 1)));
+  EXPECT_TRUE(bits_ops::ULessThan(UBits(1, 1), wide_high));
+  EXPECT_TRUE(bits_ops::ULessThan(wide_high, wide_max));
+  EXPECT_FALSE(bits_ops::ULessThan(wide_max, wide_high));
+  EXPECT_TRUE(bits_ops::ULessThanOrEqual(wide_max, wide_max));
+  EXPECT_TRUE(bits_ops::UGreaterThan(wide_max, UBits(7, 3)));
+
+  EXPECT_TRUE(bits_ops::SEqual(wide_max, SBits(-1, 2)));
+  EXPECT_TRUE(bits_ops::SLessThan(wide_high, wide_max));
+  EXPECT_TRUE(bits_ops::SLessThan(wide_max, wide_zero));
+  EXPECT_TRUE(bits_ops::SLessThan(wide_high, SBits(-1, 1)));
+  EXPECT_TRUE(bits_ops::SGreaterThan(wide_one, wide_high));
+  EXPECT_TRUE(bits_ops::SLessThanOrEqual(wide_zero, wide_zero));
+}
+
 TEST(BitsOpsTest, Negate) {
   EXPECT_EQ(bits_ops::Negate(Bits(0)), Bits(0));
   EXPECT_EQ(bits_ops::Negate(UBits(0, 1)), UBits(0, 1));
@@ -0,0 +1,487 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/bytecode_interpreter.h"
+
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/ir_interpreter.h"
+#include "xls/ir/keyword_args.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+// Returns the nodes which the return value of "function" depends on (including
+// the return value itself), in topological order. Nodes which do not
+// contribute to the result are never evaluated, as with ir_interpreter::Run().
+std::vector<Node*> LiveNodesInTopoOrder(Function* function) {
+  std::vector<Node*> order;
+  absl::flat_hash_set<Node*> visited;
+  // An explicit stack of (node, index of the next operand to visit) to avoid
+  // recursing to the depth of the graph.
+  std::vector<std::pair<Node*, int64>> stack;
+  stack.push_back({function->return_value(), 0});
+  visited.insert(function->return_value());
+  while (!stack.empty()) {
+    Node* node = stack.back().first;
+    int64 operand_index = stack.back().second++;
+    if (operand_index < node->operand_count()) {
+      Node* operand = node->operand(operand_index);
+      if (visited.insert(operand).second) {
+        stack.push_back({operand, 0});
+      }
+      continue;
+    }
+    order.push_back(node);
+    stack.pop_back();
+  }
+  return order;
+}
+
+// Returns true if the node and all of its operands are of bits type.
+bool IsAllBits(Node* node) {
+  if (!node->GetType()->IsBits()) {
+    return false;
+  }
+  for (Node* operand : node->operands()) {
+    if (!operand->GetType()->IsBits()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/* static */ xabsl::StatusOr<std::unique_ptr<BytecodeInterpreter>>
+BytecodeInterpreter::Create(Function* function) {
+  auto interpreter = absl::WrapUnique(new BytecodeInterpreter(function));
+  XLS_RETURN_IF_ERROR(interpreter->Compile());
+  return std::move(interpreter);
+}
+
+xabsl::StatusOr<BytecodeInterpreter*> BytecodeInterpreter::GetCallee(
+    Function* function) {
+  auto it = callee_by_function_.find(function);
+  if (it != callee_by_function_.end()) {
+    return it->second;
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeInterpreter> callee,
+                       Create(function));
+  callees_.push_back(std::move(callee));
+  callee_by_function_[function] = callees_.back().get();
+  return callees_.back().get();
+}
+
+absl::Status BytecodeInterpreter::Compile() {
+  std::vector<Node*> nodes = LiveNodesInTopoOrder(function_);
+  absl::flat_hash_map<Node*, int64> slot_by_node;
+  slot_by_node.reserve(nodes.size());
+  for (Node* node : nodes) {
+    slot_by_node[node] = slot_by_node.size();
+  }
+  slots_.resize(nodes.size());
+  return_slot_ = slot_by_node.at(function_->return_value());
+  param_slots_.assign(function_->params().size(), -1);
+
+  for (Node* node : nodes) {
+    int64 slot = slot_by_node.at(node);
+    if (node->Is<Literal>()) {
+      slots_[slot] = node->As<Literal>()->value();
+      continue;
+    }
+    if (node->Is<Param>()) {
+      XLS_ASSIGN_OR_RETURN(int64 index,
+                           function_->GetParamIndex(node->As<Param>()));
+      param_slots_[index] = slot;
+      continue;
+    }
+    Instruction instruction;
+    instruction.op = node->op();
+    instruction.node = node;
+    instruction.result_slot = slot;
+    instruction.operands_begin = operand_slots_.size();
+    instruction.operand_count = node->operand_count();
+    instruction.callee = nullptr;
+    for (Node* operand : node->operands()) {
+      operand_slots_.push_back(slot_by_node.at(operand));
+    }
+    if (node->Is<CountedFor>()) {
+      XLS_ASSIGN_OR_RETURN(instruction.callee,
+                           GetCallee(node->As<CountedFor>()->body()));
+    } else if (node->Is<Invoke>()) {
+      XLS_ASSIGN_OR_RETURN(instruction.callee,
+                           GetCallee(node->As<Invoke>()->to_apply()));
+    } else if (node->Is<Map>()) {
+      XLS_ASSIGN_OR_RETURN(instruction.callee,
+                           GetCallee(node->As<Map>()->to_apply()));
+    }
+    instructions_.push_back(instruction);
+  }
+  return absl::OkStatus();
+}
+
+xabsl::StatusOr<Value> BytecodeInterpreter::Run(absl::Span<const Value> args) {
+  if (args.size() != function_->params().size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Function %s wants %d arguments, got %d.", function_->name(),
+        function_->params().size(), args.size()));
+  }
+  for (int64 argno = 0; argno < args.size(); ++argno) {
+    Type* param_type = function_->param(argno)->GetType();
+    if (!ValueConformsToType(args[argno], param_type)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got argument %s for parameter %d which is not of type %s",
+          args[argno].ToString(), argno, param_type->ToString()));
+    }
+    if (param_slots_[argno] >= 0) {
+      slots_[param_slots_[argno]] = args[argno];
+    }
+  }
+  for (const Instruction& instruction : instructions_) {
+    XLS_RETURN_IF_ERROR(Execute(instruction));
+  }
+  return slots_[return_slot_];
+}
+
+xabsl::StatusOr<Value> BytecodeInterpreter::RunKwargs(
+    const absl::flat_hash_map<std::string, Value>& kwargs) {
+  XLS_ASSIGN_OR_RETURN(std::vector<Value> positional_args,
+                       KeywordArgsToPositional(*function_, kwargs));
+  return Run(positional_args);
+}
+
+uint64 BytecodeInterpreter::OperandAsBoundedUint64(
+    const Instruction& instruction, int64 i, uint64 upper_limit) const {
+  const Bits& bits = operand_bits(instruction, i);
+  if (Bits::MinBitCountUnsigned(upper_limit) <= bits.bit_count() &&
+      bits_ops::UGreaterThan(bits, UBits(upper_limit, bits.bit_count()))) {
+    return upper_limit;
+  }
+  // Necessarily the bits value fits in a uint64 so the value() call is safe.
+  return bits.ToUint64().value();
+}
+
+Bits BytecodeInterpreter::FoldOperands(
+    const Instruction& instruction, Bits (*f)(const Bits&, const Bits&)) const {
+  Bits accum = operand_bits(instruction, 0);
+  for (int64 i = 1; i < instruction.operand_count; ++i) {
+    accum = f(accum, operand_bits(instruction, i));
+  }
+  return accum;
+}
+
+absl::Status BytecodeInterpreter::ExecuteGeneric(
+    const Instruction& instruction) {
+  absl::InlinedVector<const Value*, 4> operand_values;
+  for (int64 i = 0; i < instruction.operand_count; ++i) {
+    operand_values.push_back(&operand(instruction, i));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      slots_[instruction.result_slot],
+      ir_interpreter::EvaluateNode(instruction.node, operand_values));
+  return absl::OkStatus();
+}
+
+absl::Status BytecodeInterpreter::Execute(const Instruction& instruction) {
+  Node* node = instruction.node;
+  Value& result = slots_[instruction.result_slot];
+  auto set_bits = [&](Bits bits) { result = Value(std::move(bits)); };
+  auto set_bool = [&](bool value) { result = Value(UBits(value, 1)); };
+  auto bits_operand = [&](int64 i) -> const Bits& {
+    return operand_bits(instruction, i);
+  };
+
+  switch (instruction.op) {
+    case Op::kAdd:
+      set_bits(bits_ops::Add(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSub:
+      set_bits(bits_ops::Sub(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kUMul:
+      set_bits(bits_ops::UMul(bits_operand(0), bits_operand(1),
+                              node->BitCountOrDie()));
+      break;
+    case Op::kSMul:
+      set_bits(bits_ops::SMul(bits_operand(0), bits_operand(1),
+                              node->BitCountOrDie()));
+      break;
+    case Op::kUDiv:
+      set_bits(bits_ops::UDiv(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSDiv:
+      set_bits(bits_ops::SDiv(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kAnd:
+      set_bits(FoldOperands(instruction, bits_ops::And));
+      break;
+    case Op::kOr:
+      set_bits(FoldOperands(instruction, bits_ops::Or));
+      break;
+    case Op::kXor:
+      set_bits(FoldOperands(instruction, bits_ops::Xor));
+      break;
+    case Op::kNand:
+      set_bits(bits_ops::Not(FoldOperands(instruction, bits_ops::And)));
+      break;
+    case Op::kNor:
+      set_bits(bits_ops::Not(FoldOperands(instruction, bits_ops::Or)));
+      break;
+    case Op::kAndReduce:
+      set_bits(bits_ops::AndReduce(bits_operand(0)));
+      break;
+    case Op::kOrReduce:
+      set_bits(bits_ops::OrReduce(bits_operand(0)));
+      break;
+    case Op::kXorReduce:
+      set_bits(bits_ops::XorReduce(bits_operand(0)));
+      break;
+    case Op::kNot:
+      set_bits(bits_ops::Not(bits_operand(0)));
+      break;
+    case Op::kNeg:
+      set_bits(bits_ops::Negate(bits_operand(0)));
+      break;
+    case Op::kReverse:
+      set_bits(bits_ops::Reverse(bits_operand(0)));
+      break;
+    case Op::kEq:
+    case Op::kNe:
+      if (!IsAllBits(node)) {
+        // Let the interpreter produce its error for non-bits operands.
+        return ExecuteGeneric(instruction);
+      }
+      set_bool((bits_operand(0) == bits_operand(1)) ==
+               (instruction.op == Op::kEq));
+      break;
+    case Op::kUGe:
+      set_bool(bits_ops::UGreaterThanOrEqual(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kUGt:
+      set_bool(bits_ops::UGreaterThan(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kULe:
+      set_bool(bits_ops::ULessThanOrEqual(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kULt:
+      set_bool(bits_ops::ULessThan(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSGe:
+      set_bool(bits_ops::SGreaterThanOrEqual(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSGt:
+      set_bool(bits_ops::SGreaterThan(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSLe:
+      set_bool(bits_ops::SLessThanOrEqual(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kSLt:
+      set_bool(bits_ops::SLessThan(bits_operand(0), bits_operand(1)));
+      break;
+    case Op::kShll:
+    case Op::kShrl:
+    case Op::kShra: {
+      const Bits& input = bits_operand(0);
+      int64 amount = OperandAsBoundedUint64(instruction, 1, input.bit_count());
+      set_bits(instruction.op == Op::kShll
+                   ? bits_ops::ShiftLeftLogical(input, amount)
+                   : instruction.op == Op::kShrl
+                         ? bits_ops::ShiftRightLogical(input, amount)
+                         : bits_ops::ShiftRightArith(input, amount));
+      break;
+    }
+    case Op::kSignExt:
+      set_bits(bits_ops::SignExtend(bits_operand(0),
+                                    node->As<ExtendOp>()->new_bit_count()));
+      break;
+    case Op::kZeroExt:
+      set_bits(bits_ops::ZeroExtend(bits_operand(0),
+                                    node->As<ExtendOp>()->new_bit_count()));
+      break;
+    case Op::kBitSlice: {
+      BitSlice* bit_slice = node->As<BitSlice>();
+      set_bits(bits_operand(0).Slice(bit_slice->start(), bit_slice->width()));
+      break;
+    }
+    case Op::kDynamicBitSlice: {
+      int64 width = node->As<DynamicBitSlice>()->width();
+      const Bits& input = bits_operand(0);
+      const Bits& start = bits_operand(1);
+      if (bits_ops::UGreaterThanOrEqual(start, input.bit_count())) {
+        // Slice is entirely out-of-bounds.
+        set_bits(Bits(width));
+      } else {
+        set_bits(
+            bits_ops::ShiftRightLogical(input, start.ToUint64().value())
+                .Slice(0, width));
+      }
+      break;
+    }
+    case Op::kConcat: {
+      // The last operand holds the LSbs.
+      BitsRope rope(node->BitCountOrDie());
+      for (int64 i = instruction.operand_count - 1; i >= 0; --i) {
+        rope.push_back(bits_operand(i));
+      }
+      set_bits(rope.Build());
+      break;
+    }
+    case Op::kDecode: {
+      XLS_ASSIGN_OR_RETURN(uint64 index, bits_operand(0).ToUint64());
+      int64 width = node->BitCountOrDie();
+      set_bits(index < static_cast<uint64>(width)
+                   ? Bits::PowerOfTwo(index, width)
+                   : Bits(width));
+      break;
+    }
+    case Op::kOneHot:
+      set_bits(node->As<OneHot>()->priority() == LsbOrMsb::kLsb
+                   ? bits_ops::OneHotLsbToMsb(bits_operand(0))
+                   : bits_ops::OneHotMsbToLsb(bits_operand(0)));
+      break;
+    case Op::kOneHotSel: {
+      if (!node->GetType()->IsBits()) {
+        return ExecuteGeneric(instruction);
+      }
+      const Bits& selector = bits_operand(0);
+      Bits accum(node->BitCountOrDie());
+      for (int64 i = 0; i < selector.bit_count(); ++i) {
+        if (selector.Get(i)) {
+          accum = bits_ops::Or(accum, bits_operand(i + 1));
+        }
+      }
+      set_bits(std::move(accum));
+      break;
+    }
+    case Op::kSel: {
+      const Bits& selector = bits_operand(0);
+      int64 case_count = node->As<Select>()->cases().size();
+      if (bits_ops::UGreaterThan(selector,
+                                 UBits(case_count - 1, selector.bit_count()))) {
+        XLS_RET_CHECK(node->As<Select>()->default_value().has_value());
+        result = operand(instruction, instruction.operand_count - 1);
+      } else {
+        XLS_ASSIGN_OR_RETURN(uint64 i, selector.ToUint64());
+        result = operand(instruction, i + 1);
+      }
+      break;
+    }
+    case Op::kIdentity:
+      result = operand(instruction, 0);
+      break;
+    case Op::kTuple: {
+      std::vector<Value> elements;
+      elements.reserve(instruction.operand_count);
+      for (int64 i = 0; i < instruction.operand_count; ++i) {
+        elements.push_back(operand(instruction, i));
+      }
+      result = Value::TupleOwned(std::move(elements));
+      break;
+    }
+    case Op::kTupleIndex:
+      result = operand(instruction, 0).element(node->As<TupleIndex>()->index());
+      break;
+    case Op::kArray: {
+      std::vector<Value> elements;
+      elements.reserve(instruction.operand_count);
+      for (int64 i = 0; i < instruction.operand_count; ++i) {
+        elements.push_back(operand(instruction, i));
+      }
+      XLS_ASSIGN_OR_RETURN(result, Value::Array(elements));
+      break;
+    }
+    case Op::kArrayIndex: {
+      const Value& array = operand(instruction, 0);
+      // Out-of-bounds accesses are clamped to the highest index.
+      uint64 i = OperandAsBoundedUint64(instruction, 1, array.size() - 1);
+      result = array.element(i);
+      break;
+    }
+    case Op::kArrayUpdate: {
+      const Value& array = operand(instruction, 0);
+      uint64 index = OperandAsBoundedUint64(instruction, 1, array.size());
+      // Out-of-bounds accesses have no effect.
+      if (index >= array.size()) {
+        result = array;
+        break;
+      }
+      std::vector<Value> elements(array.elements().begin(),
+                                  array.elements().end());
+      elements[index] = operand(instruction, 2);
+      XLS_ASSIGN_OR_RETURN(result, Value::Array(elements));
+      break;
+    }
+    case Op::kInvoke: {
+      std::vector<Value> args;
+      args.reserve(instruction.operand_count);
+      for (int64 i = 0; i < instruction.operand_count; ++i) {
+        args.push_back(operand(instruction, i));
+      }
+      XLS_ASSIGN_OR_RETURN(result, instruction.callee->Run(args));
+      break;
+    }
+    case Op::kMap: {
+      std::vector<Value> elements;
+      for (const Value& element : operand(instruction, 0).elements()) {
+        XLS_ASSIGN_OR_RETURN(
+            Value mapped,
+            instruction.callee->Run(absl::MakeConstSpan(&element, 1)));
+        elements.push_back(std::move(mapped));
+      }
+      XLS_ASSIGN_OR_RETURN(result, Value::Array(elements));
+      break;
+    }
+    case Op::kCountedFor: {
+      CountedFor* counted_for = node->As<CountedFor>();
+      int64 iv_width =
+          counted_for->body()->param(0)->GetType()->AsBitsOrDie()->bit_count();
+      // Parameters of the body are the induction variable, the loop state and
+      // then the loop invariants (operands 1 and on).
+      std::vector<Value> args(instruction.operand_count + 1);
+      args[1] = operand(instruction, 0);
+      for (int64 i = 1; i < instruction.operand_count; ++i) {
+        args[i + 1] = operand(instruction, i);
+      }
+      for (int64 i = 0, iv = 0; i < counted_for->trip_count();
+           ++i, iv += counted_for->stride()) {
+        args[0] = Value(UBits(iv, iv_width));
+        XLS_ASSIGN_OR_RETURN(args[1], instruction.callee->Run(args));
+      }
+      result = std::move(args[1]);
+      break;
+    }
+    case Op::kAfterAll:
+      result = Value::Token();
+      break;
+    default:
+      // E.g., encode and channel operations.
+      return ExecuteGeneric(instruction);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace xls
@@ -0,0 +1,127 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_BYTECODE_INTERPRETER_H_
+#define XLS_IR_BYTECODE_INTERPRETER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// An IR interpreter for repeatedly evaluating the same function, e.g., when
+// fuzzing on hosts without the JIT. Create() does the work that
+// ir_interpreter::Run() repeats on every call: it orders the nodes which
+// contribute to the return value once, assigns each a dense "slot" index, and
+// compiles them into a flat array of instructions over a preallocated vector
+// of Value slots. Run() then just executes the instructions in order, with no
+// graph traversal or hashing; literals are materialized once, at creation.
+//
+// Results are identical to ir_interpreter::Run(). Run() reuses the object's
+// slots, so a BytecodeInterpreter must not be used by more than one thread at a
+// time; create one per thread instead.
+class BytecodeInterpreter {
+ public:
+  // Compiles "function", and (recursively) the functions it invokes, maps or
+  // loops over.
+  static xabsl::StatusOr<std::unique_ptr<BytecodeInterpreter>> Create(
+      Function* function);
+
+  // Evaluates the function with the given (positional) arguments.
+  xabsl::StatusOr<Value> Run(absl::Span<const Value> args);
+
+  // As above, but with arguments as key-value pairs.
+  xabsl::StatusOr<Value> RunKwargs(
+      const absl::flat_hash_map<std::string, Value>& kwargs);
+
+  Function* function() const { return function_; }
+
+  // Returns the number of instructions executed by each call to Run() (i.e.,
+  // excluding those of any callees).
+  int64 instruction_count() const { return instructions_.size(); }
+
+ private:
+  // A single compiled node. Operands are the slots
+  // operand_slots_[operands_begin, operands_begin + operand_count).
+  struct Instruction {
+    Op op;
+    Node* node;
+    int64 result_slot;
+    int64 operands_begin;
+    int64 operand_count;
+    // The compiled function for invoke, map and counted_for; nullptr
+    // otherwise.
+    BytecodeInterpreter* callee;
+  };
+
+  explicit BytecodeInterpreter(Function* function) : function_(function) {}
+
+  // Compiles the function into instructions_, creating callees as needed.
+  absl::Status Compile();
+
+  // Returns the compiled interpreter for "function", creating it on first use.
+  xabsl::StatusOr<BytecodeInterpreter*> GetCallee(Function* function);
+
+  absl::Status Execute(const Instruction& instruction);
+
+  // Evaluates the instruction via ir_interpreter::EvaluateNode(); used for
+  // rarely-seen ops and operand types with no specialized implementation.
+  absl::Status ExecuteGeneric(const Instruction& instruction);
+
+  // Returns the value of the "i"-th operand of "instruction".
+  const Value& operand(const Instruction& instruction, int64 i) const {
+    return slots_[operand_slots_[instruction.operands_begin + i]];
+  }
+  const Bits& operand_bits(const Instruction& instruction, int64 i) const {
+    return operand(instruction, i).bits();
+  }
+
+  // Returns the "i"-th operand as a uint64, clamped to "upper_limit".
+  uint64 OperandAsBoundedUint64(const Instruction& instruction, int64 i,
+                                uint64 upper_limit) const;
+
+  // Returns the bits-typed operands of "instruction" combined left to right
+  // with the binary operation "f" (e.g., bits_ops::And).
+  Bits FoldOperands(const Instruction& instruction,
+                    Bits (*f)(const Bits&, const Bits&)) const;
+
+  Function* function_;
+  std::vector<Instruction> instructions_;
+  std::vector<int64> operand_slots_;
+
+  // The value of every node contributing to the return value, indexed by slot.
+  std::vector<Value> slots_;
+  // The slot of each parameter, in parameter order. Parameters which do not
+  // contribute to the return value have no slot (-1).
+  std::vector<int64> param_slots_;
+  int64 return_slot_;
+
+  std::vector<std::unique_ptr<BytecodeInterpreter>> callees_;
+  absl::flat_hash_map<Function*, BytecodeInterpreter*> callee_by_function_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_BYTECODE_INTERPRETER_H_
@@ -0,0 +1,142 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the throughput of the bytecode interpreter against
+// ir_interpreter::Run() on the sample packages, and checks that they agree.
+
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/bytecode_interpreter.h"
+#include "xls/ir/ir_interpreter.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_helpers.h"
+
+const char* kUsage = R"(
+Measures the throughput of the bytecode interpreter relative to the
+tree-walking IR interpreter on the entry functions of sample packages. Usage:
+
+   bytecode_interpreter_benchmark --benchmarks=sha256,crc32
+)";
+
+ABSL_FLAG(std::vector<std::string>, benchmarks, {"all"},
+          "Comma-separated list of sample packages to measure, or \"all\".");
+ABSL_FLAG(int64, samples, 64, "Number of random argument sets per package.");
+ABSL_FLAG(absl::Duration, min_time, absl::Milliseconds(500),
+          "Minimum time to spend measuring each evaluator on each package.");
+
+namespace xls {
+namespace {
+
+// Returns the average time per evaluation of "f" over all samples.
+xabsl::StatusOr<absl::Duration> TimeEvaluator(
+    const std::function<xabsl::StatusOr<Value>(absl::Span<const Value>)>& f,
+    absl::Span<const std::vector<Value>> samples) {
+  absl::Duration min_time = absl::GetFlag(FLAGS_min_time);
+  int64 runs = 0;
+  absl::Time start = absl::Now();
+  absl::Duration elapsed;
+  do {
+    for (const std::vector<Value>& args : samples) {
+      XLS_RETURN_IF_ERROR(f(args).status());
+    }
+    runs += samples.size();
+    elapsed = absl::Now() - start;
+  } while (elapsed < min_time);
+  return elapsed / runs;
+}
+
+absl::Status RunBenchmark(const std::string& name) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       sample_packages::GetBenchmark(name, /*optimized=*/true));
+  XLS_ASSIGN_OR_RETURN(Function * function, package->EntryFunction());
+
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeInterpreter> interpreter,
+                       BytecodeInterpreter::Create(function));
+  absl::Duration compile_time = absl::Now() - start;
+
+  std::minstd_rand bitgen;
+  std::vector<std::vector<Value>> samples;
+  for (int64 i = 0; i < absl::GetFlag(FLAGS_samples); ++i) {
+    samples.push_back(RandomFunctionArguments(function, &bitgen));
+  }
+  for (const std::vector<Value>& args : samples) {
+    XLS_ASSIGN_OR_RETURN(Value expected, ir_interpreter::Run(function, args));
+    XLS_ASSIGN_OR_RETURN(Value actual, interpreter->Run(args));
+    XLS_RET_CHECK_EQ(actual, expected) << "Mismatch evaluating " << name;
+  }
+
+  XLS_ASSIGN_OR_RETURN(
+      absl::Duration tree_time,
+      TimeEvaluator(
+          [&](absl::Span<const Value> args) {
+            return ir_interpreter::Run(function, args);
+          },
+          samples));
+  XLS_ASSIGN_OR_RETURN(
+      absl::Duration bytecode_time,
+      TimeEvaluator(
+          [&](absl::Span<const Value> args) { return interpreter->Run(args); },
+          samples));
+  std::cout << absl::StreamFormat(
+      "%-40s %6d %12s %14s %14s %8.2fx\n", name, function->node_count(),
+      absl::FormatDuration(compile_time), absl::FormatDuration(tree_time),
+      absl::FormatDuration(bytecode_time),
+      absl::FDivDuration(tree_time, bytecode_time));
+  return absl::OkStatus();
+}
+
+absl::Status RealMain() {
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_samples), 0);
+  std::vector<std::string> names = absl::GetFlag(FLAGS_benchmarks);
+  if (names.size() == 1 && names.front() == "all") {
+    XLS_ASSIGN_OR_RETURN(names, sample_packages::GetBenchmarkNames());
+  }
+  std::cout << absl::StreamFormat("%-40s %6s %12s %14s %14s %9s\n", "benchmark",
+                                  "nodes", "compile", "interpreter",
+                                  "bytecode", "speedup");
+  for (const std::string& name : names) {
+    XLS_RETURN_IF_ERROR(RunBenchmark(name));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/bytecode_interpreter.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ir_evaluator_test.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+INSTANTIATE_TEST_SUITE_P(
+    BytecodeInterpreterTest, IrEvaluatorTest,
+    testing::Values(IrEvaluatorTestParam(
+        [](Function* function,
+           const std::vector<Value>& args) -> xabsl::StatusOr<Value> {
+          XLS_ASSIGN_OR_RETURN(auto interpreter,
+                               BytecodeInterpreter::Create(function));
+          return interpreter->Run(args);
+        },
+        [](Function* function,
+           const absl::flat_hash_map<std::string, Value>& kwargs)
+            -> xabsl::StatusOr<Value> {
+          XLS_ASSIGN_OR_RETURN(auto interpreter,
+                               BytecodeInterpreter::Create(function));
+          return interpreter->RunKwargs(kwargs);
+        })));
+
+// Fixture for BytecodeInterpreter-only tests (i.e., those that aren't common to
+// all IR evaluators).
+class BytecodeInterpreterOnlyTest : public IrTestBase {};
+
+TEST_F(BytecodeInterpreterOnlyTest, RepeatedRuns) {
+  Package package("my_package");
+  std::string fn_text = R"(
+    fn f(x: bits[8], y: bits[8]) -> (bits[8], bits[16]) {
+      literal.1: bits[8] = literal(value=3)
+      add.2: bits[8] = add(x, literal.1)
+      umul.3: bits[16] = umul(add.2, y)
+      ret tuple.4: (bits[8], bits[16]) = tuple(add.2, umul.3)
+    }
+    )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(fn_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto interpreter,
+                           BytecodeInterpreter::Create(function));
+  EXPECT_EQ(interpreter->instruction_count(), 3);
+  for (int64 x = 0; x < 256; x += 17) {
+    for (int64 y = 0; y < 256; y += 23) {
+      EXPECT_THAT(
+          interpreter->Run({Value(UBits(x, 8)), Value(UBits(y, 8))}),
+          IsOkAndHolds(Value::Tuple({Value(UBits((x + 3) % 256, 8)),
+                                     Value(UBits((x + 3) % 256 * y, 16))})));
+    }
+  }
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, DeadNodesAreNotEvaluated) {
+  Package package("my_package");
+  // Decoding a value which doesn't fit in 64 bits is an error, but the decode
+  // does not contribute to the result.
+  std::string fn_text = R"(
+    fn f(x: bits[100]) -> bits[100] {
+      decode.1: bits[4] = decode(x, width=4)
+      ret not.2: bits[100] = not(x)
+    }
+    )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(fn_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto interpreter,
+                           BytecodeInterpreter::Create(function));
+  EXPECT_EQ(interpreter->instruction_count(), 1);
+  EXPECT_THAT(interpreter->Run({Value(Bits::AllOnes(100))}),
+              IsOkAndHolds(Value(Bits(100))));
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, WrongArguments) {
+  Package package("my_package");
+  std::string fn_text = R"(
+    fn f(x: bits[8]) -> bits[8] {
+      ret neg.1: bits[8] = neg(x)
+    }
+    )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(fn_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto interpreter,
+                           BytecodeInterpreter::Create(function));
+  EXPECT_FALSE(interpreter->Run(std::vector<Value>()).ok());
+  EXPECT_FALSE(interpreter->Run({Value(UBits(1, 4))}).ok());
+}
+
+}  // namespace
+}  // namespace xls
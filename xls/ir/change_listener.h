@@ -0,0 +1,51 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_CHANGE_LISTENER_H_
+#define XLS_IR_CHANGE_LISTENER_H_
+
+namespace xls {
+
+class Function;
+class Node;
+
+// Interface for objects which are notified of changes to the nodes of a
+// function, e.g., to keep an analysis up to date without recomputing it from
+// scratch. Register with Function::RegisterChangeListener. Notifications are
+// delivered synchronously, possibly while the graph is part way through a
+// larger transformation, so listeners should record what changed rather than
+// inspect the rest of the graph.
+class ChangeListener {
+ public:
+  virtual ~ChangeListener() = default;
+
+  // Called after "node" has been added to the function.
+  virtual void NodeAdded(Node* node) {}
+
+  // Called before "node" is removed from the function.
+  virtual void NodeDeleted(Node* node) {}
+
+  // Called after one or more operands of "node" have changed. "old_operand" is
+  // the operand which was replaced, or nullptr if operands were only
+  // reordered.
+  virtual void OperandChanged(Node* node, Node* old_operand) {}
+
+  // Called after the return value of "function" has changed.
+  virtual void ReturnValueChanged(Function* function, Node* old_return_value) {
+  }
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_CHANGE_LISTENER_H_
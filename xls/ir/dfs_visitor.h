@@ -109,6 +109,13 @@ class DfsVisitor {
     traversing_.clear();
   }
 
+  // Sizes the traversal state for "node_count" nodes, so a traversal of that
+  // many nodes doesn't rehash it.
+  void ReserveVisitedState(int64 node_count) {
+    visited_.reserve(node_count);
+    traversing_.reserve(node_count);
+  }
+
  private:
   // Set of nodes which have been visited.
   absl::flat_hash_set<Node*> visited_;
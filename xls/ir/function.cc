@@ -27,6 +27,14 @@ using absl::StrAppend;
 
 namespace xls {
 
+Function::~Function() {
+  for (Node* node : node_slots_) {
+    if (node != nullptr) {
+      DeleteNode(node);
+    }
+  }
+}
+
 std::string Function::DumpIr(bool recursive) const {
   std::string nested_funcs = "";
   std::string res = "fn " + name() + "(";
@@ -130,19 +138,67 @@ absl::Status Function::RemoveNode(Node* node, bool remove_param_ok) {
   }
   for (Node* operand : unique_operands) {
     operand->RemoveUser(node);
+    MarkDirty(operand);
+  }
+  XLS_RET_CHECK(node->node_index() < node_slots_.size() &&
+                node_slots_[node->node_index()] == node);
+  for (ChangeListener* listener : change_listeners_) {
+    listener->NodeDeleted(node);
   }
-  auto node_it = node_iterators_.find(node);
-  XLS_RET_CHECK(node_it != node_iterators_.end());
-  nodes_.erase(node_it->second);
-  node_iterators_.erase(node_it);
+  node_slots_[node->node_index()] = nullptr;
+  if (tracking_dirty_nodes_) {
+    dirty_nodes_.erase(node);
+  }
+  --node_count_;
+  ++modification_epoch_;
   if (remove_param_ok) {
     params_.erase(std::remove(params_.begin(), params_.end(), node),
                   params_.end());
   }
+  DeleteNode(node);
 
   return absl::OkStatus();
 }
 
+void Function::CompactNodeIndices() {
+  if (node_count_ == node_slots_.size()) {
+    return;
+  }
+  int64 next_index = 0;
+  for (Node* node : node_slots_) {
+    if (node != nullptr) {
+      node->node_index_ = next_index;
+      node_slots_[next_index++] = node;
+    }
+  }
+  node_slots_.resize(next_index);
+  ++node_index_generation_;
+}
+
+void Function::AddNodeInternal(Node* node) {
+  if (node->Is<Param>()) {
+    params_.push_back(node->As<Param>());
+  }
+  node->node_index_ = node_slots_.size();
+  node_slots_.push_back(node);
+  MarkDirty(node);
+  ++node_count_;
+  ++modification_epoch_;
+  for (ChangeListener* listener : change_listeners_) {
+    listener->NodeAdded(node);
+  }
+}
+
+void Function::DeleteNode(Node* node) {
+  int64 arena_size = node->arena_size_;
+  if (arena_size == 0) {
+    delete node;
+    return;
+  }
+  node->~Node();
+  node_arena_.Deallocate(node, arena_size);
+}
+
 absl::Status Function::Accept(DfsVisitor* visitor) {
   for (Node* node : nodes()) {
     if (node->users().empty()) {
@@ -15,20 +15,27 @@
 #ifndef XLS_IR_FUNCTION_H_
 #define XLS_IR_FUNCTION_H_
 
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/statusor.h"
+#include "xls/ir/change_listener.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/node.h"
+#include "xls/ir/node_arena.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
-#include "xls/ir/unwrapping_iterator.h"
 #include "xls/ir/verifier.h"
 
 namespace xls {
@@ -38,14 +45,54 @@ namespace xls {
 // * Functions are composed out of nodes (that represent expressions).
 // * Functions are owned by packages that contain them.
 class Function {
- private:
-  using NodeList = std::list<std::unique_ptr<Node>>;
-
  public:
+  // Iterates over the nodes of a function in the order they were added. Nodes
+  // added during the iteration are visited, and nodes removed during the
+  // iteration are skipped.
+  class NodeSlotIterator
+      : public std::iterator<std::forward_iterator_tag, Node*> {
+   public:
+    NodeSlotIterator(const std::vector<Node*>* slots, int64 index)
+        : slots_(slots), index_(index) {
+      SkipRemoved();
+    }
+
+    Node* operator*() const { return (*slots_)[index_]; }
+    NodeSlotIterator& operator++() {
+      ++index_;
+      SkipRemoved();
+      return *this;
+    }
+    NodeSlotIterator operator++(int) {
+      NodeSlotIterator temp = *this;
+      operator++();
+      return temp;
+    }
+    bool operator==(const NodeSlotIterator& other) const {
+      return AtEnd() ? other.AtEnd()
+                     : !other.AtEnd() && index_ == other.index_;
+    }
+    bool operator!=(const NodeSlotIterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    bool AtEnd() const { return index_ >= slots_->size(); }
+    void SkipRemoved() {
+      while (!AtEnd() && (*slots_)[index_] == nullptr) {
+        ++index_;
+      }
+    }
+
+    const std::vector<Node*>* slots_;
+    int64 index_;
+  };
+
   explicit Function(absl::string_view name, Package* package)
       : name_(name),
         qualified_name_(absl::StrCat(package->name(), "::", name_)),
         package_(package) {}
+  ~Function();
 
   Package* package() const { return package_; }
   const std::string& name() const { return name_; }
@@ -59,7 +106,17 @@ class Function {
 
   // Returns the node that serves as the return value of this function.
   Node* return_value() const { return return_value_; }
-  void set_return_value(Node* n) { return_value_ = n; }
+  void set_return_value(Node* n) {
+    Node* old_return_value = return_value_;
+    return_value_ = n;
+    ++modification_epoch_;
+    if (n != nullptr) {
+      MarkDirty(n);
+    }
+    for (ChangeListener* listener : change_listeners_) {
+      listener->ReturnValueChanged(this, old_return_value);
+    }
+  }
 
   FunctionType* GetType();
 
@@ -74,39 +131,64 @@ class Function {
 
   xabsl::StatusOr<int64> GetParamIndex(Param* param) const;
 
-  int64 node_count() const { return nodes_.size(); }
+  int64 node_count() const { return node_count_; }
+
+  // Returns an upper bound (exclusive) on the node indices of the nodes of this
+  // function (see Node::node_index). Side tables indexed by node index, such as
+  // NodeMap, need this many entries.
+  int64 node_index_limit() const { return node_slots_.size(); }
+
+  // Returns the number of times the node indices have been compacted. Side
+  // tables indexed by node index are invalidated when this changes.
+  int64 node_index_generation() const { return node_index_generation_; }
+
+  // Renumbers the node indices to 0 ... node_count() - 1, in the order of
+  // nodes(), reclaiming the indices of removed nodes. Invalidates side tables
+  // indexed by node index if any node was removed since the last compaction,
+  // so it must not be called during an iteration over nodes().
+  void CompactNodeIndices();
 
   // Expose Nodes, so that transformation passes can operate
   // on this function.
-  xabsl::iterator_range<UnwrappingIterator<NodeList::iterator>> nodes() {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
+  xabsl::iterator_range<NodeSlotIterator> nodes() {
+    return xabsl::make_range(
+        NodeSlotIterator(&node_slots_, 0),
+        NodeSlotIterator(&node_slots_, std::numeric_limits<int64>::max()));
   }
 
-  // Adds a node to the set owned by this function.
+  // Adds a heap-allocated node to the set owned by this function.
   template <typename T>
   T* AddNode(std::unique_ptr<T> n) {
-    if (n->template Is<Param>()) {
-      params_.push_back(n->template As<Param>());
-    }
-    T* ptr = n.get();
-    node_iterators_[ptr] = nodes_.insert(nodes_.end(), std::move(n));
+    T* ptr = n.release();
+    AddNodeInternal(ptr);
     return ptr;
   }
 
-  // Creates a new node and adds it to the function. NodeT is the node subclass
-  // (e.g., 'Param') and the variadic args are the constructor arguments with
-  // the exception of the final Function* argument. This method verifies the
-  // newly constructed node after it is added to the function. Returns a pointer
-  // to the newly constructed node.
+  // Creates a new node in the arena of this function and adds it to the
+  // function. NodeT is the node subclass (e.g., 'Param') and the variadic args
+  // are the constructor arguments with the exception of the final Function*
+  // argument. Returns a pointer to the newly constructed node.
+  template <typename NodeT, typename... Args>
+  NodeT* NewNode(Args&&... args) {
+    void* memory = node_arena_.Allocate(sizeof(NodeT));
+    NodeT* new_node = new (memory) NodeT(std::forward<Args>(args)..., this);
+    new_node->arena_size_ = sizeof(NodeT);
+    AddNodeInternal(new_node);
+    return new_node;
+  }
+
+  // As NewNode, but also verifies the newly constructed node after it is added
+  // to the function.
   template <typename NodeT, typename... Args>
   xabsl::StatusOr<NodeT*> MakeNode(Args&&... args) {
-    NodeT* new_node =
-        AddNode(absl::make_unique<NodeT>(std::forward<Args>(args)..., this));
+    NodeT* new_node = NewNode<NodeT>(std::forward<Args>(args)...);
     XLS_RETURN_IF_ERROR(Verify(new_node));
     return new_node;
   }
 
+  // Returns the arena holding the nodes created by NewNode and MakeNode.
+  const NodeArena& node_arena() const { return node_arena_; }
+
   // Find a node by it's name, as generated by DumpIr.
   xabsl::StatusOr<Node*> GetNode(absl::string_view standard_node_name);
 
@@ -133,26 +215,112 @@ class Function {
   // conservative and false may be returned for some "equivalent" functions.
   bool IsDefinitelyEqualTo(const Function* other) const;
 
+  // Registers "listener" to be notified of changes to the nodes of this
+  // function until it is unregistered. The listener is not owned, and must be
+  // unregistered before it is destroyed.
+  void RegisterChangeListener(ChangeListener* listener) {
+    change_listeners_.push_back(listener);
+  }
+  void UnregisterChangeListener(ChangeListener* listener) {
+    change_listeners_.erase(absl::c_find(change_listeners_, listener));
+  }
+  absl::Span<ChangeListener* const> change_listeners() const {
+    return change_listeners_;
+  }
+
+  // Returns a counter which is incremented whenever a node is added or
+  // removed, the operands of a node change, or the return value changes.
+  // Results computed from the graph of the function, such as the topological
+  // order cached for TopoSort, remain valid while the epoch is unchanged.
+  int64 modification_epoch() const { return modification_epoch_; }
+
+  // Starts recording dirty nodes, with none dirty. Tracking costs a hash set
+  // insertion per change, so it is off until VerifyIncremental needs it.
+  void StartTrackingDirtyNodes() {
+    tracking_dirty_nodes_ = true;
+    dirty_nodes_.clear();
+  }
+  bool tracking_dirty_nodes() const { return tracking_dirty_nodes_; }
+
+  // Returns the nodes which may have changed since tracking started or the
+  // last call to ClearDirtyNodes: nodes which were added, whose operands
+  // changed, which lost a user, or which became the return value.
+  // VerifyIncremental verifies only these nodes.
+  const absl::flat_hash_set<Node*>& dirty_nodes() const {
+    return dirty_nodes_;
+  }
+  void ClearDirtyNodes() { dirty_nodes_.clear(); }
+
  private:
+  // Node notifies the function of operand changes (and marks the changed
+  // nodes dirty), and NodeIterator keeps its topological order in
+  // topo_sort_cache_.
+  friend class Node;
+  friend class NodeIterator;
+
+  // Topological orders of the nodes, valid if "epoch" is the modification
+  // epoch of the function. The orders are shared with the NodeIterators
+  // created from them. Guarded by a mutex as functions may be traversed by
+  // several threads at once (e.g., callees of functions optimized in
+  // parallel).
+  struct TopoSortCache {
+    absl::Mutex mutex;
+    int64 epoch ABSL_GUARDED_BY(mutex) = -1;
+    std::shared_ptr<const std::vector<Node*>> order ABSL_GUARDED_BY(mutex);
+    std::shared_ptr<const std::vector<Node*>> reverse_order
+        ABSL_GUARDED_BY(mutex);
+  };
+
   Function(const Function& other) = delete;
   void operator=(const Function& other) = delete;
 
+  void AddNodeInternal(Node* node);
+
+  // Destroys "node" and frees its memory.
+  void DeleteNode(Node* node);
+
+  // Adds "node" to dirty_nodes_ if dirty nodes are being tracked.
+  void MarkDirty(Node* node) {
+    if (tracking_dirty_nodes_) {
+      dirty_nodes_.insert(node);
+    }
+  }
+
   std::string name_;
   std::string qualified_name_;
   Package* package_;
 
-  // Store Nodes in std::list as they can be added and removed arbitrarily and
-  // we want a stable iteration order. Keep a map from instruction pointer to
-  // location in the list for fast lookup.
-  NodeList nodes_;
-  absl::flat_hash_map<const Node*, NodeList::iterator> node_iterators_;
+  NodeArena node_arena_;
+
+  // The nodes of the function indexed by node index, in the order they were
+  // added, with nullptr in the slots of removed nodes. This keeps a stable
+  // iteration order and makes removal O(1).
+  std::vector<Node*> node_slots_;
+  int64 node_count_ = 0;
+  int64 node_index_generation_ = 0;
 
   std::vector<Param*> params_;
   Node* return_value_ = nullptr;
+
+  std::vector<ChangeListener*> change_listeners_;
+
+  int64 modification_epoch_ = 0;
+  mutable TopoSortCache topo_sort_cache_;
+
+  bool tracking_dirty_nodes_ = false;
+  absl::flat_hash_set<Node*> dirty_nodes_;
 };
 
 std::ostream& operator<<(std::ostream& os, const Function& function);
 
+template <typename NodeT, typename... Args>
+xabsl::StatusOr<NodeT*> Node::ReplaceUsesWithNew(Args&&... args) {
+  NodeT* new_node =
+      function()->NewNode<NodeT>(loc(), std::forward<Args>(args)...);
+  XLS_RETURN_IF_ERROR(VerifyAndReplaceUsesWith(new_node));
+  return new_node;
+}
+
 }  // namespace xls
 
 #endif  // XLS_IR_FUNCTION_H_
@@ -0,0 +1,180 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the memory footprint of a large function and the time to traverse
+// it and to fill and query side tables keyed by its nodes.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/node_map.h"
+#include "xls/ir/package.h"
+
+const char* kUsage = R"(
+Measures the memory footprint of a generated function with about --nodes nodes
+and the time to traverse it (in insertion and topological order) and to fill
+and query a side table keyed by its nodes, using NodeMap and, for comparison,
+absl::flat_hash_map. Usage:
+
+   function_benchmark --nodes=1000000
+)";
+
+ABSL_FLAG(int64, nodes, 1000000, "Approximate number of nodes.");
+ABSL_FLAG(int64, runs, 3,
+          "Number of times to run each traversal; the fastest run is "
+          "reported.");
+
+namespace xls {
+namespace {
+
+// Builds a function of layers of adds and xors, each node using two nodes of
+// the previous layer so no node has many users.
+xabsl::StatusOr<Function*> BuildFunction(int64 node_count, Package* package) {
+  constexpr int64 kWidth = 64;
+  FunctionBuilder fb("big", package);
+  std::vector<BValue> layer;
+  for (int64 i = 0; i < kWidth; ++i) {
+    layer.push_back(
+        fb.Param(absl::StrFormat("p%d", i), package->GetBitsType(32)));
+  }
+  for (int64 depth = 0; (depth + 1) * kWidth < node_count; ++depth) {
+    std::vector<BValue> next;
+    for (int64 i = 0; i < kWidth; ++i) {
+      BValue a = layer[i];
+      BValue b = layer[(i + depth + 1) % kWidth];
+      next.push_back(i % 2 == 0 ? fb.Add(a, b) : fb.Xor(a, b));
+    }
+    layer = std::move(next);
+  }
+  BValue result = layer[0];
+  for (int64 i = 1; i < kWidth; ++i) {
+    result = fb.Or(result, layer[i]);
+  }
+  return fb.BuildWithReturnValue(result);
+}
+
+// Returns the fastest of --runs calls of "f".
+template <typename F>
+absl::Duration Time(F f) {
+  absl::Duration best = absl::InfiniteDuration();
+  for (int64 i = 0; i < absl::GetFlag(FLAGS_runs); ++i) {
+    absl::Time start = absl::Now();
+    f();
+    best = std::min(best, absl::Now() - start);
+  }
+  return best;
+}
+
+// Computes the depth of each node in a side table of type MapT, and returns
+// the sum of the depths of the operands of all nodes.
+template <typename MapT>
+int64 SumOperandDepths(const std::vector<Node*>& topo_sort, MapT* depth) {
+  for (Node* node : topo_sort) {
+    int64 node_depth = 0;
+    for (Node* operand : node->operands()) {
+      node_depth = std::max(node_depth, (*depth)[operand] + 1);
+    }
+    (*depth)[node] = node_depth;
+  }
+  int64 sum = 0;
+  for (Node* node : topo_sort) {
+    for (Node* operand : node->operands()) {
+      sum += depth->at(operand);
+    }
+  }
+  return sum;
+}
+
+absl::Status RealMain() {
+  const int64 node_count = absl::GetFlag(FLAGS_nodes);
+  XLS_RET_CHECK_GT(node_count, 0);
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_runs), 0);
+
+  Package package("function_benchmark");
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(Function * f, BuildFunction(node_count, &package));
+  absl::Duration build_time = absl::Now() - start;
+  std::cout << absl::StreamFormat(
+      "Nodes: %d, build time: %s\n"
+      "Node arena: %d bytes allocated, %d bytes reserved (%.1f bytes/node)\n",
+      f->node_count(), absl::FormatDuration(build_time),
+      f->node_arena().allocated_bytes(), f->node_arena().reserved_bytes(),
+      static_cast<double>(f->node_arena().allocated_bytes()) /
+          f->node_count());
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    std::cout << "Peak RSS (KiB): " << usage.ru_maxrss << "\n";
+  }
+
+  int64 id_sum = 0;
+  absl::Duration nodes_time = Time([&] {
+    for (Node* node : f->nodes()) {
+      id_sum += node->id();
+    }
+  });
+  std::vector<Node*> topo_sort;
+  absl::Duration topo_sort_time = Time([&] {
+    auto topo_sort_range = TopoSort(f);
+    topo_sort.assign(topo_sort_range.begin(), topo_sort_range.end());
+  });
+  std::cout << absl::StreamFormat("nodes(): %s, TopoSort: %s\n",
+                                  absl::FormatDuration(nodes_time),
+                                  absl::FormatDuration(topo_sort_time));
+
+  int64 node_map_sum = 0;
+  absl::Duration node_map_time = Time([&] {
+    NodeMap<int64> depth(f);
+    node_map_sum = SumOperandDepths(topo_sort, &depth);
+  });
+  int64 hash_map_sum = 0;
+  absl::Duration hash_map_time = Time([&] {
+    absl::flat_hash_map<Node*, int64> depth;
+    hash_map_sum = SumOperandDepths(topo_sort, &depth);
+  });
+  XLS_RET_CHECK_EQ(node_map_sum, hash_map_sum);
+  std::cout << absl::StreamFormat(
+      "Side table fill and lookup: NodeMap %s, flat_hash_map %s\n",
+      absl::FormatDuration(node_map_time), absl::FormatDuration(hash_map_time));
+  XLS_VLOG(1) << "Checksum: " << id_sum;
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
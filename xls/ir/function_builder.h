@@ -418,8 +418,7 @@ class FunctionBuilder {
   // BValue.
   template <typename NodeT, typename... Args>
   BValue AddNode(Args&&... args) {
-    last_node_ = function_->AddNode<NodeT>(
-        absl::make_unique<NodeT>(std::forward<Args>(args)..., function_.get()));
+    last_node_ = function_->NewNode<NodeT>(std::forward<Args>(args)...);
     return BValue(last_node_, this);
   }
 
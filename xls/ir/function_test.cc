@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
@@ -26,6 +27,7 @@ namespace {
 using status_testing::StatusIs;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
 
 class FunctionTest : public IrTestBase {};
 
@@ -166,5 +168,194 @@ fn id(x: bits[16], y: bits[32]) -> bits[16] {
                          "match type of xor")));
 }
 
+// Records the change notifications of a function as strings.
+class RecordingListener : public ChangeListener {
+ public:
+  void NodeAdded(Node* node) override {
+    events_.push_back(absl::StrCat("added ", node->GetName()));
+  }
+  void NodeDeleted(Node* node) override {
+    events_.push_back(absl::StrCat("deleted ", node->GetName()));
+  }
+  void OperandChanged(Node* node, Node* old_operand) override {
+    events_.push_back(absl::StrCat(
+        "operand of ", node->GetName(), " was ",
+        old_operand == nullptr ? "swapped" : old_operand->GetName()));
+  }
+  void ReturnValueChanged(Function* function, Node* old_return_value) override {
+    events_.push_back(
+        absl::StrCat("return value was ", old_return_value->GetName()));
+  }
+
+  const std::vector<std::string>& events() const { return events_; }
+
+ private:
+  std::vector<std::string> events_;
+};
+
+TEST_F(FunctionTest, ChangeListener) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  sub.3: bits[8] = sub(x, y)
+  ret neg.4: bits[8] = neg(sub.3)
+}
+)",
+                                                          p.get()));
+  RecordingListener listener;
+  func->RegisterChangeListener(&listener);
+  Node* sub = FindNode("sub.3", func);
+  Node* neg = FindNode("neg.4", func);
+  XLS_ASSERT_OK_AND_ASSIGN(Node * add,
+                           sub->ReplaceUsesWithNew<BinOp>(
+                               FindNode("x", func), FindNode("y", func),
+                               Op::kAdd));
+  add->SwapOperands(0, 1);
+  XLS_ASSERT_OK(func->RemoveNode(sub));
+  XLS_ASSERT_OK(neg->ReplaceUsesWith(add).status());
+  func->UnregisterChangeListener(&listener);
+  XLS_ASSERT_OK(func->RemoveNode(neg));
+
+  std::string add_name = add->GetName();
+  EXPECT_THAT(
+      listener.events(),
+      ElementsAre(absl::StrCat("added ", add_name),
+                  "operand of neg.4 was sub.3",
+                  absl::StrCat("operand of ", add_name, " was swapped"),
+                  "deleted sub.3", "return value was neg.4"));
+}
+
+TEST_F(FunctionTest, NodeIndices) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  add.3: bits[8] = add(x, y)
+  sub.4: bits[8] = sub(x, y)
+  ret neg.5: bits[8] = neg(add.3)
+}
+)",
+                                                          p.get()));
+  std::vector<int64> indices;
+  for (Node* node : func->nodes()) {
+    indices.push_back(node->node_index());
+  }
+  EXPECT_THAT(indices, ElementsAre(0, 1, 2, 3, 4));
+  EXPECT_EQ(func->node_index_limit(), 5);
+
+  // Removing a node leaves a hole in the indices until they are compacted.
+  Node* sub = FindNode("sub.4", func);
+  XLS_ASSERT_OK(func->RemoveNode(sub));
+  EXPECT_EQ(func->node_count(), 4);
+  EXPECT_EQ(func->node_index_limit(), 5);
+  EXPECT_EQ(FindNode("neg.5", func)->node_index(), 4);
+
+  int64 generation = func->node_index_generation();
+  func->CompactNodeIndices();
+  EXPECT_EQ(func->node_index_generation(), generation + 1);
+  EXPECT_EQ(func->node_index_limit(), 4);
+  EXPECT_EQ(FindNode("neg.5", func)->node_index(), 3);
+  std::vector<std::string> names;
+  for (Node* node : func->nodes()) {
+    names.push_back(node->GetName());
+  }
+  EXPECT_THAT(names, ElementsAre("x", "y", "add.3", "neg.5"));
+
+  // Compacting dense indices is a no-op.
+  func->CompactNodeIndices();
+  EXPECT_EQ(func->node_index_generation(), generation + 1);
+}
+
+TEST_F(FunctionTest, NodesWhileModifyingFunction) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  add.3: bits[8] = add(x, y)
+  sub.4: bits[8] = sub(x, y)
+  ret neg.5: bits[8] = neg(add.3)
+}
+)",
+                                                          p.get()));
+  // Nodes added during the iteration are visited and nodes removed during the
+  // iteration are skipped.
+  std::vector<std::string> names;
+  for (Node* node : func->nodes()) {
+    names.push_back(node->GetName());
+    if (node->GetName() == "add.3") {
+      XLS_ASSERT_OK(func->RemoveNode(FindNode("sub.4", func)));
+      XLS_ASSERT_OK(node->ReplaceUsesWithNew<BinOp>(FindNode("x", func),
+                                                    FindNode("y", func),
+                                                    Op::kSub)
+                        .status());
+    }
+  }
+  ASSERT_EQ(names.size(), 5);
+  EXPECT_EQ(names[3], "neg.5");
+  EXPECT_EQ(names[4], func->return_value()->operand(0)->GetName());
+}
+
+TEST_F(FunctionTest, NodesAllocatedInArena) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  BValue result = x;
+  for (int64 i = 0; i < 100; ++i) {
+    result = b.Add(result, x);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, b.BuildWithReturnValue(result));
+  int64 allocated_bytes = func->node_arena().allocated_bytes();
+  EXPECT_GT(allocated_bytes, 0);
+  EXPECT_GE(func->node_arena().reserved_bytes(), allocated_bytes);
+
+  // Memory of removed nodes is returned to the arena and reused.
+  Node* add = func->return_value()->operand(0);
+  XLS_ASSERT_OK(add->ReplaceUsesWith(x.node()).status());
+  XLS_ASSERT_OK(func->RemoveNode(add));
+  EXPECT_LT(func->node_arena().allocated_bytes(), allocated_bytes);
+  XLS_ASSERT_OK(func->MakeNode<BinOp>(absl::nullopt, x.node(), x.node(),
+                                      Op::kAdd)
+                    .status());
+  EXPECT_EQ(func->node_arena().allocated_bytes(), allocated_bytes);
+
+  // Nodes may also be allocated on the heap.
+  func->AddNode(absl::make_unique<UnOp>(absl::nullopt, x.node(), Op::kNeg,
+                                        func));
+  EXPECT_EQ(func->node_arena().allocated_bytes(), allocated_bytes);
+  EXPECT_EQ(func->node_count(), 102);
+}
+
+TEST_F(FunctionTest, DirtyNodes) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  BValue y = b.Param("y", p->GetBitsType(32));
+  BValue neg = b.Negate(x);
+  BValue add = b.Add(neg, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, b.BuildWithReturnValue(add));
+  // Dirty nodes aren't tracked until requested.
+  EXPECT_FALSE(func->tracking_dirty_nodes());
+  EXPECT_TRUE(func->dirty_nodes().empty());
+  func->StartTrackingDirtyNodes();
+  EXPECT_TRUE(func->dirty_nodes().empty());
+
+  // Replacing an operand dirties the user and the old operand.
+  XLS_ASSERT_OK(add.node()->ReplaceOperandNumber(0, x.node()));
+  EXPECT_THAT(func->dirty_nodes(),
+              UnorderedElementsAre(add.node(), neg.node()));
+  func->ClearDirtyNodes();
+
+  // Removing a node dirties its operands, and forgets the removed node.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * not_y, func->MakeNode<UnOp>(absl::nullopt, y.node(), Op::kNot));
+  EXPECT_THAT(func->dirty_nodes(), UnorderedElementsAre(not_y));
+  XLS_ASSERT_OK(func->RemoveNode(neg.node()));
+  XLS_ASSERT_OK(func->RemoveNode(not_y));
+  EXPECT_THAT(func->dirty_nodes(), UnorderedElementsAre(x.node(), y.node()));
+  func->ClearDirtyNodes();
+
+  // The new return value is dirty.
+  func->set_return_value(x.node());
+  EXPECT_THAT(func->dirty_nodes(), UnorderedElementsAre(x.node()));
+}
+
 }  // namespace
 }  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/ir/ir_interpreter.h"
 
+#include <utility>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "xls/common/logging/log_lines.h"
@@ -57,6 +59,10 @@ class InterpreterVisitor : public DfsVisitor {
       }
     }
     InterpreterVisitor visitor(args, stats);
+    // Size the value map and traversal state up front so evaluating a node
+    // never rehashes them.
+    visitor.node_values_.reserve(function->node_count());
+    visitor.ReserveVisitedState(function->node_count());
     XLS_RETURN_IF_ERROR(function->return_value()->Accept(&visitor));
     return visitor.ResolveAsValue(function->return_value());
   }
@@ -71,6 +77,7 @@ class InterpreterVisitor : public DfsVisitor {
       Node* node, absl::Span<const Value* const> operand_values) {
     XLS_RET_CHECK_EQ(node->operand_count(), operand_values.size());
     InterpreterVisitor visitor({}, /*stats=*/nullptr);
+    visitor.node_values_.reserve(node->operand_count() + 1);
     for (int64 i = 0; i < operand_values.size(); ++i) {
       visitor.node_values_[node->operand(i)] = *operand_values[i];
     }
@@ -84,50 +91,40 @@ class InterpreterVisitor : public DfsVisitor {
   }
 
   absl::Status HandleAndReduce(BitwiseReductionOp* and_reduce) override {
-    Bits operand = ResolveAsBits(and_reduce->operand(0));
+    const Bits& operand = ResolveAsBits(and_reduce->operand(0));
     return SetBitsResult(and_reduce, bits_ops::AndReduce(operand));
   }
 
   absl::Status HandleOrReduce(BitwiseReductionOp* or_reduce) override {
-    Bits operand = ResolveAsBits(or_reduce->operand(0));
+    const Bits& operand = ResolveAsBits(or_reduce->operand(0));
     return SetBitsResult(or_reduce, bits_ops::OrReduce(operand));
   }
 
   absl::Status HandleXorReduce(BitwiseReductionOp* xor_reduce) override {
-    Bits operand = ResolveAsBits(xor_reduce->operand(0));
+    const Bits& operand = ResolveAsBits(xor_reduce->operand(0));
     return SetBitsResult(xor_reduce, bits_ops::XorReduce(operand));
   }
 
   absl::Status HandleNaryAnd(NaryOp* and_op) override {
-    Bits accum = ResolveAsBits(and_op->operand(0));
-    for (Node* operand : and_op->operands().subspan(1)) {
-      accum = bits_ops::And(accum, ResolveAsBits(operand));
-    }
-    return SetBitsResult(and_op, accum);
+    return SetBitsResult(and_op, FoldOperands(and_op, bits_ops::And));
   }
 
   absl::Status HandleNaryNand(NaryOp* nand_op) override {
-    std::vector<Bits> operands = ResolveAsBits(nand_op->operands());
-    Bits accum = bits_ops::NaryNand(operands);
-    return SetBitsResult(nand_op, accum);
+    return SetBitsResult(
+        nand_op, bits_ops::Not(FoldOperands(nand_op, bits_ops::And)));
   }
 
   absl::Status HandleNaryNor(NaryOp* nor_op) override {
-    std::vector<Bits> operands = ResolveAsBits(nor_op->operands());
-    Bits accum = bits_ops::NaryNor(operands);
-    return SetBitsResult(nor_op, accum);
+    return SetBitsResult(nor_op,
+                         bits_ops::Not(FoldOperands(nor_op, bits_ops::Or)));
   }
 
   absl::Status HandleNaryOr(NaryOp* or_op) override {
-    std::vector<Bits> operands = ResolveAsBits(or_op->operands());
-    Bits accum = bits_ops::NaryOr(operands);
-    return SetBitsResult(or_op, accum);
+    return SetBitsResult(or_op, FoldOperands(or_op, bits_ops::Or));
   }
 
   absl::Status HandleNaryXor(NaryOp* xor_op) override {
-    std::vector<Bits> operands = ResolveAsBits(xor_op->operands());
-    Bits accum = bits_ops::NaryXor(operands);
-    return SetBitsResult(xor_op, accum);
+    return SetBitsResult(xor_op, FoldOperands(xor_op, bits_ops::Xor));
   }
 
   absl::Status HandleAfterAll(AfterAll* after_all) override {
@@ -150,7 +147,7 @@ class InterpreterVisitor : public DfsVisitor {
       operand_values.push_back(ResolveAsValue(operand));
     }
     XLS_ASSIGN_OR_RETURN(Value result, Value::Array(operand_values));
-    return SetValueResult(array, result);
+    return SetValueResult(array, std::move(result));
   }
 
   absl::Status HandleBitSlice(BitSlice* bit_slice) override {
@@ -170,16 +167,18 @@ class InterpreterVisitor : public DfsVisitor {
     uint64 start = start_bits.ToUint64().value();
     const Bits& operand = ResolveAsBits(dynamic_bit_slice->operand(0));
     Bits shifted_value = bits_ops::ShiftRightLogical(operand, start);
-    Bits truncated_value = shifted_value.Slice(0, dynamic_bit_slice->width());
-    return SetBitsResult(dynamic_bit_slice, truncated_value);
+    return SetBitsResult(dynamic_bit_slice,
+                         shifted_value.Slice(0, dynamic_bit_slice->width()));
   }
 
   absl::Status HandleConcat(Concat* concat) override {
-    std::vector<Bits> operand_values;
-    for (Node* operand : concat->operands()) {
-      operand_values.push_back(ResolveAsBits(operand));
+    // Build the result directly from the operand values rather than copying
+    // them into a vector for bits_ops::Concat. The last operand holds the LSbs.
+    BitsRope rope(concat->BitCountOrDie());
+    for (int64 i = concat->operand_count() - 1; i >= 0; --i) {
+      rope.push_back(ResolveAsBits(concat->operand(i)));
     }
-    return SetBitsResult(concat, bits_ops::Concat(operand_values));
+    return SetBitsResult(concat, rope.Build());
   }
 
   absl::Status HandleCountedFor(CountedFor* counted_for) override {
@@ -207,7 +206,7 @@ class InterpreterVisitor : public DfsVisitor {
       }
       XLS_ASSIGN_OR_RETURN(loop_state, Run(body, args_for_body, stats_));
     }
-    return SetValueResult(counted_for, loop_state);
+    return SetValueResult(counted_for, std::move(loop_state));
   }
 
   absl::Status HandleDecode(Decode* decode) override {
@@ -230,7 +229,7 @@ class InterpreterVisitor : public DfsVisitor {
         result = bits_ops::Or(result, UBits(i, encode->BitCountOrDie()));
       }
     }
-    return SetBitsResult(encode, result);
+    return SetBitsResult(encode, std::move(result));
   }
 
   absl::Status HandleUDiv(BinOp* div) override {
@@ -298,7 +297,7 @@ class InterpreterVisitor : public DfsVisitor {
       array_elements[index] = update_value;
     }
     XLS_ASSIGN_OR_RETURN(Value result, Value::Array(array_elements));
-    return SetValueResult(update, result);
+    return SetValueResult(update, std::move(result));
   }
 
   absl::Status HandleInvoke(Invoke* invoke) override {
@@ -308,7 +307,7 @@ class InterpreterVisitor : public DfsVisitor {
       args.push_back(ResolveAsValue(invoke->operand(i)));
     }
     XLS_ASSIGN_OR_RETURN(Value result, Run(to_apply, args, stats_));
-    return SetValueResult(invoke, result);
+    return SetValueResult(invoke, std::move(result));
   }
 
   absl::Status HandleLiteral(Literal* literal) override {
@@ -349,31 +348,19 @@ class InterpreterVisitor : public DfsVisitor {
       results.push_back(result);
     }
     XLS_ASSIGN_OR_RETURN(Value result_array, Value::Array(results));
-    return SetValueResult(map, result_array);
+    return SetValueResult(map, std::move(result_array));
   }
 
   absl::Status HandleSMul(ArithOp* mul) override {
-    const int64 mul_width = mul->BitCountOrDie();
-    Bits result = bits_ops::SMul(ResolveAsBits(mul->operand(0)),
-                                 ResolveAsBits(mul->operand(1)));
-    if (result.bit_count() > mul_width) {
-      return SetBitsResult(mul, result.Slice(0, mul_width));
-    } else if (result.bit_count() < mul_width) {
-      return SetBitsResult(mul, bits_ops::SignExtend(result, mul_width));
-    }
-    return SetBitsResult(mul, result);
+    return SetBitsResult(mul, bits_ops::SMul(ResolveAsBits(mul->operand(0)),
+                                             ResolveAsBits(mul->operand(1)),
+                                             mul->BitCountOrDie()));
   }
 
   absl::Status HandleUMul(ArithOp* mul) override {
-    const int64 mul_width = mul->BitCountOrDie();
-    Bits result = bits_ops::UMul(ResolveAsBits(mul->operand(0)),
-                                 ResolveAsBits(mul->operand(1)));
-    if (result.bit_count() > mul_width) {
-      return SetBitsResult(mul, result.Slice(0, mul_width));
-    } else if (result.bit_count() < mul_width) {
-      return SetBitsResult(mul, bits_ops::ZeroExtend(result, mul_width));
-    }
-    return SetBitsResult(mul, result);
+    return SetBitsResult(mul, bits_ops::UMul(ResolveAsBits(mul->operand(0)),
+                                             ResolveAsBits(mul->operand(1)),
+                                             mul->BitCountOrDie()));
   }
 
   absl::Status HandleNe(CompareOp* ne) override {
@@ -420,7 +407,7 @@ class InterpreterVisitor : public DfsVisitor {
     }
     XLS_ASSIGN_OR_RETURN(Value result,
                          DeepOr(sel->GetType(), activated_inputs));
-    return SetValueResult(sel, result);
+    return SetValueResult(sel, std::move(result));
   }
 
   absl::Status HandleParam(Param* param) override {
@@ -439,7 +426,7 @@ class InterpreterVisitor : public DfsVisitor {
   }
 
   absl::Status HandleSel(Select* sel) override {
-    Bits selector = ResolveAsBits(sel->selector());
+    const Bits& selector = ResolveAsBits(sel->selector());
     if (bits_ops::UGreaterThan(
             selector, UBits(sel->cases().size() - 1, selector.bit_count()))) {
       XLS_RET_CHECK(sel->default_value().has_value());
@@ -553,12 +540,15 @@ class InterpreterVisitor : public DfsVisitor {
   // fails if it is not bits.
   const Bits& ResolveAsBits(Node* node) { return node_values_.at(node).bits(); }
 
-  std::vector<Bits> ResolveAsBits(absl::Span<Node* const> nodes) {
-    std::vector<Bits> results;
-    for (Node* node : nodes) {
-      results.push_back(ResolveAsBits(node));
+  // Returns the bits-typed operands of 'node' combined left to right with the
+  // binary operation 'f' (e.g., bits_ops::And), without copying the operand
+  // values.
+  Bits FoldOperands(Node* node, Bits (*f)(const Bits&, const Bits&)) {
+    Bits accum = ResolveAsBits(node->operand(0));
+    for (Node* operand : node->operands().subspan(1)) {
+      accum = f(accum, ResolveAsBits(operand));
     }
-    return results;
+    return accum;
   }
 
   // Returns the previously evaluated value of 'node' as a uint64. If the value
@@ -586,13 +576,13 @@ class InterpreterVisitor : public DfsVisitor {
 
   // Sets the evaluated value for 'node' to the given bits value. Returns an
   // error if 'node' is not a bits type.
-  absl::Status SetBitsResult(Node* node, const Bits& result) {
+  absl::Status SetBitsResult(Node* node, Bits result) {
     XLS_RET_CHECK(node->GetType()->IsBits());
     XLS_RET_CHECK_EQ(node->BitCountOrDie(), result.bit_count());
     if (stats_ != nullptr) {
       stats_->NoteNodeBits(node->ToString(), result);
     }
-    return SetValueResult(node, Value(result));
+    return SetValueResult(node, Value(std::move(result)));
   }
 
   // Sets the evaluated value for 'node' to the given Value. 'value' must be
@@ -609,7 +599,7 @@ class InterpreterVisitor : public DfsVisitor {
     XLS_VLOG(3) << absl::StreamFormat("Result of %s: %s", node->ToString(),
                                       result.ToString());
     XLS_RET_CHECK(!node_values_.contains(node));
-    node_values_[node] = result;
+    node_values_[node] = std::move(result);
     return absl::OkStatus();
   }
 
@@ -0,0 +1,217 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Counts the heap allocations made by the IR interpreter when evaluating a
+// sample package, overall and per evaluated node. Global operator new is
+// replaced (for this binary only) with a counting version.
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_interpreter.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_helpers.h"
+
+namespace {
+
+std::atomic<int64> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { std::free(ptr); }
+
+const char* kUsage = R"(
+Counts heap allocations made by the IR interpreter while evaluating the entry
+function of a sample package with random arguments. Reports allocations per
+run, and per evaluated node bucketed by result type. Usage:
+
+   ir_interpreter_allocation_benchmark --benchmark=sha256
+)";
+
+ABSL_FLAG(std::string, benchmark, "sha256",
+          "Name of the sample package (see sample_packages::GetBenchmark) to "
+          "evaluate.");
+ABSL_FLAG(int64, samples, 16, "Number of random argument sets to evaluate.");
+
+namespace xls {
+namespace {
+
+// Allocations made by ir_interpreter::EvaluateNode itself, independent of the
+// node evaluated: its (reserved) map from node to value. Copying the operand
+// values into that map may allocate too; that is measured separately.
+constexpr int64 kEvaluateNodeOverhead = 1;
+
+// Returns the number of allocations made when copying "value".
+int64 CopyAllocations(const Value& value) {
+  int64 before = allocation_count.load(std::memory_order_relaxed);
+  Value copy = value;
+  return allocation_count.load(std::memory_order_relaxed) - before;
+}
+
+// Allocation counts for one class of nodes.
+struct Bucket {
+  int64 evaluations = 0;
+  int64 allocations = 0;
+  // Allocations by op, for nodes which allocate at all.
+  std::map<std::string, int64> allocations_by_op;
+};
+
+std::string BucketName(Node* node) {
+  if (!node->GetType()->IsBits()) {
+    return "non-bits";
+  }
+  return node->BitCountOrDie() <= 64 * InlineBitmap::kInlineWords
+             ? absl::StrFormat("bits <= %d", 64 * InlineBitmap::kInlineWords)
+             : absl::StrFormat("bits > %d", 64 * InlineBitmap::kInlineWords);
+}
+
+// Evaluates "function" one node at a time, noting the allocations made while
+// evaluating each node in "buckets" (if non-null).
+absl::Status EvaluateByNode(Function* function, absl::Span<const Value> args,
+                            std::map<std::string, Bucket>* buckets) {
+  absl::flat_hash_map<Node*, Value> values;
+  values.reserve(function->node_count());
+  std::vector<const Value*> operand_values;
+  for (Node* node : TopoSort(function)) {
+    if (node->Is<Param>()) {
+      XLS_ASSIGN_OR_RETURN(int64 index,
+                           function->GetParamIndex(node->As<Param>()));
+      values[node] = args[index];
+      continue;
+    }
+    operand_values.clear();
+    int64 overhead = kEvaluateNodeOverhead;
+    for (Node* operand : node->operands()) {
+      operand_values.push_back(&values.at(operand));
+      overhead += CopyAllocations(values.at(operand));
+    }
+    int64 before = allocation_count.load(std::memory_order_relaxed);
+    xabsl::StatusOr<Value> result =
+        ir_interpreter::EvaluateNode(node, operand_values);
+    int64 allocations = allocation_count.load(std::memory_order_relaxed) -
+                        before - overhead;
+    XLS_RETURN_IF_ERROR(result.status());
+    values[node] = std::move(result).value();
+    if (buckets != nullptr) {
+      Bucket& bucket = (*buckets)[BucketName(node)];
+      bucket.evaluations++;
+      bucket.allocations += allocations;
+      if (allocations != 0) {
+        bucket.allocations_by_op[OpToString(node->op())] += allocations;
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RealMain() {
+  int64 sample_count = absl::GetFlag(FLAGS_samples);
+  XLS_RET_CHECK_GT(sample_count, 0);
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      sample_packages::GetBenchmark(absl::GetFlag(FLAGS_benchmark),
+                                    /*optimized=*/true));
+  XLS_ASSIGN_OR_RETURN(Function * function, package->EntryFunction());
+
+  std::minstd_rand bitgen;
+  std::vector<std::vector<Value>> samples;
+  for (int64 i = 0; i < sample_count; ++i) {
+    samples.push_back(RandomFunctionArguments(function, &bitgen));
+  }
+
+  // Warm up, so one-time allocations (e.g., logging setup) aren't counted.
+  XLS_RETURN_IF_ERROR(ir_interpreter::Run(function, samples[0]).status());
+  XLS_RETURN_IF_ERROR(EvaluateByNode(function, samples[0], nullptr));
+
+  int64 before = allocation_count.load(std::memory_order_relaxed);
+  absl::Time start = absl::Now();
+  for (const std::vector<Value>& args : samples) {
+    XLS_RETURN_IF_ERROR(ir_interpreter::Run(function, args).status());
+  }
+  absl::Duration elapsed = absl::Now() - start;
+  int64 run_allocations =
+      allocation_count.load(std::memory_order_relaxed) - before;
+  std::cout << absl::StreamFormat(
+      "%s: %d nodes, %.1f allocations/run, %.3f allocations/node, %s/run\n",
+      function->name(), function->node_count(),
+      static_cast<double>(run_allocations) / sample_count,
+      static_cast<double>(run_allocations) / sample_count /
+          function->node_count(),
+      absl::FormatDuration(elapsed / sample_count));
+
+  std::map<std::string, Bucket> buckets;
+  for (const std::vector<Value>& args : samples) {
+    XLS_RETURN_IF_ERROR(EvaluateByNode(function, args, &buckets));
+  }
+  std::cout << absl::StreamFormat("%-12s %12s %12s %12s\n", "nodes",
+                                  "evaluations", "allocations", "allocs/eval");
+  for (const auto& pair : buckets) {
+    const Bucket& bucket = pair.second;
+    std::cout << absl::StreamFormat(
+        "%-12s %12d %12d %12.3f\n", pair.first, bucket.evaluations,
+        bucket.allocations,
+        static_cast<double>(bucket.allocations) / bucket.evaluations);
+    for (const auto& op_allocations : bucket.allocations_by_op) {
+      std::cout << absl::StreamFormat("  %-10s %25d\n", op_allocations.first,
+                                      op_allocations.second);
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
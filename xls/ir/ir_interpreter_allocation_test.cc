@@ -0,0 +1,143 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the IR interpreter makes no heap allocations when evaluating
+// bits nodes whose values fit in InlineBitmap's inline storage. Global
+// operator new is replaced (for this binary only) with a counting version.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/status/statusor.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_interpreter.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace {
+
+std::atomic<int64> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { std::free(ptr); }
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+// Returns a package whose entry function applies "blocks" rounds of common
+// bits operations to two "width"-bit parameters. Every value is at most
+// "width" bits wide.
+std::string MakeBitsOpsPackage(int64 width, int64 blocks) {
+  int64 half = width / 2;
+  std::string ir = absl::StrFormat(
+      "package bits_ops\n\nfn main(x: bits[%d], y: bits[%d]) -> bits[%d] {\n",
+      width, width, width);
+  std::string prev = "x";
+  for (int64 i = 0; i < blocks; ++i) {
+    absl::StrAppendFormat(&ir, R"(  add%1$d: bits[%2$d] = add(%3$s, y)
+  sub%1$d: bits[%2$d] = sub(add%1$d, x)
+  and%1$d: bits[%2$d] = and(sub%1$d, x, y)
+  or%1$d: bits[%2$d] = or(and%1$d, add%1$d)
+  xor%1$d: bits[%2$d] = xor(or%1$d, sub%1$d)
+  not%1$d: bits[%2$d] = not(xor%1$d)
+  neg%1$d: bits[%2$d] = neg(not%1$d)
+  shll%1$d: bits[%2$d] = shll(neg%1$d, y)
+  shrl%1$d: bits[%2$d] = shrl(shll%1$d, x)
+  shra%1$d: bits[%2$d] = shra(xor%1$d, y)
+  lo%1$d: bits[%4$d] = bit_slice(shra%1$d, start=0, width=%4$d)
+  hi%1$d: bits[%5$d] = bit_slice(shrl%1$d, start=%4$d, width=%5$d)
+  concat%1$d: bits[%2$d] = concat(lo%1$d, hi%1$d)
+  zext%1$d: bits[%2$d] = zero_ext(lo%1$d, new_bit_count=%2$d)
+  sext%1$d: bits[%2$d] = sign_ext(hi%1$d, new_bit_count=%2$d)
+  ult%1$d: bits[1] = ult(concat%1$d, x)
+  eq%1$d: bits[1] = eq(zext%1$d, y)
+  sel%1$d: bits[%2$d] = sel(ult%1$d, cases=[zext%1$d, sext%1$d])
+  umul%1$d: bits[%2$d] = umul(sel%1$d, concat%1$d)
+  smul%1$d: bits[%2$d] = smul(umul%1$d, lo%1$d)
+  reverse%1$d: bits[%2$d] = reverse(smul%1$d)
+  result%1$d: bits[%2$d] = sel(eq%1$d, cases=[reverse%1$d, concat%1$d])
+)",
+                          i, width, prev, half, width - half);
+    prev = absl::StrFormat("result%d", i);
+  }
+  absl::StrAppendFormat(&ir, "  ret identity: bits[%d] = identity(%s)\n}\n",
+                        width, prev);
+  return ir;
+}
+
+// Returns the number of heap allocations made by one interpreter run of the
+// package made by MakeBitsOpsPackage(width, blocks).
+xabsl::StatusOr<int64> RunAllocations(int64 width, int64 blocks) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(MakeBitsOpsPackage(width, blocks)));
+  XLS_ASSIGN_OR_RETURN(Function * function, package->EntryFunction());
+  std::vector<Value> args = {Value(Bits::AllOnes(width)),
+                             Value(Bits::PowerOfTwo(width / 2, width))};
+  // Warm up, so one-time allocations (e.g., type lookups) aren't counted.
+  XLS_ASSIGN_OR_RETURN(Value result, ir_interpreter::Run(function, args));
+
+  int64 before = allocation_count.load(std::memory_order_relaxed);
+  XLS_ASSIGN_OR_RETURN(result, ir_interpreter::Run(function, args));
+  return allocation_count.load(std::memory_order_relaxed) - before;
+}
+
+TEST(IrInterpreterAllocationTest, NoAllocationsPerInlineBitsNode) {
+  // A run makes a fixed number of allocations (e.g., its map from node to
+  // value), so a function with many more nodes must make no more.
+  for (int64 width :
+       std::vector<int64>{2, 8, 64, 65, 100, 64 * InlineBitmap::kInlineWords}) {
+    XLS_ASSERT_OK_AND_ASSIGN(int64 allocations,
+                             RunAllocations(width, /*blocks=*/1));
+    EXPECT_THAT(RunAllocations(width, /*blocks=*/32),
+                IsOkAndHolds(allocations))
+        << "width " << width;
+  }
+}
+
+TEST(IrInterpreterAllocationTest, AllocationsAreCounted) {
+  // Values wider than the inline storage allocate, so the check above isn't
+  // vacuous.
+  int64 width = 64 * InlineBitmap::kInlineWords + 1;
+  XLS_ASSERT_OK_AND_ASSIGN(int64 few, RunAllocations(width, /*blocks=*/1));
+  XLS_ASSERT_OK_AND_ASSIGN(int64 many, RunAllocations(width, /*blocks=*/32));
+  EXPECT_GT(many, few);
+}
+
+}  // namespace
+}  // namespace xls
@@ -193,7 +193,7 @@ class ArgParser {
                 absl::StrFormat("Invalid keyword @ %s: %s",
                                 name.pos().ToHumanString(), name.value()));
           }
-          seen_keywords.insert(name.value());
+          seen_keywords.insert(std::string(name.value()));
         } else {
           if (!name_to_bvalue_.contains(name.value())) {
             return absl::InvalidArgumentError(absl::StrFormat(
@@ -285,7 +285,7 @@ xabsl::StatusOr<std::string> Parser::ParseIdentifierString(TokenPos* pos) {
   if (pos != nullptr) {
     *pos = token.pos();
   }
-  return token.value();
+  return std::string(token.value());
 }
 
 xabsl::StatusOr<BValue> Parser::ParseIdentifierValue(
@@ -477,7 +477,8 @@ namespace {
 
 // GetLocalNode finds function-local BValues by name.
 xabsl::StatusOr<Node*> GetLocalNode(
-    std::string name, absl::flat_hash_map<std::string, BValue>* name_to_value) {
+    absl::string_view name,
+    absl::flat_hash_map<std::string, BValue>* name_to_value) {
   auto it = name_to_value->find(name);
   if (it == name_to_value->end()) {
     return absl::InvalidArgumentError(absl::StrFormat(
@@ -795,7 +796,8 @@ xabsl::StatusOr<BValue> Parser::ParseFunctionBody(
 
 xabsl::StatusOr<Type*> Parser::ParseTupleType(Package* package) {
   std::vector<Type*> types;
-  scanner_.PopToken();
+  XLS_RETURN_IF_ERROR(scanner_.DropTokenOrError(LexicalTokenType::kParenOpen,
+                                                "'(' to start tuple type"));
   if (!scanner_.PeekTokenIs(LexicalTokenType::kParenClose)) {
     do {
       XLS_ASSIGN_OR_RETURN(Type * type, ParseType(package));
@@ -803,11 +805,15 @@ xabsl::StatusOr<Type*> Parser::ParseTupleType(Package* package) {
     } while (scanner_.TryDropToken(LexicalTokenType::kComma));
   }
   if (!scanner_.PeekTokenIs(LexicalTokenType::kParenClose)) {
+    // The scanner may be holding a lexical error or be at EOF rather than at
+    // an unexpected token; PeekToken reports those.
+    XLS_ASSIGN_OR_RETURN(Token token, scanner_.PeekToken());
     return absl::InvalidArgumentError(
         absl::StrFormat("Expected ')' to terminate tuple type; found %s",
-                        scanner_.PopToken().value()));
+                        token.value()));
   }
-  scanner_.PopToken();
+  XLS_RETURN_IF_ERROR(scanner_.DropTokenOrError(LexicalTokenType::kParenClose,
+                                                "')' to end tuple type"));
   return package->GetTupleType(types);
 }
 
@@ -850,7 +856,7 @@ xabsl::StatusOr<std::string> Parser::ParsePackageName() {
   XLS_ASSIGN_OR_RETURN(
       Token package_name,
       scanner_.PopTokenOrError(LexicalTokenType::kIdent, "package name"));
-  return package_name.value();
+  return std::string(package_name.value());
 }
 
 xabsl::StatusOr<Function*> Parser::ParseFunction(Package* package) {
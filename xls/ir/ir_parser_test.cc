@@ -876,6 +876,22 @@ TEST(IrParserTest, ParseTupleType) {
   EXPECT_TRUE(t->AsTupleOrDie()->element_type(1)->IsBits());
 }
 
+TEST(IrParserTest, ParseTupleTypeErrors) {
+  // The scanner reports the invalid character where the ')' is expected.
+  EXPECT_THAT(Parser::ParsePackage(R"(package foobar
+
+fn foo(x: (bits[32]$) -> bits[32] {
+  ret x: bits[32] = param(name=x)
+})")
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\"")));
+  EXPECT_THAT(Parser::ParsePackage("package foobar\n\nfn foo(x: (bits[32]")
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("EOF")));
+}
+
 TEST(IrParserTest, ParseEmptyTuple) {
   const std::string input = R"(
     package foobar
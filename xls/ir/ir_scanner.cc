@@ -110,177 +110,180 @@ std::string Token::ToString() const {
 }
 
 xabsl::StatusOr<std::vector<Token>> TokenizeString(absl::string_view str) {
-  int lineno = 0;
-  int colno = 0;
+  XLS_ASSIGN_OR_RETURN(Scanner scanner, Scanner::Create(str));
+  std::vector<Token> tokens;
+  while (!scanner.AtEof()) {
+    XLS_ASSIGN_OR_RETURN(Token token, scanner.PopTokenOrError());
+    tokens.push_back(token);
+  }
+  return tokens;
+}
 
-  auto in_bounds = [&str](int64 index) -> bool { return index < str.size(); };
+xabsl::StatusOr<Scanner> Scanner::Create(absl::string_view text) {
+  Scanner scanner(text);
+  scanner.Advance();
+  XLS_RETURN_IF_ERROR(scanner.status_);
+  return scanner;
+}
 
-  // Returns the first index greater than 'index' in 'str' with a non-whitespace
-  // character. Updates source location information.
-  auto eat_white_space = [&](absl::string_view str, int64 index) -> int64 {
-    while (in_bounds(index) && absl::ascii_isspace(str[index])) {
-      char c = str[index];
+void Scanner::Advance() {
+  lookahead_.reset();
+  if (!status_.ok()) {
+    return;
+  }
+  SkipWhitespaceAndComments();
+  if (index_ >= text_.size()) {
+    return;
+  }
+  xabsl::StatusOr<Token> token = ScanToken();
+  if (!token.ok()) {
+    status_ = token.status();
+    return;
+  }
+  lookahead_ = token.value();
+}
+
+void Scanner::SkipWhitespaceAndComments() {
+  while (index_ < text_.size()) {
+    char c = text_[index_];
+    if (absl::ascii_isspace(c)) {
       if (c == ' ') {
-        ++colno;
+        ++colno_;
       }
       if (c == '\t') {
-        colno += 4;
+        colno_ += 4;
       }
       if (c == '\n') {
-        colno = 1;
-        ++lineno;
+        colno_ = 1;
+        ++lineno_;
       }
-      index++;
+      ++index_;
+      continue;
     }
-    return index;
-  };
-
-  // In case of end-of-line comments, return the first index after
-  // the comment-terminating end-of-line character. Otherwise return
-  // the originally-given index.
-  auto eat_end_of_line_comment = [&](absl::string_view str,
-                                     int64 index) -> int64 {
-    if (in_bounds(index + 1) && str[index] == '/' && str[index + 1] == '/') {
-      index += 2;
-      while (in_bounds(index) && str[index] != '\n') {
-        index++;
+    // End-of-line comments extend to the end-of-line character, which is then
+    // skipped as whitespace.
+    if (c == '/' && index_ + 1 < text_.size() && text_[index_ + 1] == '/') {
+      index_ += 2;
+      while (index_ < text_.size() && text_[index_] != '\n') {
+        ++index_;
       }
+      continue;
     }
-    return index;
-  };
+    return;
+  }
+}
 
-  auto drop_whitespace_and_comments = [&](absl::string_view str,
-                                          int64 index) -> int64 {
-    int64 old_index = -1;
-    while (old_index != index) {
-      old_index = index;
-      index = eat_white_space(str, index);
-      index = eat_end_of_line_comment(str, index);
-    }
-    return index;
+xabsl::StatusOr<Token> Scanner::ScanToken() {
+  auto in_bounds = [&](int64 index) { return index < text_.size(); };
+  const int64 start = index_;
+  const int64 lineno = lineno_;
+  const int64 colno = colno_;
+  auto make_token = [&](LexicalTokenType type) {
+    const int64 length = index_ - start;
+    colno_ += length;
+    return Token(type, text_.substr(start, length), lineno, colno);
   };
 
-  std::vector<Token> tokens;
-  int64 index = 0;  // Running index into the input string.
-  while (in_bounds(index)) {
-    index = drop_whitespace_and_comments(str, index);
-    if (!in_bounds(index)) {
-      break;
-    }
-    int64 token_start_index = index;
-
-    // Literal numbers can decimal, binary (eg, 0b0101) or hexadecimal (eg,
-    // 0xbeef) so capture all alphanumeric characters after the initial digit.
-    // Literal numbers can also contain '_'s after the first character which are
-    // used to improve readability (example: '0xabcd_ef00').
-    if (isdigit(str[index]) || (str[index] == '-' && in_bounds(index + 1) &&
-                                isdigit(str[index + 1]))) {
-      while ((token_start_index == index && str[index] == '-') ||
-             (in_bounds(index) &&
-              (absl::ascii_isalnum(str[index]) || str[index] == '_'))) {
-        index++;
-      }
-      const int64 token_len = index - token_start_index;
-      absl::string_view value = str.substr(token_start_index, token_len);
-      tokens.push_back(Token(LexicalTokenType::kLiteral, value, lineno, colno));
-      colno += token_len;
-      continue;
+  // Literal numbers can decimal, binary (eg, 0b0101) or hexadecimal (eg,
+  // 0xbeef) so capture all alphanumeric characters after the initial digit.
+  // Literal numbers can also contain '_'s after the first character which are
+  // used to improve readability (example: '0xabcd_ef00').
+  if (absl::ascii_isdigit(text_[index_]) ||
+      (text_[index_] == '-' && in_bounds(index_ + 1) &&
+       absl::ascii_isdigit(text_[index_ + 1]))) {
+    ++index_;
+    while (in_bounds(index_) &&
+           (absl::ascii_isalnum(text_[index_]) || text_[index_] == '_')) {
+      ++index_;
     }
-    if (isalpha(str[index]) || str[index] == '_') {
-      std::string res = "";
-      while (isalpha(str[index]) || str[index] == '_' || str[index] == '.' ||
-             isdigit(str[index])) {
-        res.append(1, str[index++]);
-      }
-      tokens.push_back(Token::MakeIdentOrKeyword(res, lineno, colno));
-      colno += (index - token_start_index);
-      continue;
-    }
-
-    // Look for multi-character tokens.
-    if (str[index] == '-' && in_bounds(index + 1) && str[index + 1] == '>') {
-      tokens.push_back(
-          Token(LexicalTokenType::kRightArrow, "->", lineno, colno));
-      index += 2;
-      colno += 2;
-      continue;
+    return make_token(LexicalTokenType::kLiteral);
+  }
+  if (absl::ascii_isalpha(text_[index_]) || text_[index_] == '_') {
+    while (in_bounds(index_) &&
+           (absl::ascii_isalnum(text_[index_]) || text_[index_] == '_' ||
+            text_[index_] == '.')) {
+      ++index_;
     }
+    absl::string_view value = text_.substr(start, index_ - start);
+    colno_ += value.size();
+    return Token::MakeIdentOrKeyword(value, lineno, colno);
+  }
 
-    // Handle single-character tokens.
-    LexicalTokenType token_type;
-    const char c = str[index];
-    switch (c) {
-      case '-':
-        token_type = LexicalTokenType::kMinus;
-        break;
-      case '+':
-        token_type = LexicalTokenType::kAdd;
-        break;
-      case '.':
-        token_type = LexicalTokenType::kDot;
-        break;
-      case ':':
-        token_type = LexicalTokenType::kColon;
-        break;
-      case ',':
-        token_type = LexicalTokenType::kComma;
-        break;
-      case '=':
-        token_type = LexicalTokenType::kEquals;
-        break;
-      case '[':
-        token_type = LexicalTokenType::kBracketOpen;
-        break;
-      case ']':
-        token_type = LexicalTokenType::kBracketClose;
-        break;
-      case '{':
-        token_type = LexicalTokenType::kCurlOpen;
-        break;
-      case '}':
-        token_type = LexicalTokenType::kCurlClose;
-        break;
-      case '(':
-        token_type = LexicalTokenType::kParenOpen;
-        break;
-      case ')':
-        token_type = LexicalTokenType::kParenClose;
-        break;
-      case '>':
-        token_type = LexicalTokenType::kGt;
-        break;
-      case '<':
-        token_type = LexicalTokenType::kLt;
-        break;
-      default:
-        std::string char_str = absl::ascii_iscntrl(c)
-                                   ? absl::StrFormat("\\x%02x", c)
-                                   : std::string(1, c);
-        XLS_LOG(ERROR) << "IR text with error: " << str;
-        return absl::InvalidArgumentError(
-            absl::StrFormat("Invalid character in IR text \"%s\" @ %s",
-                            char_str, TokenPos{lineno, colno}.ToHumanString()));
-    }
-    tokens.push_back(Token(token_type, lineno, colno));
-    index++;
-    colno++;
+  // Look for multi-character tokens.
+  if (text_[index_] == '-' && in_bounds(index_ + 1) &&
+      text_[index_ + 1] == '>') {
+    index_ += 2;
+    return make_token(LexicalTokenType::kRightArrow);
   }
-  return tokens;
-}
 
-xabsl::StatusOr<Scanner> Scanner::Create(absl::string_view text) {
-  XLS_ASSIGN_OR_RETURN(auto tokens, TokenizeString(text));
-  return Scanner(std::move(tokens));
+  // Handle single-character tokens.
+  LexicalTokenType token_type;
+  const char c = text_[index_];
+  switch (c) {
+    case '-':
+      token_type = LexicalTokenType::kMinus;
+      break;
+    case '+':
+      token_type = LexicalTokenType::kAdd;
+      break;
+    case '.':
+      token_type = LexicalTokenType::kDot;
+      break;
+    case ':':
+      token_type = LexicalTokenType::kColon;
+      break;
+    case ',':
+      token_type = LexicalTokenType::kComma;
+      break;
+    case '=':
+      token_type = LexicalTokenType::kEquals;
+      break;
+    case '[':
+      token_type = LexicalTokenType::kBracketOpen;
+      break;
+    case ']':
+      token_type = LexicalTokenType::kBracketClose;
+      break;
+    case '{':
+      token_type = LexicalTokenType::kCurlOpen;
+      break;
+    case '}':
+      token_type = LexicalTokenType::kCurlClose;
+      break;
+    case '(':
+      token_type = LexicalTokenType::kParenOpen;
+      break;
+    case ')':
+      token_type = LexicalTokenType::kParenClose;
+      break;
+    case '>':
+      token_type = LexicalTokenType::kGt;
+      break;
+    case '<':
+      token_type = LexicalTokenType::kLt;
+      break;
+    default:
+      std::string char_str = absl::ascii_iscntrl(c)
+                                 ? absl::StrFormat("\\x%02x", c)
+                                 : std::string(1, c);
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid character in IR text \"%s\" @ %s",
+                          char_str, TokenPos{lineno, colno}.ToHumanString()));
+  }
+  ++index_;
+  return make_token(token_type);
 }
 
 xabsl::StatusOr<Token> Scanner::PeekToken() const {
+  XLS_RETURN_IF_ERROR(status_);
   if (AtEof()) {
     return absl::InvalidArgumentError("Expected token, but found EOF.");
   }
-  return tokens_[token_idx_];
+  return *lookahead_;
 }
 
 xabsl::StatusOr<Token> Scanner::PopTokenOrError(absl::string_view context) {
+  XLS_RETURN_IF_ERROR(status_);
   if (AtEof()) {
     std::string context_str =
         context.empty() ? std::string("") : absl::StrCat(" in ", context);
@@ -300,6 +303,7 @@ bool Scanner::TryDropToken(LexicalTokenType target) {
 
 absl::Status Scanner::DropTokenOrError(LexicalTokenType target,
                                        absl::string_view context) {
+  XLS_RETURN_IF_ERROR(status_);
   if (AtEof()) {
     std::string context_str =
         context.empty() ? std::string("") : absl::StrCat(" in ", context);
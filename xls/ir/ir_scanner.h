@@ -16,9 +16,12 @@
 #define XLS_IR_IR_SCANNER_H_
 
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "xls/common/integral_types.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/statusor.h"
@@ -57,6 +60,8 @@ struct TokenPos {
   std::string ToHumanString() const;
 };
 
+// A lexical token. The value of the token is a view of the text it was scanned
+// from, so the text must outlive the token.
 class Token {
  public:
   // Returns the (singleton) set of keyword strings.
@@ -87,7 +92,7 @@ class Token {
       : type_(type), value_(value), pos_({lineno, colno}) {}
 
   LexicalTokenType type() const { return type_; }
-  const std::string& value() const { return value_; }
+  absl::string_view value() const { return value_; }
   const TokenPos& pos() const { return pos_; }
 
   // Returns the token as a (u)int64 value. Token must be a literal. The
@@ -111,7 +116,7 @@ class Token {
 
  private:
   LexicalTokenType type_;
-  std::string value_;
+  absl::string_view value_;
   TokenPos pos_;
 };
 
@@ -121,13 +126,18 @@ inline std::ostream& operator<<(std::ostream& os, const Token& token) {
 }
 
 // Tokenizes the given string and returns the tokens. It maintains precise
-// source location information.  Right now this is a eager implementation - it
-// tokenizes the whole input. This can be easily changed later to a more demand
-// driven tokenization.
+// source location information.
 xabsl::StatusOr<std::vector<Token>> TokenizeString(absl::string_view str);
 
+// Scans tokens on demand from a text, which must outlive the scanner and its
+// tokens. Tokens are views into the text, and only the next token is buffered,
+// so scanning takes constant memory beyond the text regardless of its size
+// (e.g., the text can be a memory-mapped file). Errors in the text are
+// reported when the scanner reaches them.
 class Scanner {
  public:
+  // Creates a scanner positioned at the first token of "text". Returns an
+  // error if the first token is malformed.
   static xabsl::StatusOr<Scanner> Create(absl::string_view text);
 
   // Peeks at the next token in the token stream, or returns an error if we're
@@ -136,19 +146,21 @@ class Scanner {
 
   // Return the current token.
   const Token& PeekTokenOrDie() const {
-    XLS_CHECK(!AtEof());
-    return tokens_[token_idx_];
+    XLS_CHECK(lookahead_.has_value()) << status_;
+    return *lookahead_;
   }
 
   // Helper that makes sure we don't peek past EOF.
   bool PeekTokenIs(LexicalTokenType target) const {
-    return !AtEof() && PeekTokenOrDie().type() == target;
+    return lookahead_.has_value() && lookahead_->type() == target;
   }
 
   // Pop the current token, advance token pointer to next token.
   Token PopToken() {
-    XLS_VLOG(3) << "Popping token: " << tokens_[token_idx_];
-    return tokens_.at(token_idx_++);
+    Token token = PeekTokenOrDie();
+    XLS_VLOG(3) << "Popping token: " << token;
+    Advance();
+    return token;
   }
 
   // Same as PopToken() but returns a status error if we are at EOF (in which
@@ -189,14 +201,33 @@ class Scanner {
   // Returns an absl::Status error if we cannot.
   absl::Status DropKeywordOrError(absl::string_view keyword);
 
-  // Check if more tokens are available.
-  bool AtEof() const { return token_idx_ >= tokens_.size(); }
+  // Check if more tokens are available. The scanner is not at EOF if the rest
+  // of the text is malformed: popping a token then returns the error.
+  bool AtEof() const { return !lookahead_.has_value() && status_.ok(); }
 
  private:
-  explicit Scanner(std::vector<Token> tokens) : tokens_(tokens) {}
+  explicit Scanner(absl::string_view text) : text_(text) {}
 
-  int64 token_idx_ = 0;
-  std::vector<Token> tokens_;
+  // Scans the next token of the text into lookahead_. At the end of the text,
+  // or if the text is malformed, lookahead_ is left empty; in the latter case
+  // status_ holds the error.
+  void Advance();
+
+  // Scans the token starting at index_, which must not be whitespace or the
+  // start of a comment.
+  xabsl::StatusOr<Token> ScanToken();
+
+  // Skips whitespace and comments, updating the source position.
+  void SkipWhitespaceAndComments();
+
+  absl::string_view text_;
+  int64 index_ = 0;
+  int64 lineno_ = 0;
+  int64 colno_ = 0;
+
+  // The next token, if any. The parser needs a single token of lookahead.
+  absl::optional<Token> lookahead_;
+  absl::Status status_;
 };
 
 }  // namespace xls
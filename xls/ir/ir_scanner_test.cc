@@ -73,5 +73,52 @@ TEST(IrScannerTest, TokenizeInvalidCharacter) {
   }
 }
 
+TEST(IrScannerTest, TokenValuesViewInput) {
+  constexpr absl::string_view kText = "fn f(x: bits[32]) -> bits[32]";
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Token> tokens, TokenizeString(kText));
+  ASSERT_EQ(tokens.size(), 15);
+  EXPECT_EQ(tokens[0].type(), LexicalTokenType::kKeyword);
+  EXPECT_EQ(tokens[0].value(), "fn");
+  EXPECT_EQ(tokens[0].value().data(), kText.data());
+  EXPECT_EQ(tokens[1].type(), LexicalTokenType::kIdent);
+  EXPECT_EQ(tokens[1].value(), "f");
+  EXPECT_EQ(tokens[7].type(), LexicalTokenType::kLiteral);
+  EXPECT_EQ(tokens[7].value(), "32");
+  EXPECT_EQ(tokens[10].type(), LexicalTokenType::kRightArrow);
+  // The last token ends at the end of the text.
+  EXPECT_EQ(tokens[14].type(), LexicalTokenType::kBracketClose);
+  EXPECT_EQ(tokens[14].value().data() + 1, kText.data() + kText.size());
+}
+
+TEST(IrScannerTest, ScannerPeeksAndPops) {
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner, Scanner::Create("ret x\n"));
+  EXPECT_FALSE(scanner.AtEof());
+  EXPECT_TRUE(scanner.PeekTokenIs(LexicalTokenType::kKeyword));
+  EXPECT_TRUE(scanner.TryDropKeyword("ret"));
+  XLS_ASSERT_OK_AND_ASSIGN(Token x, scanner.PeekToken());
+  EXPECT_EQ(x.value(), "x");
+  EXPECT_EQ(x.pos().lineno, 0);
+  EXPECT_EQ(x.pos().colno, 4);
+  XLS_EXPECT_OK(scanner.DropTokenOrError(LexicalTokenType::kIdent));
+  EXPECT_TRUE(scanner.AtEof());
+  EXPECT_THAT(scanner.PopTokenOrError("test").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       ::testing::HasSubstr("Expected token in test")));
+}
+
+TEST(IrScannerTest, ErrorReportedWhenReached) {
+  // Tokens before the invalid character are scanned normally.
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner, Scanner::Create("a b $ c"));
+  XLS_ASSERT_OK_AND_ASSIGN(Token a, scanner.PopTokenOrError());
+  EXPECT_EQ(a.value(), "a");
+  XLS_ASSERT_OK_AND_ASSIGN(Token b, scanner.PopTokenOrError());
+  EXPECT_EQ(b.value(), "b");
+  EXPECT_FALSE(scanner.AtEof());
+  EXPECT_FALSE(scanner.PeekTokenIs(LexicalTokenType::kIdent));
+  EXPECT_THAT(scanner.PopTokenOrError().status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       ::testing::HasSubstr("Invalid character")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,666 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_serializer.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/node_map.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/verifier.h"
+
+namespace xls {
+namespace {
+
+constexpr int64 kBytesPerLimb = 8;
+
+// Returns the index of "type" in the type table of "proto", adding it (and its
+// element types) to the table if necessary.
+int64 InternType(const Type* type,
+                 absl::flat_hash_map<const Type*, int64>* type_indices,
+                 PackageProto* proto) {
+  auto it = type_indices->find(type);
+  if (it != type_indices->end()) {
+    return it->second;
+  }
+  InternedTypeProto type_proto;
+  switch (type->kind()) {
+    case TypeKind::kBits:
+      type_proto.set_type_enum(TypeProto::BITS);
+      type_proto.set_bit_count(type->AsBitsOrDie()->bit_count());
+      break;
+    case TypeKind::kTuple:
+      type_proto.set_type_enum(TypeProto::TUPLE);
+      for (const Type* element_type : type->AsTupleOrDie()->element_types()) {
+        type_proto.add_tuple_elements(
+            InternType(element_type, type_indices, proto));
+      }
+      break;
+    case TypeKind::kArray:
+      type_proto.set_type_enum(TypeProto::ARRAY);
+      type_proto.set_array_size(type->AsArrayOrDie()->size());
+      type_proto.set_array_element(InternType(
+          type->AsArrayOrDie()->element_type(), type_indices, proto));
+      break;
+    case TypeKind::kToken:
+      type_proto.set_type_enum(TypeProto::TOKEN);
+      break;
+  }
+  int64 index = proto->types_size();
+  *proto->add_types() = std::move(type_proto);
+  (*type_indices)[type] = index;
+  return index;
+}
+
+void BitsToLimbs(const Bits& bits, std::string* limbs) {
+  const int64 byte_count = CeilOfRatio(bits.bit_count(), int64{8});
+  limbs->resize(byte_count);
+  for (int64 i = 0; i < byte_count; ++i) {
+    uint64 limb = bits.bitmap().GetWord(i / kBytesPerLimb);
+    (*limbs)[i] = static_cast<char>(limb >> (8 * (i % kBytesPerLimb)));
+  }
+}
+
+xabsl::StatusOr<Bits> LimbsToBits(absl::string_view limbs, int64 bit_count) {
+  const int64 byte_count = CeilOfRatio(bit_count, int64{8});
+  if (limbs.size() != byte_count) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d bytes for a bits[%d] value, got %d",
+                        byte_count, bit_count, limbs.size()));
+  }
+  InlineBitmap bitmap(bit_count);
+  for (int64 wordno = 0; wordno < bitmap.word_count(); ++wordno) {
+    uint64 limb = 0;
+    for (int64 i = 0; i < kBytesPerLimb; ++i) {
+      int64 byte_index = wordno * kBytesPerLimb + i;
+      if (byte_index < byte_count) {
+        limb |= uint64{static_cast<uint8>(limbs[byte_index])} << (8 * i);
+      }
+    }
+    bitmap.SetWord(wordno, limb);
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+void ValueToProto(const Value& value, ValueProto* proto) {
+  if (value.IsBits()) {
+    BitsToLimbs(value.bits(), proto->mutable_bits());
+    return;
+  }
+  if (value.IsTuple() || value.IsArray()) {
+    for (const Value& element : value.elements()) {
+      ValueToProto(element, proto->add_elements());
+    }
+  }
+}
+
+xabsl::StatusOr<Value> ValueFromProto(const ValueProto& proto,
+                                      const Type* type) {
+  switch (type->kind()) {
+    case TypeKind::kBits: {
+      XLS_ASSIGN_OR_RETURN(
+          Bits bits,
+          LimbsToBits(proto.bits(), type->AsBitsOrDie()->bit_count()));
+      return Value(std::move(bits));
+    }
+    case TypeKind::kTuple: {
+      const TupleType* tuple_type = type->AsTupleOrDie();
+      if (proto.elements_size() != tuple_type->size()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Expected %d elements for a value of type %s",
+                            tuple_type->size(), type->ToString()));
+      }
+      std::vector<Value> elements;
+      elements.reserve(tuple_type->size());
+      for (int64 i = 0; i < tuple_type->size(); ++i) {
+        XLS_ASSIGN_OR_RETURN(
+            Value element,
+            ValueFromProto(proto.elements(i), tuple_type->element_type(i)));
+        elements.push_back(std::move(element));
+      }
+      return Value::TupleOwned(std::move(elements));
+    }
+    case TypeKind::kArray: {
+      const ArrayType* array_type = type->AsArrayOrDie();
+      if (proto.elements_size() != array_type->size()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Expected %d elements for a value of type %s",
+                            array_type->size(), type->ToString()));
+      }
+      std::vector<Value> elements;
+      elements.reserve(array_type->size());
+      for (const ValueProto& element_proto : proto.elements()) {
+        XLS_ASSIGN_OR_RETURN(
+            Value element,
+            ValueFromProto(element_proto, array_type->element_type()));
+        elements.push_back(std::move(element));
+      }
+      return Value::Array(elements);
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  return absl::InternalError(
+      absl::StrFormat("Unhandled type kind: %s", type->ToString()));
+}
+
+// Converts "node" to a NodeProto. "node_indices" holds the index of each
+// node of the function converted so far, and "node_index" the index of "node".
+absl::Status NodeToProto(
+    Node* node, int64 node_index, const NodeMap<int64>& node_indices,
+    const absl::flat_hash_map<const Function*, int64>& function_indices,
+    absl::flat_hash_map<const Type*, int64>* type_indices,
+    PackageProto* package_proto, NodeProto* proto) {
+  proto->set_op(ToOpProto(node->op()));
+  proto->set_id(node->id());
+  proto->set_type(InternType(node->GetType(), type_indices, package_proto));
+  for (Node* operand : node->operands()) {
+    proto->add_operands(node_index - node_indices.at(operand));
+  }
+  if (node->loc().has_value()) {
+    proto->set_fileno(node->loc()->fileno().value());
+    proto->set_lineno(node->loc()->lineno().value());
+    proto->set_colno(node->loc()->colno().value());
+  }
+  auto set_function = [&](const Function* f) -> absl::Status {
+    auto it = function_indices.find(f);
+    if (it == function_indices.end()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Node %s applies function %s, which does not precede function %s "
+          "in the package",
+          node->GetName(), f->name(), node->function()->name()));
+    }
+    proto->set_function(it->second);
+    return absl::OkStatus();
+  };
+  switch (node->op()) {
+    case Op::kParam:
+      proto->set_name(node->As<Param>()->name());
+      break;
+    case Op::kLiteral:
+      ValueToProto(node->As<Literal>()->value(), proto->mutable_value());
+      break;
+    case Op::kBitSlice:
+      proto->set_start(node->As<BitSlice>()->start());
+      break;
+    case Op::kTupleIndex:
+      proto->set_index(node->As<TupleIndex>()->index());
+      break;
+    case Op::kCountedFor:
+      proto->set_trip_count(node->As<CountedFor>()->trip_count());
+      proto->set_stride(node->As<CountedFor>()->stride());
+      XLS_RETURN_IF_ERROR(set_function(node->As<CountedFor>()->body()));
+      break;
+    case Op::kMap:
+      XLS_RETURN_IF_ERROR(set_function(node->As<Map>()->to_apply()));
+      break;
+    case Op::kInvoke:
+      XLS_RETURN_IF_ERROR(set_function(node->As<Invoke>()->to_apply()));
+      break;
+    case Op::kOneHot:
+      proto->set_lsb_prio(node->As<OneHot>()->priority() == LsbOrMsb::kLsb);
+      break;
+    case Op::kSel:
+      proto->set_has_default(
+          node->As<Select>()->default_value().has_value());
+      break;
+    case Op::kChannelReceive:
+    case Op::kChannelSend:
+      return absl::UnimplementedError(absl::StrFormat(
+          "Cannot serialize node %s: op %s is not supported", node->GetName(),
+          OpToString(node->op())));
+    default:
+      break;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FunctionToProto(
+    Function* f,
+    const absl::flat_hash_map<const Function*, int64>& function_indices,
+    absl::flat_hash_map<const Type*, int64>* type_indices,
+    PackageProto* package_proto, FunctionProto* proto) {
+  proto->set_name(f->name());
+  std::vector<Node*> nodes(f->params().begin(), f->params().end());
+  nodes.reserve(f->node_count());
+  for (Node* node : TopoSort(f)) {
+    if (!node->Is<Param>()) {
+      nodes.push_back(node);
+    }
+  }
+  NodeMap<int64> node_indices(f);
+  for (int64 i = 0; i < nodes.size(); ++i) {
+    XLS_RETURN_IF_ERROR(NodeToProto(nodes[i], i, node_indices,
+                                    function_indices, type_indices,
+                                    package_proto, proto->add_nodes()));
+    node_indices[nodes[i]] = i;
+    if (nodes[i] == f->return_value()) {
+      proto->set_return_value(i);
+    }
+  }
+  return absl::OkStatus();
+}
+
+xabsl::StatusOr<Type*> TypeFromProto(const InternedTypeProto& proto,
+                                     absl::Span<Type* const> types,
+                                     Package* package) {
+  auto get_type = [&](int64 index) -> xabsl::StatusOr<Type*> {
+    if (index < 0 || index >= types.size()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid element type index %d", index));
+    }
+    return types[index];
+  };
+  switch (proto.type_enum()) {
+    case TypeProto::BITS:
+      if (proto.bit_count() < 0) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Invalid bit count %d", proto.bit_count()));
+      }
+      return package->GetBitsType(proto.bit_count());
+    case TypeProto::TUPLE: {
+      std::vector<Type*> element_types;
+      for (int64 element : proto.tuple_elements()) {
+        XLS_ASSIGN_OR_RETURN(Type * element_type, get_type(element));
+        element_types.push_back(element_type);
+      }
+      return package->GetTupleType(element_types);
+    }
+    case TypeProto::ARRAY: {
+      if (proto.array_size() < 0) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Invalid array size %d", proto.array_size()));
+      }
+      XLS_ASSIGN_OR_RETURN(Type * element_type,
+                           get_type(proto.array_element()));
+      return package->GetArrayType(proto.array_size(), element_type);
+    }
+    case TypeProto::TOKEN:
+      return package->GetTokenType();
+    default:
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Invalid type enum %d", static_cast<int>(proto.type_enum())));
+  }
+}
+
+// Adds the node described by "proto" to the function being built by "fb".
+// "values" holds the nodes added so far, in the order of the FunctionProto.
+xabsl::StatusOr<BValue> NodeFromProto(const NodeProto& proto,
+                                      absl::Span<Type* const> types,
+                                      absl::Span<Function* const> functions,
+                                      absl::Span<const BValue> values,
+                                      FunctionBuilder* fb) {
+  if (!proto.has_op()) {
+    return absl::InvalidArgumentError("Node has no op");
+  }
+  const Op op = FromOpProto(proto.op());
+  if (proto.type() < 0 || proto.type() >= types.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid type index %d of %s node %d", proto.type(),
+                        OpToString(op), proto.id()));
+  }
+  Type* type = types[proto.type()];
+  std::vector<BValue> operands;
+  operands.reserve(proto.operands_size());
+  for (int64 distance : proto.operands()) {
+    if (distance <= 0 || distance > values.size()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid operand reference %d of %s node %d",
+                          distance, OpToString(op), proto.id()));
+    }
+    operands.push_back(values[values.size() - distance]);
+  }
+  auto check_operand_count = [&](int64 min_count,
+                                 int64 max_count) -> absl::Status {
+    if (operands.size() < min_count || operands.size() > max_count) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid operand count %d of %s node %d",
+                          operands.size(), OpToString(op), proto.id()));
+    }
+    return absl::OkStatus();
+  };
+  auto check_arity = [&](int64 arity) {
+    return check_operand_count(arity, arity);
+  };
+  constexpr int64 kVariadic = std::numeric_limits<int64>::max();
+  auto get_function = [&]() -> xabsl::StatusOr<Function*> {
+    if (proto.function() < 0 || proto.function() >= functions.size()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid function index %d of %s node %d",
+                          proto.function(), OpToString(op), proto.id()));
+    }
+    return functions[proto.function()];
+  };
+  // The node constructors CHECK-fail on operands of the wrong kind of type, so
+  // these are checked here first.
+  auto check_operand_type = [&](int64 i, bool ok,
+                                absl::string_view expected) -> absl::Status {
+    if (!ok) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Operand %d of %s node %d is not %s; got %s", i, OpToString(op),
+          proto.id(), expected, operands[i].GetType()->ToString()));
+    }
+    return absl::OkStatus();
+  };
+  // Checks that "args" match the parameters of "to_apply" in number and type.
+  auto check_args = [&](Function* to_apply,
+                        absl::Span<Type* const> args) -> absl::Status {
+    if (args.size() != to_apply->params().size()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s node %d passes %d arguments to function %s, which takes %d",
+          OpToString(op), proto.id(), args.size(), to_apply->name(),
+          to_apply->params().size()));
+    }
+    for (int64 i = 0; i < args.size(); ++i) {
+      Type* param_type = to_apply->params()[i]->GetType();
+      if (args[i] != param_type) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Argument %d of %s node %d has type %s; function %s expects %s", i,
+            OpToString(op), proto.id(), args[i]->ToString(), to_apply->name(),
+            param_type->ToString()));
+      }
+    }
+    return absl::OkStatus();
+  };
+  auto bit_count = [&]() -> xabsl::StatusOr<int64> {
+    if (!type->IsBits()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Expected bits type for %s node %d, got %s",
+                          OpToString(op), proto.id(), type->ToString()));
+    }
+    return type->AsBitsOrDie()->bit_count();
+  };
+  absl::optional<SourceLocation> loc;
+  if (proto.has_fileno()) {
+    loc = SourceLocation(Fileno(proto.fileno()), Lineno(proto.lineno()),
+                         Colno(proto.colno()));
+  }
+
+  switch (op) {
+    case Op::kParam:
+      XLS_RETURN_IF_ERROR(check_arity(0));
+      return fb->Param(proto.name(), type, loc);
+    case Op::kLiteral: {
+      XLS_RETURN_IF_ERROR(check_arity(0));
+      XLS_ASSIGN_OR_RETURN(Value value, ValueFromProto(proto.value(), type));
+      return fb->Literal(value, loc);
+    }
+    case Op::kBitSlice: {
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_ASSIGN_OR_RETURN(int64 width, bit_count());
+      return fb->BitSlice(operands[0], proto.start(), width, loc);
+    }
+    case Op::kDynamicBitSlice: {
+      XLS_RETURN_IF_ERROR(check_arity(2));
+      XLS_ASSIGN_OR_RETURN(int64 width, bit_count());
+      return fb->DynamicBitSlice(operands[0], operands[1], width, loc);
+    }
+    case Op::kConcat:
+      return fb->Concat(operands, loc);
+    case Op::kMap: {
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_RETURN_IF_ERROR(
+          check_operand_type(0, operands[0].GetType()->IsArray(), "an array"));
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, get_function());
+      XLS_RETURN_IF_ERROR(check_args(
+          to_apply, {operands[0].GetType()->AsArrayOrDie()->element_type()}));
+      return fb->Map(operands[0], to_apply, loc);
+    }
+    case Op::kCountedFor: {
+      XLS_RETURN_IF_ERROR(check_operand_count(1, kVariadic));
+      XLS_ASSIGN_OR_RETURN(Function * body, get_function());
+      return fb->CountedFor(
+          operands[0], proto.trip_count(), proto.stride(), body,
+          absl::MakeConstSpan(operands).subspan(1), loc);
+    }
+    case Op::kOneHot:
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_RETURN_IF_ERROR(
+          check_operand_type(0, operands[0].GetType()->IsBits(), "bits"));
+      return fb->OneHot(operands[0],
+                        proto.lsb_prio() ? LsbOrMsb::kLsb : LsbOrMsb::kMsb,
+                        loc);
+    case Op::kOneHotSel:
+      XLS_RETURN_IF_ERROR(check_operand_count(2, kVariadic));
+      return fb->OneHotSelect(
+          operands[0], absl::MakeConstSpan(operands).subspan(1), loc);
+    case Op::kSel: {
+      XLS_RETURN_IF_ERROR(
+          check_operand_count(proto.has_default() ? 3 : 2, kVariadic));
+      absl::optional<BValue> default_value;
+      if (proto.has_default()) {
+        default_value = operands.back();
+        operands.pop_back();
+      }
+      return fb->Select(operands[0], absl::MakeConstSpan(operands).subspan(1),
+                        default_value, loc);
+    }
+    case Op::kTuple:
+      return fb->Tuple(operands, loc);
+    case Op::kAfterAll:
+      return fb->AfterAll(operands, loc);
+    case Op::kArray:
+      if (!type->IsArray()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Expected array type for array node %d, got %s",
+                            proto.id(), type->ToString()));
+      }
+      return fb->Array(operands, type->AsArrayOrDie()->element_type(), loc);
+    case Op::kTupleIndex: {
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_RETURN_IF_ERROR(
+          check_operand_type(0, operands[0].GetType()->IsTuple(), "a tuple"));
+      int64 size = operands[0].GetType()->AsTupleOrDie()->size();
+      if (proto.index() < 0 || proto.index() >= size) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Invalid index %d of tuple_index node %d; tuple has %d elements",
+            proto.index(), proto.id(), size));
+      }
+      return fb->TupleIndex(operands[0], proto.index(), loc);
+    }
+    case Op::kArrayIndex:
+      XLS_RETURN_IF_ERROR(check_arity(2));
+      return fb->ArrayIndex(operands[0], operands[1], loc);
+    case Op::kArrayUpdate:
+      XLS_RETURN_IF_ERROR(check_arity(3));
+      return fb->ArrayUpdate(operands[0], operands[1], operands[2], loc);
+    case Op::kInvoke: {
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, get_function());
+      std::vector<Type*> arg_types;
+      for (const BValue& operand : operands) {
+        arg_types.push_back(operand.GetType());
+      }
+      XLS_RETURN_IF_ERROR(check_args(to_apply, arg_types));
+      return fb->Invoke(operands, to_apply, loc);
+    }
+    case Op::kZeroExt:
+    case Op::kSignExt: {
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_ASSIGN_OR_RETURN(int64 new_bit_count, bit_count());
+      return op == Op::kZeroExt
+                 ? fb->ZeroExtend(operands[0], new_bit_count, loc)
+                 : fb->SignExtend(operands[0], new_bit_count, loc);
+    }
+    case Op::kEncode:
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_RETURN_IF_ERROR(
+          check_operand_type(0, operands[0].GetType()->IsBits(), "bits"));
+      return fb->Encode(operands[0], loc);
+    case Op::kDecode: {
+      XLS_RETURN_IF_ERROR(check_arity(1));
+      XLS_ASSIGN_OR_RETURN(int64 width, bit_count());
+      return fb->Decode(operands[0], width, loc);
+    }
+    case Op::kSMul:
+    case Op::kUMul: {
+      XLS_RETURN_IF_ERROR(check_arity(2));
+      XLS_ASSIGN_OR_RETURN(int64 width, bit_count());
+      return fb->AddArithOp(op, operands[0], operands[1], width, loc);
+    }
+    case Op::kChannelReceive:
+    case Op::kChannelSend:
+      return absl::UnimplementedError(
+          absl::StrFormat("Cannot deserialize %s node %d: op not supported",
+                          OpToString(op), proto.id()));
+    default:
+      break;
+  }
+  if (IsOpClass<BinOp>(op)) {
+    XLS_RETURN_IF_ERROR(check_arity(2));
+    return fb->AddBinOp(op, operands[0], operands[1], loc);
+  }
+  if (IsOpClass<UnOp>(op)) {
+    XLS_RETURN_IF_ERROR(check_arity(1));
+    return fb->AddUnOp(op, operands[0], loc);
+  }
+  if (IsOpClass<CompareOp>(op)) {
+    XLS_RETURN_IF_ERROR(check_arity(2));
+    return fb->AddCompareOp(op, operands[0], operands[1], loc);
+  }
+  if (IsOpClass<NaryOp>(op)) {
+    return fb->AddNaryOp(op, operands, loc);
+  }
+  if (IsOpClass<BitwiseReductionOp>(op)) {
+    XLS_RETURN_IF_ERROR(check_arity(1));
+    return fb->AddBitwiseReductionOp(op, operands[0], loc);
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Cannot deserialize %s node %d", OpToString(op), proto.id()));
+}
+
+xabsl::StatusOr<Function*> FunctionFromProto(
+    const FunctionProto& proto, absl::Span<Type* const> types,
+    absl::Span<Function* const> functions, Package* package) {
+  FunctionBuilder fb(proto.name(), package);
+  std::vector<BValue> values;
+  values.reserve(proto.nodes_size());
+  for (const NodeProto& node_proto : proto.nodes()) {
+    XLS_ASSIGN_OR_RETURN(BValue value, NodeFromProto(node_proto, types,
+                                                     functions, values, &fb));
+    if (!value.valid()) {
+      // The builder recorded an error, which Build returns.
+      return fb.Build();
+    }
+    if (value.GetType() != types[node_proto.type()]) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Declared type %s of node %d does not match its type %s",
+          types[node_proto.type()]->ToString(), node_proto.id(),
+          value.GetType()->ToString()));
+    }
+    value.node()->set_id(node_proto.id());
+    values.push_back(value);
+  }
+  if (!proto.has_return_value()) {
+    return fb.Build();
+  }
+  if (proto.return_value() < 0 || proto.return_value() >= values.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid return value index %d of function %s",
+                        proto.return_value(), proto.name()));
+  }
+  return fb.BuildWithReturnValue(values[proto.return_value()]);
+}
+
+}  // namespace
+
+xabsl::StatusOr<PackageProto> PackageToProto(const Package& package) {
+  PackageProto proto;
+  proto.set_version(kPackageProtoVersion);
+  proto.set_name(package.name());
+  absl::flat_hash_map<const Type*, int64> type_indices;
+  absl::flat_hash_map<const Function*, int64> function_indices;
+  for (const std::unique_ptr<Function>& f : package.functions()) {
+    XLS_RETURN_IF_ERROR(FunctionToProto(f.get(), function_indices,
+                                        &type_indices, &proto,
+                                        proto.add_functions()));
+    int64 function_index = function_indices.size();
+    function_indices[f.get()] = function_index;
+  }
+  return proto;
+}
+
+xabsl::StatusOr<std::unique_ptr<Package>> PackageFromProto(
+    const PackageProto& proto, absl::optional<absl::string_view> entry) {
+  if (proto.version() != kPackageProtoVersion) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Unsupported serialized package version %d; expected version %d",
+        proto.version(), kPackageProtoVersion));
+  }
+  auto package = absl::make_unique<Package>(proto.name(), entry);
+  std::vector<Type*> types;
+  types.reserve(proto.types_size());
+  for (const InternedTypeProto& type_proto : proto.types()) {
+    XLS_ASSIGN_OR_RETURN(Type * type,
+                         TypeFromProto(type_proto, types, package.get()));
+    types.push_back(type);
+  }
+  std::vector<Function*> functions;
+  functions.reserve(proto.functions_size());
+  for (const FunctionProto& function_proto : proto.functions()) {
+    XLS_ASSIGN_OR_RETURN(
+        Function * f,
+        FunctionFromProto(function_proto, types, functions, package.get()));
+    functions.push_back(f);
+  }
+
+  // As in the parser, make sure the ids of new nodes don't collide with the
+  // serialized ids.
+  int64 max_id_seen = -1;
+  for (Function* f : functions) {
+    for (Node* node : f->nodes()) {
+      max_id_seen = std::max(max_id_seen, node->id());
+    }
+  }
+  package->set_next_node_id(max_id_seen + 1);
+
+  if (entry.has_value()) {
+    XLS_RETURN_IF_ERROR(package->GetFunction(*entry).status());
+  }
+  XLS_RETURN_IF_ERROR(Verify(package.get()));
+  return package;
+}
+
+xabsl::StatusOr<std::string> SerializePackage(const Package& package) {
+  XLS_ASSIGN_OR_RETURN(PackageProto proto, PackageToProto(package));
+  std::string serialized;
+  XLS_RET_CHECK(proto.SerializeToString(&serialized));
+  return serialized;
+}
+
+xabsl::StatusOr<std::unique_ptr<Package>> DeserializePackage(
+    absl::string_view serialized, absl::optional<absl::string_view> entry) {
+  PackageProto proto;
+  if (!proto.ParseFromArray(serialized.data(), serialized.size())) {
+    return absl::InvalidArgumentError(
+        "Could not parse serialized package: not a PackageProto");
+  }
+  return PackageFromProto(proto, entry);
+}
+
+}  // namespace xls
@@ -0,0 +1,61 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Binary serialization of IR packages as a PackageProto (see xls_ir.proto).
+// This is the binary counterpart of the text format of Package::DumpIr and
+// Parser::ParsePackage, intended for passing large packages between tools:
+// types are interned in a table, operands are varint-encoded references, and
+// literal bits are stored as raw limbs, so a serialized package is smaller
+// than its text and loads without lexing or number parsing.
+
+#ifndef XLS_IR_IR_SERIALIZER_H_
+#define XLS_IR_IR_SERIALIZER_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+#include "xls/ir/package.h"
+#include "xls/ir/xls_ir.pb.h"
+
+namespace xls {
+
+// Version of the PackageProto format written by PackageToProto. Packages
+// written with a different version are rejected by PackageFromProto.
+constexpr int64 kPackageProtoVersion = 1;
+
+// Converts the package to a PackageProto. Returns an error if the package
+// contains ops which the IR text format does not support either (e.g., channel
+// ops), or a function applies a function which comes after it in the package.
+xabsl::StatusOr<PackageProto> PackageToProto(const Package& package);
+
+// Builds and verifies a package from a PackageProto. If "entry" is given, it
+// is set as the entry function of the package.
+xabsl::StatusOr<std::unique_ptr<Package>> PackageFromProto(
+    const PackageProto& proto,
+    absl::optional<absl::string_view> entry = absl::nullopt);
+
+// As PackageToProto and PackageFromProto, but to and from the wire format of
+// the proto.
+xabsl::StatusOr<std::string> SerializePackage(const Package& package);
+xabsl::StatusOr<std::unique_ptr<Package>> DeserializePackage(
+    absl::string_view serialized,
+    absl::optional<absl::string_view> entry = absl::nullopt);
+
+}  // namespace xls
+
+#endif  // XLS_IR_IR_SERIALIZER_H_
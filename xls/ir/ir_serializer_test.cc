@@ -0,0 +1,342 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_serializer.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/ir_parser.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+// Parses the given IR text, round-trips it through the binary format and
+// checks that the deserialized package dumps as the same text.
+void RoundTripAndCheckDump(absl::string_view ir_text) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string serialized, SerializePackage(*package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> deserialized,
+                           DeserializePackage(serialized));
+  EXPECT_EQ(deserialized->DumpIr(), package->DumpIr());
+  EXPECT_EQ(deserialized->next_node_id(), package->next_node_id());
+}
+
+TEST(IrSerializerTest, ArithmeticAndLogic) {
+  RoundTripAndCheckDump(R"(package p
+
+fn f(x: bits[32], y: bits[32], z: bits[8]) -> bits[64] {
+  add.1: bits[32] = add(x, y, pos=0,1,2)
+  not.2: bits[32] = not(add.1)
+  and.3: bits[32] = and(x, y, not.2)
+  ult.4: bits[1] = ult(and.3, x)
+  smul.5: bits[64] = smul(x, y)
+  shll.6: bits[32] = shll(x, z)
+  and_reduce.7: bits[1] = and_reduce(shll.6)
+  concat.8: bits[34] = concat(ult.4, and_reduce.7, x)
+  bit_slice.9: bits[30] = bit_slice(concat.8, start=3, width=30)
+  zero_ext.10: bits[64] = zero_ext(bit_slice.9, new_bit_count=64)
+  sign_ext.11: bits[64] = sign_ext(z, new_bit_count=64)
+  dynamic_bit_slice.12: bits[64] = dynamic_bit_slice(smul.5, z, width=64)
+  xor.13: bits[64] = xor(zero_ext.10, sign_ext.11, dynamic_bit_slice.12)
+  encode.14: bits[3] = encode(z)
+  decode.15: bits[8] = decode(encode.14, width=8)
+  zero_ext.16: bits[64] = zero_ext(decode.15, new_bit_count=64)
+  ret or.17: bits[64] = or(xor.13, zero_ext.16)
+}
+)");
+}
+
+TEST(IrSerializerTest, Literals) {
+  RoundTripAndCheckDump(R"(package p
+
+fn f() -> (bits[1], bits[0], bits[96], bits[65][2], (bits[3], ())) {
+  literal.1: bits[1] = literal(value=1)
+  literal.2: bits[0] = literal(value=0)
+  literal.3: bits[96] = literal(value=0xaaaa_bbbb_1234_5678_90ab_cdef)
+  literal.4: bits[65][2] = literal(value=[0x1_ffff_ffff_ffff_ffff, 0x1_0000_0000_0000_0000])
+  literal.5: (bits[3], ()) = literal(value=(5, ()))
+  ret tuple.6: (bits[1], bits[0], bits[96], bits[65][2], (bits[3], ())) = tuple(literal.1, literal.2, literal.3, literal.4, literal.5)
+}
+)");
+}
+
+TEST(IrSerializerTest, SelectsAndAggregates) {
+  RoundTripAndCheckDump(R"(package p
+
+fn f(p: bits[2], x: bits[32], y: bits[32], a: bits[32][3], t: token) -> (bits[32], bits[32], bits[32], bits[4], bits[32][3], token) {
+  literal.1: bits[32] = literal(value=0)
+  sel.2: bits[32] = sel(p, cases=[x, y, literal.1], default=y)
+  one_hot.3: bits[3] = one_hot(p, lsb_prio=false)
+  one_hot_sel.4: bits[32] = one_hot_sel(one_hot.3, cases=[x, y, literal.1])
+  array_index.5: bits[32] = array_index(a, p)
+  array.6: bits[32][3] = array(x, y, sel.2)
+  array_update.7: bits[32][3] = array_update(array.6, p, one_hot_sel.4)
+  tuple.8: (bits[32], bits[32][3]) = tuple(array_index.5, array_update.7)
+  tuple_index.9: bits[32] = tuple_index(tuple.8, index=0)
+  bit_slice.10: bits[3] = bit_slice(x, start=1, width=3)
+  one_hot.11: bits[4] = one_hot(bit_slice.10, lsb_prio=true)
+  after_all.12: token = after_all(t, t)
+  ret tuple.13: (bits[32], bits[32], bits[32], bits[4], bits[32][3], token) = tuple(sel.2, one_hot_sel.4, tuple_index.9, one_hot.11, array_update.7, after_all.12)
+}
+)");
+}
+
+TEST(IrSerializerTest, FunctionApplication) {
+  RoundTripAndCheckDump(R"(package p
+
+fn body(i: bits[11], accum: bits[11], inv: bits[11]) -> bits[11] {
+  add.3: bits[11] = add(accum, i)
+  ret add.4: bits[11] = add(add.3, inv)
+}
+
+fn negate(x: bits[11]) -> bits[11] {
+  ret neg.6: bits[11] = neg(x)
+}
+
+fn main(a: bits[11][4]) -> (bits[11], bits[11][4], bits[11]) {
+  literal.8: bits[11] = literal(value=1)
+  counted_for.9: bits[11] = counted_for(literal.8, trip_count=7, stride=2, body=body, invariant_args=[literal.8])
+  map.10: bits[11][4] = map(a, to_apply=negate)
+  invoke.11: bits[11] = invoke(counted_for.9, to_apply=negate)
+  ret tuple.12: (bits[11], bits[11][4], bits[11]) = tuple(counted_for.9, map.10, invoke.11)
+}
+)");
+}
+
+TEST(IrSerializerTest, ReturnsParam) {
+  RoundTripAndCheckDump(R"(package p
+
+fn f(x: bits[32], y: bits[16]) -> bits[16] {
+  ret param.2: bits[16] = param(name=y)
+}
+)");
+}
+
+TEST(IrSerializerTest, TypesAreInterned) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package p
+
+fn f(x: bits[32], y: bits[32]) -> (bits[32], bits[32]) {
+  add.1: bits[32] = add(x, y)
+  sub.2: bits[32] = sub(x, y)
+  ret tuple.3: (bits[32], bits[32]) = tuple(add.1, sub.2)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(PackageProto proto, PackageToProto(*package));
+  EXPECT_EQ(proto.version(), kPackageProtoVersion);
+  // bits[32] and the tuple type.
+  ASSERT_EQ(proto.types_size(), 2);
+  EXPECT_EQ(proto.types(1).type_enum(), TypeProto::TUPLE);
+  EXPECT_THAT(proto.types(1).tuple_elements(), ::testing::ElementsAre(0, 0));
+  ASSERT_EQ(proto.functions_size(), 1);
+  const FunctionProto& f = proto.functions(0);
+  ASSERT_EQ(f.nodes_size(), 5);
+  // Operands are distances back to the operand node.
+  EXPECT_THAT(f.nodes(4).operands(), ::testing::ElementsAre(2, 1));
+  EXPECT_EQ(f.return_value(), 4);
+}
+
+TEST(IrSerializerTest, SmallerThanText) {
+  std::string ir_text = "package p\n\nfn f(x: bits[64]) -> bits[64] {\n";
+  std::string last = "x";
+  for (int64 i = 1; i <= 100; ++i) {
+    absl::StrAppendFormat(&ir_text,
+                          "  literal.%d: bits[64] = literal(value=%d)\n",
+                          2 * i, 1000000 * i);
+    absl::StrAppendFormat(&ir_text,
+                          "  add.%d: bits[64] = add(%s, literal.%d)\n",
+                          2 * i + 1, last, 2 * i);
+    last = absl::StrFormat("add.%d", 2 * i + 1);
+  }
+  absl::StrAppendFormat(&ir_text,
+                        "  ret identity.500: bits[64] = identity(%s)\n}\n",
+                        last);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string serialized, SerializePackage(*package));
+  EXPECT_LT(serialized.size(), package->DumpIr().size() / 2);
+}
+
+TEST(IrSerializerTest, SetsEntry) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package p
+
+fn f(x: bits[32]) -> bits[32] {
+  ret neg.1: bits[32] = neg(x)
+}
+
+fn g(x: bits[32]) -> bits[32] {
+  ret not.3: bits[32] = not(x)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string serialized, SerializePackage(*package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> deserialized,
+                           DeserializePackage(serialized, "f"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * entry, deserialized->EntryFunction());
+  EXPECT_EQ(entry->name(), "f");
+  EXPECT_THAT(DeserializePackage(serialized, "h").status(),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+// Returns the index in "function" of its first node satisfying "pred".
+template <typename Pred>
+int64 NodeIndex(const FunctionProto& function, Pred pred) {
+  for (int64 i = 0; i < function.nodes_size(); ++i) {
+    if (pred(function.nodes(i))) {
+      return i;
+    }
+  }
+  ADD_FAILURE() << "No such node in function " << function.name();
+  return -1;
+}
+
+int64 NodeIndexOfOp(const FunctionProto& function, OpProto op) {
+  return NodeIndex(function,
+                   [&](const NodeProto& node) { return node.op() == op; });
+}
+
+int64 NodeIndexOfParam(const FunctionProto& function, absl::string_view name) {
+  return NodeIndex(function, [&](const NodeProto& node) {
+    return node.op() == OP_PARAM && node.name() == name;
+  });
+}
+
+TEST(IrSerializerTest, RejectsOtherVersion) {
+  PackageProto proto;
+  proto.set_version(kPackageProtoVersion + 1);
+  proto.set_name("p");
+  EXPECT_THAT(PackageFromProto(proto).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unsupported serialized package version")));
+}
+
+TEST(IrSerializerTest, RejectsMalformedInput) {
+  EXPECT_THAT(DeserializePackage("not a proto\xff\xff").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package p
+
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  ret add.1: bits[32] = add(x, y)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(PackageProto proto, PackageToProto(*package));
+  {
+    PackageProto bad_operand = proto;
+    bad_operand.mutable_functions(0)->mutable_nodes(2)->set_operands(0, 3);
+    EXPECT_THAT(PackageFromProto(bad_operand).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Invalid operand reference")));
+  }
+  {
+    PackageProto bad_arity = proto;
+    bad_arity.mutable_functions(0)->mutable_nodes(2)->add_operands(1);
+    EXPECT_THAT(PackageFromProto(bad_arity).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Invalid operand count")));
+  }
+  {
+    PackageProto bad_type = proto;
+    bad_type.mutable_functions(0)->mutable_nodes(2)->set_type(7);
+    EXPECT_THAT(PackageFromProto(bad_type).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Invalid type index")));
+  }
+}
+
+TEST(IrSerializerTest, RejectsIllTypedNodes) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package p
+
+fn negate(x: bits[11]) -> bits[11] {
+  ret neg.2: bits[11] = neg(x)
+}
+
+fn main(a: bits[11][4], b: bits[11], t: (bits[11], bits[8])) -> (bits[11], bits[11][4], bits[11], bits[4]) {
+  tuple_index.6: bits[11] = tuple_index(t, index=0)
+  map.7: bits[11][4] = map(a, to_apply=negate)
+  invoke.8: bits[11] = invoke(b, to_apply=negate)
+  encode.9: bits[4] = encode(b)
+  ret tuple.10: (bits[11], bits[11][4], bits[11], bits[4]) = tuple(tuple_index.6, map.7, invoke.8, encode.9)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(PackageProto proto, PackageToProto(*package));
+  XLS_ASSERT_OK(PackageFromProto(proto).status());
+  const FunctionProto& main = proto.functions(1);
+  int64 t_index = NodeIndexOfParam(main, "t");
+  int64 b_index = NodeIndexOfParam(main, "b");
+
+  // Points the only operand of the node at "index" to the node at "operand".
+  auto set_operand = [](PackageProto* proto, int64 index, int64 operand) {
+    NodeProto* node = proto->mutable_functions(1)->mutable_nodes(index);
+    ASSERT_EQ(node->operands_size(), 1);
+    node->set_operands(0, index - operand);
+  };
+  {
+    PackageProto bad_index = proto;
+    for (int64 index : {2, 5, -1}) {
+      bad_index.mutable_functions(1)
+          ->mutable_nodes(NodeIndexOfOp(main, OP_TUPLE_INDEX))
+          ->set_index(index);
+      EXPECT_THAT(PackageFromProto(bad_index).status(),
+                  StatusIs(absl::StatusCode::kInvalidArgument,
+                           HasSubstr("Invalid index")));
+    }
+  }
+  {
+    PackageProto map_of_bits = proto;
+    set_operand(&map_of_bits, NodeIndexOfOp(main, OP_MAP), b_index);
+    EXPECT_THAT(PackageFromProto(map_of_bits).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Operand 0 of map node 7 is not an array")));
+  }
+  {
+    PackageProto extra_arg = proto;
+    extra_arg.mutable_functions(1)
+        ->mutable_nodes(NodeIndexOfOp(main, OP_INVOKE))
+        ->add_operands(1);
+    EXPECT_THAT(PackageFromProto(extra_arg).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("passes 2 arguments to function negate, "
+                                   "which takes 1")));
+  }
+  {
+    PackageProto ill_typed_arg = proto;
+    set_operand(&ill_typed_arg, NodeIndexOfOp(main, OP_INVOKE), t_index);
+    EXPECT_THAT(PackageFromProto(ill_typed_arg).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Argument 0 of invoke node 8 has type "
+                                   "(bits[11], bits[8])")));
+  }
+  {
+    PackageProto encode_of_tuple = proto;
+    set_operand(&encode_of_tuple, NodeIndexOfOp(main, OP_ENCODE), t_index);
+    EXPECT_THAT(PackageFromProto(encode_of_tuple).status(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("is not bits")));
+  }
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,7 +14,10 @@
 
 #include "xls/ir/node.h"
 
+#include <tuple>
+
 #include "absl/algorithm/container.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -57,11 +60,9 @@ void Node::AddOptionalOperand(absl::optional<Node*> operand) {
   }
 }
 
-absl::Status Node::AddNodeToFunctionAndReplace(
-    std::unique_ptr<Node> replacement) {
-  Node* replacement_ptr = function()->AddNode(std::move(replacement));
-  XLS_RETURN_IF_ERROR(Verify(replacement_ptr));
-  return ReplaceUsesWith(replacement_ptr).status();
+absl::Status Node::VerifyAndReplaceUsesWith(Node* replacement) {
+  XLS_RETURN_IF_ERROR(Verify(replacement));
+  return ReplaceUsesWith(replacement).status();
 }
 
 void Node::AddUser(Node* user) {
@@ -296,6 +297,11 @@ bool Node::IsDefinitelyEqualTo(const Node* other) const {
   return same_type(this, other);
 }
 
+size_t Node::StructuralHash() const {
+  return absl::Hash<std::tuple<Op, absl::Span<Node* const>, size_t>>()(
+      std::make_tuple(op(), operands(), AttributeHash()));
+}
+
 std::string Node::GetName() const {
   if (Is<Param>()) {
     return As<Param>()->name();
@@ -478,6 +484,9 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
     }
   }
   old_operand->RemoveUser(this);
+  if (did_replace) {
+    NotifyOperandChanged(old_operand);
+  }
   return did_replace;
 }
 
@@ -491,6 +500,7 @@ absl::Status Node::ReplaceOperandNumber(int64 operand_no, Node* new_operand) {
   // node in another operand slot, it is safe to call.
   new_operand->AddUser(this);
   operands_[operand_no] = new_operand;
+  NotifyOperandChanged(old_operand);
 
   for (Node* operand : operands()) {
     if (operand == old_operand) {
@@ -502,6 +512,23 @@ absl::Status Node::ReplaceOperandNumber(int64 operand_no, Node* new_operand) {
   return absl::OkStatus();
 }
 
+void Node::SwapOperands(int64 a, int64 b) {
+  // Operand/user chains already set up properly.
+  std::swap(operands_[a], operands_[b]);
+  NotifyOperandChanged(/*old_operand=*/nullptr);
+}
+
+void Node::NotifyOperandChanged(Node* old_operand) {
+  ++function()->modification_epoch_;
+  function()->MarkDirty(this);
+  if (old_operand != nullptr) {
+    function()->MarkDirty(old_operand);
+  }
+  for (ChangeListener* listener : function()->change_listeners()) {
+    listener->OperandChanged(this, old_operand);
+  }
+}
+
 xabsl::StatusOr<bool> Node::ReplaceUsesWith(Node* replacement) {
   XLS_RET_CHECK(GetType() == replacement->GetType())
       << "type was: " << GetType()->ToString()
@@ -100,26 +100,25 @@ class Node {
   // variadic args are the constructor arguments with the exception of the first
   // loc argument and the final Function* argument which are inherited from this
   // node. Returns a pointer to the newly constructed node.
+  // Defined in function.h.
   template <typename NodeT, typename... Args>
-  xabsl::StatusOr<NodeT*> ReplaceUsesWithNew(Args&&... args) {
-    std::unique_ptr<NodeT> new_node = absl::make_unique<NodeT>(
-        loc(), std::forward<Args>(args)..., function());
-    NodeT* ptr = new_node.get();
-    XLS_RETURN_IF_ERROR(AddNodeToFunctionAndReplace(std::move(new_node)));
-    return ptr;
-  }
+  xabsl::StatusOr<NodeT*> ReplaceUsesWithNew(Args&&... args);
 
   // Swaps the operands at indices 'a' and 'b' in the operands sequence.
-  void SwapOperands(int64 a, int64 b) {
-    // Operand/user chains already set up properly.
-    std::swap(operands_[a], operands_[b]);
-  }
+  void SwapOperands(int64 a, int64 b);
 
   // Returns true if analysis indicates that this node always produces the
   // same value as 'other' when run with the same operands. The analysis is
   // conservative and false may be returned for some "equivalent" nodes.
   virtual bool IsDefinitelyEqualTo(const Node* other) const;
 
+  // Returns a hash of the op, the operands and the op-specific attributes
+  // (e.g., the value of a literal or the bounds of a bit slice) of this node.
+  // Nodes with the same operands for which IsDefinitelyEqualTo is true have the
+  // same hash. Operands are hashed by identity, so this takes time linear in
+  // the number of operands and attributes, and does not allocate.
+  size_t StructuralHash() const;
+
   // Returns whether this Op is of the template argument subclass. For example:
   // Is<Param>().
   template <typename OpT>
@@ -181,6 +180,13 @@ class Node {
 
   int64 id() const { return id_; }
 
+  // Returns the index of this node in its function. Node indices are dense:
+  // they are unique among the nodes of the function and less than
+  // Function::node_index_limit(). They are assigned in the order the nodes are
+  // added to the function and only change when the function compacts them
+  // (see Function::CompactNodeIndices).
+  int64 node_index() const { return node_index_; }
+
   // Note: use with caution, the id should be unique among all nodes in a
   // function.
   void set_id(int64 id) { id_ = id; }
@@ -213,16 +219,28 @@ class Node {
   // links as with AddOperand.
   void AddOptionalOperand(absl::optional<Node*> operand);
 
-  // Adds the given node to this node's function and replaces this node's uses
-  // with the node.
-  absl::Status AddNodeToFunctionAndReplace(std::unique_ptr<Node> replacement);
+  // Returns a hash of the attributes compared by the IsDefinitelyEqualTo
+  // override of the subclass, if any.
+  virtual size_t AttributeHash() const { return 0; }
+
+  // Verifies "replacement", a node newly added to this node's function, and
+  // replaces this node's uses with it.
+  absl::Status VerifyAndReplaceUsesWith(Node* replacement);
 
  private:
   void AddUser(Node* user);
   void RemoveUser(Node* user);
 
+  // Notifies the change listeners of the function that the operands of this
+  // node changed, and marks this node and "old_operand" dirty in the function.
+  void NotifyOperandChanged(Node* old_operand);
+
   Function* function_;
   int64 id_;
+  int64 node_index_ = -1;
+  // The size of the node if it was allocated in the arena of the function, or
+  // zero if it was allocated on the heap.
+  int64 arena_size_ = 0;
   Op op_;
   Type* type_;
 
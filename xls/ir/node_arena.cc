@@ -0,0 +1,59 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_arena.h"
+
+#include <algorithm>
+
+#include "xls/common/logging/logging.h"
+#include "xls/common/math_util.h"
+
+namespace xls {
+
+void* NodeArena::Allocate(int64 size) {
+  XLS_CHECK_GT(size, 0);
+  int64 units = CeilOfRatio(size, kAlignment);
+  int64 bytes = units * kAlignment;
+  allocated_bytes_ += bytes;
+  if (units < free_lists_.size() && free_lists_[units] != nullptr) {
+    FreeBlock* block = free_lists_[units];
+    free_lists_[units] = block->next;
+    return block;
+  }
+  if (end_ - next_ < bytes) {
+    // Abandon the remainder of the current chunk. Objects larger than a chunk
+    // get a chunk of their own.
+    int64 chunk_bytes = std::max(bytes, kChunkBytes);
+    chunks_.push_back(std::unique_ptr<char[]>(new char[chunk_bytes]));
+    reserved_bytes_ += chunk_bytes;
+    next_ = chunks_.back().get();
+    end_ = next_ + chunk_bytes;
+  }
+  void* result = next_;
+  next_ += bytes;
+  return result;
+}
+
+void NodeArena::Deallocate(void* ptr, int64 size) {
+  int64 units = CeilOfRatio(size, kAlignment);
+  allocated_bytes_ -= units * kAlignment;
+  if (units >= free_lists_.size()) {
+    free_lists_.resize(units + 1, nullptr);
+  }
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = free_lists_[units];
+  free_lists_[units] = block;
+}
+
+}  // namespace xls
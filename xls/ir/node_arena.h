@@ -0,0 +1,76 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_NODE_ARENA_H_
+#define XLS_IR_NODE_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "xls/common/integral_types.h"
+
+namespace xls {
+
+// Allocator for the nodes of a function. Memory is carved out of large chunks,
+// so the nodes of a function are close together in memory and allocating a
+// node rarely calls the system allocator. Deallocated memory is kept on a free
+// list per allocation size and reused by later allocations of the same size.
+// All memory is released when the arena is destroyed.
+//
+// Not thread-safe: a function and its arena are only mutated by one thread at
+// a time.
+class NodeArena {
+ public:
+  NodeArena() = default;
+  NodeArena(const NodeArena&) = delete;
+  NodeArena& operator=(const NodeArena&) = delete;
+
+  // Returns uninitialized memory of "size" bytes, aligned for any object.
+  void* Allocate(int64 size);
+
+  // Returns the memory at "ptr", previously returned by Allocate(size), to the
+  // arena.
+  void Deallocate(void* ptr, int64 size);
+
+  // Returns the number of bytes obtained from the system allocator.
+  int64 reserved_bytes() const { return reserved_bytes_; }
+
+  // Returns the number of bytes allocated and not yet deallocated.
+  int64 allocated_bytes() const { return allocated_bytes_; }
+
+ private:
+  static constexpr int64 kAlignment = alignof(std::max_align_t);
+  static constexpr int64 kChunkBytes = 64 * 1024;
+
+  // Header overlaid on deallocated memory.
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  // The unused remainder of the last chunk.
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+
+  // Free lists indexed by allocation size in units of kAlignment.
+  std::vector<FreeBlock*> free_lists_;
+
+  int64 reserved_bytes_ = 0;
+  int64 allocated_bytes_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_NODE_ARENA_H_
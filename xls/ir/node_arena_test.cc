@@ -0,0 +1,73 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "xls/common/integral_types.h"
+
+namespace xls {
+namespace {
+
+TEST(NodeArenaTest, AllocationsAreAlignedAndDisjoint) {
+  NodeArena arena;
+  char* a = static_cast<char*>(arena.Allocate(24));
+  char* b = static_cast<char*>(arena.Allocate(1));
+  char* c = static_cast<char*>(arena.Allocate(100));
+  for (char* ptr : {a, b, c}) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t), 0);
+  }
+  memset(a, 1, 24);
+  memset(b, 2, 1);
+  memset(c, 3, 100);
+  EXPECT_EQ(a[23], 1);
+  EXPECT_EQ(b[0], 2);
+  EXPECT_EQ(c[0], 3);
+  EXPECT_GE(arena.allocated_bytes(), 125);
+  EXPECT_GE(arena.reserved_bytes(), arena.allocated_bytes());
+}
+
+TEST(NodeArenaTest, DeallocatedMemoryIsReused) {
+  NodeArena arena;
+  void* a = arena.Allocate(64);
+  void* b = arena.Allocate(64);
+  int64 allocated_bytes = arena.allocated_bytes();
+  arena.Deallocate(a, 64);
+  EXPECT_LT(arena.allocated_bytes(), allocated_bytes);
+
+  // Allocations of a different size do not reuse the block.
+  void* c = arena.Allocate(256);
+  EXPECT_NE(c, a);
+  EXPECT_EQ(arena.Allocate(64), a);
+  EXPECT_NE(arena.Allocate(64), b);
+}
+
+TEST(NodeArenaTest, LargeAllocations) {
+  NodeArena arena;
+  int64 size = 1 << 20;
+  char* a = static_cast<char*>(arena.Allocate(size));
+  memset(a, 0, size);
+  EXPECT_GE(arena.reserved_bytes(), size);
+  // Many small allocations span several chunks.
+  for (int64 i = 0; i < 10000; ++i) {
+    arena.Allocate(48);
+  }
+  EXPECT_GE(arena.allocated_bytes(), size + 10000 * 48);
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,14 +14,35 @@
 
 #include "xls/ir/node_iterator.h"
 
-#include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/logging/logging.h"
+#include "xls/ir/node_map.h"
 
 namespace xls {
 
-void NodeIterator::Initialize() {
+/* static */
+std::shared_ptr<const std::vector<Node*>> NodeIterator::GetOrder(Function* f,
+                                                                 bool reverse) {
+  Function::TopoSortCache& cache = f->topo_sort_cache_;
+  absl::MutexLock lock(&cache.mutex);
+  if (cache.epoch != f->modification_epoch()) {
+    cache.order = std::make_shared<const std::vector<Node*>>(ComputeOrder(f));
+    cache.reverse_order = nullptr;
+    cache.epoch = f->modification_epoch();
+  }
+  if (!reverse) {
+    return cache.order;
+  }
+  if (cache.reverse_order == nullptr) {
+    cache.reverse_order = std::make_shared<const std::vector<Node*>>(
+        cache.order->rbegin(), cache.order->rend());
+  }
+  return cache.reverse_order;
+}
+
+/* static */
+std::vector<Node*> NodeIterator::ComputeOrder(Function* f) {
   // For topological traversal we only add nodes to the order when all of its
   // users have been scheduled.
   //
@@ -34,51 +55,49 @@ void NodeIterator::Initialize() {
   // the "pending_to_remaining_users" mapping if it is not yet present -- this
   // keeps track of how many more users must be seen (before that node is ready
   // to place into the ordering).
-  absl::flat_hash_map<Node*, int64> pending_to_remaining_users;
-  pending_to_remaining_users.reserve(f_->node_count());
+  NodeMap<int64> pending_to_remaining_users(f);
   std::deque<Node*> ready;
 
-  ordered_ = absl::make_unique<std::vector<Node*>>();
-  ordered_->reserve(f_->node_count());
+  std::vector<Node*> ordered;
+  ordered.reserve(f->node_count());
 
   auto is_scheduled = [&](Node* n) {
-    auto it = pending_to_remaining_users.find(n);
-    if (it == pending_to_remaining_users.end()) {
-      return false;
-    }
-    return it->second < 0;
+    return pending_to_remaining_users.contains(n) &&
+           pending_to_remaining_users.at(n) < 0;
   };
   auto all_users_scheduled = [&](Node* n) {
     return absl::c_all_of(n->users(), is_scheduled);
   };
   auto bump_down_remaining_users = [&](Node* n) {
     XLS_CHECK(!n->users().empty());
-    auto result = pending_to_remaining_users.insert({n, n->users().size()});
-    auto it = result.first;
-    int64& remaining_users = it->second;
+    if (!pending_to_remaining_users.contains(n)) {
+      pending_to_remaining_users[n] = n->users().size();
+    }
+    int64& remaining_users = pending_to_remaining_users[n];
     XLS_CHECK_GT(remaining_users, 0);
     remaining_users -= 1;
     XLS_VLOG(4) << "Bumped down remaining users for: " << n
                 << "; now: " << remaining_users;
     if (remaining_users == 0) {
-      ready.push_back(result.first->first);
+      ready.push_back(n);
       remaining_users -= 1;
     }
   };
+  NodeMap<Node*> last_bumped_by(f);
   auto add_to_order = [&](Node* r) {
     XLS_VLOG(4) << "Adding node to order: " << r;
     XLS_DCHECK(all_users_scheduled(r))
         << r << " users size: " << r->users().size();
-    ordered_->push_back(r);
+    ordered.push_back(r);
 
     // We want to be careful to only bump down our operands once, since we're a
     // single user, even though we may refer to them multiple times in our
-    // operands sequence.
-    absl::flat_hash_set<Node*> seen_operands;
-
+    // operands sequence. Each node is added to the order once, so recording
+    // the last user which bumped down an operand identifies repeats.
     for (auto it = r->operands().rbegin(); it != r->operands().rend(); ++it) {
       Node* o = *it;
-      if (seen_operands.insert(o).second) {
+      if (!last_bumped_by.contains(o) || last_bumped_by.at(o) != r) {
+        last_bumped_by[o] = r;
         // When we bump down the remaining users for the operand it may enter
         // the back of the ready queue.
         bump_down_remaining_users(o);
@@ -88,11 +107,12 @@ void NodeIterator::Initialize() {
 
   auto seed_ready = [&](Node* n) {
     ready.push_front(n);
-    XLS_CHECK(pending_to_remaining_users.insert({n, -1}).second);
+    XLS_CHECK(!pending_to_remaining_users.contains(n));
+    pending_to_remaining_users[n] = -1;
   };
 
-  for (Node* node : f_->nodes()) {
-    if (node->users().empty() && node != f_->return_value()) {
+  for (Node* node : f->nodes()) {
+    if (node->users().empty() && node != f->return_value()) {
       XLS_DCHECK(all_users_scheduled(node));
       XLS_VLOG(4) << "At start node was ready: " << node;
       seed_ready(node);
@@ -100,9 +120,9 @@ void NodeIterator::Initialize() {
   }
 
   // Note: we special case the return value so it always comes at the front.
-  XLS_VLOG(4) << "Maybe marking return value as ready: " << f_->return_value();
-  if (f_->return_value()->users().empty()) {
-    seed_ready(f_->return_value());
+  XLS_VLOG(4) << "Maybe marking return value as ready: " << f->return_value();
+  if (f->return_value()->users().empty()) {
+    seed_ready(f->return_value());
   }
 
   while (!ready.empty()) {
@@ -113,12 +133,15 @@ void NodeIterator::Initialize() {
 
 #ifdef DEBUG
   // Validate all members in the pending mapping have been scheduled.
-  for (const auto& item : pending_to_remaining_users) {
-    XLS_CHECK_LT(item.second, 0) << item.first;
+  for (Node* node : f->nodes()) {
+    if (pending_to_remaining_users.contains(node)) {
+      XLS_CHECK_LT(pending_to_remaining_users.at(node), 0) << node;
+    }
   }
 #endif
 
-  absl::c_reverse(*ordered_);
+  absl::c_reverse(ordered);
+  return ordered;
 }
 
 }  // namespace xls
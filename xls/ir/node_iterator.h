@@ -15,6 +15,9 @@
 #ifndef XLS_IR_NODE_ITERATOR_H_
 #define XLS_IR_NODE_ITERATOR_H_
 
+#include <memory>
+#include <vector>
+
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
 
@@ -23,36 +26,44 @@ namespace xls {
 // A type that orders the reachable nodes in a function into a usable traversal
 // order. Currently just does a stable topological ordering.
 //
+// The order is cached by the function and shared by all NodeIterators created
+// until the function is next modified (see Function::modification_epoch), so
+// repeated traversals of an unchanged function do not recompute it. A
+// NodeIterator holds on to the order it was created with: modifying the
+// function during the traversal does not change the nodes visited.
+//
 // Note that this container value must outlive any iterators derived from it
 // (via begin()/end()).
 class NodeIterator {
  public:
   static NodeIterator Create(Function* f) {
-    NodeIterator it(f);
-    it.Initialize();
-    return it;
+    return NodeIterator(GetOrder(f, /*reverse=*/false));
   }
 
   static NodeIterator CreateReverse(Function* f) {
-    NodeIterator it(f);
-    it.Initialize();
-    std::reverse(it.ordered_->begin(), it.ordered_->end());
-    return it;
+    return NodeIterator(GetOrder(f, /*reverse=*/true));
   }
 
-  std::vector<Node*>::iterator begin() { return ordered_->begin(); }
-  std::vector<Node*>::iterator end() { return ordered_->end(); }
+  std::vector<Node*>::const_iterator begin() const { return ordered_->begin(); }
+  std::vector<Node*>::const_iterator end() const { return ordered_->end(); }
 
  private:
-  explicit NodeIterator(Function* f) : f_(f) {}
+  explicit NodeIterator(std::shared_ptr<const std::vector<Node*>> ordered)
+      : ordered_(std::move(ordered)) {}
+
+  // Returns the (reverse) topological order of the nodes of "f" from the cache
+  // of "f", computing it if "f" was modified since it was cached. Thread-safe
+  // for concurrent calls on an unchanging function.
+  static std::shared_ptr<const std::vector<Node*>> GetOrder(Function* f,
+                                                            bool reverse);
 
-  void Initialize();
+  // Computes the topological order of the nodes of "f".
+  static std::vector<Node*> ComputeOrder(Function* f);
 
-  // The vector of nodes is wrapped in a unique_ptr so that the
-  // NodeIterator may be movable but the iterators returned to the
-  // caller of begin()/end() are not invalidated by those moves.
-  std::unique_ptr<std::vector<Node*>> ordered_;
-  Function* f_;
+  // The vector of nodes is shared with the cache of the function, and held by
+  // pointer so that the iterators returned to the caller of begin()/end() are
+  // not invalidated by moves of the NodeIterator.
+  std::shared_ptr<const std::vector<Node*>> ordered_;
 };
 
 // Convenience function for concise use in foreach constructs; e.g.:
@@ -64,8 +75,8 @@ class NodeIterator {
 // Yields nodes in a stable topological traversal order (dependency ordering is
 // satisfied).
 //
-// Note that the ordering for all nodes is computed up front, *not*
-// incrementally as iteration proceeds.
+// Note that the ordering for all nodes is computed up front (or taken from the
+// cache of the function), *not* incrementally as iteration proceeds.
 inline NodeIterator TopoSort(Function* f) { return NodeIterator::Create(f); }
 
 // As above, but returns a reverse topo order.
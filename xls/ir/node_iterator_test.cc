@@ -14,6 +14,9 @@
 
 #include "xls/ir/node_iterator.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
@@ -267,5 +270,43 @@ TEST(NodeIteratorTest, RpoVsTopo) {
   EXPECT_EQ(rni.end(), it);
 }
 
+TEST(NodeIteratorTest, OrderIsCachedUntilModified) {
+  std::string program = R"(
+  fn f(x: bits[32], y: bits[32]) -> bits[32] {
+    neg.1: bits[32] = neg(x)
+    ret add.2: bits[32] = add(neg.1, y)
+  })";
+
+  Package p("p");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, Parser::ParseFunction(program, &p));
+  Node* x = f->params()[0];
+  Node* neg = f->return_value()->operand(0);
+
+  // Traversals of an unchanged function share the cached order.
+  NodeIterator first = TopoSort(f);
+  NodeIterator second = TopoSort(f);
+  EXPECT_EQ(&*first.begin(), &*second.begin());
+  std::vector<Node*> order(first.begin(), first.end());
+
+  // Modifying the function invalidates the cached order but not the order of
+  // existing NodeIterators.
+  int64 epoch = f->modification_epoch();
+  XLS_ASSERT_OK_AND_ASSIGN(Node * not_x, f->MakeNode<UnOp>(absl::nullopt, x,
+                                                           Op::kNot));
+  XLS_ASSERT_OK(neg->ReplaceOperandNumber(0, not_x));
+  EXPECT_GT(f->modification_epoch(), epoch);
+  EXPECT_EQ(std::vector<Node*>(first.begin(), first.end()), order);
+
+  NodeIterator third = TopoSort(f);
+  std::vector<Node*> new_order(third.begin(), third.end());
+  EXPECT_EQ(new_order.size(), order.size() + 1);
+  EXPECT_LT(std::find(new_order.begin(), new_order.end(), not_x),
+            std::find(new_order.begin(), new_order.end(), neg));
+
+  NodeIterator reverse = ReverseTopoSort(f);
+  std::reverse(new_order.begin(), new_order.end());
+  EXPECT_EQ(std::vector<Node*>(reverse.begin(), reverse.end()), new_order);
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,112 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_NODE_MAP_H_
+#define XLS_IR_NODE_MAP_H_
+
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+
+namespace xls {
+
+// Map from the nodes of a single function to values of type T, stored in a
+// vector indexed by node index (see Node::node_index). Lookups are an array
+// access rather than a hash of the node pointer, which makes NodeMap the
+// preferred side table for analyses which visit every node of a function.
+//
+// Nodes may be added to the function while the map is live. The map is
+// invalidated when the function compacts its node indices (see
+// Function::CompactNodeIndices), which is checked in debug builds.
+template <typename T>
+class NodeMap {
+ public:
+  explicit NodeMap(const Function* f)
+      : function_(f),
+        generation_(f->node_index_generation()),
+        values_(f->node_index_limit()) {}
+
+  const Function* function() const { return function_; }
+
+  // Returns the number of nodes with a value in the map.
+  int64 size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool contains(const Node* node) const {
+    CheckNode(node);
+    return node->node_index() < values_.size() &&
+           values_[node->node_index()].has_value();
+  }
+
+  // Returns the value of "node", inserting a default-constructed value if the
+  // map has none.
+  T& operator[](const Node* node) {
+    CheckNode(node);
+    if (node->node_index() >= values_.size()) {
+      values_.resize(function_->node_index_limit());
+    }
+    absl::optional<T>& value = values_[node->node_index()];
+    if (!value.has_value()) {
+      value.emplace();
+      ++size_;
+    }
+    return *value;
+  }
+
+  // Returns the value of "node", which must be in the map.
+  T& at(const Node* node) {
+    XLS_CHECK(contains(node)) << node->GetName();
+    return *values_[node->node_index()];
+  }
+  const T& at(const Node* node) const {
+    XLS_CHECK(contains(node)) << node->GetName();
+    return *values_[node->node_index()];
+  }
+
+  // Removes the value of "node", if any. Returns the number of values removed.
+  int64 erase(const Node* node) {
+    if (!contains(node)) {
+      return 0;
+    }
+    values_[node->node_index()].reset();
+    --size_;
+    return 1;
+  }
+
+  void clear() {
+    values_.clear();
+    size_ = 0;
+  }
+
+ private:
+  void CheckNode(const Node* node) const {
+    XLS_DCHECK_EQ(node->function(), function_) << node->GetName();
+    XLS_DCHECK_EQ(function_->node_index_generation(), generation_)
+        << "Node indices of function " << function_->name()
+        << " were compacted after the NodeMap was created";
+  }
+
+  const Function* function_;
+  int64 generation_;
+  std::vector<absl::optional<T>> values_;
+  int64 size_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_NODE_MAP_H_
@@ -0,0 +1,79 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_map.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace {
+
+class NodeMapTest : public IrTestBase {};
+
+TEST_F(NodeMapTest, InsertLookupErase) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  BValue y = b.Param("y", p->GetBitsType(32));
+  BValue add = b.Add(x, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.BuildWithReturnValue(add));
+
+  NodeMap<std::string> names(f);
+  EXPECT_TRUE(names.empty());
+  EXPECT_FALSE(names.contains(x.node()));
+  names[x.node()] = "x";
+  names[add.node()] = "add";
+  EXPECT_EQ(names.size(), 2);
+  EXPECT_TRUE(names.contains(x.node()));
+  EXPECT_FALSE(names.contains(y.node()));
+  EXPECT_EQ(names.at(add.node()), "add");
+
+  // operator[] inserts a default-constructed value.
+  EXPECT_EQ(names[y.node()], "");
+  EXPECT_EQ(names.size(), 3);
+
+  EXPECT_EQ(names.erase(x.node()), 1);
+  EXPECT_EQ(names.erase(x.node()), 0);
+  EXPECT_FALSE(names.contains(x.node()));
+  EXPECT_EQ(names.size(), 2);
+
+  names.clear();
+  EXPECT_TRUE(names.empty());
+  EXPECT_FALSE(names.contains(add.node()));
+}
+
+TEST_F(NodeMapTest, NodesAddedAfterConstruction) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.BuildWithReturnValue(b.Not(x)));
+
+  NodeMap<int64> values(f);
+  values[x.node()] = 1;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg,
+      f->MakeNode<UnOp>(absl::nullopt, x.node(), Op::kNeg));
+  EXPECT_FALSE(values.contains(neg));
+  values[neg] = 2;
+  EXPECT_EQ(values.at(x.node()), 1);
+  EXPECT_EQ(values.at(neg), 2);
+}
+
+}  // namespace
+}  // namespace xls
@@ -326,6 +326,63 @@ fn main() -> bits[11] {
   EXPECT_FALSE(nodes_equal("counted_for.13", "counted_for.16"));
 }
 
+TEST_F(NodeTest, StructuralHash) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package StructuralHash
+
+fn body(x: bits[11], y: bits[11]) -> bits[11] {
+  ret add.1: bits[11] = add(x, y)
+}
+
+fn same_as_body(a: bits[11], b: bits[11]) -> bits[11] {
+  ret add.2: bits[11] = add(a, b)
+}
+
+fn main(x: bits[11], y: bits[11]) -> bits[11] {
+  and.3: bits[11] = and(x, y)
+  and.4: bits[11] = and(x, y)
+  and.5: bits[11] = and(y, x)
+
+  literal.6: bits[11] = literal(value=42)
+  literal.7: bits[11] = literal(value=42)
+  literal.8: bits[11] = literal(value=43)
+  literal.9: bits[12] = literal(value=42)
+
+  bit_slice.10: bits[3] = bit_slice(x, start=3, width=3)
+  bit_slice.11: bits[3] = bit_slice(x, start=3, width=3)
+  bit_slice.12: bits[3] = bit_slice(x, start=2, width=3)
+
+  zero_ext.13: bits[20] = zero_ext(x, new_bit_count=20)
+  zero_ext.14: bits[20] = zero_ext(x, new_bit_count=20)
+  zero_ext.15: bits[21] = zero_ext(x, new_bit_count=21)
+
+  counted_for.16: bits[11] = counted_for(x, trip_count=7, stride=1, body=body)
+  counted_for.17: bits[11] = counted_for(x, trip_count=7, stride=1, body=same_as_body)
+  ret counted_for.18: bits[11] = counted_for(x, trip_count=8, stride=1, body=body)
+}
+)"));
+
+  auto hash = [&](absl::string_view name) {
+    return FindNode(name, p.get())->StructuralHash();
+  };
+  EXPECT_EQ(hash("and.3"), hash("and.4"));
+  EXPECT_NE(hash("and.3"), hash("and.5"));
+
+  EXPECT_EQ(hash("literal.6"), hash("literal.7"));
+  EXPECT_NE(hash("literal.6"), hash("literal.8"));
+  EXPECT_NE(hash("literal.6"), hash("literal.9"));
+
+  EXPECT_EQ(hash("bit_slice.10"), hash("bit_slice.11"));
+  EXPECT_NE(hash("bit_slice.10"), hash("bit_slice.12"));
+
+  EXPECT_EQ(hash("zero_ext.13"), hash("zero_ext.14"));
+  EXPECT_NE(hash("zero_ext.13"), hash("zero_ext.15"));
+
+  // Equivalent functions are equal, so the function is not hashed.
+  EXPECT_EQ(hash("counted_for.16"), hash("counted_for.17"));
+  EXPECT_NE(hash("counted_for.16"), hash("counted_for.18"));
+}
+
 TEST_F(NodeTest, ReplaceUses) {
   auto p = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
@@ -53,17 +53,22 @@ class DataMember(object):
     equals_tmpl: A Python format string defining the expression for testing this
       member for equality. The format fields are named 'lhs' and 'rhs'. Example:
         '{lhs}.EqualTo({rhs})'.
+    hashed: Whether the member is combined into the structural hash of the
+      node. Members which are not compared with '==' (see equals_tmpl) may only
+      be hashed if their absl hash is consistent with that comparison.
   """
 
   def __init__(self,
                name: str,
                cpp_type: str,
                init: str,
-               equals_tmpl: str = '{lhs} == {rhs}'):
+               equals_tmpl: str = '{lhs} == {rhs}',
+               hashed: bool = True):
     self.name = name
     self.cpp_type = cpp_type
     self.init = init
     self.equals_tmpl = equals_tmpl
+    self.hashed = hashed
 
 
 class Method(object):
@@ -109,6 +114,7 @@ class Attribute(object):
                arg_cpp_type: Optional[str] = None,
                return_cpp_type: Optional[str] = None,
                equals_tmpl: str = '{lhs} == {rhs}',
+               hashed: bool = True,
                init_args=None):
     """Initialize an Attribute.
 
@@ -124,6 +130,8 @@ class Attribute(object):
       equals_tmpl: A Python format string defining the expression for testing
         this member for equality. The format fields are named 'lhs' and 'rhs'.
         For example, '{lhs}.EqualTo({rhs})'.
+      hashed: Whether the attribute is combined into the structural hash of the
+        node.
       init_args: Optional arguments to pass to the data member constructor.
         If not specified, this is 'name', the name of the attribute constructor
         argument.
@@ -138,7 +146,8 @@ class Attribute(object):
         name=name + '_',
         cpp_type=cpp_type,
         init=name if init_args is None else ', '.join(init_args),
-        equals_tmpl=equals_tmpl)
+        equals_tmpl=equals_tmpl,
+        hashed=hashed)
     self.method = Method(
         name=name,
         return_cpp_type=cpp_type
@@ -164,7 +173,10 @@ class FunctionAttribute(Attribute):
     super(FunctionAttribute, self).__init__(
         name,
         cpp_type='Function*',
-        equals_tmpl='{lhs}->IsDefinitelyEqualTo({rhs})')
+        equals_tmpl='{lhs}->IsDefinitelyEqualTo({rhs})',
+        # Distinct but equivalent functions compare equal, so the pointer
+        # cannot be hashed.
+        hashed=False)
 
 
 class ValueAttribute(Attribute):
@@ -333,6 +345,14 @@ class OpClass(object):
     members.extend(self.extra_data_members)
     return members
 
+  def hashed_data_members(self) -> List[DataMember]:
+    """Returns the data members combined into the structural hash."""
+    return [m for m in self.data_members() if m.hashed]
+
+  def hashed_data_members_str(self) -> str:
+    """The hashed data members as a comma-separated list."""
+    return ', '.join(m.name for m in self.hashed_data_members())
+
   def equal_to_expr(self) -> str:
     """Returns expression used in IsDefinitelyEqualTo to compare expression."""
 
@@ -142,6 +142,7 @@ SourceLocation Package::AddSourceLocation(absl::string_view filename,
 
 std::string Package::SourceLocationToString(const SourceLocation loc) {
   const std::string unknown = "UNKNOWN";
+  absl::MutexLock lock(&mutex_);
   absl::string_view filename =
       fileno_to_filename_.find(loc.fileno()) != fileno_to_filename_.end()
           ? fileno_to_filename_.at(loc.fileno())
@@ -149,7 +150,19 @@ std::string Package::SourceLocationToString(const SourceLocation loc) {
   return absl::StrFormat("%s:%d", filename, loc.lineno().value());
 }
 
+bool Package::IsOwnedType(const Type* type) {
+  absl::MutexLock lock(&mutex_);
+  return owned_types_.find(type) != owned_types_.end();
+}
+
+bool Package::IsOwnedFunctionType(const FunctionType* function_type) {
+  absl::MutexLock lock(&mutex_);
+  return owned_function_types_.find(function_type) !=
+         owned_function_types_.end();
+}
+
 BitsType* Package::GetBitsType(int64 bit_count) {
+  absl::MutexLock lock(&mutex_);
   if (bit_count_to_type_.find(bit_count) != bit_count_to_type_.end()) {
     return &bit_count_to_type_.at(bit_count);
   }
@@ -161,10 +174,11 @@ BitsType* Package::GetBitsType(int64 bit_count) {
 
 ArrayType* Package::GetArrayType(int64 size, Type* element_type) {
   ArrayKey key{size, element_type};
+  absl::MutexLock lock(&mutex_);
   if (array_types_.find(key) != array_types_.end()) {
     return &array_types_.at(key);
   }
-  XLS_CHECK(IsOwnedType(element_type))
+  XLS_CHECK(owned_types_.count(element_type) != 0)
       << "Type is not owned by package: " << *element_type;
   auto it = array_types_.emplace(key, ArrayType(size, element_type));
   ArrayType* new_type = &(it.first->second);
@@ -174,11 +188,12 @@ ArrayType* Package::GetArrayType(int64 size, Type* element_type) {
 
 TupleType* Package::GetTupleType(absl::Span<Type* const> element_types) {
   TypeVec key(element_types.begin(), element_types.end());
+  absl::MutexLock lock(&mutex_);
   if (tuple_types_.find(key) != tuple_types_.end()) {
     return &tuple_types_.at(key);
   }
   for (const Type* element_type : element_types) {
-    XLS_CHECK(IsOwnedType(element_type))
+    XLS_CHECK(owned_types_.count(element_type) != 0)
         << "Type is not owned by package: " << *element_type;
   }
   auto it = tuple_types_.emplace(key, TupleType(element_types));
@@ -192,11 +207,12 @@ TokenType* Package::GetTokenType() { return &token_type_; }
 FunctionType* Package::GetFunctionType(absl::Span<Type* const> args_types,
                                        Type* return_type) {
   std::string key = FunctionType(args_types, return_type).ToString();
+  absl::MutexLock lock(&mutex_);
   if (function_types_.find(key) != function_types_.end()) {
     return &function_types_.at(key);
   }
   for (Type* t : args_types) {
-    XLS_CHECK(IsOwnedType(t))
+    XLS_CHECK(owned_types_.count(t) != 0)
         << "Parameter type is not owned by package: " << t->ToString();
   }
   auto it = function_types_.emplace(key, FunctionType(args_types, return_type));
@@ -285,6 +301,7 @@ Type* Package::GetTypeForValue(const Value& value) {
 
 Fileno Package::GetOrCreateFileno(absl::string_view filename) {
   // Attempt to add a new fileno/filename pair to the map.
+  absl::MutexLock lock(&mutex_);
   auto this_fileno = Fileno(filename_to_fileno_.size());
   if (auto it = filename_to_fileno_.find(std::string(filename));
       it != filename_to_fileno_.end()) {
@@ -15,6 +15,7 @@
 #ifndef XLS_IR_PACKAGE_H_
 #define XLS_IR_PACKAGE_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +25,7 @@
 #include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/integral_types.h"
 #include "xls/common/status/statusor.h"
 #include "xls/ir/fileno.h"
@@ -48,14 +50,12 @@ class Package {
   virtual ~Package();
 
   // Returns whether the given type is one of the types owned by this package.
-  bool IsOwnedType(const Type* type) {
-    return owned_types_.find(type) != owned_types_.end();
-  }
-  bool IsOwnedFunctionType(const FunctionType* function_type) {
-    return owned_function_types_.find(function_type) !=
-           owned_function_types_.end();
-  }
+  bool IsOwnedType(const Type* type);
+  bool IsOwnedFunctionType(const FunctionType* function_type);
 
+  // Returns the owned type with the given structure, creating it if
+  // necessary. These methods (and IsOwned*Type) are thread-safe so that passes
+  // may create nodes in different functions of the package concurrently.
   BitsType* GetBitsType(int64 bit_count);
   ArrayType* GetArrayType(int64 size, Type* element_type);
   TupleType* GetTupleType(absl::Span<Type* const> element_types);
@@ -108,7 +108,8 @@ class Package {
   std::string SourceLocationToString(const SourceLocation loc);
 
   // Retrieves the next node ID to assign to a node in the package and
-  // increments the next node counter. For use in node construction.
+  // increments the next node counter. For use in node construction. This is
+  // thread-safe, but ids are then assigned in the order the threads call it.
   int64 GetNextNodeId() { return next_node_id_++; }
 
   // Adds a file to the file-number table and returns its corresponding number.
@@ -159,43 +160,47 @@ class Package {
   std::string name_;
 
   // Ordinal to assign to the next node created in this package.
-  int64 next_node_id_ = 1;
+  std::atomic<int64> next_node_id_{1};
 
   std::vector<std::unique_ptr<Function>> functions_;
 
+  // Guards the owned types and the file-number tables.
+  mutable absl::Mutex mutex_;
+
   // Set of owned types in this package.
-  UnorderedSet<const Type*> owned_types_;
+  UnorderedSet<const Type*> owned_types_ ABSL_GUARDED_BY(mutex_);
 
   // Set of owned function types in this package.
-  UnorderedSet<const FunctionType*> owned_function_types_;
+  UnorderedSet<const FunctionType*> owned_function_types_
+      ABSL_GUARDED_BY(mutex_);
 
   // Mapping from bit count to the owned "bits" type with that many bits. Use
   // node_hash_map for pointer stability.
-  StableMap<int64, BitsType> bit_count_to_type_;
+  StableMap<int64, BitsType> bit_count_to_type_ ABSL_GUARDED_BY(mutex_);
 
   // Mapping from the size and element type of an array type to the owned
   // ArrayType. Use node_hash_map for pointer stability.
   using ArrayKey = std::pair<int64, const Type*>;
-  StableMap<ArrayKey, ArrayType> array_types_;
+  StableMap<ArrayKey, ArrayType> array_types_ ABSL_GUARDED_BY(mutex_);
 
   // Mapping from elements to the owned tuple type.
   //
   // Uses node_hash_map for pointer stability.
   using TypeVec = absl::InlinedVector<const Type*, 4>;
-  StableMap<TypeVec, TupleType> tuple_types_;
+  StableMap<TypeVec, TupleType> tuple_types_ ABSL_GUARDED_BY(mutex_);
 
   // Owned token type.
   TokenType token_type_;
 
   // Mapping from Type:ToString to the owned function type. Use
   // node_hash_map for pointer stability.
-  StableMap<std::string, FunctionType> function_types_;
+  StableMap<std::string, FunctionType> function_types_ ABSL_GUARDED_BY(mutex_);
 
   // Mapping of Fileno ids to string filenames, and vice-versa for reverse
   // lookups. These two data structures must be updated together for consistency
   // and should always contain the same number of entries.
-  UnorderedMap<Fileno, std::string> fileno_to_filename_;
-  UnorderedMap<std::string, Fileno> filename_to_fileno_;
+  UnorderedMap<Fileno, std::string> fileno_to_filename_ ABSL_GUARDED_BY(mutex_);
+  UnorderedMap<std::string, Fileno> filename_to_fileno_ ABSL_GUARDED_BY(mutex_);
 
 #include "xls/ir/container_hack_undef.inc"
 };
@@ -132,6 +132,11 @@ class Value {
   bool operator==(const Value& other) const;
   bool operator!=(const Value& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const Value& value) {
+    return H::combine(std::move(h), value.kind_, value.payload_);
+  }
+
  private:
   Value(ValueKind kind, absl::Span<const Value> elements)
       : kind_(kind),
@@ -59,7 +59,7 @@ inline bool ValueConformsToType(const Value& value, const Type* type) {
       return type->IsBits() &&
              value.bits().bit_count() == type->AsBitsOrDie()->bit_count();
     case ValueKind::kArray:
-      return type->IsArray() &&
+      return type->IsArray() && type->AsArrayOrDie()->size() == value.size() &&
              ValueConformsToType(value.element(0),
                                  type->AsArrayOrDie()->element_type());
     case ValueKind::kTuple: {
@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/hash/hash_testing.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/package.h"
@@ -149,4 +150,23 @@ TEST(ValueTest, IsAllZeroOnes) {
                    .IsAllOnes());
 }
 
+TEST(ValueTest, Hash) {
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly({
+      Value(UBits(0, 0)),
+      Value(UBits(0, 1)),
+      Value(UBits(1, 1)),
+      Value(UBits(42, 32)),
+      Value(UBits(42, 64)),
+      Value(UBits(42, 65)),
+      Value(Bits::AllOnes(200)),
+      Value::Token(),
+      Value::Tuple({}),
+      Value::Tuple({Value(UBits(42, 32))}),
+      Value::Tuple({Value(UBits(42, 32)), Value::Token()}),
+      Value::ArrayOrDie({Value(UBits(42, 32))}),
+      Value::ArrayOrDie({Value(UBits(42, 32)), Value(UBits(43, 32))}),
+      Value::ArrayOrDie({Value::Tuple({}), Value::Tuple({})}),
+  }));
+}
+
 }  // namespace xls
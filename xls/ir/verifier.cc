@@ -14,6 +14,7 @@
 
 #include "xls/ir/verifier.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
@@ -724,6 +725,41 @@ absl::Status VerifyNodeIdUnique(
   return absl::OkStatus();
 }
 
+// Verifies that the parameters in Function::params() are distinct and have
+// unique names, and returns the set of them.
+xabsl::StatusOr<absl::flat_hash_set<Node*>> VerifyParams(
+    Function* function) {
+  absl::flat_hash_set<std::string> param_names;
+  absl::flat_hash_set<Node*> param_set;
+  for (Node* param : function->params()) {
+    XLS_RET_CHECK(param_set.insert(param).second)
+        << "Param appears more than once in Function::params()";
+    XLS_RET_CHECK(param_names.insert(param->GetName()).second)
+        << "Param name " << param->GetName()
+        << " is duplicated in Function::params()";
+  }
+  return param_set;
+}
+
+// Verifies function names are unique within the package.
+absl::Status VerifyFunctionNamesUnique(Package* package) {
+  absl::flat_hash_set<Function*> functions;
+  absl::flat_hash_set<std::string> function_names;
+  for (auto& function : package->functions()) {
+    XLS_RET_CHECK(!function_names.contains(function->name()))
+        << "Function with name " << function->name()
+        << " is not unique within package " << package->name();
+    function_names.insert(function->name());
+
+    XLS_RET_CHECK(!functions.contains(function.get()))
+        << "Function with name " << function->name()
+        << " appears more than once in function list within package "
+        << package->name();
+    functions.insert(function.get());
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::Status Verify(Package* package) {
@@ -754,21 +790,7 @@ absl::Status Verify(Package* package) {
   }
   XLS_RET_CHECK_GT(package->next_node_id(), max_id_seen);
 
-  // Verify function names are unique within the package.
-  absl::flat_hash_set<Function*> functions;
-  absl::flat_hash_set<std::string> function_names;
-  for (auto& function : package->functions()) {
-    XLS_RET_CHECK(!function_names.contains(function->name()))
-        << "Function with name " << function->name()
-        << " is not unique within package " << package->name();
-    function_names.insert(function->name());
-
-    XLS_RET_CHECK(!functions.contains(function.get()))
-        << "Function with name " << function->name()
-        << " appears more than once in function list within package "
-        << package->name();
-    functions.insert(function.get());
-  }
+  XLS_RETURN_IF_ERROR(VerifyFunctionNamesUnique(package));
 
   // TODO(meheff): Verify main entry point is one of the functions.
   // TODO(meheff): Verify functions called by any node are in the set of
@@ -802,15 +824,8 @@ absl::Status Verify(Function* function) {
 
   // Verify the set of parameter nodes is exactly Function::params(), and that
   // the parameter names are unique.
-  absl::flat_hash_set<std::string> param_names;
-  absl::flat_hash_set<Node*> param_set;
-  for (Node* param : function->params()) {
-    XLS_RET_CHECK(param_set.insert(param).second)
-        << "Param appears more than once in Function::params()";
-    XLS_RET_CHECK(param_names.insert(param->GetName()).second)
-        << "Param name " << param->GetName()
-        << " is duplicated in Function::params()";
-  }
+  XLS_ASSIGN_OR_RETURN(absl::flat_hash_set<Node*> param_set,
+                       VerifyParams(function));
   int64 param_node_count = 0;
   for (Node* node : function->nodes()) {
     if (node->Is<Param>()) {
@@ -827,6 +842,39 @@ absl::Status Verify(Function* function) {
   return absl::OkStatus();
 }
 
+absl::Status VerifyIncremental(Package* package) {
+  for (auto& function : package->functions()) {
+    XLS_RET_CHECK(function->package() == package);
+    if (!function->tracking_dirty_nodes()) {
+      // Nothing is known about the changes to this function (e.g., it was
+      // just added), so verify all of it and track its changes from now on.
+      XLS_RETURN_IF_ERROR(Verify(function.get()));
+      for (Node* node : function->nodes()) {
+        XLS_RET_CHECK_LT(node->id(), package->next_node_id());
+      }
+      function->StartTrackingDirtyNodes();
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(absl::flat_hash_set<Node*> param_set,
+                         VerifyParams(function.get()));
+    for (Node* node : function->dirty_nodes()) {
+      XLS_RET_CHECK(package->IsOwnedType(node->GetType()));
+      XLS_RET_CHECK(node->package() == package);
+      // Nodes are added with fresh IDs, so instead of checking the IDs of all
+      // nodes for uniqueness only check the IDs of the changed nodes against
+      // the next ID of the package.
+      XLS_RET_CHECK_LT(node->id(), package->next_node_id());
+      if (node->Is<Param>()) {
+        XLS_RET_CHECK(param_set.contains(node))
+            << "Param " << node->GetName() << " is not in Function::params()";
+      }
+      XLS_RETURN_IF_ERROR(Verify(node));
+    }
+    function->ClearDirtyNodes();
+  }
+  return VerifyFunctionNamesUnique(package);
+}
+
 absl::Status Verify(Node* node) {
   XLS_VLOG(2) << "Verifying node: " << node->ToString();
 
@@ -30,6 +30,15 @@ class Package;
 // error status if a violation is found.
 absl::Status Verify(Package* package);
 
+// Verifies the invariants of the package which may have been broken by changes
+// since the last call, i.e., checks only the dirty nodes of each function (see
+// Function::dirty_nodes) and then clears them. Functions which are not yet
+// tracking dirty nodes are verified in full, and then start tracking them.
+// This is much cheaper than Verify on large packages but does not check all
+// invariants: e.g., node IDs are only checked against Package::next_node_id
+// rather than for uniqueness.
+absl::Status VerifyIncremental(Package* package);
+
 // Overload for functions.
 absl::Status Verify(Function* function);
 
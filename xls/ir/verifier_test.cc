@@ -155,5 +155,54 @@ fn f(p: bits[1], q: bits[42], r: bits[42], s:bits[42], t:bits[42]) -> bits[42] {
               "Selector must have at least 2 bits to select amongst 4 cases")));
 }
 
+TEST_F(VerifierTest, IncrementalVerifiesChangedNodes) {
+  std::string input = R"(
+package IncrementalVerifiesChangedNodes
+
+fn graph(p: bits[2], q: bits[42], r: bits[42]) -> bits[42] {
+  and.1: bits[42] = and(q, r)
+  ret neg.2: bits[42] = neg(and.1)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("graph"));
+  // The first incremental verification verifies the whole function, and
+  // starts tracking its changes.
+  EXPECT_FALSE(f->tracking_dirty_nodes());
+  XLS_ASSERT_OK(VerifyIncremental(p.get()));
+  EXPECT_TRUE(f->tracking_dirty_nodes());
+  EXPECT_TRUE(f->dirty_nodes().empty());
+  XLS_ASSERT_OK(VerifyIncremental(p.get()));
+
+  FindNode("and.1", f)->ReplaceOperand(FindNode("q", f), FindNode("p", f));
+  EXPECT_THAT(VerifyIncremental(p.get()),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Type of operand 0 (bits[2] via p) does not "
+                                 "match type of and.1")));
+}
+
+TEST_F(VerifierTest, IncrementalVerifiesNewReturnValue) {
+  std::string input = R"(
+package IncrementalVerifiesNewReturnValue
+
+fn graph(p: bits[2], q: bits[42], r: bits[42]) -> bits[42] {
+  and.1: bits[42] = and(q, r)
+  ret neg.2: bits[42] = neg(and.1)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("graph"));
+  XLS_ASSERT_OK(VerifyIncremental(p.get()));
+
+  // Changing the ID of a node doesn't dirty it, but making it the return value
+  // does.
+  Node* and_node = FindNode("and.1", f);
+  and_node->set_id(p->next_node_id());
+  XLS_ASSERT_OK(VerifyIncremental(p.get()));
+  f->set_return_value(and_node);
+  EXPECT_THAT(VerifyIncremental(p.get()),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,209 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+
+#include "absl/flags/flag.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/SHA1.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+ABSL_FLAG(std::string, jit_object_cache_dir, "",
+          "If non-empty, directory in which to persist JIT-compiled objects "
+          "across runs, so that re-JITting unchanged functions is cheap.");
+ABSL_FLAG(int64, jit_object_cache_max_bytes, int64{1} << 30,
+          "Maximum total size of the objects in --jit_object_cache_dir. The "
+          "least recently used objects are evicted past this bound.");
+
+namespace xls {
+namespace {
+
+// Bump whenever the JIT's lowering changes in a way that alters generated code
+// for the same IR; this invalidates all previously cached objects.
+constexpr int kCacheFormatVersion = 2;
+
+constexpr char kObjectExtension[] = ".o";
+
+// Distinguishes the temporary files of concurrent stores within the process.
+std::atomic<int64> next_temp_file_id{0};
+
+}  // namespace
+
+xabsl::StatusOr<std::unique_ptr<JitObjectCache>> JitObjectCache::Create(
+    const std::filesystem::path& directory, int64 max_size_bytes) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory));
+  return absl::WrapUnique(new JitObjectCache(directory, max_size_bytes));
+}
+
+JitObjectCache* JitObjectCache::GetDefault() {
+  static JitObjectCache* cache = []() -> JitObjectCache* {
+    std::string directory = absl::GetFlag(FLAGS_jit_object_cache_dir);
+    if (directory.empty()) {
+      return nullptr;
+    }
+    xabsl::StatusOr<std::unique_ptr<JitObjectCache>> cache_or =
+        Create(directory, absl::GetFlag(FLAGS_jit_object_cache_max_bytes));
+    if (!cache_or.ok()) {
+      XLS_LOG(WARNING) << "Unable to use JIT object cache at " << directory
+                       << "; continuing without it: " << cache_or.status();
+      return nullptr;
+    }
+    return cache_or.value().release();
+  }();
+  return cache;
+}
+
+std::filesystem::path JitObjectCache::ObjectPath(absl::string_view key) const {
+  return directory_ / absl::StrCat(key, kObjectExtension);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::Lookup(
+    absl::string_view key) {
+  std::filesystem::path path = ObjectPath(key);
+  xabsl::StatusOr<std::string> contents_or = GetFileContents(path);
+  absl::MutexLock lock(&mutex_);
+  if (!contents_or.ok()) {
+    stats_.misses++;
+    return nullptr;
+  }
+  stats_.hits++;
+
+  // Refresh the modification time so eviction is least-recently-used rather
+  // than least-recently-written. Failure here only affects eviction order.
+  std::error_code ec;
+  std::filesystem::last_write_time(
+      path, std::filesystem::file_time_type::clock::now(), ec);
+  return llvm::MemoryBuffer::getMemBufferCopy(contents_or.value(),
+                                              path.string());
+}
+
+void JitObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                          llvm::MemoryBufferRef object) {
+  std::string key = module->getModuleIdentifier();
+  std::filesystem::path path = ObjectPath(key);
+
+  // Write to a temporary unique to this store and rename it into place, so
+  // that concurrent readers never observe a partially-written object. The
+  // name includes the process ID and a counter, as threads of this or other
+  // processes may be storing the same key at the same time.
+  std::filesystem::path temp_path =
+      directory_ / absl::StrFormat("%s.%d.%d.tmp", key, getpid(),
+                                   next_temp_file_id.fetch_add(1));
+  absl::Status status = SetFileContents(
+      temp_path, absl::string_view(object.getBufferStart(),
+                                   object.getBufferSize()));
+  std::error_code ec;
+  if (status.ok()) {
+    std::filesystem::rename(temp_path, path, ec);
+  }
+  if (!status.ok() || ec) {
+    XLS_LOG(WARNING) << "Unable to store JIT object " << path << ": "
+                     << (status.ok() ? ec.message() : status.ToString());
+    std::filesystem::remove(temp_path, ec);
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  stats_.stores++;
+  EvictIfNeeded();
+}
+
+void JitObjectCache::Invalidate(absl::string_view key) {
+  std::error_code ec;
+  std::filesystem::remove(ObjectPath(key), ec);
+  absl::MutexLock lock(&mutex_);
+  stats_.hits--;
+  stats_.misses++;
+  stats_.invalidations++;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::getObject(
+    const llvm::Module* module) {
+  return nullptr;
+}
+
+JitObjectCache::Stats JitObjectCache::stats() const {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+void JitObjectCache::EvictIfNeeded() {
+  struct Entry {
+    std::filesystem::path path;
+    std::filesystem::file_time_type last_write_time;
+    int64 size;
+  };
+  std::vector<Entry> entries;
+  int64 total_size = 0;
+  std::error_code ec;
+  for (const auto& dir_entry :
+       std::filesystem::directory_iterator(directory_, ec)) {
+    if (dir_entry.path().extension() != kObjectExtension) {
+      continue;
+    }
+    Entry entry{dir_entry.path(), dir_entry.last_write_time(ec),
+                static_cast<int64>(dir_entry.file_size(ec))};
+    if (ec) {
+      // Most likely removed by a concurrent process; ignore it.
+      ec.clear();
+      continue;
+    }
+    total_size += entry.size;
+    entries.push_back(std::move(entry));
+  }
+  if (total_size <= max_size_bytes_) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.last_write_time < b.last_write_time;
+            });
+  for (const Entry& entry : entries) {
+    if (total_size <= max_size_bytes_) {
+      break;
+    }
+    if (std::filesystem::remove(entry.path, ec)) {
+      stats_.evictions++;
+    }
+    total_size -= entry.size;
+  }
+}
+
+std::string JitObjectCacheKey(absl::string_view ir_text, int64 opt_level,
+                              absl::string_view target_triple,
+                              absl::string_view target_cpu,
+                              absl::string_view target_features) {
+  llvm::SHA1 hasher;
+  hasher.update(absl::StrFormat(
+      "xls_jit_object_cache_v%d\n%s\n%d\n%s\n%s\n%s\n", kCacheFormatVersion,
+      LLVM_VERSION_STRING, opt_level, target_triple, target_cpu,
+      target_features));
+  hasher.update(llvm::StringRef(ir_text.data(), ir_text.size()));
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+}  // namespace xls
@@ -0,0 +1,121 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_JIT_OBJECT_CACHE_H_
+#define XLS_JIT_JIT_OBJECT_CACHE_H_
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+
+namespace xls {
+
+// Persistent, size-bounded on-disk cache of JIT-compiled object files.
+//
+// Objects are keyed by JitObjectCacheKey() - a digest of everything that
+// determines the generated code - and stored as one file per key in a local
+// directory. When the directory grows past its size bound, the least recently
+// used objects are evicted. Files are written atomically, so a directory may be
+// shared by concurrent processes.
+//
+// LlvmIrJit consults the cache (via Lookup()) before lowering a function; on a
+// hit it links the cached object directly, skipping lowering, optimization and
+// code generation entirely. On a miss, the cache is handed to the ORC compiler
+// as its llvm::ObjectCache, which stores the freshly compiled object under the
+// identifier of the compiled module (which LlvmIrJit sets to the key).
+class JitObjectCache : public llvm::ObjectCache {
+ public:
+  // Hit/miss statistics for the lifetime of this object.
+  struct Stats {
+    int64 hits = 0;
+    int64 misses = 0;
+    // Objects written to the cache directory.
+    int64 stores = 0;
+    // Objects removed to stay within the size bound.
+    int64 evictions = 0;
+    // Objects removed because they could not be loaded.
+    int64 invalidations = 0;
+  };
+
+  // Creates a cache backed by "directory" (created if necessary) holding at
+  // most "max_size_bytes" of objects.
+  static xabsl::StatusOr<std::unique_ptr<JitObjectCache>> Create(
+      const std::filesystem::path& directory, int64 max_size_bytes);
+
+  // Returns the process-wide cache configured by --jit_object_cache_dir, or
+  // nullptr if that flag is unset.
+  static JitObjectCache* GetDefault();
+
+  // Returns the cached object for "key", or nullptr if there is none. Counts
+  // towards the hit/miss statistics.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(absl::string_view key);
+
+  // Removes the object for "key", which was returned by Lookup() but could not
+  // be loaded (e.g., because it was truncated). That lookup then counts as a
+  // miss rather than a hit.
+  void Invalidate(absl::string_view key);
+
+  // llvm::ObjectCache implementation. notifyObjectCompiled() stores "object"
+  // under the identifier of "module". getObject() always returns nullptr: all
+  // lookups happen up front via Lookup(), before any module is built.
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+  Stats stats() const;
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  JitObjectCache(std::filesystem::path directory, int64 max_size_bytes)
+      : directory_(std::move(directory)), max_size_bytes_(max_size_bytes) {}
+
+  // Returns the path to the object file for the given key.
+  std::filesystem::path ObjectPath(absl::string_view key) const;
+
+  // Removes least recently used objects until the cache directory is within
+  // its size bound.
+  void EvictIfNeeded() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::filesystem::path directory_;
+  int64 max_size_bytes_;
+
+  mutable absl::Mutex mutex_;
+  Stats stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the cache key for a JIT-compiled function: a hex digest of its
+// (recursive) IR text, the optimization level, the host target triple, CPU and
+// features, and the LLVM version. The CPU and features matter as a cache
+// directory may be shared by hosts which support different instructions.
+// "ir_text" must include everything that affects codegen, including the names
+// of the generated symbols.
+std::string JitObjectCacheKey(absl::string_view ir_text, int64 opt_level,
+                              absl::string_view target_triple,
+                              absl::string_view target_cpu,
+                              absl::string_view target_features);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_JIT_OBJECT_CACHE_H_
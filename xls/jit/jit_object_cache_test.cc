@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+// Stores "contents" in the cache under "key", as the ORC compiler would.
+void Store(JitObjectCache* cache, const std::string& key,
+           const std::string& contents) {
+  llvm::LLVMContext context;
+  llvm::Module module(key, context);
+  cache->notifyObjectCompiled(&module, llvm::MemoryBufferRef(contents, key));
+}
+
+TEST(JitObjectCacheTest, KeyCoversAllInputs) {
+  constexpr char kTriple[] = "x86_64-unknown-linux-gnu";
+  constexpr char kCpu[] = "skylake-avx512";
+  constexpr char kFeatures[] = "+avx2,+avx512f";
+  std::string key = JitObjectCacheKey("fn f", 3, kTriple, kCpu, kFeatures);
+  EXPECT_EQ(key, JitObjectCacheKey("fn f", 3, kTriple, kCpu, kFeatures));
+  EXPECT_NE(key, JitObjectCacheKey("fn g", 3, kTriple, kCpu, kFeatures));
+  EXPECT_NE(key, JitObjectCacheKey("fn f", 2, kTriple, kCpu, kFeatures));
+  EXPECT_NE(key, JitObjectCacheKey("fn f", 3, "aarch64-unknown-linux-gnu",
+                                   kCpu, kFeatures));
+  EXPECT_NE(key, JitObjectCacheKey("fn f", 3, kTriple, "haswell", kFeatures));
+  EXPECT_NE(key,
+            JitObjectCacheKey("fn f", 3, kTriple, kCpu, "+avx2,-avx512f"));
+}
+
+TEST(JitObjectCacheTest, StoreAndLookup) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto cache,
+                           JitObjectCache::Create(temp_dir.path(), 1024));
+
+  EXPECT_EQ(cache->Lookup("abc"), nullptr);
+  Store(cache.get(), "abc", "object bytes");
+  std::unique_ptr<llvm::MemoryBuffer> object = cache->Lookup("abc");
+  ASSERT_NE(object, nullptr);
+  EXPECT_EQ(object->getBuffer().str(), "object bytes");
+
+  JitObjectCache::Stats stats = cache->stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.stores, 1);
+  EXPECT_EQ(stats.evictions, 0);
+
+  // A second cache over the same directory sees the stored object.
+  XLS_ASSERT_OK_AND_ASSIGN(auto other_cache,
+                           JitObjectCache::Create(temp_dir.path(), 1024));
+  EXPECT_NE(other_cache->Lookup("abc"), nullptr);
+}
+
+TEST(JitObjectCacheTest, Invalidate) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto cache,
+                           JitObjectCache::Create(temp_dir.path(), 1024));
+
+  Store(cache.get(), "abc", "truncated obj");
+  ASSERT_NE(cache->Lookup("abc"), nullptr);
+  cache->Invalidate("abc");
+  EXPECT_EQ(cache->Lookup("abc"), nullptr);
+
+  JitObjectCache::Stats stats = cache->stats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.invalidations, 1);
+}
+
+TEST(JitObjectCacheTest, EvictsToSizeBound) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto cache,
+                           JitObjectCache::Create(temp_dir.path(), 100));
+
+  Store(cache.get(), "first", std::string(60, 'a'));
+  Store(cache.get(), "second", std::string(60, 'b'));
+
+  // Only one of the two objects fits; the most recently written remains.
+  EXPECT_EQ(cache->stats().evictions, 1);
+  EXPECT_NE(cache->Lookup("second"), nullptr);
+}
+
+TEST(JitObjectCacheTest, ConcurrentStoresOfSameKey) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto cache,
+                           JitObjectCache::Create(temp_dir.path(), 1 << 24));
+
+  // Each thread stores an object of a distinct byte under the same key.
+  constexpr int kThreadCount = 8;
+  constexpr int kObjectSize = 1 << 20;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&cache, i]() {
+      Store(cache.get(), "same", std::string(kObjectSize, 'a' + i));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // The stored object is one complete object, not a mix of several.
+  std::unique_ptr<llvm::MemoryBuffer> object = cache->Lookup("same");
+  ASSERT_NE(object, nullptr);
+  std::string contents = object->getBuffer().str();
+  ASSERT_FALSE(contents.empty());
+  EXPECT_EQ(contents, std::string(kObjectSize, contents[0]));
+  EXPECT_EQ(cache->stats().stores, kThreadCount);
+
+  // No temporary files are left behind.
+  int64 file_count = 0;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(temp_dir.path())) {
+    EXPECT_EQ(entry.path().extension(), ".o") << entry.path();
+    ++file_count;
+  }
+  EXPECT_EQ(file_count, 1);
+}
+
+}  // namespace
+}  // namespace xls
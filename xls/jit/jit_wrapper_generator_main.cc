@@ -25,8 +25,8 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/jit/jit_wrapper_generator.h"
+#include "xls/tools/ir_file.h"
 
 ABSL_FLAG(std::string, class_name, "",
           "Name of the generated class. "
@@ -45,6 +45,8 @@ ABSL_FLAG(std::string, output_dir, "",
 ABSL_FLAG(std::string, genfiles_dir, "",
           "The directory into which generated files are placed. "
           "This prefix will be removed from the header guards.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -65,8 +67,10 @@ absl::Status RealMain(const std::filesystem::path& ir_path,
                       const std::filesystem::path& genfiles_dir,
                       std::string class_name, std::string output_name,
                       std::string function_name) {
-  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
-  XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(auto package,
+                       ReadPackageFile(ir_path.string(), ir_format));
 
   Function* function;
   std::string package_prefix = absl::StrCat("__", package->name(), "__");
@@ -14,10 +14,12 @@
 
 #include "xls/jit/llvm_ir_jit.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <random>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -29,12 +31,15 @@
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/ExecutionEngine/Orc/IRTransformLayer.h"
 #include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/ExecutionEngine/Orc/Layer.h"
+#include "llvm/ExecutionEngine/Orc/LazyReexports.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
@@ -43,9 +48,12 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/raw_ostream.h"
@@ -63,12 +71,40 @@
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_helpers.h"
+
+ABSL_FLAG(int64, llvm_jit_max_unrolled_trip_count, 8,
+          "counted_for loops with at most this many iterations, and maps over "
+          "arrays with at most this many elements, are fully unrolled by the "
+          "JIT. Larger ones are emitted as loops.");
+
 namespace xls {
 namespace {
 
 // Convenience alias for XLS type => LLVM type mapping used as a cache.
 using TypeCache = absl::flat_hash_map<const Type*, llvm::Type*>;
 
+// Moves all allocas in "function" into its entry block. Node lowering emits
+// allocas (e.g., for array indexing) at the current insertion point, which may
+// be after (or within) a loop. Such allocas would be re-executed, growing the
+// stack, and could not be promoted to registers.
+void HoistAllocasToEntryBlock(llvm::Function* function) {
+  llvm::BasicBlock& entry_block = function->getEntryBlock();
+  std::vector<llvm::AllocaInst*> allocas;
+  for (llvm::BasicBlock& block : *function) {
+    if (&block == &entry_block) {
+      continue;
+    }
+    for (llvm::Instruction& instruction : block) {
+      if (auto* alloca = llvm::dyn_cast<llvm::AllocaInst>(&instruction)) {
+        allocas.push_back(alloca);
+      }
+    }
+  }
+  for (llvm::AllocaInst* alloca : allocas) {
+    alloca->moveBefore(&*entry_block.getFirstInsertionPt());
+  }
+}
+
 // Visitor to construct LLVM IR for each encountered XLS IR node. Based on
 // DfsVisitorWithDefault to highlight any unhandled IR nodes.
 class BuilderVisitor : public DfsVisitorWithDefault {
@@ -88,7 +124,9 @@ class BuilderVisitor : public DfsVisitorWithDefault {
         return_value_(nullptr),
         type_converter_(type_converter),
         llvm_entry_function_(llvm_entry_function),
-        generate_packed_(generate_packed) {
+        generate_packed_(generate_packed),
+        max_unrolled_trip_count_(std::max<int64>(
+            absl::GetFlag(FLAGS_llvm_jit_max_unrolled_trip_count), 0)) {
     for (int i = 0; i < params.size(); ++i) {
       int64 start = i == 0 ? 0 : arg_indices_[i - 1].second + 1;
       int64 end =
@@ -305,13 +343,31 @@ class BuilderVisitor : public DfsVisitorWithDefault {
     args[1] = node_map_.at(counted_for->initial_value());
 
     llvm::Type* function_type = function->getType()->getPointerElementType();
-    for (int i = 0; i < counted_for->trip_count(); ++i) {
-      args[0] = llvm::ConstantInt::get(function_type->getFunctionParamType(0),
-                                       i * counted_for->stride());
-      args[1] = builder_->CreateCall(function, {args});
+    llvm::Type* index_type = function_type->getFunctionParamType(0);
+    if (counted_for->trip_count() <= max_unrolled_trip_count_) {
+      for (int i = 0; i < counted_for->trip_count(); ++i) {
+        args[0] = llvm::ConstantInt::get(index_type, i * counted_for->stride());
+        args[1] = builder_->CreateCall(function, {args});
+      }
+      return StoreResult(counted_for, args[1]);
     }
 
-    return StoreResult(counted_for, args[1]);
+    // Emit an actual loop, with the accumulator carried by a phi.
+    llvm::BasicBlock* preheader = builder_->GetInsertBlock();
+    Loop loop = BeginLoop(counted_for);
+    llvm::PHINode* carry = builder_->CreatePHI(args[1]->getType(), 2);
+    carry->addIncoming(args[1], preheader);
+    args[0] = builder_->CreateIntCast(
+        builder_->CreateMul(loop.index,
+                            llvm::ConstantInt::get(loop.index->getType(),
+                                                   counted_for->stride())),
+        index_type, /*isSigned=*/false);
+    args[1] = carry;
+    llvm::Value* next_carry = builder_->CreateCall(function, {args});
+    carry->addIncoming(next_carry, builder_->GetInsertBlock());
+    EndLoop(loop, counted_for->trip_count());
+
+    return StoreResult(counted_for, next_carry);
   }
 
   absl::Status HandleDecode(Decode* decode) override {
@@ -401,16 +457,36 @@ class BuilderVisitor : public DfsVisitorWithDefault {
     llvm::FunctionType* function_type = llvm::cast<llvm::FunctionType>(
         to_apply->getType()->getPointerElementType());
 
-    llvm::Value* result = CreateTypedZeroValue(llvm::ArrayType::get(
-        function_type->getReturnType(), input_type->getArrayNumElements()));
-
-    for (uint32 i = 0; i < input_type->getArrayNumElements(); ++i) {
-      llvm::Value* iter_input = builder_->CreateExtractValue(input, {i});
-      llvm::Value* iter_result = builder_->CreateCall(to_apply, iter_input);
-      result = builder_->CreateInsertValue(result, iter_result, {i});
+    int64 element_count = input_type->getArrayNumElements();
+    llvm::Type* result_type =
+        llvm::ArrayType::get(function_type->getReturnType(), element_count);
+    if (element_count <= max_unrolled_trip_count_) {
+      llvm::Value* result = CreateTypedZeroValue(result_type);
+      for (uint32 i = 0; i < element_count; ++i) {
+        llvm::Value* iter_input = builder_->CreateExtractValue(input, {i});
+        llvm::Value* iter_result = builder_->CreateCall(to_apply, iter_input);
+        result = builder_->CreateInsertValue(result, iter_result, {i});
+      }
+      return StoreResult(map, result);
     }
 
-    return StoreResult(map, result);
+    // Emit an actual loop. As in HandleArrayIndex(), elements can only be
+    // addressed by a non-constant index through memory, so the input and
+    // result arrays live in allocas for its duration.
+    llvm::AllocaInst* input_storage = builder_->CreateAlloca(input_type);
+    builder_->CreateStore(input, input_storage);
+    llvm::AllocaInst* result_storage = builder_->CreateAlloca(result_type);
+    llvm::Value* zero = llvm::ConstantInt::get(builder_->getInt64Ty(), 0);
+
+    Loop loop = BeginLoop(map);
+    llvm::Value* iter_input = builder_->CreateLoad(
+        builder_->CreateGEP(input_storage, {zero, loop.index}));
+    llvm::Value* iter_result = builder_->CreateCall(to_apply, iter_input);
+    builder_->CreateStore(
+        iter_result, builder_->CreateGEP(result_storage, {zero, loop.index}));
+    EndLoop(loop, element_count);
+
+    return StoreResult(map, builder_->CreateLoad(result_type, result_storage));
   }
 
   absl::Status HandleSMul(ArithOp* mul) override { return HandleArithOp(mul); }
@@ -585,12 +661,22 @@ class BuilderVisitor : public DfsVisitorWithDefault {
             llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context_), 0),
             llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context_), index),
         });
-    llvm::LoadInst* load =
+    llvm::Value* arg_buffer =
         builder_->CreateLoad(gep->getType()->getPointerElementType(), gep);
-    llvm::Value* cast = builder_->CreateBitCast(load, llvm_arg_ptr_type);
+    if (batch_index_ != nullptr) {
+      // In batch mode, each arg pointer addresses an array of per-sample
+      // elements; step forward to the current sample's element.
+      llvm::Value* offset = builder_->CreateMul(
+          batch_index_,
+          llvm::ConstantInt::get(
+              llvm::Type::getInt64Ty(*context_),
+              type_converter_->GetTypeByteSize(*param->GetType())));
+      arg_buffer = builder_->CreateGEP(arg_buffer, offset);
+    }
+    llvm::Value* cast = builder_->CreateBitCast(arg_buffer, llvm_arg_ptr_type);
 
     // Load 2: Get the data at that pointer's destination.
-    load = builder_->CreateLoad(arg_type, cast);
+    llvm::LoadInst* load = builder_->CreateLoad(arg_type, cast);
 
     return StoreResult(param, load);
   }
@@ -827,6 +913,11 @@ class BuilderVisitor : public DfsVisitorWithDefault {
 
   llvm::Value* return_value() { return return_value_; }
 
+  // Sets the (i64) index of the sample being evaluated when building the body
+  // of a batched entry function. Entry function params are then read from that
+  // element of each per-param input array rather than from its start.
+  void set_batch_index(llvm::Value* batch_index) { batch_index_ = batch_index; }
+
  private:
   absl::Status HandleArithOp(ArithOp* arith_op) {
     bool is_signed;
@@ -972,6 +1063,47 @@ class BuilderVisitor : public DfsVisitorWithDefault {
     return builder_->CreateUDiv(lhs, rhs);
   }
 
+  // The body block and (i64) induction variable of a loop under construction.
+  struct Loop {
+    llvm::BasicBlock* body;
+    llvm::PHINode* index;
+  };
+
+  // Begins a loop on behalf of "node": branches from the current block into a
+  // new loop body block and positions the builder there. The index counts up
+  // from zero.
+  Loop BeginLoop(Node* node) {
+    std::string name = verilog::SanitizeIdentifier(node->GetName());
+    llvm::BasicBlock* preheader = builder_->GetInsertBlock();
+    llvm::BasicBlock* body = llvm::BasicBlock::Create(
+        *context_, absl::StrCat(name, "_loop"), preheader->getParent());
+    builder_->CreateBr(body);
+    builder_->SetInsertPoint(body);
+    llvm::PHINode* index =
+        builder_->CreatePHI(builder_->getInt64Ty(), 2, name + "_index");
+    index->addIncoming(llvm::ConstantInt::get(builder_->getInt64Ty(), 0),
+                       preheader);
+    return Loop{body, index};
+  }
+
+  // Ends a loop begun by BeginLoop() after "trip_count" (> 0) iterations, and
+  // positions the builder at the (new) block following the loop.
+  void EndLoop(const Loop& loop, int64 trip_count) {
+    llvm::BasicBlock* latch = builder_->GetInsertBlock();
+    llvm::BasicBlock* exit = llvm::BasicBlock::Create(
+        *context_, absl::StrCat(loop.body->getName().str(), "_exit"),
+        latch->getParent());
+    llvm::Value* next_index = builder_->CreateAdd(
+        loop.index, llvm::ConstantInt::get(builder_->getInt64Ty(), 1));
+    loop.index->addIncoming(next_index, latch);
+    builder_->CreateCondBr(
+        builder_->CreateICmpULT(
+            next_index,
+            llvm::ConstantInt::get(builder_->getInt64Ty(), trip_count)),
+        loop.body, exit);
+    builder_->SetInsertPoint(exit);
+  }
+
   llvm::Constant* CreateTypedZeroValue(llvm::Type* type) {
     if (type->isIntegerTy()) {
       return llvm::ConstantInt::get(type, 0);
@@ -1091,6 +1223,7 @@ class BuilderVisitor : public DfsVisitorWithDefault {
     } else {
       builder.CreateRet(visitor.return_value());
     }
+    HoistAllocasToEntryBlock(function);
 
     return function;
   }
@@ -1135,6 +1268,13 @@ class BuilderVisitor : public DfsVisitorWithDefault {
   // True if this builder should generate packed parameter loads (as in the
   // header comment for LlvmIrJit::RunWithPackedViews()).
   bool generate_packed_;
+
+  // If non-null, the index of the current sample in a batched entry function.
+  llvm::Value* batch_index_ = nullptr;
+
+  // Loops (counted_for or map) with trip counts above this are emitted as
+  // actual loops rather than being unrolled.
+  int64 max_unrolled_trip_count_;
 };
 
 absl::once_flag once;
@@ -1144,29 +1284,166 @@ void OnceInit() {
   LLVMInitializeNativeAsmParser();
 }
 
+// Returns an error unless "object" is a well-formed object file defining all
+// of "symbols" (named without the global prefix of the target, if any). Cached
+// objects may have been truncated or corrupted on disk.
+llvm::Error CheckObjectDefines(const llvm::MemoryBuffer& object,
+                               absl::Span<const std::string> symbols,
+                               char global_prefix) {
+  llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> object_file =
+      llvm::object::ObjectFile::createObjectFile(object.getMemBufferRef());
+  if (!object_file) {
+    return object_file.takeError();
+  }
+  for (const llvm::object::SectionRef& section : (*object_file)->sections()) {
+    // Fails if the section extends past the end of the file.
+    llvm::Expected<llvm::StringRef> contents = section.getContents();
+    if (!contents) {
+      return contents.takeError();
+    }
+  }
+  absl::flat_hash_set<std::string> undefined(symbols.begin(), symbols.end());
+  for (const llvm::object::SymbolRef& symbol : (*object_file)->symbols()) {
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+    if (!name) {
+      return name.takeError();
+    }
+    llvm::Expected<llvm::object::section_iterator> section =
+        symbol.getSection();
+    if (!section) {
+      return section.takeError();
+    }
+    if (*section == (*object_file)->section_end()) {
+      continue;
+    }
+    llvm::StringRef unprefixed = *name;
+    if (global_prefix != '\0') {
+      unprefixed.consume_front(llvm::StringRef(&global_prefix, 1));
+    }
+    undefined.erase(unprefixed.str());
+  }
+  if (!undefined.empty()) {
+    return llvm::make_error<llvm::StringError>(
+        absl::StrCat("Object does not define ", *undefined.begin()),
+        llvm::inconvertibleErrorCode());
+  }
+  return llvm::Error::success();
+}
+
+// Jumped to by lazy call-through stubs whose function failed to materialize.
+// The execution session has already reported why; there is no way to hand an
+// error back to the JIT-compiled caller, so abort rather than jump to null.
+void LazyMaterializationFailed() {
+  XLS_LOG(FATAL) << "Lazy compilation of a JIT function failed; see the "
+                    "preceding LLVM error";
+}
+
 }  // namespace
 
 xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> LlvmIrJit::Create(
+    Function* xls_function, int64 opt_level, JitObjectCache* object_cache) {
+  absl::call_once(once, OnceInit);
+
+  if (object_cache == nullptr) {
+    object_cache = JitObjectCache::GetDefault();
+  }
+  auto jit = absl::WrapUnique(
+      new LlvmIrJit(xls_function, opt_level, object_cache, /*lazy=*/false));
+  XLS_RETURN_IF_ERROR(jit->Init());
+  XLS_RETURN_IF_ERROR(jit->Compile());
+  return jit;
+}
+
+xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> LlvmIrJit::CreateLazy(
     Function* xls_function, int64 opt_level) {
   absl::call_once(once, OnceInit);
 
-  auto jit = absl::WrapUnique(new LlvmIrJit(xls_function, opt_level));
+  // Lazily-compiled partitions are emitted as separate objects whose contents
+  // depend on which functions have been called, so they're not cacheable.
+  auto jit = absl::WrapUnique(new LlvmIrJit(
+      xls_function, opt_level, /*object_cache=*/nullptr, /*lazy=*/true));
   XLS_RETURN_IF_ERROR(jit->Init());
   XLS_RETURN_IF_ERROR(jit->Compile());
   return jit;
 }
 
 absl::Status LlvmIrJit::Compile() {
-  llvm::LLVMContext* bare_context = context_.getContext();
-  auto module = std::make_unique<llvm::Module>("the_module", *bare_context);
-  module->setDataLayout(data_layout_);
-  XLS_RETURN_IF_ERROR(CompileFunction(module.get()));
-  XLS_RETURN_IF_ERROR(CompilePackedViewFunction(module.get()));
-  llvm::Error error = transform_layer_->add(
-      dylib_, llvm::orc::ThreadSafeModule(std::move(module), context_));
-  if (error) {
-    return absl::UnknownError(absl::StrFormat(
-        "Error compiling converted IR: %s", llvm::toString(std::move(error))));
+  for (const Type* type : xls_function_type_->parameters()) {
+    arg_type_bytes_.push_back(type_converter_->GetTypeByteSize(*type));
+  }
+  return_type_bytes_ =
+      type_converter_->GetTypeByteSize(*xls_function_type_->return_type());
+
+  // Populate all type layout caches now, so the Run*() methods never mutate
+  // them (and thus are safe to call concurrently).
+  for (const Type* type : xls_function_type_->parameters()) {
+    ir_runtime_->PrepareType(*type);
+  }
+  ir_runtime_->PrepareType(*xls_function_type_->return_type());
+
+  std::string function_name = absl::StrFormat(
+      "%s::%s", xls_function_->package()->name(), xls_function_->name());
+  std::string packed_function_name = absl::StrCat(function_name, "_packed");
+  std::string batch_function_name = absl::StrCat(function_name, "_batch");
+
+  // On an object cache hit, link the cached object directly - there's no need
+  // to build (much less optimize) any LLVM IR.
+  std::string cache_key;
+  std::unique_ptr<llvm::MemoryBuffer> cached_object;
+  if (object_cache_ != nullptr) {
+    // Generated symbol names are derived from the package name, so it must be
+    // part of the key along with the (recursive) function IR. The unrolling
+    // threshold also changes the generated code.
+    cache_key = JitObjectCacheKey(
+        absl::StrCat(xls_function_->package()->name(), "\n",
+                     absl::GetFlag(FLAGS_llvm_jit_max_unrolled_trip_count),
+                     "\n", xls_function_->DumpIr(/*recursive=*/true)),
+        opt_level_, target_machine_->getTargetTriple().str(),
+        target_machine_->getTargetCPU().str(),
+        target_machine_->getTargetFeatureString().str());
+    cached_object = object_cache_->Lookup(cache_key);
+  }
+
+  bool loaded_cached_object = false;
+  if (cached_object != nullptr) {
+    XLS_VLOG(1) << "Loading " << xls_function_->name()
+                << " from JIT object cache: " << cache_key;
+    // Nothing is added to the JITDylib unless the object is accepted, so on
+    // failure the function can still be compiled as on a miss.
+    llvm::Error error = CheckObjectDefines(
+        *cached_object,
+        {function_name, packed_function_name, batch_function_name},
+        data_layout_.getGlobalPrefix());
+    if (!error) {
+      error = object_layer_.add(dylib_, std::move(cached_object));
+    }
+    if (error) {
+      XLS_LOG(WARNING) << "Discarding unloadable JIT object cache entry "
+                       << cache_key << ": " << llvm::toString(std::move(error));
+      object_cache_->Invalidate(cache_key);
+    } else {
+      loaded_cached_object = true;
+    }
+  }
+  if (!loaded_cached_object) {
+    llvm::LLVMContext* bare_context = context_.getContext();
+    auto module = std::make_unique<llvm::Module>(
+        cache_key.empty() ? "the_module" : cache_key, *bare_context);
+    module->setDataLayout(data_layout_);
+    XLS_RETURN_IF_ERROR(CompileFunction(module.get()));
+    XLS_RETURN_IF_ERROR(CompilePackedViewFunction(module.get()));
+    XLS_RETURN_IF_ERROR(CompileBatchFunction(module.get()));
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(module),
+                                                   context_);
+    llvm::Error error =
+        lazy_ ? compile_on_demand_layer_->add(dylib_,
+                                              std::move(thread_safe_module))
+              : transform_layer_->add(dylib_, std::move(thread_safe_module));
+    if (error) {
+      return absl::UnknownError(
+          absl::StrFormat("Error compiling converted IR: %s",
+                          llvm::toString(std::move(error))));
+    }
   }
 
   auto load_symbol = [this](const std::string& function_name)
@@ -1181,19 +1458,20 @@ absl::Status LlvmIrJit::Compile() {
     return symbol->getAddress();
   };
 
-  std::string function_name = absl::StrFormat(
-      "%s::%s", xls_function_->package()->name(), xls_function_->name());
   XLS_ASSIGN_OR_RETURN(auto fn_address, load_symbol(function_name));
   invoker_ = reinterpret_cast<JitFunctionType>(fn_address);
 
-  absl::StrAppend(&function_name, "_packed");
-  XLS_ASSIGN_OR_RETURN(fn_address, load_symbol(function_name));
+  XLS_ASSIGN_OR_RETURN(fn_address, load_symbol(packed_function_name));
   packed_invoker_ = reinterpret_cast<PackedJitFunctionType>(fn_address);
 
+  XLS_ASSIGN_OR_RETURN(fn_address, load_symbol(batch_function_name));
+  batch_invoker_ = reinterpret_cast<BatchJitFunctionType>(fn_address);
+
   return absl::OkStatus();
 }
 
-LlvmIrJit::LlvmIrJit(Function* xls_function, int64 opt_level)
+LlvmIrJit::LlvmIrJit(Function* xls_function, int64 opt_level,
+                     JitObjectCache* object_cache, bool lazy)
     : context_(std::make_unique<llvm::LLVMContext>()),
       object_layer_(
           execution_session_,
@@ -1203,11 +1481,18 @@ LlvmIrJit::LlvmIrJit(Function* xls_function, int64 opt_level)
       xls_function_(xls_function),
       xls_function_type_(xls_function_->GetType()),
       opt_level_(opt_level),
-      invoker_(nullptr) {}
+      object_cache_(object_cache),
+      lazy_(lazy),
+      invoker_(nullptr),
+      packed_invoker_(nullptr),
+      batch_invoker_(nullptr) {}
 
 llvm::Expected<llvm::orc::ThreadSafeModule> LlvmIrJit::Optimizer(
     llvm::orc::ThreadSafeModule module,
     const llvm::orc::MaterializationResponsibility& responsibility) {
+  // In lazy mode, partitions of our module (which share one LLVMContext) may
+  // be materialized concurrently by calls from different threads.
+  auto context_lock = module.getContext().getLock();
   llvm::Module* bare_module = module.getModuleUnlocked();
 
   XLS_VLOG(2) << "Unoptimized module IR:";
@@ -1218,6 +1503,10 @@ llvm::Expected<llvm::orc::ThreadSafeModule> LlvmIrJit::Optimizer(
   builder.OptLevel = opt_level_;
   builder.LibraryInfo =
       new llvm::TargetLibraryInfoImpl(target_machine_->getTargetTriple());
+  // Vectorization is what makes the batched entry point (see RunBatch())
+  // worthwhile: it lets narrow ops be evaluated across samples at once.
+  builder.LoopVectorize = opt_level_ > 1;
+  builder.SLPVectorize = opt_level_ > 1;
 
   llvm::legacy::PassManager module_pass_manager;
   builder.populateModulePassManager(module_pass_manager);
@@ -1282,7 +1571,9 @@ absl::Status LlvmIrJit::Init() {
             data_layout_.getGlobalPrefix())));
   });
 
-  auto compiler = std::make_unique<llvm::orc::SimpleCompiler>(*target_machine_);
+  // On a cache miss, the compiler stores the compiled object in the cache.
+  auto compiler = std::make_unique<llvm::orc::SimpleCompiler>(*target_machine_,
+                                                              object_cache_);
   compile_layer_ = std::make_unique<llvm::orc::IRCompileLayer>(
       execution_session_, object_layer_, std::move(compiler));
 
@@ -1293,6 +1584,27 @@ absl::Status LlvmIrJit::Init() {
         return Optimizer(std::move(module), responsibility);
       });
 
+  if (lazy_) {
+    const llvm::Triple& triple = target_machine_->getTargetTriple();
+    auto call_through_manager_or = llvm::orc::createLocalLazyCallThroughManager(
+        triple, execution_session_,
+        llvm::pointerToJITTargetAddress(&LazyMaterializationFailed));
+    if (!call_through_manager_or) {
+      return absl::InternalError(absl::StrCat(
+          "Unable to create lazy call-through manager: ",
+          llvm::toString(call_through_manager_or.takeError())));
+    }
+    lazy_call_through_manager_ = std::move(call_through_manager_or.get());
+    compile_on_demand_layer_ =
+        std::make_unique<llvm::orc::CompileOnDemandLayer>(
+            execution_session_, *transform_layer_, *lazy_call_through_manager_,
+            llvm::orc::createLocalIndirectStubsManagerBuilder(triple));
+    // Emit only the function being called, rather than (by default) the whole
+    // module containing it.
+    compile_on_demand_layer_->setPartitionFunction(
+        llvm::orc::CompileOnDemandLayer::compileRequested);
+  }
+
   ir_runtime_ =
       std::make_unique<LlvmIrRuntime>(data_layout_, type_converter_.get());
 
@@ -1317,10 +1629,6 @@ absl::Status LlvmIrJit::CompileFunction(llvm::Module* module) {
           xls_function_type_->parameter_count()),
       /*AddressSpace=*/0));
 
-  for (const Type* type : xls_function_type_->parameters()) {
-    arg_type_bytes_.push_back(type_converter_->GetTypeByteSize(*type));
-  }
-
   // Pass the last param as a pointer to the actual return type.
   Type* return_type = xls_function_type_->return_type();
   llvm::Type* llvm_return_type =
@@ -1352,12 +1660,24 @@ absl::Status LlvmIrJit::CompileFunction(llvm::Module* module) {
   }
 
   // Store the result to the output pointer.
-  return_type_bytes_ = type_converter_->GetTypeByteSize(*return_type);
+  XLS_RETURN_IF_ERROR(
+      StoreReturnValue(builder, return_value, llvm_return_type,
+                       llvm_function->getArg(llvm_function->arg_size() - 1)));
+  builder.CreateRetVoid();
+  HoistAllocasToEntryBlock(llvm_function);
+
+  return absl::OkStatus();
+}
+
+absl::Status LlvmIrJit::StoreReturnValue(llvm::IRBuilder<>& builder,
+                                         llvm::Value* return_value,
+                                         llvm::Type* llvm_return_type,
+                                         llvm::Value* output) {
   if (return_value->getType()->isPointerTy()) {
     llvm::Type* pointee_type = return_value->getType()->getPointerElementType();
     if (pointee_type != llvm_return_type) {
-      std::string output;
-      llvm::raw_string_ostream stream(output);
+      std::string error;
+      llvm::raw_string_ostream stream(error);
       stream << "Produced return type does not match intended: produced: ";
       pointee_type->print(stream, /*IsForDebug=*/true);
       stream << ", expected: ";
@@ -1365,15 +1685,11 @@ absl::Status LlvmIrJit::CompileFunction(llvm::Module* module) {
       return absl::InternalError(stream.str());
     }
 
-    builder.CreateMemCpy(llvm_function->getArg(llvm_function->arg_size() - 1),
-                         llvm::MaybeAlign(0), return_value, llvm::MaybeAlign(0),
-                         return_type_bytes_);
+    builder.CreateMemCpy(output, llvm::MaybeAlign(0), return_value,
+                         llvm::MaybeAlign(0), return_type_bytes_);
   } else {
-    builder.CreateStore(return_value,
-                        llvm_function->getArg(llvm_function->arg_size() - 1));
+    builder.CreateStore(return_value, output);
   }
-  builder.CreateRetVoid();
-
   return absl::OkStatus();
 }
 
@@ -1439,6 +1755,31 @@ absl::Status LlvmIrJit::RunWithViews(absl::Span<const uint8*> args,
   return absl::OkStatus();
 }
 
+absl::Status LlvmIrJit::RunBatch(absl::Span<const uint8* const> args,
+                                 absl::Span<uint8> result_buffer,
+                                 int64 batch_size) {
+  absl::Span<Param* const> params = xls_function_->params();
+  if (args.size() != params.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Arg list has the wrong size: %d vs expected %d.",
+                        args.size(), xls_function_->params().size()));
+  }
+
+  if (batch_size < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Batch size must be non-negative; got %d", batch_size));
+  }
+
+  if (result_buffer.size() < batch_size * return_type_bytes_) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Result buffer too small - must be at least %d bytes!",
+        batch_size * return_type_bytes_));
+  }
+
+  batch_invoker_(args.data(), result_buffer.data(), batch_size);
+  return absl::OkStatus();
+}
+
 xabsl::StatusOr<Value> CreateAndRun(Function* xls_function,
                                     absl::Span<const Value> args) {
   XLS_ASSIGN_OR_RETURN(auto jit, LlvmIrJit::Create(xls_function));
@@ -1528,6 +1869,106 @@ absl::Status LlvmIrJit::CompilePackedViewFunction(llvm::Module* module) {
   }
 
   builder.CreateRetVoid();
+  HoistAllocasToEntryBlock(llvm_function);
+
+  return absl::OkStatus();
+}
+
+// Much of the core here is the same as in CompileFunction() - refer there for
+// general comments.
+absl::Status LlvmIrJit::CompileBatchFunction(llvm::Module* module) {
+  llvm::LLVMContext* bare_context = context_.getContext();
+  llvm::Type* i8_ptr_type =
+      llvm::PointerType::get(llvm::Type::getInt8Ty(*bare_context),
+                             /*AddressSpace=*/0);
+  llvm::IntegerType* i64_type = llvm::Type::getInt64Ty(*bare_context);
+
+  // The signature is that of the unpacked entry function with a trailing
+  // sample count, and with the result passed as a flat byte buffer (as it
+  // holds "count" results rather than one).
+  std::vector<llvm::Type*> param_types = {
+      llvm::PointerType::get(
+          llvm::ArrayType::get(i8_ptr_type,
+                               xls_function_type_->parameter_count()),
+          /*AddressSpace=*/0),
+      i8_ptr_type, i64_type};
+  llvm::FunctionType* function_type = llvm::FunctionType::get(
+      llvm::Type::getVoidTy(*bare_context),
+      llvm::ArrayRef<llvm::Type*>(param_types.data(), param_types.size()),
+      /*isVarArg=*/false);
+
+  Package* xls_package = xls_function_->package();
+  std::string function_name = absl::StrFormat(
+      "%s::%s_batch", xls_package->name(), xls_function_->name());
+  llvm::Function* llvm_function = llvm::cast<llvm::Function>(
+      module->getOrInsertFunction(function_name, function_type).getCallee());
+  // The output never overlaps the inputs (see RunBatch()); telling LLVM as much
+  // spares the vectorized loop its runtime overlap checks.
+  llvm_function->addParamAttr(1, llvm::Attribute::NoAlias);
+  llvm::Value* output_buffer = llvm_function->getArg(1);
+  llvm::Value* count = llvm_function->getArg(2);
+
+  auto entry_block = llvm::BasicBlock::Create(
+      *bare_context, "entry", llvm_function, /*InsertBefore=*/nullptr);
+  auto loop_block = llvm::BasicBlock::Create(
+      *bare_context, "loop", llvm_function, /*InsertBefore=*/nullptr);
+  auto exit_block = llvm::BasicBlock::Create(
+      *bare_context, "exit", llvm_function, /*InsertBefore=*/nullptr);
+
+  llvm::IRBuilder<> builder(entry_block);
+  builder.CreateCondBr(
+      builder.CreateICmpSGT(count, llvm::ConstantInt::get(i64_type, 0)),
+      loop_block, exit_block);
+
+  builder.SetInsertPoint(loop_block);
+  llvm::PHINode* index = builder.CreatePHI(i64_type, 2, "sample_index");
+  index->addIncoming(llvm::ConstantInt::get(i64_type, 0), entry_block);
+
+  BuilderVisitor visitor(module, &builder, xls_function_->params(),
+                         xls_function_, type_converter_.get(),
+                         /*generate_packed=*/false);
+  visitor.set_batch_index(index);
+  XLS_RETURN_IF_ERROR(xls_function_->Accept(&visitor));
+  llvm::Value* return_value = visitor.return_value();
+  if (return_value == nullptr) {
+    return absl::InvalidArgumentError(
+        "Function had no (or an unsupported) return value specification!");
+  }
+
+  llvm::Type* llvm_return_type =
+      type_converter_->ConvertToLlvmType(*xls_function_type_->return_type());
+  llvm::Value* output = builder.CreateGEP(
+      output_buffer,
+      builder.CreateMul(index,
+                        llvm::ConstantInt::get(i64_type, return_type_bytes_)));
+  output = builder.CreateBitCast(
+      output, llvm::PointerType::get(llvm_return_type, /*AddressSpace=*/0));
+  XLS_RETURN_IF_ERROR(
+      StoreReturnValue(builder, return_value, llvm_return_type, output));
+
+  // Lowering may have introduced new blocks, so the back edge comes from
+  // wherever the builder ended up.
+  llvm::Value* next_index =
+      builder.CreateAdd(index, llvm::ConstantInt::get(i64_type, 1));
+  index->addIncoming(next_index, builder.GetInsertBlock());
+  llvm::BranchInst* back_edge = builder.CreateCondBr(
+      builder.CreateICmpSLT(next_index, count), loop_block, exit_block);
+
+  // Explicitly request vectorization of the sample loop; its trip count is
+  // unknown at compile time, so the cost model may otherwise skip it.
+  llvm::MDNode* vectorize_enable = llvm::MDNode::get(
+      *bare_context,
+      {llvm::MDString::get(*bare_context, "llvm.loop.vectorize.enable"),
+       llvm::ConstantAsMetadata::get(builder.getTrue())});
+  llvm::MDNode* loop_id =
+      llvm::MDNode::getDistinct(*bare_context, {nullptr, vectorize_enable});
+  loop_id->replaceOperandWith(0, loop_id);
+  back_edge->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+
+  builder.SetInsertPoint(exit_block);
+  builder.CreateRetVoid();
+
+  HoistAllocasToEntryBlock(llvm_function);
 
   return absl::OkStatus();
 }
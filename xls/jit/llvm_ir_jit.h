@@ -17,10 +17,12 @@
 
 #include "absl/status/status.h"
 #include "absl/types/span.h"
+#include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/ExecutionEngine/Orc/IRTransformLayer.h"
+#include "llvm/ExecutionEngine/Orc/LazyReexports.h"
 #include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/IR/DataLayout.h"
@@ -32,6 +34,7 @@
 #include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_view.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/llvm_ir_runtime.h"
 #include "xls/jit/llvm_type_converter.h"
 
@@ -39,11 +42,30 @@ namespace xls {
 
 // This class provides a facility to execute XLS functions (on the host) by
 // converting it to LLVM IR, compiling it, and finally executing it.
+//
+// Once created, a LlvmIrJit is thread-safe: the Run*() methods keep all
+// per-call state on the caller's stack (or in caller-provided buffers), so a
+// single compiled instance can serve any number of concurrent callers.
 class LlvmIrJit {
  public:
   // Returns an object containing a host-compiled version of the specified XLS
   // function.
+  //
+  // If "object_cache" is non-null (or, if it's null, when a process-wide cache
+  // is configured via --jit_object_cache_dir), previously compiled code for an
+  // identical function is loaded from that cache instead of being recompiled.
+  // The cache must outlive the returned object.
   static xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> Create(
+      Function* xls_function, int64 opt_level = 3,
+      JitObjectCache* object_cache = nullptr);
+
+  // As Create(), but compiles lazily: each LLVM function - the entry points and
+  // every function they (transitively) invoke, map or loop over - is optimized
+  // and compiled only when first called, via ORC compile-on-demand stubs. This
+  // cuts startup latency for large packages whose callees mostly go
+  // unexecuted, at the cost of a one-time compile stall on the first call of
+  // each function. The object cache is not used in this mode.
+  static xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> CreateLazy(
       Function* xls_function, int64 opt_level = 3);
 
   // Executes the compiled function with the specified arguments.
@@ -93,6 +115,21 @@ class LlvmIrJit {
     return absl::OkStatus();
   }
 
+  // Executes the compiled function over "batch_size" argument sets in a single
+  // call, amortizing per-call overhead across the batch.
+  //
+  // Arguments are laid out structure-of-arrays style: args[i] points to
+  // "batch_size" contiguous elements of parameter i, each of which has the same
+  // layout (and size, GetArgTypeSize(i)) as the corresponding RunWithViews()
+  // argument. Results are likewise written contiguously into result_buffer,
+  // which must hold at least batch_size * GetReturnTypeSize() bytes and must
+  // not overlap any argument buffer.
+  //
+  // The batch is evaluated by a single compiled loop over the samples, which
+  // gives LLVM the opportunity to vectorize narrow operations across samples.
+  absl::Status RunBatch(absl::Span<const uint8* const> args,
+                        absl::Span<uint8> result_buffer, int64 batch_size);
+
   // Returns the function that the JIT executes.
   Function* function() { return xls_function_; }
 
@@ -102,8 +139,13 @@ class LlvmIrJit {
   int64 GetArgTypeSize(int arg_index) { return arg_type_bytes_[arg_index]; }
   int64 GetReturnTypeSize() { return return_type_bytes_; }
 
+  // Returns the runtime used to convert between XLS Values and the (unpacked)
+  // view buffers accepted by RunWithViews() and RunBatch().
+  LlvmIrRuntime* runtime() { return ir_runtime_.get(); }
+
  private:
-  explicit LlvmIrJit(Function* xls_function, int64 opt_level);
+  explicit LlvmIrJit(Function* xls_function, int64 opt_level,
+                     JitObjectCache* object_cache, bool lazy);
 
   // Performs non-trivial initialization (i.e., that which can fail).
   absl::Status Init();
@@ -119,6 +161,17 @@ class LlvmIrJit {
   // closely packed, without any padding bits or bytes between them.
   absl::Status CompilePackedViewFunction(llvm::Module* module);
 
+  // Compiles the input function as in CompileFunction(), but wrapped in a loop
+  // over a batch of structure-of-arrays inputs (see RunBatch()).
+  absl::Status CompileBatchFunction(llvm::Module* module);
+
+  // Stores the computed return value of the function into the output buffer
+  // "output", which must be a pointer to the LLVM return type.
+  absl::Status StoreReturnValue(llvm::IRBuilder<>& builder,
+                                llvm::Value* return_value,
+                                llvm::Type* llvm_return_type,
+                                llvm::Value* output);
+
   // Packs an element into an LLVM integral type...in other words, packs an
   // output element into the return buffer/value.
   // Args:
@@ -163,10 +216,22 @@ class LlvmIrJit {
   std::unique_ptr<llvm::orc::IRCompileLayer> compile_layer_;
   std::unique_ptr<llvm::orc::IRTransformLayer> transform_layer_;
 
+  // Only used in lazy mode (see CreateLazy()): the layer that splits modules
+  // into per-function partitions and emits call-through stubs for them, and the
+  // manager for those stubs.
+  std::unique_ptr<llvm::orc::LazyCallThroughManager> lazy_call_through_manager_;
+  std::unique_ptr<llvm::orc::CompileOnDemandLayer> compile_on_demand_layer_;
+
   Function* xls_function_;
   FunctionType* xls_function_type_;
   int64 opt_level_;
 
+  // If non-null, the cache of previously-compiled objects to consult.
+  JitObjectCache* object_cache_;
+
+  // True if functions are compiled on first call rather than up front.
+  bool lazy_;
+
   // Size of the function's args or return type as flat bytes.
   std::vector<int64> arg_type_bytes_;
   int64 return_type_bytes_;
@@ -185,6 +250,12 @@ class LlvmIrJit {
   using PackedJitFunctionType = void (*)(const uint8* const* inputs,
                                          uint8* output);
   PackedJitFunctionType packed_invoker_;
+
+  // Batched entry point: as JitFunctionType, but each input and the output
+  // point to arrays of "count" elements.
+  using BatchJitFunctionType = void (*)(const uint8* const* inputs,
+                                        uint8* output, int64 count);
+  BatchJitFunctionType batch_invoker_;
 };
 
 // JIT-compiles the given xls_function and invokes it with args, returning the
@@ -0,0 +1,393 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/types/span.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/status/statusor.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value_helpers.h"
+#include "xls/jit/llvm_ir_jit.h"
+
+const char* kUsage = R"(
+Measures the compile time and per-sample throughput of the LLVM IR JIT on
+randomly-generated inputs. Usage:
+
+To benchmark the entry function of an IR file:
+   llvm_ir_jit_benchmark <ir_file>
+
+To benchmark a set of sample packages:
+   llvm_ir_jit_benchmark --benchmarks=sha256,crc32
+   llvm_ir_jit_benchmark --benchmarks=all
+
+To compare unrolled and looped lowering of counted_for loops:
+   llvm_ir_jit_benchmark --trip_counts=16,256,4096
+)";
+
+ABSL_FLAG(std::vector<std::string>, benchmarks, {},
+          "Comma-separated list of benchmarks to run.");
+ABSL_FLAG(int64, samples, 100000, "Number of random samples to evaluate.");
+ABSL_FLAG(int64, batch_size, 1024,
+          "Number of samples to pass to each LlvmIrJit::RunBatch() call.");
+ABSL_FLAG(int64, max_threads, std::thread::hardware_concurrency(),
+          "Maximum number of threads sharing a single JIT instance. Throughput "
+          "is measured for each power of two up to (and including) this.");
+ABSL_FLAG(std::vector<std::string>, trip_counts, {},
+          "Comma-separated list of counted_for trip counts. For each, compares "
+          "compile time and throughput of a fully-unrolled loop against an "
+          "LLVM loop.");
+
+ABSL_DECLARE_FLAG(int64, llvm_jit_max_unrolled_trip_count);
+
+namespace xls {
+namespace {
+
+// Return list of pairs of {name, Package} for the specified bechmarks.
+xabsl::StatusOr<std::vector<std::pair<std::string, std::unique_ptr<Package>>>>
+GetBenchmarks(absl::Span<const std::string> benchmark_names) {
+  std::vector<std::pair<std::string, std::unique_ptr<Package>>> packages;
+  std::vector<std::string> names;
+  if (benchmark_names.size() == 1 && benchmark_names.front() == "all") {
+    XLS_ASSIGN_OR_RETURN(names, sample_packages::GetBenchmarkNames());
+  } else {
+    names = std::vector<std::string>(benchmark_names.begin(),
+                                     benchmark_names.end());
+  }
+  for (const std::string& name : names) {
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<Package> package,
+        sample_packages::GetBenchmark(name, /*optimized=*/true));
+    packages.push_back({name, std::move(package)});
+  }
+  return packages;
+}
+
+// Random samples in structure-of-arrays layout, i.e., as accepted by
+// LlvmIrJit::RunBatch().
+struct SampleBuffers {
+  std::vector<std::vector<uint8>> args;
+  std::vector<uint8> results;
+};
+
+SampleBuffers MakeSampleBuffers(LlvmIrJit* jit, int64 sample_count) {
+  Function* function = jit->function();
+  std::minstd_rand bitgen;
+  SampleBuffers buffers;
+  buffers.args.resize(function->params().size());
+  for (int64 p = 0; p < function->params().size(); ++p) {
+    buffers.args[p].resize(sample_count * jit->GetArgTypeSize(p));
+  }
+  for (int64 i = 0; i < sample_count; ++i) {
+    std::vector<Value> args = RandomFunctionArguments(function, &bitgen);
+    for (int64 p = 0; p < args.size(); ++p) {
+      int64 size = jit->GetArgTypeSize(p);
+      jit->runtime()->BlitValueToBuffer(
+          args[p], *function->param(p)->GetType(),
+          absl::MakeSpan(buffers.args[p].data() + i * size, size));
+    }
+  }
+  buffers.results.resize(sample_count * jit->GetReturnTypeSize());
+  return buffers;
+}
+
+// Evaluates every sample with one RunWithViews() call per sample.
+absl::Status RunScalar(LlvmIrJit* jit, int64 sample_count,
+                       SampleBuffers* buffers) {
+  std::vector<const uint8*> args(buffers->args.size());
+  for (int64 i = 0; i < sample_count; ++i) {
+    for (int64 p = 0; p < args.size(); ++p) {
+      args[p] = buffers->args[p].data() + i * jit->GetArgTypeSize(p);
+    }
+    XLS_RETURN_IF_ERROR(jit->RunWithViews(
+        absl::MakeSpan(args),
+        absl::MakeSpan(
+            buffers->results.data() + i * jit->GetReturnTypeSize(),
+            jit->GetReturnTypeSize())));
+  }
+  return absl::OkStatus();
+}
+
+// Evaluates every sample with one RunWithViews() call per sample, with the
+// samples split evenly across "thread_count" threads sharing the one JIT.
+absl::Status RunThreaded(LlvmIrJit* jit, int64 sample_count,
+                         int64 thread_count, SampleBuffers* buffers) {
+  std::vector<absl::Status> statuses(thread_count);
+  std::vector<std::thread> threads;
+  for (int64 t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&, t]() {
+      int64 start = sample_count * t / thread_count;
+      int64 end = sample_count * (t + 1) / thread_count;
+      std::vector<const uint8*> args(buffers->args.size());
+      for (int64 i = start; i < end && statuses[t].ok(); ++i) {
+        for (int64 p = 0; p < args.size(); ++p) {
+          args[p] = buffers->args[p].data() + i * jit->GetArgTypeSize(p);
+        }
+        statuses[t] = jit->RunWithViews(
+            absl::MakeSpan(args),
+            absl::MakeSpan(
+                buffers->results.data() + i * jit->GetReturnTypeSize(),
+                jit->GetReturnTypeSize()));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+// Evaluates every sample via RunBatch() calls of up to "batch_size" samples.
+absl::Status RunBatched(LlvmIrJit* jit, int64 sample_count, int64 batch_size,
+                        SampleBuffers* buffers) {
+  std::vector<const uint8*> args(buffers->args.size());
+  for (int64 start = 0; start < sample_count; start += batch_size) {
+    int64 count = std::min(batch_size, sample_count - start);
+    for (int64 p = 0; p < args.size(); ++p) {
+      args[p] = buffers->args[p].data() + start * jit->GetArgTypeSize(p);
+    }
+    XLS_RETURN_IF_ERROR(jit->RunBatch(
+        args,
+        absl::MakeSpan(
+            buffers->results.data() + start * jit->GetReturnTypeSize(),
+            count * jit->GetReturnTypeSize()),
+        count));
+  }
+  return absl::OkStatus();
+}
+
+// Returns the number of samples whose results differ between the two buffers.
+int64 CountMismatches(LlvmIrJit* jit, int64 sample_count,
+                      const std::vector<uint8>& a,
+                      const std::vector<uint8>& b) {
+  Type* return_type = jit->function()->GetType()->return_type();
+  int64 size = jit->GetReturnTypeSize();
+  int64 mismatches = 0;
+  for (int64 i = 0; i < sample_count; ++i) {
+    if (jit->runtime()->UnpackBuffer(a.data() + i * size, return_type) !=
+        jit->runtime()->UnpackBuffer(b.data() + i * size, return_type)) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+absl::Status RunBenchmark(Function* function) {
+  int64 sample_count = absl::GetFlag(FLAGS_samples);
+  int64 batch_size = absl::GetFlag(FLAGS_batch_size);
+  XLS_RET_CHECK_GT(sample_count, 0);
+  XLS_RET_CHECK_GT(batch_size, 0);
+
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LlvmIrJit> jit,
+                       LlvmIrJit::Create(function));
+  std::cout << "JIT compile time: " << absl::Now() - start << "\n";
+
+  SampleBuffers buffers = MakeSampleBuffers(jit.get(), sample_count);
+
+  // Startup latency of the lazy JIT: creation compiles only the entry points,
+  // and the first call additionally compiles every callee it reaches.
+  start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LlvmIrJit> lazy_jit,
+                       LlvmIrJit::CreateLazy(function));
+  absl::Duration lazy_create_time = absl::Now() - start;
+  XLS_RETURN_IF_ERROR(RunScalar(lazy_jit.get(), /*sample_count=*/1, &buffers));
+  absl::Duration lazy_first_run_time = absl::Now() - start - lazy_create_time;
+  std::cout << "Lazy JIT create time: " << lazy_create_time
+            << ", first run: " << lazy_first_run_time << "\n";
+  auto samples_per_second = [&](absl::Duration d) {
+    return sample_count / absl::ToDoubleSeconds(d);
+  };
+
+  start = absl::Now();
+  XLS_RETURN_IF_ERROR(RunScalar(jit.get(), sample_count, &buffers));
+  absl::Duration scalar_time = absl::Now() - start;
+  std::vector<uint8> scalar_results = buffers.results;
+
+  start = absl::Now();
+  XLS_RETURN_IF_ERROR(
+      RunBatched(jit.get(), sample_count, batch_size, &buffers));
+  absl::Duration batch_time = absl::Now() - start;
+
+  std::cout << absl::StreamFormat(
+      "Scalar (RunWithViews): %s, %.0f samples/s\n",
+      absl::FormatDuration(scalar_time), samples_per_second(scalar_time));
+  std::cout << absl::StreamFormat(
+      "Batched (RunBatch, batch size %d): %s, %.0f samples/s (%.2fx)\n",
+      batch_size, absl::FormatDuration(batch_time),
+      samples_per_second(batch_time),
+      absl::FDivDuration(scalar_time, batch_time));
+
+  int64 mismatches = CountMismatches(jit.get(), sample_count, scalar_results,
+                                     buffers.results);
+  if (mismatches != 0) {
+    return absl::InternalError(absl::StrFormat(
+        "%d of %d batched results differ from scalar results", mismatches,
+        sample_count));
+  }
+
+  absl::Duration single_thread_time;
+  for (int64 thread_count = 1;
+       thread_count <= absl::GetFlag(FLAGS_max_threads); thread_count *= 2) {
+    start = absl::Now();
+    XLS_RETURN_IF_ERROR(
+        RunThreaded(jit.get(), sample_count, thread_count, &buffers));
+    absl::Duration threaded_time = absl::Now() - start;
+    if (thread_count == 1) {
+      single_thread_time = threaded_time;
+    }
+    std::cout << absl::StreamFormat(
+        "Shared JIT, %3d thread(s): %s, %.0f samples/s (%.2fx)\n",
+        thread_count, absl::FormatDuration(threaded_time),
+        samples_per_second(threaded_time),
+        absl::FDivDuration(single_thread_time, threaded_time));
+
+    mismatches = CountMismatches(jit.get(), sample_count, scalar_results,
+                                 buffers.results);
+    if (mismatches != 0) {
+      return absl::InternalError(absl::StrFormat(
+          "%d of %d results with %d threads differ from scalar results",
+          mismatches, sample_count, thread_count));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Compiles and runs an accumulating counted_for loop of the given trip count
+// with the JIT unrolling at most "max_unrolled_trip_count" iterations.
+absl::Status RunTripCountBenchmark(int64 trip_count,
+                                   int64 max_unrolled_trip_count,
+                                   absl::string_view label,
+                                   std::vector<uint8>* results) {
+  int64 sample_count = absl::GetFlag(FLAGS_samples);
+  std::pair<std::unique_ptr<Package>, Function*> accumulate =
+      sample_packages::BuildAccumulateIvar(trip_count, /*bit_count=*/32);
+
+  int64 saved = absl::GetFlag(FLAGS_llvm_jit_max_unrolled_trip_count);
+  absl::SetFlag(&FLAGS_llvm_jit_max_unrolled_trip_count,
+                max_unrolled_trip_count);
+  absl::Time start = absl::Now();
+  xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> jit_or =
+      LlvmIrJit::Create(accumulate.second);
+  absl::Duration compile_time = absl::Now() - start;
+  absl::SetFlag(&FLAGS_llvm_jit_max_unrolled_trip_count, saved);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LlvmIrJit> jit, jit_or);
+
+  SampleBuffers buffers = MakeSampleBuffers(jit.get(), sample_count);
+  start = absl::Now();
+  XLS_RETURN_IF_ERROR(RunScalar(jit.get(), sample_count, &buffers));
+  absl::Duration run_time = absl::Now() - start;
+  std::cout << absl::StreamFormat(
+      "  %-8s compile time: %s, %.0f samples/s\n", label,
+      absl::FormatDuration(compile_time),
+      sample_count / absl::ToDoubleSeconds(run_time));
+  *results = std::move(buffers.results);
+  return absl::OkStatus();
+}
+
+absl::Status RunTripCountBenchmarks(
+    absl::Span<const std::string> trip_count_strs) {
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_samples), 0);
+  for (const std::string& trip_count_str : trip_count_strs) {
+    int64 trip_count;
+    XLS_RET_CHECK(absl::SimpleAtoi(trip_count_str, &trip_count))
+        << "Invalid trip count: " << trip_count_str;
+    XLS_RET_CHECK_GT(trip_count, 0);
+    // Use endl to flush cout so the banner appears before starting work.
+    std::cout << "================== trip count " << trip_count << std::endl;
+    std::vector<uint8> unrolled_results;
+    std::vector<uint8> looped_results;
+    XLS_RETURN_IF_ERROR(RunTripCountBenchmark(
+        trip_count, trip_count, "Unrolled", &unrolled_results));
+    XLS_RETURN_IF_ERROR(RunTripCountBenchmark(
+        trip_count, /*max_unrolled_trip_count=*/0, "Looped", &looped_results));
+    XLS_RET_CHECK(unrolled_results == looped_results)
+        << "Unrolled and looped results differ for trip count " << trip_count;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RealMain(absl::string_view input_path) {
+  if (!absl::GetFlag(FLAGS_trip_counts).empty()) {
+    return RunTripCountBenchmarks(absl::GetFlag(FLAGS_trip_counts));
+  }
+
+  std::vector<std::pair<std::string, std::unique_ptr<Package>>> packages;
+  if (absl::GetFlag(FLAGS_benchmarks).empty()) {
+    XLS_QCHECK(!input_path.empty());
+    std::string path;
+    if (input_path == "-") {
+      path = "/dev/stdin";
+    } else {
+      path = std::string(input_path);
+    }
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                         Parser::ParsePackage(contents, path));
+    packages.push_back({path, std::move(package)});
+  } else {
+    XLS_ASSIGN_OR_RETURN(packages,
+                         GetBenchmarks(absl::GetFlag(FLAGS_benchmarks)));
+  }
+
+  for (const auto& pair : packages) {
+    const std::string& name = pair.first;
+    const auto& package = pair.second;
+    if (packages.size() > 1) {
+      // Use endl to flush cout so the banner appears before starting work.
+      std::cout << "================== " << name << std::endl;
+    }
+    XLS_ASSIGN_OR_RETURN(Function * entry, package->EntryFunction());
+    XLS_RETURN_IF_ERROR(RunBenchmark(entry));
+  }
+
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+
+  if (positional_arguments.empty() && absl::GetFlag(FLAGS_benchmarks).empty() &&
+      absl::GetFlag(FLAGS_trip_counts).empty()) {
+    XLS_LOG(QFATAL) << absl::StreamFormat(
+        "Expected invocation:\n  %s <path>\n  %s "
+        "--benchmarks=<benchmark-names>",
+        argv[0], argv[0]);
+  }
+
+  XLS_QCHECK_OK(xls::RealMain(
+      positional_arguments.empty() ? "" : positional_arguments[0]));
+  return EXIT_SUCCESS;
+}
@@ -14,23 +14,43 @@
 
 #include "xls/jit/llvm_ir_jit.h"
 
+#include <filesystem>
 #include <random>
+#include <string>
+#include <thread>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/flags/flag.h"
 #include "absl/random/random.h"
 #include "absl/strings/substitute.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/ir_evaluator_test.h"
 #include "xls/ir/value_helpers.h"
 #include "re2/re2.h"
 
+ABSL_DECLARE_FLAG(int64, llvm_jit_max_unrolled_trip_count);
+
 namespace xls {
 namespace {
 
 using status_testing::IsOkAndHolds;
 
+// Creates a JIT for "function" in which every counted_for and map is emitted
+// as a loop rather than being unrolled.
+xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> CreateWithoutUnrolling(
+    Function* function) {
+  int64 saved = absl::GetFlag(FLAGS_llvm_jit_max_unrolled_trip_count);
+  absl::SetFlag(&FLAGS_llvm_jit_max_unrolled_trip_count, 0);
+  xabsl::StatusOr<std::unique_ptr<LlvmIrJit>> jit_or =
+      LlvmIrJit::Create(function);
+  absl::SetFlag(&FLAGS_llvm_jit_max_unrolled_trip_count, saved);
+  return jit_or;
+}
+
 INSTANTIATE_TEST_SUITE_P(
     LlvmIrJitTest, IrEvaluatorTest,
     testing::Values(IrEvaluatorTestParam(
@@ -44,7 +64,31 @@ INSTANTIATE_TEST_SUITE_P(
             -> xabsl::StatusOr<Value> {
           XLS_ASSIGN_OR_RETURN(auto jit, LlvmIrJit::Create(function));
           return jit->Run(kwargs);
-        })));
+        }),
+        IrEvaluatorTestParam(
+            [](Function* function,
+               const std::vector<Value>& args) -> xabsl::StatusOr<Value> {
+              XLS_ASSIGN_OR_RETURN(auto jit, LlvmIrJit::CreateLazy(function));
+              return jit->Run(args);
+            },
+            [](Function* function,
+               const absl::flat_hash_map<std::string, Value>& kwargs)
+                -> xabsl::StatusOr<Value> {
+              XLS_ASSIGN_OR_RETURN(auto jit, LlvmIrJit::CreateLazy(function));
+              return jit->Run(kwargs);
+            }),
+        IrEvaluatorTestParam(
+            [](Function* function,
+               const std::vector<Value>& args) -> xabsl::StatusOr<Value> {
+              XLS_ASSIGN_OR_RETURN(auto jit, CreateWithoutUnrolling(function));
+              return jit->Run(args);
+            },
+            [](Function* function,
+               const absl::flat_hash_map<std::string, Value>& kwargs)
+                -> xabsl::StatusOr<Value> {
+              XLS_ASSIGN_OR_RETURN(auto jit, CreateWithoutUnrolling(function));
+              return jit->Run(kwargs);
+            })));
 
 // This test verifies that a compiled JIT function can be re-used.
 TEST(LlvmIrJitTest, ReuseTest) {
@@ -461,5 +505,266 @@ TEST(LlvmIrJitTest, PackedTuples) {
   }
 }
 
+// Verifies that batched evaluation matches evaluating each sample separately.
+TEST(LlvmIrJitTest, RunBatch) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[7], y: bits[7], a: bits[7][4]) -> (bits[7], bits[7]) {
+    add.1: bits[7] = add(x, y)
+    array_index.2: bits[7] = array_index(a, x)
+    ret tuple.3: (bits[7], bits[7]) = tuple(add.1, array_index.2)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, LlvmIrJit::Create(function));
+
+  // Use a batch size that isn't a multiple of any plausible vector width to
+  // exercise the loop remainder.
+  constexpr int64 kBatchSize = 1001;
+  std::minstd_rand bitgen;
+  std::vector<std::vector<Value>> argsets;
+  std::vector<std::vector<uint8>> arg_buffers(function->params().size());
+  for (int64 i = 0; i < kBatchSize; ++i) {
+    argsets.push_back(RandomFunctionArguments(function, &bitgen));
+  }
+  for (int64 p = 0; p < function->params().size(); ++p) {
+    Type* type = function->param(p)->GetType();
+    int64 size = jit->GetArgTypeSize(p);
+    arg_buffers[p].resize(kBatchSize * size);
+    for (int64 i = 0; i < kBatchSize; ++i) {
+      jit->runtime()->BlitValueToBuffer(
+          argsets[i][p], *type,
+          absl::MakeSpan(arg_buffers[p].data() + i * size, size));
+    }
+  }
+  std::vector<const uint8*> args;
+  for (const std::vector<uint8>& buffer : arg_buffers) {
+    args.push_back(buffer.data());
+  }
+
+  int64 result_size = jit->GetReturnTypeSize();
+  std::vector<uint8> results(kBatchSize * result_size);
+  XLS_ASSERT_OK(jit->RunBatch(args, absl::MakeSpan(results), kBatchSize));
+  for (int64 i = 0; i < kBatchSize; ++i) {
+    Value result = jit->runtime()->UnpackBuffer(
+        results.data() + i * result_size, function->GetType()->return_type());
+    EXPECT_THAT(jit->Run(argsets[i]), IsOkAndHolds(result)) << "sample " << i;
+  }
+
+  // An empty batch is a no-op; an undersized result buffer is an error.
+  XLS_EXPECT_OK(jit->RunBatch(args, absl::Span<uint8>(), 0));
+  EXPECT_FALSE(
+      jit->RunBatch(args, absl::MakeSpan(results), kBatchSize + 1).ok());
+}
+
+// Hammers a single JIT instance from many threads at once, verifying that every
+// thread sees the same results as single-threaded evaluation.
+TEST(LlvmIrJitTest, ConcurrentRuns) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[16], y: bits[16][3]) -> (bits[16], bits[16][3]) {
+    literal.1: bits[2] = literal(value=1)
+    array_index.2: bits[16] = array_index(y, literal.1)
+    umul.3: bits[16] = umul(x, array_index.2)
+    array_update.4: bits[16][3] = array_update(y, x, umul.3)
+    ret tuple.5: (bits[16], bits[16][3]) = tuple(umul.3, array_update.4)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, LlvmIrJit::Create(function));
+
+  constexpr int64 kSampleCount = 500;
+  std::minstd_rand bitgen;
+  std::vector<std::vector<Value>> argsets;
+  std::vector<Value> expected;
+  for (int64 i = 0; i < kSampleCount; ++i) {
+    argsets.push_back(RandomFunctionArguments(function, &bitgen));
+    XLS_ASSERT_OK_AND_ASSIGN(Value result, jit->Run(argsets.back()));
+    expected.push_back(result);
+  }
+
+  constexpr int kThreadCount = 16;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&, t]() {
+      // Start each thread at a different sample so they don't run in lockstep.
+      for (int64 n = 0; n < kSampleCount; ++n) {
+        int64 i = (n + t * kSampleCount / kThreadCount) % kSampleCount;
+        EXPECT_THAT(jit->Run(argsets[i]), IsOkAndHolds(expected[i]));
+
+        std::vector<std::unique_ptr<uint8[]>> arg_storage;
+        std::vector<const uint8*> args;
+        for (int64 p = 0; p < argsets[i].size(); ++p) {
+          arg_storage.push_back(
+              std::make_unique<uint8[]>(jit->GetArgTypeSize(p)));
+          jit->runtime()->BlitValueToBuffer(
+              argsets[i][p], *function->param(p)->GetType(),
+              absl::MakeSpan(arg_storage.back().get(), jit->GetArgTypeSize(p)));
+          args.push_back(arg_storage.back().get());
+        }
+        auto result = std::make_unique<uint8[]>(jit->GetReturnTypeSize());
+        XLS_EXPECT_OK(jit->RunWithViews(
+            absl::MakeSpan(args),
+            absl::MakeSpan(result.get(), jit->GetReturnTypeSize())));
+        EXPECT_EQ(jit->runtime()->UnpackBuffer(
+                      result.get(), function->GetType()->return_type()),
+                  expected[i]);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Verifies that a second JIT of the same function is served from the object
+// cache, i.e., without lowering, optimizing or compiling the function again.
+TEST(LlvmIrJitTest, ObjectCache) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<JitObjectCache> cache,
+      JitObjectCache::Create(temp_dir.path(), /*max_size_bytes=*/1 << 20));
+
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn add_one(x: bits[8]) -> bits[8] {
+    literal.1: bits[8] = literal(value=1)
+    ret add.2: bits[8] = add(x, literal.1)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        auto jit, LlvmIrJit::Create(function, /*opt_level=*/3, cache.get()));
+    EXPECT_THAT(jit->Run({Value(UBits(2, 8))}),
+                IsOkAndHolds(Value(UBits(3, 8))));
+  }
+  EXPECT_EQ(cache->stats().misses, 1);
+  EXPECT_EQ(cache->stats().hits, 0);
+  EXPECT_EQ(cache->stats().stores, 1);
+
+  // The second JIT hits in the cache and stores nothing new: no module was
+  // handed to the optimizer and compiler.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, LlvmIrJit::Create(function, /*opt_level=*/3, cache.get()));
+  EXPECT_EQ(cache->stats().misses, 1);
+  EXPECT_EQ(cache->stats().hits, 1);
+  EXPECT_EQ(cache->stats().stores, 1);
+  EXPECT_THAT(jit->Run({Value(UBits(7, 8))}), IsOkAndHolds(Value(UBits(8, 8))));
+  std::vector<uint8> results(3 * jit->GetReturnTypeSize());
+  uint8 inputs[] = {1, 2, 3};
+  std::vector<const uint8*> args = {inputs};
+  XLS_ASSERT_OK(jit->RunBatch(args, absl::MakeSpan(results), 3));
+  EXPECT_EQ(results, std::vector<uint8>({2, 3, 4}));
+
+  // A different optimization level is a different object.
+  XLS_ASSERT_OK(
+      LlvmIrJit::Create(function, /*opt_level=*/1, cache.get()).status());
+  EXPECT_EQ(cache->stats().misses, 2);
+  EXPECT_EQ(cache->stats().stores, 2);
+}
+
+// Verifies that a truncated or corrupt object in the cache is discarded and the
+// function compiled again, rather than failing the JIT.
+TEST(LlvmIrJitTest, CorruptObjectCacheEntry) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<JitObjectCache> cache,
+      JitObjectCache::Create(temp_dir.path(), /*max_size_bytes=*/1 << 20));
+
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn add_one(x: bits[8]) -> bits[8] {
+    literal.1: bits[8] = literal(value=1)
+    ret add.2: bits[8] = add(x, literal.1)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK(
+      LlvmIrJit::Create(function, /*opt_level=*/3, cache.get()).status());
+  ASSERT_EQ(cache->stats().stores, 1);
+  std::filesystem::path object_path =
+      std::filesystem::directory_iterator(temp_dir.path())->path();
+  XLS_ASSERT_OK_AND_ASSIGN(std::string object, GetFileContents(object_path));
+
+  for (const std::string& corrupt_object :
+       {object.substr(0, object.size() / 2), std::string("not an object")}) {
+    XLS_ASSERT_OK(SetFileContents(object_path, corrupt_object));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        auto jit, LlvmIrJit::Create(function, /*opt_level=*/3, cache.get()));
+    EXPECT_THAT(jit->Run({Value(UBits(2, 8))}),
+                IsOkAndHolds(Value(UBits(3, 8))));
+  }
+  // Each corrupt object was replaced by a freshly compiled one.
+  EXPECT_EQ(cache->stats().hits, 0);
+  EXPECT_EQ(cache->stats().misses, 3);
+  EXPECT_EQ(cache->stats().invalidations, 2);
+  EXPECT_EQ(cache->stats().stores, 3);
+
+  // Which is used from then on.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, LlvmIrJit::Create(function, /*opt_level=*/3, cache.get()));
+  EXPECT_THAT(jit->Run({Value(UBits(7, 8))}), IsOkAndHolds(Value(UBits(8, 8))));
+  EXPECT_EQ(cache->stats().hits, 1);
+}
+
+// Counted-for loops and maps past the unrolling threshold are emitted as LLVM
+// loops; these should behave exactly like their unrolled counterparts.
+TEST(LlvmIrJitTest, LargeTripCountCountedFor) {
+  Package package("my_package");
+  std::string body_text = R"(
+  fn body(i: bits[32], accum: bits[32], scale: bits[32]) -> bits[32] {
+    umul.1: bits[32] = umul(i, scale)
+    ret add.2: bits[32] = add(accum, umul.1)
+  }
+  )";
+  std::string main_text = R"(
+  fn main(init: bits[32], scale: bits[32]) -> bits[32] {
+    ret counted_for.3: bits[32] = counted_for(init, trip_count=1000, stride=3, body=body, invariant_args=[scale])
+  }
+  )";
+  XLS_ASSERT_OK(Parser::ParseFunction(body_text, &package).status());
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(main_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, LlvmIrJit::Create(function));
+
+  // init + scale * 3 * (0 + 1 + ... + 999).
+  EXPECT_THAT(jit->Run({Value(UBits(5, 32)), Value(UBits(2, 32))}),
+              IsOkAndHolds(Value(UBits(5 + 2 * 3 * 499500, 32))));
+}
+
+TEST(LlvmIrJitTest, LargeMap) {
+  Package package("my_package");
+  std::string square_text = R"(
+  fn square(x: bits[16]) -> bits[16] {
+    ret umul.1: bits[16] = umul(x, x)
+  }
+  )";
+  std::string main_text = R"(
+  fn main(input: bits[16][100]) -> bits[16][100] {
+    ret map.2: bits[16][100] = map(input, to_apply=square)
+  }
+  )";
+  XLS_ASSERT_OK(Parser::ParseFunction(square_text, &package).status());
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(main_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, LlvmIrJit::Create(function));
+
+  std::vector<Value> input;
+  std::vector<Value> expected;
+  for (int64 i = 0; i < 100; ++i) {
+    input.push_back(Value(UBits(i, 16)));
+    expected.push_back(Value(UBits(i * i, 16)));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Value input_array, Value::Array(input));
+  XLS_ASSERT_OK_AND_ASSIGN(Value expected_array, Value::Array(expected));
+  EXPECT_THAT(jit->Run({input_array}), IsOkAndHolds(expected_array));
+}
+
 }  // namespace
 }  // namespace xls
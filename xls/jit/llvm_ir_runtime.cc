@@ -93,18 +93,15 @@ Value LlvmIrRuntime::UnpackBuffer(const uint8* buffer,
         return Value::ArrayOrDie({});
       }
 
+      // Array elements are laid out at multiples of their allocation size.
+      // Note that this must not create any LLVM constants (or otherwise touch
+      // the LLVMContext), as this may be called concurrently.
       const Type* element_type = array_type->element_type();
-      llvm::Type* llvm_element_type =
-          type_converter_->ConvertToLlvmType(*array_type->element_type());
+      int64 element_size = type_converter_->GetTypeByteSize(*element_type);
       std::vector<Value> values;
       values.reserve(array_type->size());
       for (int i = 0; i < array_type->size(); ++i) {
-        llvm::Constant* index =
-            type_converter_->ToLlvmConstant(BitsType(64), Value(UBits(i, 64)))
-                .value();
-        int64 offset =
-            data_layout_.getIndexedOffsetInType(llvm_element_type, index);
-        Value value = UnpackBuffer(buffer + offset, element_type);
+        Value value = UnpackBuffer(buffer + i * element_size, element_type);
         values.push_back(value);
       }
 
@@ -162,6 +159,21 @@ void LlvmIrRuntime::BlitValueToBuffer(const Value& value, const Type& type,
   }
 }
 
+void LlvmIrRuntime::PrepareType(const Type& type) {
+  // Both the type converter and the DataLayout lazily populate caches (of LLVM
+  // types and of struct layouts, respectively); populate them all up front.
+  llvm::Type* llvm_type = type_converter_->ConvertToLlvmType(type);
+  type_converter_->GetTypeByteSize(type);
+  if (type.IsTuple()) {
+    data_layout_.getStructLayout(llvm::cast<llvm::StructType>(llvm_type));
+    for (const Type* element_type : type.AsTupleOrDie()->element_types()) {
+      PrepareType(*element_type);
+    }
+  } else if (type.IsArray()) {
+    PrepareType(*type.AsArrayOrDie()->element_type());
+  }
+}
+
 template <typename T>
 std::string LlvmIrRuntime::DumpToString(const T& llvm_object) {
   std::string buffer;
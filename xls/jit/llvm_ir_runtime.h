@@ -53,6 +53,12 @@ class LlvmIrRuntime {
   void BlitValueToBuffer(const Value& value, const Type& type,
                          absl::Span<uint8> buffer);
 
+  // Computes and caches all layout information needed to pack or unpack values
+  // of the given type. Afterwards, PackArgs(), UnpackBuffer() and
+  // BlitValueToBuffer() only read those caches for this type (and the types it
+  // contains), and so may be called concurrently from multiple threads.
+  void PrepareType(const Type& type);
+
   // Returns a textual description of the argument LLVM object.
   template <typename T>
   static std::string DumpToString(const T& llvm_object);
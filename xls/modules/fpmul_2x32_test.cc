@@ -85,10 +85,15 @@ bool CompareResults(float a, float b) {
 }
 
 absl::Status RealMain(bool use_opt_ir, uint64 num_samples, int num_threads) {
-  Testbench<Fpmul2x32, Float2x32, float> testbench(
+  auto testbench = MakeTestbench<Fpmul2x32>(
       0, num_samples,
-      /*max_failures=*/1, IndexToInput, ComputeExpected, ComputeActual,
-      CompareResults);
+      /*max_failures=*/1,
+      [](uint64 index) { return IndexToInput(index); },
+      [](Float2x32 input) { return ComputeExpected(input); },
+      [](Fpmul2x32* jit, absl::Span<uint8> buffer, Float2x32 input) {
+        return ComputeActual(jit, buffer, input);
+      },
+      [](float a, float b) { return CompareResults(a, b); });
   if (num_threads != 0) {
     XLS_RETURN_IF_ERROR(testbench.SetNumThreads(num_threads));
   }
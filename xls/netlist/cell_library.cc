@@ -17,6 +17,8 @@
 #include "google/protobuf/repeated_field.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/common/integral_types.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -118,6 +120,53 @@ xabsl::StatusOr<StateTableSignalProto> ProtoFromStateTableSignal(
   }
 }
 
+// Evaluates "ast" with input j of the entry set to bit j of "input_values".
+// Returns nullopt if the function refers to anything but the inputs.
+absl::optional<bool> EvaluateOnInputs(
+    const function::Ast& ast, absl::Span<const std::string> input_names,
+    uint64 input_values) {
+  switch (ast.kind()) {
+    case function::Ast::Kind::kIdentifier:
+      for (int64 i = input_names.size() - 1; i >= 0; --i) {
+        if (input_names[i] == ast.name()) {
+          return (input_values >> i) & 1;
+        }
+      }
+      return absl::nullopt;
+    case function::Ast::Kind::kLiteralZero:
+      return false;
+    case function::Ast::Kind::kLiteralOne:
+      return true;
+    case function::Ast::Kind::kNot: {
+      absl::optional<bool> operand =
+          EvaluateOnInputs(ast.children()[0], input_names, input_values);
+      if (!operand.has_value()) {
+        return absl::nullopt;
+      }
+      return !*operand;
+    }
+    case function::Ast::Kind::kAnd:
+    case function::Ast::Kind::kOr:
+    case function::Ast::Kind::kXor: {
+      absl::optional<bool> lhs =
+          EvaluateOnInputs(ast.children()[0], input_names, input_values);
+      absl::optional<bool> rhs =
+          EvaluateOnInputs(ast.children()[1], input_names, input_values);
+      if (!lhs.has_value() || !rhs.has_value()) {
+        return absl::nullopt;
+      }
+      if (ast.kind() == function::Ast::Kind::kAnd) {
+        return *lhs && *rhs;
+      }
+      if (ast.kind() == function::Ast::Kind::kOr) {
+        return *lhs || *rhs;
+      }
+      return *lhs != *rhs;
+    }
+  }
+  return absl::nullopt;
+}
+
 }  // namespace
 
 std::string CellKindToString(CellKind kind) {
@@ -322,6 +371,46 @@ xabsl::StatusOr<StateTableProto> StateTable::ToProto() const {
                           state_table);
 }
 
+void CellLibraryEntry::ParseOutputPinFunctions() {
+  for (const auto& kv : output_pin_to_function_) {
+    xabsl::StatusOr<function::Ast> ast =
+        function::Parser::ParseFunction(kv.second);
+    if (!ast.ok()) {
+      output_pin_functions_.emplace(kv.first, ast.status());
+      continue;
+    }
+    OutputPinFunction function{std::move(ast).value(), absl::nullopt};
+    if (input_names_.size() <= kMaxTruthTableInputs) {
+      uint64 truth_table = 0;
+      bool depends_only_on_inputs = true;
+      for (uint64 i = 0;
+           depends_only_on_inputs && i < (uint64{1} << input_names_.size());
+           ++i) {
+        absl::optional<bool> value =
+            EvaluateOnInputs(function.ast, input_names_, i);
+        depends_only_on_inputs = value.has_value();
+        truth_table |= static_cast<uint64>(value.value_or(false)) << i;
+      }
+      if (depends_only_on_inputs) {
+        function.truth_table = truth_table;
+      }
+    }
+    output_pin_functions_.emplace(kv.first, std::move(function));
+  }
+}
+
+xabsl::StatusOr<const CellLibraryEntry::OutputPinFunction*>
+CellLibraryEntry::GetOutputPinFunction(absl::string_view pin_name) const {
+  auto it = output_pin_functions_.find(pin_name);
+  if (it == output_pin_functions_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("No function for output pin %s of cell %s.", pin_name,
+                        name_));
+  }
+  XLS_RETURN_IF_ERROR(it->second.status());
+  return &it->second.value();
+}
+
 xabsl::StatusOr<CellLibraryEntryProto> CellLibraryEntry::ToProto() const {
   CellLibraryEntryProto proto;
   switch (kind_) {
@@ -399,11 +488,21 @@ absl::Status CellLibrary::AddEntry(CellLibraryEntry entry) {
 xabsl::StatusOr<const CellLibraryEntry*> CellLibrary::GetEntry(
     absl::string_view name) const {
   auto it = entries_.find(name);
-  if (it == entries_.end()) {
+  if (it != entries_.end()) {
+    return it->second.get();
+  }
+  if (!entry_loader_) {
     return absl::NotFoundError(
         absl::StrCat("Cell not found in library: ", name));
   }
-  return it->second.get();
+  XLS_ASSIGN_OR_RETURN(CellLibraryEntryProto entry_proto, entry_loader_(name));
+  XLS_RET_CHECK_EQ(entry_proto.name(), name);
+  XLS_ASSIGN_OR_RETURN(CellLibraryEntry entry,
+                       CellLibraryEntry::FromProto(entry_proto));
+  auto entry_ptr = absl::make_unique<CellLibraryEntry>(std::move(entry));
+  const CellLibraryEntry* result = entry_ptr.get();
+  entries_.insert({std::string(name), std::move(entry_ptr)});
+  return result;
 }
 
 }  // namespace netlist
@@ -15,12 +15,18 @@
 #ifndef XLS_NETLIST_CELL_LIBRARY_H_
 #define XLS_NETLIST_CELL_LIBRARY_H_
 
+#include <functional>
+#include <memory>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/status/statusor.h"
+#include "xls/netlist/function_parser.h"
 #include "xls/netlist/netlist.pb.h"
 
 namespace xls {
@@ -143,6 +149,18 @@ class CellLibraryEntry {
  public:
   using OutputPinToFunction = absl::flat_hash_map<std::string, std::string>;
 
+  // The function of an output pin, parsed once when the entry is created.
+  struct OutputPinFunction {
+    function::Ast ast;
+
+    // If the entry has at most kMaxTruthTableInputs inputs and the function
+    // depends only on them (not on internal signals of a state table), the
+    // function as a truth table: bit i is the value of the function when each
+    // input j has the value of bit j of i.
+    absl::optional<uint64> truth_table;
+  };
+  static constexpr int64 kMaxTruthTableInputs = 6;
+
   static xabsl::StatusOr<CellLibraryEntry> FromProto(
       const CellLibraryEntryProto& proto);
 
@@ -159,7 +177,9 @@ class CellLibraryEntry {
         input_names_(input_names.begin(), input_names.end()),
         output_pin_to_function_(output_pin_to_function),
         state_table_(state_table),
-        clock_name_(clock_name) {}
+        clock_name_(clock_name) {
+    ParseOutputPinFunctions();
+  }
 
   CellKind kind() const { return kind_; }
   const std::string& name() const { return name_; }
@@ -170,15 +190,24 @@ class CellLibraryEntry {
   const absl::optional<StateTable>& state_table() const { return state_table_; }
   absl::optional<std::string> clock_name() const { return clock_name_; }
 
+  // Returns the parsed function of the given output pin, or the error from
+  // parsing it.
+  xabsl::StatusOr<const OutputPinFunction*> GetOutputPinFunction(
+      absl::string_view pin_name) const;
+
   xabsl::StatusOr<CellLibraryEntryProto> ToProto() const;
 
  private:
+  void ParseOutputPinFunctions();
+
   CellKind kind_;
   std::string name_;
   std::vector<std::string> input_names_;
   OutputPinToFunction output_pin_to_function_;
   absl::optional<StateTable> state_table_;
   absl::optional<std::string> clock_name_;
+  absl::flat_hash_map<std::string, xabsl::StatusOr<OutputPinFunction>>
+      output_pin_functions_;
 };
 
 // Represents a library of cells. The definitions (represented in
@@ -186,18 +215,40 @@ class CellLibraryEntry {
 // Module.
 class CellLibrary {
  public:
+  // Produces the entry of a cell which is not (yet) in the library; see
+  // set_entry_loader.
+  using EntryLoader =
+      std::function<xabsl::StatusOr<CellLibraryEntryProto>(absl::string_view)>;
+
   static xabsl::StatusOr<CellLibrary> FromProto(const CellLibraryProto& proto);
 
-  // Returns a NOT_FOUND status if there is not entry with the given name.
+  // Returns a NOT_FOUND status if there is not entry with the given name. If
+  // the library has an entry loader, entries which are not in the library are
+  // loaded on demand instead.
   xabsl::StatusOr<const CellLibraryEntry*> GetEntry(
       absl::string_view name) const;
 
   absl::Status AddEntry(CellLibraryEntry entry);
 
+  // Sets a function which GetEntry calls with the name of a cell which is not
+  // in the library. The entry it returns is added to the library, so large
+  // libraries can be populated with just the cells which are used; see
+  // LazyCellLibrary. Loading entries is not thread-safe.
+  void set_entry_loader(EntryLoader entry_loader) {
+    entry_loader_ = std::move(entry_loader);
+  }
+
+  // Returns the number of entries in the library, including only the loaded
+  // ones.
+  int64 size() const { return entries_.size(); }
+
   xabsl::StatusOr<CellLibraryProto> ToProto() const;
 
  private:
-  absl::flat_hash_map<std::string, std::unique_ptr<CellLibraryEntry>> entries_;
+  // Mutable so that entries can be loaded by GetEntry.
+  mutable absl::flat_hash_map<std::string, std::unique_ptr<CellLibraryEntry>>
+      entries_;
+  EntryLoader entry_loader_;
 };
 
 }  // namespace netlist
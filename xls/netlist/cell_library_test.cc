@@ -20,7 +20,9 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
 #include "xls/common/status/matchers.h"
+#include "xls/netlist/function_parser.h"
 #include "xls/netlist/netlist.pb.h"
 
 namespace xls {
@@ -140,6 +142,40 @@ TEST(CellLibraryTest, EvaluateStateTable) {
                                ::testing::HasSubstr("No matching row")));
 }
 
+TEST(CellLibraryTest, OutputPinFunctions) {
+  CellLibraryEntry::OutputPinToFunction pins;
+  pins["Z"] = "!(A&B)";
+  pins["Y"] = "A^X";
+  pins["W"] = "A&(";
+  CellLibraryEntry entry(CellKind::kOther, "CELL",
+                         std::vector<std::string>{"A", "B"}, pins,
+                         absl::nullopt);
+
+  // Input A is bit 0 of the truth table index and B bit 1.
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry::OutputPinFunction* z,
+                           entry.GetOutputPinFunction("Z"));
+  EXPECT_EQ(z->ast.kind(), function::Ast::Kind::kNot);
+  EXPECT_EQ(z->truth_table, 0b0111);
+
+  // Y depends on a signal which is not an input, so has no truth table.
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry::OutputPinFunction* y,
+                           entry.GetOutputPinFunction("Y"));
+  EXPECT_EQ(y->ast.kind(), function::Ast::Kind::kXor);
+  EXPECT_FALSE(y->truth_table.has_value());
+
+  EXPECT_FALSE(entry.GetOutputPinFunction("W").ok());
+  EXPECT_THAT(entry.GetOutputPinFunction("V").status(),
+              status_testing::StatusIs(absl::StatusCode::kNotFound));
+
+  // The parsed functions are kept by copies of the entry.
+  CellLibrary cell_library;
+  XLS_ASSERT_OK(cell_library.AddEntry(entry));
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* added,
+                           cell_library.GetEntry("CELL"));
+  XLS_ASSERT_OK_AND_ASSIGN(z, added->GetOutputPinFunction("Z"));
+  EXPECT_EQ(z->truth_table, 0b0111);
+}
+
 }  // namespace
 }  // namespace netlist
 }  // namespace xls
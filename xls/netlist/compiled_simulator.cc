@@ -0,0 +1,542 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/compiled_simulator.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/netlist/function_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+// Nets holding the constants zero and one.
+constexpr int64 kZeroNet = 0;
+constexpr int64 kOneNet = 1;
+
+// State tables are compiled into truth tables over the inputs of the cell, so
+// only cells with few inputs are supported.
+constexpr int64 kMaxStateTableInputs = 16;
+
+}  // namespace
+
+// Compiles modules into the program of a CompiledSimulator.
+class ModuleCompiler {
+ public:
+  using Instruction = CompiledSimulator::Instruction;
+  using Op = Instruction::Op;
+  using TruthTable = CompiledSimulator::TruthTable;
+  // Program nets of the nets of a module, indexed by NetDef::id(); -1 for nets
+  // not yet assigned.
+  using NetSlots = std::vector<int64>;
+
+  ModuleCompiler(const rtl::Netlist* netlist, CompiledSimulator* simulator)
+      : netlist_(netlist), simulator_(simulator) {}
+
+  absl::Status CompileTop(const rtl::Module* module) {
+    simulator_->net_count_ = 2;
+    NetSlots slots(module->nets().size(), -1);
+    for (rtl::NetRef input : module->inputs()) {
+      int64 net = NewNet();
+      slots[input->id()] = net;
+      simulator_->input_nets_.push_back(net);
+    }
+    XLS_ASSIGN_OR_RETURN(simulator_->level_count_,
+                         CompileModule(module, &slots));
+    for (rtl::NetRef output : module->outputs()) {
+      simulator_->output_nets_.push_back(slots[output->id()]);
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // The output function of a cell library entry for one output pin, compiled
+  // to instructions in which the operand of kLoad is the index of an input pin
+  // of the entry and the operand of kStateTable is an index into
+  // "truth_tables".
+  struct CellFunction {
+    std::vector<Instruction> instructions;
+    std::vector<const TruthTable*> truth_tables;
+    int64 max_stack_depth = 0;
+  };
+
+  int64 NewNet() { return simulator_->net_count_++; }
+
+  // Compiles the cells of "module" in level order. "slots" maps the nets of
+  // the module which are bound to nets of the program (the inputs of a
+  // submodule); the other nets of the module are added to it. Returns the
+  // number of levels of the module.
+  xabsl::StatusOr<int64> CompileModule(const rtl::Module* module,
+                                       NetSlots* slots) {
+    XLS_ASSIGN_OR_RETURN(rtl::NetRef net_0, module->ResolveNumber(0));
+    XLS_ASSIGN_OR_RETURN(rtl::NetRef net_1, module->ResolveNumber(1));
+    (*slots)[net_0->id()] = kZeroNet;
+    (*slots)[net_1->id()] = kOneNet;
+    for (int64& slot : *slots) {
+      if (slot == -1) {
+        slot = NewNet();
+      }
+    }
+
+    // Levelize the cells: a cell is ready once all of its inputs are driven,
+    // and its level is one more than the highest level of the cells driving
+    // its inputs.
+    absl::Span<const std::unique_ptr<rtl::Cell>> cells = module->cells();
+    // The levels of the nets by id, or -1 for nets which are not driven yet.
+    std::vector<int64> net_levels(module->nets().size(), -1);
+    std::vector<std::vector<int64>> readers(module->nets().size());
+    std::vector<int64> unready_inputs(cells.size());
+    std::vector<int64> cell_levels(cells.size());
+    std::vector<int64> order;
+    std::deque<rtl::NetRef> ready_nets;
+    auto mark_ready = [&](rtl::NetRef net, int64 level) {
+      if (net_levels[net->id()] == -1) {
+        net_levels[net->id()] = level;
+        ready_nets.push_back(net);
+      }
+    };
+    auto schedule = [&](int64 cell_index) {
+      int64 level = 0;
+      for (const rtl::Cell::Pin& input : cells[cell_index]->inputs()) {
+        level = std::max(level, net_levels[input.netref->id()]);
+      }
+      cell_levels[cell_index] = level + 1;
+      order.push_back(cell_index);
+      for (const rtl::Cell::Pin& output : cells[cell_index]->outputs()) {
+        mark_ready(output.netref, level + 1);
+      }
+    };
+    for (rtl::NetRef input : module->inputs()) {
+      mark_ready(input, 0);
+    }
+    mark_ready(net_0, 0);
+    mark_ready(net_1, 0);
+    for (int64 i = 0; i < cells.size(); ++i) {
+      absl::flat_hash_set<rtl::NetRef> inputs;
+      for (const rtl::Cell::Pin& input : cells[i]->inputs()) {
+        if (inputs.insert(input.netref).second) {
+          readers[input.netref->id()].push_back(i);
+        }
+      }
+      unready_inputs[i] = inputs.size();
+      if (inputs.empty()) {
+        schedule(i);
+      }
+    }
+    while (!ready_nets.empty()) {
+      rtl::NetRef net = ready_nets.front();
+      ready_nets.pop_front();
+      for (int64 reader : readers[net->id()]) {
+        if (--unready_inputs[reader] == 0) {
+          schedule(reader);
+        }
+      }
+    }
+    if (order.size() != cells.size()) {
+      for (int64 i = 0; i < cells.size(); ++i) {
+        if (unready_inputs[i] != 0) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "Netlist contains unconnected subgraphs and cannot be "
+              "simulated. Example: cell %s, input %s.",
+              cells[i]->name(), FirstUnreadyInput(*cells[i], net_levels)));
+        }
+      }
+    }
+    for (rtl::NetRef output : module->outputs()) {
+      if (net_levels[output->id()] == -1) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Output %s of module %s is not driven.",
+                            output->name(), module->name()));
+      }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](int64 a, int64 b) {
+      return cell_levels[a] < cell_levels[b];
+    });
+    for (int64 cell_index : order) {
+      XLS_RETURN_IF_ERROR(CompileCell(*cells[cell_index], *slots));
+    }
+    return order.empty() ? 0 : cell_levels[order.back()];
+  }
+
+  static absl::string_view FirstUnreadyInput(
+      const rtl::Cell& cell, absl::Span<const int64> net_levels) {
+    for (const rtl::Cell::Pin& input : cell.inputs()) {
+      if (net_levels[input.netref->id()] == -1) {
+        return input.netref->name();
+      }
+    }
+    return "<none>";
+  }
+
+  absl::Status CompileCell(const rtl::Cell& cell, const NetSlots& slots) {
+    const CellLibraryEntry* entry = cell.cell_library_entry();
+    xabsl::StatusOr<const rtl::Module*> submodule =
+        netlist_->GetModule(entry->name());
+    if (submodule.ok()) {
+      return CompileSubmodule(cell, submodule.value(), slots);
+    }
+
+    XLS_RET_CHECK_EQ(cell.inputs().size(), entry->input_names().size());
+    for (const rtl::Cell::Pin& output : cell.outputs()) {
+      XLS_ASSIGN_OR_RETURN(const CellFunction* function,
+                           GetCellFunction(entry, output.name));
+      // The state table lookups of this cell, by index into
+      // function->truth_tables.
+      std::vector<int64> lookups(function->truth_tables.size(), -1);
+      for (const Instruction& instruction : function->instructions) {
+        switch (instruction.op) {
+          case Op::kLoad:
+            Emit(Op::kLoad,
+                 slots[cell.inputs()[instruction.operand].netref->id()]);
+            break;
+          case Op::kStateTable: {
+            int64& lookup = lookups[instruction.operand];
+            if (lookup == -1) {
+              lookup = AddStateTableLookup(
+                  cell, function->truth_tables[instruction.operand], slots);
+            }
+            Emit(Op::kStateTable, lookup);
+            break;
+          }
+          default:
+            Emit(instruction.op, instruction.operand);
+            break;
+        }
+      }
+      Emit(Op::kStore, slots[output.netref->id()]);
+      simulator_->max_stack_depth_ =
+          std::max(simulator_->max_stack_depth_, function->max_stack_depth);
+    }
+    return absl::OkStatus();
+  }
+
+  // Inlines the cells of "submodule", instantiated by "cell".
+  absl::Status CompileSubmodule(const rtl::Cell& cell,
+                                const rtl::Module* submodule,
+                                const NetSlots& slots) {
+    // Bind the inputs of the submodule to the nets of the cell inputs with the
+    // same name. In Module, the order of the inputs (as NetRefs) is the same as
+    // the input names in its CellLibraryEntry.
+    absl::Span<const std::string> input_names =
+        submodule->AsCellLibraryEntry()->input_names();
+    NetSlots submodule_slots(submodule->nets().size(), -1);
+    for (const rtl::Cell::Pin& input : cell.inputs()) {
+      auto it = std::find(input_names.begin(), input_names.end(), input.name);
+      XLS_RET_CHECK(it != input_names.end()) << absl::StrFormat(
+          "Could not find input pin \"%s\" in module \"%s\", referenced in "
+          "cell \"%s\"!",
+          input.name, submodule->name(), cell.name());
+      submodule_slots[submodule->inputs()[it - input_names.begin()]->id()] =
+          slots[input.netref->id()];
+    }
+    XLS_RETURN_IF_ERROR(CompileModule(submodule, &submodule_slots).status());
+
+    // Copy the outputs of the submodule to the cell outputs with the same
+    // name.
+    for (rtl::NetRef submodule_output : submodule->outputs()) {
+      auto it = std::find_if(cell.outputs().begin(), cell.outputs().end(),
+                             [&](const rtl::Cell::Pin& pin) {
+                               return pin.name == submodule_output->name();
+                             });
+      XLS_RET_CHECK(it != cell.outputs().end()) << absl::StrFormat(
+          "Could not find cell output pin \"%s\" in cell \"%s\", referenced in "
+          "child module \"%s\"!",
+          submodule_output->name(), cell.name(), submodule->name());
+      Emit(Op::kLoad, submodule_slots[submodule_output->id()]);
+      Emit(Op::kStore, slots[it->netref->id()]);
+    }
+    simulator_->max_stack_depth_ = std::max<int64>(
+        simulator_->max_stack_depth_, 1);
+    return absl::OkStatus();
+  }
+
+  // Returns the compiled function of the given output pin of "entry",
+  // compiling it on first use.
+  xabsl::StatusOr<const CellFunction*> GetCellFunction(
+      const CellLibraryEntry* entry, const std::string& pin_name) {
+    auto key = std::make_pair(entry, pin_name);
+    auto it = cell_functions_.find(key);
+    if (it != cell_functions_.end()) {
+      return it->second.get();
+    }
+    XLS_ASSIGN_OR_RETURN(const CellLibraryEntry::OutputPinFunction* pin,
+                         entry->GetOutputPinFunction(pin_name));
+    auto function = absl::make_unique<CellFunction>();
+    int64 depth = 0;
+    XLS_RETURN_IF_ERROR(CompileAst(pin->ast, *entry, function.get(), &depth));
+    const CellFunction* result = function.get();
+    cell_functions_[key] = std::move(function);
+    return result;
+  }
+
+  // Appends the postfix instructions of "ast" to "function". "depth" is the
+  // depth of the stack before the instructions.
+  absl::Status CompileAst(const function::Ast& ast,
+                          const CellLibraryEntry& entry,
+                          CellFunction* function, int64* depth) {
+    auto push = [&](Op op, int64 operand) {
+      function->instructions.push_back({op, operand});
+      function->max_stack_depth =
+          std::max(function->max_stack_depth, ++*depth);
+    };
+    auto binary = [&](Op op) -> absl::Status {
+      XLS_RETURN_IF_ERROR(
+          CompileAst(ast.children()[0], entry, function, depth));
+      XLS_RETURN_IF_ERROR(
+          CompileAst(ast.children()[1], entry, function, depth));
+      function->instructions.push_back({op, 0});
+      --*depth;
+      return absl::OkStatus();
+    };
+    switch (ast.kind()) {
+      case function::Ast::Kind::kIdentifier: {
+        absl::Span<const std::string> input_names = entry.input_names();
+        for (int64 i = input_names.size() - 1; i >= 0; --i) {
+          if (input_names[i] == ast.name()) {
+            push(Op::kLoad, i);
+            return absl::OkStatus();
+          }
+        }
+        if (entry.state_table().has_value() &&
+            entry.state_table()->internal_signals().contains(ast.name())) {
+          XLS_ASSIGN_OR_RETURN(const TruthTable* table,
+                               GetTruthTable(entry, ast.name()));
+          push(Op::kStateTable, function->truth_tables.size());
+          function->truth_tables.push_back(table);
+          return absl::OkStatus();
+        }
+        return absl::NotFoundError(
+            absl::StrFormat("Identifier \"%s\" not found in cell %s's inputs "
+                            "or internal signals.",
+                            ast.name(), entry.name()));
+      }
+      case function::Ast::Kind::kLiteralZero:
+        push(Op::kZero, 0);
+        return absl::OkStatus();
+      case function::Ast::Kind::kLiteralOne:
+        push(Op::kOne, 0);
+        return absl::OkStatus();
+      case function::Ast::Kind::kNot:
+        XLS_RETURN_IF_ERROR(
+            CompileAst(ast.children()[0], entry, function, depth));
+        function->instructions.push_back({Op::kNot, 0});
+        return absl::OkStatus();
+      case function::Ast::Kind::kAnd:
+        return binary(Op::kAnd);
+      case function::Ast::Kind::kOr:
+        return binary(Op::kOr);
+      case function::Ast::Kind::kXor:
+        return binary(Op::kXor);
+    }
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Unknown AST element type: ", static_cast<int>(ast.kind())));
+  }
+
+  // Returns the truth table of internal signal "signal" of the state table of
+  // "entry" over the inputs of the entry, computing it on first use.
+  xabsl::StatusOr<const TruthTable*> GetTruthTable(
+      const CellLibraryEntry& entry, const std::string& signal) {
+    auto key = std::make_pair(&entry, signal);
+    auto it = truth_tables_.find(key);
+    if (it != truth_tables_.end()) {
+      return it->second;
+    }
+    absl::Span<const std::string> input_names = entry.input_names();
+    if (input_names.size() > kMaxStateTableInputs) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "State table of cell %s has %d inputs; at most %d are supported.",
+          entry.name(), input_names.size(), kMaxStateTableInputs));
+    }
+    auto table = absl::make_unique<TruthTable>();
+    int64 combination_count = int64{1} << input_names.size();
+    table->values.resize(combination_count);
+    table->defined.resize(combination_count);
+    for (int64 index = 0; index < combination_count; ++index) {
+      StateTable::InputStimulus stimulus;
+      for (int64 i = 0; i < input_names.size(); ++i) {
+        stimulus[input_names[i]] = (index >> i) & 1;
+      }
+      xabsl::StatusOr<bool> value =
+          entry.state_table()->GetSignalValue(stimulus, signal);
+      if (value.ok()) {
+        table->values[index] = value.value();
+        table->defined[index] = true;
+      }
+    }
+    const TruthTable* result = table.get();
+    simulator_->truth_tables_.push_back(std::move(table));
+    truth_tables_[key] = result;
+    return result;
+  }
+
+  int64 AddStateTableLookup(const rtl::Cell& cell, const TruthTable* table,
+                            const NetSlots& slots) {
+    CompiledSimulator::StateTableLookup lookup;
+    lookup.table = table;
+    for (const rtl::Cell::Pin& input : cell.inputs()) {
+      lookup.input_nets.push_back(slots[input.netref->id()]);
+    }
+    lookup.cell_name = cell.name();
+    simulator_->state_tables_.push_back(std::move(lookup));
+    return simulator_->state_tables_.size() - 1;
+  }
+
+  void Emit(Op op, int64 operand) {
+    simulator_->program_.push_back({op, operand});
+  }
+
+  const rtl::Netlist* netlist_;
+  CompiledSimulator* simulator_;
+  absl::flat_hash_map<std::pair<const CellLibraryEntry*, std::string>,
+                      std::unique_ptr<CellFunction>>
+      cell_functions_;
+  absl::flat_hash_map<std::pair<const CellLibraryEntry*, std::string>,
+                      const TruthTable*>
+      truth_tables_;
+};
+
+/* static */ xabsl::StatusOr<CompiledSimulator> CompiledSimulator::Compile(
+    const rtl::Netlist* netlist, const rtl::Module* module) {
+  CompiledSimulator simulator;
+  ModuleCompiler compiler(netlist, &simulator);
+  XLS_RETURN_IF_ERROR(compiler.CompileTop(module));
+  return std::move(simulator);
+}
+
+xabsl::StatusOr<std::vector<CompiledSimulator::Word>> CompiledSimulator::Run(
+    absl::Span<const Word> inputs, int64 vector_count) const {
+  XLS_RET_CHECK_EQ(inputs.size(), input_nets_.size());
+  XLS_RET_CHECK(vector_count > 0 && vector_count <= kLanes);
+  std::vector<Word> nets(net_count_);
+  nets[kOneNet] = ~Word{0};
+  for (int64 i = 0; i < inputs.size(); ++i) {
+    nets[input_nets_[i]] = inputs[i];
+  }
+
+  std::vector<Word> stack(max_stack_depth_);
+  Word* top = stack.data() - 1;
+  for (const Instruction& instruction : program_) {
+    switch (instruction.op) {
+      case Instruction::Op::kLoad:
+        *++top = nets[instruction.operand];
+        break;
+      case Instruction::Op::kStore:
+        nets[instruction.operand] = *top--;
+        break;
+      case Instruction::Op::kZero:
+        *++top = 0;
+        break;
+      case Instruction::Op::kOne:
+        *++top = ~Word{0};
+        break;
+      case Instruction::Op::kNot:
+        *top = ~*top;
+        break;
+      case Instruction::Op::kAnd:
+        --top;
+        top[0] &= top[1];
+        break;
+      case Instruction::Op::kOr:
+        --top;
+        top[0] |= top[1];
+        break;
+      case Instruction::Op::kXor:
+        --top;
+        top[0] ^= top[1];
+        break;
+      case Instruction::Op::kStateTable: {
+        XLS_ASSIGN_OR_RETURN(
+            Word value,
+            LookUp(state_tables_[instruction.operand], nets, vector_count));
+        *++top = value;
+        break;
+      }
+    }
+  }
+
+  std::vector<Word> outputs;
+  outputs.reserve(output_nets_.size());
+  for (int64 net : output_nets_) {
+    outputs.push_back(nets[net]);
+  }
+  return outputs;
+}
+
+xabsl::StatusOr<CompiledSimulator::Word> CompiledSimulator::LookUp(
+    const StateTableLookup& lookup, absl::Span<const Word> nets,
+    int64 vector_count) const {
+  Word result = 0;
+  for (int64 lane = 0; lane < vector_count; ++lane) {
+    int64 index = 0;
+    for (int64 i = 0; i < lookup.input_nets.size(); ++i) {
+      index |= static_cast<int64>((nets[lookup.input_nets[i]] >> lane) & 1)
+               << i;
+    }
+    if (!lookup.table->defined[index]) {
+      return absl::NotFoundError(absl::StrFormat(
+          "No matching row found in the state table of cell %s.",
+          lookup.cell_name));
+    }
+    if (lookup.table->values[index]) {
+      result |= Word{1} << lane;
+    }
+  }
+  return result;
+}
+
+xabsl::StatusOr<std::vector<Bits>> CompiledSimulator::RunVectors(
+    absl::Span<const Bits> input_vectors) const {
+  std::vector<Bits> results;
+  results.reserve(input_vectors.size());
+  std::vector<Word> inputs(input_nets_.size());
+  for (int64 start = 0; start < input_vectors.size(); start += kLanes) {
+    int64 vector_count =
+        std::min<int64>(kLanes, input_vectors.size() - start);
+    std::fill(inputs.begin(), inputs.end(), 0);
+    for (int64 lane = 0; lane < vector_count; ++lane) {
+      const Bits& vector = input_vectors[start + lane];
+      XLS_RET_CHECK_EQ(vector.bit_count(), inputs.size());
+      for (int64 i = 0; i < inputs.size(); ++i) {
+        if (vector.Get(i)) {
+          inputs[i] |= Word{1} << lane;
+        }
+      }
+    }
+    XLS_ASSIGN_OR_RETURN(std::vector<Word> outputs,
+                         Run(inputs, vector_count));
+    for (int64 lane = 0; lane < vector_count; ++lane) {
+      InlineBitmap bitmap(outputs.size());
+      for (int64 i = 0; i < outputs.size(); ++i) {
+        bitmap.Set(i, (outputs[i] >> lane) & 1);
+      }
+      results.push_back(Bits::FromBitmap(std::move(bitmap)));
+    }
+  }
+  return results;
+}
+
+}  // namespace netlist
+}  // namespace xls
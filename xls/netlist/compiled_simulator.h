@@ -0,0 +1,138 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NETLIST_COMPILED_SIMULATOR_H_
+#define XLS_NETLIST_COMPILED_SIMULATOR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+#include "xls/ir/bits.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// Bit-parallel simulator for netlist modules. Computes the same results as
+// Interpreter::InterpretModule, but is much faster when a module is evaluated
+// on many inputs:
+//
+//  * The module is levelized once, when it is compiled, and cells of submodules
+//    are inlined.
+//  * The output functions of the cells are parsed once per cell library entry
+//    and compiled, together with the nets of the module, into a single flat
+//    program of word-wide logic operations.
+//  * Each net holds one machine word, whose bits are the values of the net in
+//    kLanes different input vectors, so a run of the program evaluates the
+//    module on kLanes vectors at once.
+class CompiledSimulator {
+ public:
+  // A machine word holding one bit for each of the kLanes input vectors
+  // evaluated together.
+  using Word = uint64;
+  static constexpr int64 kLanes = 64;
+
+  // Compiles "module" of "netlist". The netlist must outlive the simulator.
+  static xabsl::StatusOr<CompiledSimulator> Compile(const rtl::Netlist* netlist,
+                                                    const rtl::Module* module);
+
+  // Evaluates the module on "vector_count" (at most kLanes) input vectors at
+  // once. "inputs" holds one word for each input of the module, in the order of
+  // Module::inputs(): bit j of the word is the value of that input in input
+  // vector j. Returns one word for each output of the module, in the order of
+  // Module::outputs(), in the same form. Bits of lanes beyond "vector_count"
+  // are unspecified.
+  xabsl::StatusOr<std::vector<Word>> Run(absl::Span<const Word> inputs,
+                                         int64 vector_count = kLanes) const;
+
+  // Evaluates the module on each of the given input vectors, kLanes at a time.
+  // Bit i of an input vector is the value of input i of the module, and bit i
+  // of the corresponding returned output vector is the value of output i of the
+  // module.
+  xabsl::StatusOr<std::vector<Bits>> RunVectors(
+      absl::Span<const Bits> input_vectors) const;
+
+  // Returns the number of levels of cells of the module, i.e., the length of
+  // the longest path through cells from an input to an output.
+  int64 level_count() const { return level_count_; }
+
+  // Returns the number of operations in the compiled program.
+  int64 instruction_count() const { return program_.size(); }
+
+ private:
+  friend class ModuleCompiler;
+
+  // An operation of the program, which evaluates the cell functions with a
+  // stack of words.
+  struct Instruction {
+    enum class Op : uint8 {
+      // Pushes the value of net "operand".
+      kLoad,
+      // Pops a value into net "operand".
+      kStore,
+      kZero,
+      kOne,
+      kNot,
+      kAnd,
+      kOr,
+      kXor,
+      // Pushes the value of the internal signal of a state table, as computed
+      // by state_tables_[operand].
+      kStateTable,
+    };
+    Op op;
+    int64 operand;
+  };
+
+  // The values of an internal signal of a state table as a truth table over
+  // the inputs of the cell library entry. Bit i of an index into "values" is
+  // the value of input i of the entry. The value of input combinations which
+  // match no row of the table is undefined, as recorded by "defined".
+  struct TruthTable {
+    std::vector<bool> values;
+    std::vector<bool> defined;
+  };
+
+  // A use of a truth table by a cell.
+  struct StateTableLookup {
+    const TruthTable* table;
+    std::vector<int64> input_nets;
+    std::string cell_name;
+  };
+
+  CompiledSimulator() = default;
+
+  // Evaluates a state table lookup for the first "vector_count" lanes.
+  xabsl::StatusOr<Word> LookUp(const StateTableLookup& lookup,
+                               absl::Span<const Word> nets,
+                               int64 vector_count) const;
+
+  std::vector<Instruction> program_;
+  int64 net_count_ = 0;
+  int64 max_stack_depth_ = 0;
+  int64 level_count_ = 0;
+  std::vector<int64> input_nets_;
+  std::vector<int64> output_nets_;
+  std::vector<std::unique_ptr<TruthTable>> truth_tables_;
+  std::vector<StateTableLookup> state_tables_;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_COMPILED_SIMULATOR_H_
@@ -0,0 +1,303 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/compiled_simulator.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/interpreter.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+class CompiledSimulatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(cell_library_, MakeFakeCellLibrary());
+  }
+
+  // Parses the netlist and compiles its module "main".
+  xabsl::StatusOr<CompiledSimulator> Compile(const std::string& netlist_text) {
+    rtl::Scanner scanner(netlist_text);
+    XLS_ASSIGN_OR_RETURN(netlist_,
+                         rtl::Parser::ParseNetlist(&cell_library_, &scanner));
+    XLS_ASSIGN_OR_RETURN(const rtl::Module* module,
+                         netlist_->GetModule("main"));
+    return CompiledSimulator::Compile(netlist_.get(), module);
+  }
+
+  CellLibrary cell_library_;
+  std::unique_ptr<rtl::Netlist> netlist_;
+};
+
+TEST_F(CompiledSimulatorTest, BasicFunctionality) {
+  XLS_ASSERT_OK_AND_ASSIGN(CompiledSimulator simulator, Compile(R"(
+module main (A, B, O);
+  input A, B;
+  output O;
+
+  AND and0 ( .A(A), .B(B), .Z(O) );
+endmodule
+)"));
+  EXPECT_EQ(simulator.level_count(), 1);
+
+  // The four combinations of A and B in lanes 0 to 3.
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<CompiledSimulator::Word> outputs,
+                           simulator.Run({0b1010, 0b1100}, 4));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0] & 0xf, 0b1000);
+}
+
+// Verifies that a XOR(AND(), OR()) tree of constants and inputs is simulated
+// correctly on all lanes at once.
+TEST_F(CompiledSimulatorTest, Tree) {
+  XLS_ASSERT_OK_AND_ASSIGN(CompiledSimulator simulator, Compile(R"(
+module main (i0, i1, i2, o0, o1);
+  input i0, i1, i2;
+  output o0, o1;
+  wire and_out, or_out;
+
+  AND and0 ( .A(i0), .B(i1), .Z(and_out) );
+  OR or0 ( .A(i2), .B(1'b0), .Z(or_out) );
+  XOR xor0 ( .A(and_out), .B(or_out), .Z(o0) );
+  INV inv0 ( .A(1'b0), .ZN(o1) );
+endmodule
+)"));
+  EXPECT_EQ(simulator.level_count(), 2);
+
+  const CompiledSimulator::Word i0 = 0x0123456789abcdefULL;
+  const CompiledSimulator::Word i1 = 0xfedcba9876543210ULL;
+  const CompiledSimulator::Word i2 = 0x00ff00ff00ff00ffULL;
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<CompiledSimulator::Word> outputs,
+                           simulator.Run({i0, i1, i2}));
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_EQ(outputs[0], (i0 & i1) ^ i2);
+  EXPECT_EQ(outputs[1], ~CompiledSimulator::Word{0});
+}
+
+TEST_F(CompiledSimulatorTest, Submodules) {
+  XLS_ASSERT_OK_AND_ASSIGN(CompiledSimulator simulator, Compile(R"(
+module submodule_0 (i2_0, i2_1, o2_0);
+  input i2_0, i2_1;
+  output o2_0;
+
+  AND and0( .A(i2_0), .B(i2_1), .Z(o2_0) );
+endmodule
+
+module submodule_1 (i2_2, i2_3, o2_1);
+  input i2_2, i2_3;
+  output o2_1;
+
+  OR or0( .A(i2_2), .B(i2_3), .Z(o2_1) );
+endmodule
+
+module submodule_2 (i1_0, i1_1, i1_2, i1_3, o1_0);
+  input i1_0, i1_1, i1_2, i1_3;
+  output o1_0;
+  wire res0, res1;
+
+  submodule_0 and0 ( .i2_0(i1_0), .i2_1(i1_1), .o2_0(res0) );
+  submodule_1 or0 ( .i2_2(i1_2), .i2_3(i1_3), .o2_1(res1) );
+  XOR xor0 ( .A(res0), .B(res1), .Z(o1_0) );
+endmodule
+
+module main (i0, i1, i2, i3, o0);
+  input i0, i1, i2, i3;
+  output o0;
+
+  submodule_2 bleh( .i1_0(i0), .i1_1(i1), .i1_2(i2), .i1_3(i3), .o1_0(o0) );
+endmodule
+)"));
+
+  std::vector<Bits> input_vectors;
+  for (int64 i = 0; i < 16; ++i) {
+    input_vectors.push_back(UBits(i, 4));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Bits> outputs,
+                           simulator.RunVectors(input_vectors));
+  ASSERT_EQ(outputs.size(), 16);
+  for (int64 i = 0; i < 16; ++i) {
+    bool expected = ((i & 1) && (i & 2)) ^ ((i & 4) || (i & 8));
+    EXPECT_EQ(outputs[i], UBits(expected, 1)) << "input " << i;
+  }
+}
+
+TEST_F(CompiledSimulatorTest, StateTables) {
+  XLS_ASSERT_OK_AND_ASSIGN(CompiledSimulator simulator, Compile(R"(
+module main(i0, i1, i2, i3, o0);
+  input i0, i1, i2, i3;
+  output o0;
+  wire and0_out, and1_out;
+
+  AND and0 ( .A(i0), .B(i1), .Z(and0_out) );
+  STATETABLE_AND and1 (.A(i2), .B(i3), .Z(and1_out) );
+  AND and2 ( .A(and0_out), .B(and1_out), .Z(o0) );
+endmodule
+)"));
+
+  // i0 and i1 are true; i2 and i3 take all four combinations.
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<CompiledSimulator::Word> outputs,
+                           simulator.Run({0b1111, 0b1111, 0b1010, 0b1100}, 4));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0] & 0xf, 0b1000);
+}
+
+TEST_F(CompiledSimulatorTest, UnconnectedSubgraph) {
+  EXPECT_THAT(Compile(R"(
+module main (i0, o0);
+  input i0;
+  output o0;
+  wire floating, res;
+
+  AND and0 ( .A(i0), .B(floating), .Z(res) );
+  INV inv0 ( .A(res), .ZN(o0) );
+endmodule
+)")
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cell and0, input floating")));
+}
+
+// Compares the simulator against the Interpreter on a random netlist and more
+// input vectors than fit into one run.
+TEST_F(CompiledSimulatorTest, MatchesInterpreter) {
+  constexpr int64 kInputCount = 16;
+  constexpr int64 kCellCount = 300;
+  constexpr int64 kOutputCount = 8;
+  constexpr int64 kVectorCount = 150;
+  std::mt19937 rng(42);
+  auto random_wire = [&](int64 wire_count) {
+    int64 i = std::uniform_int_distribution<int64>(0, wire_count - 1)(rng);
+    return i < kInputCount ? absl::StrFormat("i%d", i)
+                           : absl::StrFormat("w%d", i - kInputCount);
+  };
+
+  std::vector<std::string> inputs;
+  std::vector<std::string> wires;
+  std::vector<std::string> outputs;
+  for (int64 i = 0; i < kInputCount; ++i) {
+    inputs.push_back(absl::StrFormat("i%d", i));
+  }
+  for (int64 i = 0; i < kCellCount; ++i) {
+    wires.push_back(absl::StrFormat("w%d", i));
+  }
+  for (int64 i = 0; i < kOutputCount; ++i) {
+    outputs.push_back(absl::StrFormat("o%d", i));
+  }
+  std::string cells;
+  for (int64 i = 0; i < kCellCount; ++i) {
+    int64 wire_count = kInputCount + i;
+    std::string a = random_wire(wire_count);
+    std::string b = random_wire(wire_count);
+    std::string c = random_wire(wire_count);
+    std::string d = random_wire(wire_count);
+    switch (std::uniform_int_distribution<int>(0, 7)(rng)) {
+      case 0:
+        absl::StrAppendFormat(&cells, "  AND c%d (.A(%s), .B(%s), .Z(w%d));\n",
+                              i, a, b, i);
+        break;
+      case 1:
+        absl::StrAppendFormat(&cells, "  OR c%d (.A(%s), .B(%s), .Z(w%d));\n",
+                              i, a, b, i);
+        break;
+      case 2:
+        absl::StrAppendFormat(&cells, "  XOR c%d (.A(%s), .B(%s), .Z(w%d));\n",
+                              i, a, b, i);
+        break;
+      case 3:
+        absl::StrAppendFormat(&cells,
+                              "  NAND c%d (.A(%s), .B(%s), .ZN(w%d));\n", i, a,
+                              b, i);
+        break;
+      case 4:
+        absl::StrAppendFormat(&cells, "  INV c%d (.A(%s), .ZN(w%d));\n", i, a,
+                              i);
+        break;
+      case 5:
+        absl::StrAppendFormat(
+            &cells, "  AOI21 c%d (.A(%s), .B(%s), .C(%s), .ZN(w%d));\n", i, a,
+            b, c, i);
+        break;
+      case 6:
+        absl::StrAppendFormat(
+            &cells,
+            "  NOR4 c%d (.A(%s), .B(%s), .C(%s), .D(%s), .ZN(w%d));\n", i, a,
+            b, c, d, i);
+        break;
+      case 7:
+        absl::StrAppendFormat(
+            &cells, "  STATETABLE_AND c%d (.A(%s), .B(%s), .Z(w%d));\n", i, a,
+            b, i);
+        break;
+    }
+  }
+  for (int64 i = 0; i < kOutputCount; ++i) {
+    absl::StrAppendFormat(&cells, "  INV out%d (.A(w%d), .ZN(o%d));\n", i,
+                          kCellCount - 1 - i, i);
+  }
+  std::string netlist_text = absl::StrFormat(
+      "module main (%s, %s);\n  input %s;\n  output %s;\n  wire %s;\n%s"
+      "endmodule\n",
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(wires, ", "), cells);
+
+  XLS_ASSERT_OK_AND_ASSIGN(CompiledSimulator simulator, Compile(netlist_text));
+  std::vector<Bits> input_vectors;
+  for (int64 i = 0; i < kVectorCount; ++i) {
+    input_vectors.push_back(
+        UBits(std::uniform_int_distribution<int64>(0, 0xffff)(rng),
+              kInputCount));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Bits> results,
+                           simulator.RunVectors(input_vectors));
+  ASSERT_EQ(results.size(), kVectorCount);
+
+  Interpreter interpreter(netlist_.get());
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist_->GetModule("main"));
+  for (int64 v = 0; v < kVectorCount; ++v) {
+    absl::flat_hash_map<const rtl::NetRef, bool> inputs;
+    for (int64 i = 0; i < kInputCount; ++i) {
+      inputs[module->inputs()[i]] = input_vectors[v].Get(i);
+    }
+    using OutputT = absl::flat_hash_map<const rtl::NetRef, bool>;
+    XLS_ASSERT_OK_AND_ASSIGN(OutputT expected,
+                             interpreter.InterpretModule(module, inputs));
+    for (int64 i = 0; i < kOutputCount; ++i) {
+      EXPECT_EQ(results[v].Get(i), expected.at(module->outputs()[i]))
+          << "vector " << v << ", output " << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
@@ -263,15 +263,21 @@ absl::Status ExtractFromCell(const cell_lib::Block& cell,
   return absl::OkStatus();
 }
 
+// Returns the kinds of blocks whose entries are needed to extract functions;
+// the entries of other blocks, such as timing tables, are dropped as they are
+// parsed.
+absl::flat_hash_set<std::string> KindAllowlist() {
+  return absl::flat_hash_set<std::string>(
+      {"library", "cell", "pin", "direction", "function", "ff", "next_state",
+       "statetable"});
+}
+
 }  // namespace
 
 xabsl::StatusOr<CellLibraryProto> ExtractFunctions(
     cell_lib::CharStream* stream) {
   cell_lib::Scanner scanner(stream);
-  absl::flat_hash_set<std::string> kind_allowlist(
-      {"library", "cell", "pin", "direction", "function", "ff", "next_state",
-       "statetable"});
-  cell_lib::Parser parser(&scanner);
+  cell_lib::Parser parser(&scanner, KindAllowlist());
 
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<cell_lib::Block> block,
                        parser.ParseLibrary());
@@ -289,6 +295,19 @@ xabsl::StatusOr<CellLibraryProto> ExtractFunctions(
   return proto;
 }
 
+xabsl::StatusOr<CellLibraryEntryProto> ExtractCellFunctions(
+    absl::string_view cell_text) {
+  XLS_ASSIGN_OR_RETURN(auto stream,
+                       cell_lib::CharStream::FromText(std::string(cell_text)));
+  cell_lib::Scanner scanner(&stream);
+  cell_lib::Parser parser(&scanner, KindAllowlist());
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<cell_lib::Block> cell,
+                       parser.ParseBlockOfKind("cell"));
+  CellLibraryEntryProto entry_proto;
+  XLS_RETURN_IF_ERROR(ExtractFromCell(*cell, &entry_proto));
+  return entry_proto;
+}
+
 }  // namespace function
 }  // namespace netlist
 }  // namespace xls
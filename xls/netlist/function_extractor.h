@@ -17,6 +17,8 @@
 
 #include <string>
 
+#include "absl/strings/string_view.h"
+
 #include "xls/common/status/statusor.h"
 #include "xls/netlist/lib_parser.h"
 #include "xls/netlist/netlist.pb.h"
@@ -32,6 +34,11 @@ namespace function {
 xabsl::StatusOr<CellLibraryProto> ExtractFunctions(
     cell_lib::CharStream* stream);
 
+// Extracts the entry of a single cell from the text of its "cell" group, as
+// found in a Liberty file by LibertyCellIndex.
+xabsl::StatusOr<CellLibraryEntryProto> ExtractCellFunctions(
+    absl::string_view cell_text);
+
 }  // namespace function
 }  // namespace netlist
 }  // namespace xls
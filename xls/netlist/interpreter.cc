@@ -212,14 +212,22 @@ absl::Status Interpreter::InterpretCell(
     return absl::OkStatus();
   }
 
-  const auto& pins = entry->output_pin_to_function();
-  for (int i = 0; i < cell.outputs().size(); i++) {
-    XLS_ASSIGN_OR_RETURN(
-        function::Ast ast,
-        function::Parser::ParseFunction(pins.at(cell.outputs()[i].name)));
-    XLS_ASSIGN_OR_RETURN(bool result,
-                         InterpretFunction(cell, ast, *processed_wires));
-    (*processed_wires)[cell.outputs()[i].netref] = result;
+  for (const rtl::Cell::Pin& output : cell.outputs()) {
+    XLS_ASSIGN_OR_RETURN(const CellLibraryEntry::OutputPinFunction* function,
+                         entry->GetOutputPinFunction(output.name));
+    bool result;
+    if (function->truth_table.has_value()) {
+      // The inputs of the cell are in the order of the entry's input names.
+      uint64 index = 0;
+      for (int64 i = 0; i < cell.inputs().size(); ++i) {
+        index |= uint64{processed_wires->at(cell.inputs()[i].netref)} << i;
+      }
+      result = (function->truth_table.value() >> index) & 1;
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          result, InterpretFunction(cell, function->ast, *processed_wires));
+    }
+    (*processed_wires)[output.netref] = result;
   }
 
   return absl::OkStatus();
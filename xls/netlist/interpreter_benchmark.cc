@@ -0,0 +1,217 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the time to interpret a large generated netlist built from the
+// cells of the fake cell library.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/interpreter.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist_parser.h"
+
+const char* kUsage = R"(
+Measures the time to interpret a generated netlist of about --cells cells of
+the fake cell library, and for comparison the time it would take to parse the
+function of each cell output on every evaluation. Usage:
+
+   interpreter_benchmark --cells=100000
+)";
+
+ABSL_FLAG(int64, cells, 100000, "Approximate number of cells.");
+ABSL_FLAG(int64, runs, 3,
+          "Number of times to run each measurement; the fastest run is "
+          "reported.");
+
+namespace xls {
+namespace netlist {
+namespace {
+
+// Returns the text of a netlist of layers of cells, each cell reading nets of
+// the previous layer.
+std::string GenerateNetlist(int64 cell_count) {
+  constexpr int64 kWidth = 64;
+  std::vector<std::string> inputs;
+  for (int64 i = 0; i < kWidth; ++i) {
+    inputs.push_back(absl::StrFormat("i%d", i));
+  }
+  std::vector<std::string> wires;
+  std::string cells;
+  std::vector<std::string> layer = inputs;
+  for (int64 depth = 0; (depth + 1) * kWidth < cell_count; ++depth) {
+    std::vector<std::string> next;
+    for (int64 i = 0; i < kWidth; ++i) {
+      const std::string& a = layer[i];
+      const std::string& b = layer[(i + depth + 1) % kWidth];
+      const std::string& c = layer[(i + 2 * depth + 3) % kWidth];
+      const std::string& d = layer[(i + 3 * depth + 5) % kWidth];
+      std::string z = absl::StrFormat("w%d_%d", depth, i);
+      switch ((i + depth) % 8) {
+        case 0:
+          absl::StrAppendFormat(&cells,
+                                "  AND c_%s (.A(%s), .B(%s), .Z(%s));\n", z, a,
+                                b, z);
+          break;
+        case 1:
+          absl::StrAppendFormat(&cells,
+                                "  OR c_%s (.A(%s), .B(%s), .Z(%s));\n", z, a,
+                                b, z);
+          break;
+        case 2:
+          absl::StrAppendFormat(&cells,
+                                "  XOR c_%s (.A(%s), .B(%s), .Z(%s));\n", z, a,
+                                b, z);
+          break;
+        case 3:
+          absl::StrAppendFormat(&cells,
+                                "  NAND c_%s (.A(%s), .B(%s), .ZN(%s));\n", z,
+                                a, b, z);
+          break;
+        case 4:
+          absl::StrAppendFormat(&cells, "  INV c_%s (.A(%s), .ZN(%s));\n", z, a,
+                                z);
+          break;
+        case 5:
+          absl::StrAppendFormat(
+              &cells, "  AOI21 c_%s (.A(%s), .B(%s), .C(%s), .ZN(%s));\n", z,
+              a, b, c, z);
+          break;
+        case 6:
+          absl::StrAppendFormat(
+              &cells,
+              "  NOR4 c_%s (.A(%s), .B(%s), .C(%s), .D(%s), .ZN(%s));\n", z, a,
+              b, c, d, z);
+          break;
+        case 7:
+          absl::StrAppendFormat(
+              &cells, "  STATETABLE_AND c_%s (.A(%s), .B(%s), .Z(%s));\n", z, a,
+              b, z);
+          break;
+      }
+      wires.push_back(z);
+      next.push_back(z);
+    }
+    layer = std::move(next);
+  }
+  std::vector<std::string> outputs;
+  for (int64 i = 0; i < kWidth; ++i) {
+    outputs.push_back(absl::StrFormat("o%d", i));
+    absl::StrAppendFormat(&cells, "  INV c_o%d (.A(%s), .ZN(o%d));\n", i,
+                          layer[i], i);
+  }
+  return absl::StrFormat(
+      "module main (%s, %s);\n  input %s;\n  output %s;\n  wire %s;\n%s"
+      "endmodule\n",
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(wires, ", "), cells);
+}
+
+// Returns the fastest of --runs calls of "f".
+template <typename F>
+absl::Duration Time(F f) {
+  absl::Duration best = absl::InfiniteDuration();
+  for (int64 i = 0; i < absl::GetFlag(FLAGS_runs); ++i) {
+    absl::Time start = absl::Now();
+    f();
+    best = std::min(best, absl::Now() - start);
+  }
+  return best;
+}
+
+absl::Status RealMain() {
+  const int64 cell_count = absl::GetFlag(FLAGS_cells);
+  XLS_RET_CHECK_GT(cell_count, 0);
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_runs), 0);
+
+  XLS_ASSIGN_OR_RETURN(CellLibrary cell_library, MakeFakeCellLibrary());
+  std::string netlist_text = GenerateNetlist(cell_count);
+  absl::Time start = absl::Now();
+  rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<rtl::Netlist> netlist,
+                       rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  absl::Duration parse_time = absl::Now() - start;
+  XLS_ASSIGN_OR_RETURN(const rtl::Module* module, netlist->GetModule("main"));
+  std::cout << absl::StreamFormat("Cells: %d, netlist parse time: %s\n",
+                                  module->cells().size(),
+                                  absl::FormatDuration(parse_time));
+
+  absl::flat_hash_map<const rtl::NetRef, bool> inputs;
+  for (int64 i = 0; i < module->inputs().size(); ++i) {
+    inputs[module->inputs()[i]] = i % 3 == 0;
+  }
+  Interpreter interpreter(netlist.get());
+  absl::Status status;
+  int64 ones = 0;
+  absl::Duration interpret_time = Time([&] {
+    xabsl::StatusOr<absl::flat_hash_map<const rtl::NetRef, bool>> outputs =
+        interpreter.InterpretModule(module, inputs);
+    status.Update(outputs.status());
+    if (outputs.ok()) {
+      ones = std::count_if(outputs->begin(), outputs->end(),
+                           [](const auto& kv) { return kv.second; });
+    }
+  });
+  XLS_RETURN_IF_ERROR(status);
+
+  // What the interpreter used to spend on parsing a function per cell output.
+  absl::Duration function_parse_time = Time([&] {
+    for (const auto& cell : module->cells()) {
+      const CellLibraryEntry* entry = cell->cell_library_entry();
+      for (const rtl::Cell::Pin& output : cell->outputs()) {
+        status.Update(function::Parser::ParseFunction(
+                          entry->output_pin_to_function().at(output.name))
+                          .status());
+      }
+    }
+  });
+  XLS_RETURN_IF_ERROR(status);
+  std::cout << absl::StreamFormat(
+      "InterpretModule: %s; parsing the function of every cell output: %s\n",
+      absl::FormatDuration(interpret_time),
+      absl::FormatDuration(function_parse_time));
+  XLS_VLOG(1) << "Outputs set: " << ones;
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::netlist::RealMain());
+  return EXIT_SUCCESS;
+}
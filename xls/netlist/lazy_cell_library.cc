@@ -0,0 +1,295 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/lazy_cell_library.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/function_extractor.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+bool IsIdentifierChar(char c) { return absl::ascii_isalnum(c) || c == '_'; }
+
+// Returns a fingerprint of "data". Unlike absl::Hash, the fingerprint is the
+// same in every run, so it can key a cache.
+uint64 Fingerprint(absl::string_view data) {
+  constexpr uint64 kMultiplier = 0x9e3779b97f4a7c15ULL;
+  uint64 hash = data.size();
+  int64 i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    uint64 word;
+    std::memcpy(&word, data.data() + i, sizeof(word));
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 32;
+  }
+  for (; i < data.size(); ++i) {
+    hash = (hash ^ static_cast<uint8>(data[i])) * kMultiplier;
+    hash ^= hash >> 32;
+  }
+  return hash;
+}
+
+}  // namespace
+
+/* static */ xabsl::StatusOr<LibertyCellIndex> LibertyCellIndex::Create(
+    absl::string_view text) {
+  LibertyCellIndex index(text);
+  const int64 size = text.size();
+  int64 depth = 0;
+  int64 lineno = 0;
+  // The cell group being scanned, if any, and its name.
+  absl::optional<CellGroup> cell;
+  std::string cell_name;
+
+  int64 i = 0;
+  // Skips to just past the next "terminator", counting lines; returns false at
+  // the end of the text.
+  auto skip_past = [&](absl::string_view terminator) {
+    while (i < size) {
+      if (absl::StartsWith(text.substr(i), terminator)) {
+        i += terminator.size();
+        return true;
+      }
+      lineno += text[i] == '\n';
+      ++i;
+    }
+    return false;
+  };
+  while (i < size) {
+    char c = text[i];
+    switch (c) {
+      case '\n':
+        ++lineno;
+        ++i;
+        break;
+      case '"': {
+        int64 start_lineno = lineno;
+        ++i;
+        // Line continuations within strings are escaped newlines; other
+        // escapes do not matter here.
+        while (i < size && text[i] != '"') {
+          if (text[i] == '\\' && i + 1 < size) {
+            ++i;
+          }
+          lineno += text[i] == '\n';
+          ++i;
+        }
+        if (i == size) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "Unterminated string starting on line %d", start_lineno + 1));
+        }
+        ++i;
+        break;
+      }
+      case '/':
+        if (i + 1 < size && text[i + 1] == '*') {
+          int64 start_lineno = lineno;
+          i += 2;
+          if (!skip_past("*/")) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Unterminated comment starting on line %d", start_lineno + 1));
+          }
+        } else if (i + 1 < size && text[i + 1] == '/') {
+          if (skip_past("\n")) {
+            ++lineno;
+          }
+        } else {
+          ++i;
+        }
+        break;
+      case '{':
+        ++depth;
+        ++i;
+        break;
+      case '}':
+        if (depth == 0) {
+          return absl::InvalidArgumentError(
+              absl::StrFormat("Unbalanced '}' on line %d", lineno + 1));
+        }
+        --depth;
+        ++i;
+        if (depth == 1 && cell.has_value()) {
+          cell->end = i;
+          if (!index.cells_.insert({cell_name, *cell}).second) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Duplicate cell %s on line %d", cell_name, cell->lineno + 1));
+          }
+          cell.reset();
+        }
+        break;
+      default: {
+        // Cell groups are the "cell (name) { ... }" groups in the library
+        // group.
+        bool is_cell_keyword =
+            depth == 1 && !cell.has_value() && c == 'c' &&
+            absl::StartsWith(text.substr(i), "cell") &&
+            (i == 0 || !IsIdentifierChar(text[i - 1])) &&
+            (i + 4 == size || !IsIdentifierChar(text[i + 4]));
+        if (!is_cell_keyword) {
+          ++i;
+          break;
+        }
+        int64 open_paren = i + 4;
+        while (open_paren < size &&
+               (text[open_paren] == ' ' || text[open_paren] == '\t')) {
+          ++open_paren;
+        }
+        if (open_paren == size || text[open_paren] != '(') {
+          i += 4;
+          break;
+        }
+        int64 close_paren = text.find(')', open_paren);
+        if (close_paren == absl::string_view::npos) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "Unterminated cell name on line %d", lineno + 1));
+        }
+        absl::string_view name = absl::StripAsciiWhitespace(
+            text.substr(open_paren + 1, close_paren - open_paren - 1));
+        if (name.size() >= 2 && name.front() == '"' && name.back() == '"') {
+          name = name.substr(1, name.size() - 2);
+        }
+        cell_name = std::string(name);
+        cell = CellGroup{i, 0, lineno};
+        i = close_paren + 1;
+        break;
+      }
+    }
+  }
+  if (depth != 0 || cell.has_value()) {
+    return absl::InvalidArgumentError(
+        "Unexpected end of file in a group of the cell library.");
+  }
+  return index;
+}
+
+std::vector<std::string> LibertyCellIndex::cell_names() const {
+  std::vector<std::pair<int64, std::string>> cells;
+  cells.reserve(cells_.size());
+  for (const auto& item : cells_) {
+    cells.push_back({item.second.begin, item.first});
+  }
+  std::sort(cells.begin(), cells.end());
+  std::vector<std::string> names;
+  names.reserve(cells.size());
+  for (auto& cell : cells) {
+    names.push_back(std::move(cell.second));
+  }
+  return names;
+}
+
+xabsl::StatusOr<CellLibraryEntryProto> LibertyCellIndex::ExtractCell(
+    absl::string_view cell_name) const {
+  auto it = cells_.find(cell_name);
+  if (it == cells_.end()) {
+    return absl::NotFoundError(
+        absl::StrCat("Cell not found in library: ", cell_name));
+  }
+  const CellGroup& cell = it->second;
+  xabsl::StatusOr<CellLibraryEntryProto> entry = function::ExtractCellFunctions(
+      text_.substr(cell.begin, cell.end - cell.begin));
+  if (!entry.ok()) {
+    return absl::Status(
+        entry.status().code(),
+        absl::StrFormat("In cell %s starting on line %d: %s", cell_name,
+                        cell.lineno + 1, entry.status().message()));
+  }
+  return entry;
+}
+
+/* static */ xabsl::StatusOr<std::unique_ptr<LazyCellLibrary>>
+LazyCellLibrary::Open(const std::filesystem::path& liberty_path,
+                      const std::filesystem::path& cache_dir) {
+  XLS_ASSIGN_OR_RETURN(MappedFile file, MappedFile::Open(liberty_path));
+  auto library = absl::WrapUnique(new LazyCellLibrary(std::move(file)));
+  if (!cache_dir.empty()) {
+    absl::string_view contents = library->file_.contents();
+    library->cache_path_ =
+        cache_dir / absl::StrFormat("%s.%016x.%d.cell_library.pb",
+                                    liberty_path.stem().string(),
+                                    Fingerprint(contents), contents.size());
+    if (FileExists(library->cache_path_).ok()) {
+      XLS_ASSIGN_OR_RETURN(std::string serialized,
+                           GetFileContents(library->cache_path_));
+      CellLibraryProto proto;
+      xabsl::StatusOr<CellLibrary> cached =
+          proto.ParseFromString(serialized)
+              ? CellLibrary::FromProto(proto)
+              : absl::InvalidArgumentError("Unparsable CellLibraryProto");
+      if (cached.ok()) {
+        library->cell_library_ = std::move(cached).value();
+      } else {
+        XLS_LOG(WARNING) << "Ignoring cell library cache "
+                         << library->cache_path_ << ": " << cached.status();
+      }
+    }
+  }
+  library->cell_library_.set_entry_loader(
+      [library = library.get()](absl::string_view cell_name) {
+        return library->ExtractCell(cell_name);
+      });
+  return library;
+}
+
+xabsl::StatusOr<CellLibraryEntryProto> LazyCellLibrary::ExtractCell(
+    absl::string_view cell_name) {
+  if (!index_.has_value()) {
+    XLS_ASSIGN_OR_RETURN(index_, LibertyCellIndex::Create(file_.contents()));
+  }
+  XLS_ASSIGN_OR_RETURN(CellLibraryEntryProto entry,
+                       index_->ExtractCell(cell_name));
+  ++extracted_cell_count_;
+  cache_stale_ = true;
+  return entry;
+}
+
+absl::Status LazyCellLibrary::UpdateCache() {
+  if (cache_path_.empty() || !cache_stale_) {
+    return absl::OkStatus();
+  }
+  XLS_ASSIGN_OR_RETURN(CellLibraryProto proto, cell_library_.ToProto());
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(cache_path_.parent_path()));
+  // Write to a temporary file and rename it, so concurrent readers never see a
+  // partially written cache.
+  std::filesystem::path temp_path = cache_path_;
+  temp_path += absl::StrCat(".tmp", getpid());
+  XLS_RETURN_IF_ERROR(SetFileContents(temp_path, proto.SerializeAsString()));
+  std::error_code ec;
+  std::filesystem::rename(temp_path, cache_path_, ec);
+  if (ec) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to rename %s to %s: %s", temp_path.string(),
+        cache_path_.string(), ec.message()));
+  }
+  cache_stale_ = false;
+  return absl::OkStatus();
+}
+
+}  // namespace netlist
+}  // namespace xls
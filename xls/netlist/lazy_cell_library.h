@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Loading of cell libraries from Liberty files on demand.
+//
+// A full Liberty file can be hundreds of megabytes, of which a netlist uses
+// only a few hundred cells. Rather than parsing the whole file, the cell groups
+// are indexed with a single fast pass over the text, and only the cells which
+// are looked up are parsed.
+
+#ifndef XLS_NETLIST_LAZY_CELL_LIBRARY_H_
+#define XLS_NETLIST_LAZY_CELL_LIBRARY_H_
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/common/file/mapped_file.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/netlist.pb.h"
+
+namespace xls {
+namespace netlist {
+
+// Index of the top-level "cell" groups of the text of a Liberty file.
+class LibertyCellIndex {
+ public:
+  // Indexes "text", which must outlive the index. Only the nesting of braces,
+  // quoted strings and comments are scanned; the groups themselves are not
+  // parsed, so syntax errors within them are only found by ExtractCell.
+  static xabsl::StatusOr<LibertyCellIndex> Create(absl::string_view text);
+
+  // Returns the names of the indexed cells, in order of appearance.
+  std::vector<std::string> cell_names() const;
+
+  bool Contains(absl::string_view cell_name) const {
+    return cells_.contains(cell_name);
+  }
+
+  // Parses the group of the given cell and extracts its entry.
+  xabsl::StatusOr<CellLibraryEntryProto> ExtractCell(
+      absl::string_view cell_name) const;
+
+ private:
+  // The text of a cell group, from the "cell" keyword through the closing
+  // brace, and its first line (zero-based) for error messages.
+  struct CellGroup {
+    int64 begin;
+    int64 end;
+    int64 lineno;
+  };
+
+  explicit LibertyCellIndex(absl::string_view text) : text_(text) {}
+
+  absl::string_view text_;
+  absl::flat_hash_map<std::string, CellGroup> cells_;
+};
+
+// A cell library backed by a Liberty file, whose cells are extracted the first
+// time they are looked up with CellLibrary::GetEntry.
+//
+// Extracted cells can be cached in a directory, as a CellLibraryProto keyed by
+// a fingerprint of the contents of the Liberty file. Once all the cells used by
+// a netlist are cached, loading the library costs no more than fingerprinting
+// the file; the file is indexed only when a cell is missing from the cache.
+//
+// Example usage:
+//
+//   XLS_ASSIGN_OR_RETURN(auto library,
+//                        LazyCellLibrary::Open(liberty_path, cache_dir));
+//   XLS_ASSIGN_OR_RETURN(auto netlist, rtl::Parser::ParseNetlist(
+//                                          library->cell_library(), &scanner));
+//   XLS_RETURN_IF_ERROR(library->UpdateCache());
+class LazyCellLibrary {
+ public:
+  // Maps the Liberty file at "liberty_path". If "cache_dir" is not empty, the
+  // library starts out with the cells cached there for the same file contents.
+  static xabsl::StatusOr<std::unique_ptr<LazyCellLibrary>> Open(
+      const std::filesystem::path& liberty_path,
+      const std::filesystem::path& cache_dir = "");
+
+  // The library refers to this object, so it can be neither copied nor moved.
+  LazyCellLibrary(const LazyCellLibrary&) = delete;
+  LazyCellLibrary& operator=(const LazyCellLibrary&) = delete;
+
+  CellLibrary* cell_library() { return &cell_library_; }
+
+  // Returns the number of cells extracted from the Liberty file, as opposed to
+  // read from the cache.
+  int64 extracted_cell_count() const { return extracted_cell_count_; }
+
+  // Returns the path of the cache file, or an empty path if there is no cache.
+  const std::filesystem::path& cache_path() const { return cache_path_; }
+
+  // Writes all the cells of the library to the cache if any cell had to be
+  // extracted from the Liberty file since the cache was read or last updated.
+  // Does nothing if there is no cache.
+  absl::Status UpdateCache();
+
+ private:
+  explicit LazyCellLibrary(MappedFile file) : file_(std::move(file)) {}
+
+  // Extracts a cell from the Liberty file, indexing the file first if needed.
+  xabsl::StatusOr<CellLibraryEntryProto> ExtractCell(
+      absl::string_view cell_name);
+
+  MappedFile file_;
+  absl::optional<LibertyCellIndex> index_;
+  CellLibrary cell_library_;
+  std::filesystem::path cache_path_;
+  int64 extracted_cell_count_ = 0;
+  // Whether cells were extracted since the cache was read or written.
+  bool cache_stale_ = false;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_LAZY_CELL_LIBRARY_H_
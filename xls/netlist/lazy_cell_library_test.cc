@@ -0,0 +1,180 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/lazy_cell_library.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/function_extractor.h"
+#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+constexpr const char kLibrary[] = R"(
+library (lib) {
+  /* Braces in comments { and strings are not groups. */
+  comment : "cell (FAKE) {";
+  cell_footprint : inv;
+  cell (INV) {
+    area : 1.0;
+    pin (A) {
+      direction : input;
+    }
+    pin (ZN) {
+      direction : output;
+      function : "!A";
+      timing () {
+        related_pin : "A";
+      }
+    }
+  }
+  cell ("AND2") {
+    cell_footprint : and;
+    pin (A) {
+      direction : input;
+    }
+    pin (B) {
+      direction : input;
+    }
+    pin (Z) {
+      direction : output;
+      function : "A&B";
+    }
+  }
+  cell (BROKEN) {
+    pin (A) {
+      function : "A";
+    }
+  }
+}
+)";
+
+TEST(LibertyCellIndexTest, IndexesCellGroups) {
+  XLS_ASSERT_OK_AND_ASSIGN(LibertyCellIndex index,
+                           LibertyCellIndex::Create(kLibrary));
+  EXPECT_THAT(index.cell_names(), ElementsAre("INV", "AND2", "BROKEN"));
+  EXPECT_TRUE(index.Contains("AND2"));
+  EXPECT_FALSE(index.Contains("FAKE"));
+}
+
+TEST(LibertyCellIndexTest, ExtractsSameEntriesAsFullParse) {
+  XLS_ASSERT_OK_AND_ASSIGN(LibertyCellIndex index,
+                           LibertyCellIndex::Create(kLibrary));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntryProto inv,
+                           index.ExtractCell("INV"));
+  EXPECT_EQ(inv.name(), "INV");
+  EXPECT_THAT(inv.input_names(), ElementsAre("A"));
+  ASSERT_EQ(inv.output_pin_list().pins_size(), 1);
+  EXPECT_EQ(inv.output_pin_list().pins(0).function(), "!A");
+
+  // The full parse of the library, without the broken cell.
+  std::string library = kLibrary;
+  library.erase(library.find("  cell (BROKEN)"));
+  library += "}\n";
+  XLS_ASSERT_OK_AND_ASSIGN(auto stream,
+                           cell_lib::CharStream::FromText(library));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryProto proto,
+                           function::ExtractFunctions(&stream));
+  ASSERT_EQ(proto.entries_size(), 2);
+  EXPECT_EQ(inv.DebugString(), proto.entries(0).DebugString());
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntryProto and2,
+                           index.ExtractCell("AND2"));
+  EXPECT_EQ(and2.DebugString(), proto.entries(1).DebugString());
+}
+
+TEST(LibertyCellIndexTest, Errors) {
+  XLS_ASSERT_OK_AND_ASSIGN(LibertyCellIndex index,
+                           LibertyCellIndex::Create(kLibrary));
+  EXPECT_THAT(index.ExtractCell("BROKEN"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("In cell BROKEN starting on line 32")));
+  EXPECT_THAT(index.ExtractCell("OR2"),
+              StatusIs(absl::StatusCode::kNotFound));
+
+  EXPECT_THAT(LibertyCellIndex::Create("library (lib) { cell (A) { }"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unexpected end of file")));
+  EXPECT_THAT(
+      LibertyCellIndex::Create("library (lib) {\ncell (A) { }\ncell (A) { }}"),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Duplicate cell A on line 3")));
+}
+
+TEST(LazyCellLibraryTest, ExtractsAndCachesUsedCells) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path liberty_path = temp_dir.path() / "lib.lib";
+  std::filesystem::path cache_dir = temp_dir.path() / "cache";
+  XLS_ASSERT_OK(SetFileContents(liberty_path, kLibrary));
+  const char kNetlist[] = R"(module main(a, z);
+  input a;
+  output z;
+  INV inv_0(.A(a), .ZN(z));
+endmodule)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<LazyCellLibrary> library,
+                           LazyCellLibrary::Open(liberty_path, cache_dir));
+  EXPECT_EQ(library->cell_library()->size(), 0);
+  rtl::Scanner scanner(kNetlist);
+  XLS_ASSERT_OK(
+      rtl::Parser::ParseNetlist(library->cell_library(), &scanner).status());
+  EXPECT_EQ(library->cell_library()->size(), 1);
+  EXPECT_EQ(library->extracted_cell_count(), 1);
+  XLS_ASSERT_OK(library->UpdateCache());
+  XLS_ASSERT_OK(FileExists(library->cache_path()));
+
+  // The cell is now read from the cache.
+  XLS_ASSERT_OK_AND_ASSIGN(library,
+                           LazyCellLibrary::Open(liberty_path, cache_dir));
+  EXPECT_EQ(library->cell_library()->size(), 1);
+  rtl::Scanner rescanner(kNetlist);
+  XLS_ASSERT_OK(
+      rtl::Parser::ParseNetlist(library->cell_library(), &rescanner).status());
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* inv,
+                           library->cell_library()->GetEntry("INV"));
+  EXPECT_EQ(inv->output_pin_to_function().at("ZN"), "!A");
+  EXPECT_EQ(library->extracted_cell_count(), 0);
+
+  XLS_ASSERT_OK(library->cell_library()->GetEntry("AND2").status());
+  EXPECT_EQ(library->extracted_cell_count(), 1);
+  EXPECT_THAT(library->cell_library()->GetEntry("OR2").status(),
+              StatusIs(absl::StatusCode::kNotFound));
+
+  // A changed file does not use the cache of the old contents.
+  std::string changed = kLibrary;
+  changed.replace(changed.find("\"!A\""), 4, "\"A\"");
+  XLS_ASSERT_OK(SetFileContents(liberty_path, changed));
+  XLS_ASSERT_OK_AND_ASSIGN(library,
+                           LazyCellLibrary::Open(liberty_path, cache_dir));
+  EXPECT_EQ(library->cell_library()->size(), 0);
+  XLS_ASSERT_OK_AND_ASSIGN(inv, library->cell_library()->GetEntry("INV"));
+  EXPECT_EQ(inv->output_pin_to_function().at("ZN"), "A");
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
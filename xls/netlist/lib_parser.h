@@ -370,6 +370,14 @@ class Parser {
     return ParseBlock("library");
   }
 
+  // Parses a single block of the given kind, e.g. a "cell" group cut out of a
+  // library.
+  xabsl::StatusOr<std::unique_ptr<Block>> ParseBlockOfKind(
+      absl::string_view kind) {
+    XLS_RETURN_IF_ERROR(DropIdentifierOrError(kind));
+    return ParseBlock(std::string(kind));
+  }
+
  private:
   xabsl::StatusOr<bool> TryDropToken(TokenKind target, Pos* pos = nullptr);
   absl::Status DropTokenOrError(TokenKind kind);
@@ -14,8 +14,11 @@
 
 #include "xls/netlist/netlist.h"
 
+#include <algorithm>
+#include <cstring>
 #include <variant>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -31,12 +34,12 @@ const CellLibraryEntry* Module::AsCellLibraryEntry() const {
     std::vector<std::string> input_names;
     input_names.reserve(inputs_.size());
     for (const auto& input : inputs_) {
-      input_names.push_back(input->name());
+      input_names.push_back(std::string(input->name()));
     }
     CellLibraryEntry::OutputPinToFunction output_pins;
     output_pins.reserve(outputs_.size());
     for (const auto& output : outputs_) {
-      output_pins[output->name()] = "";
+      output_pins[std::string(output->name())] = "";
     }
     cell_library_entry_.emplace(CellLibraryEntry(
         CellKind::kOther, name_, input_names, output_pins, absl::nullopt));
@@ -61,45 +64,60 @@ xabsl::StatusOr<NetRef> Module::ResolveNumber(int64 number) const {
 }
 
 xabsl::StatusOr<NetRef> Module::ResolveNet(absl::string_view name) const {
-  for (const auto& net : nets_) {
-    if (net->name() == name) {
-      return net.get();
-    }
+  auto it = nets_by_name_.find(name);
+  if (it != nets_by_name_.end()) {
+    return it->second;
   }
 
   return absl::NotFoundError(absl::StrCat("Could not find net: ", name));
 }
 
 xabsl::StatusOr<Cell*> Module::ResolveCell(absl::string_view name) const {
-  for (const auto& cell : cells_) {
-    if (cell->name() == name) {
-      return cell.get();
-    }
+  auto it = cells_by_name_.find(name);
+  if (it != cells_by_name_.end()) {
+    return it->second;
   }
   return absl::NotFoundError(
       absl::StrCat("Could not find cell with name: ", name));
 }
 
 xabsl::StatusOr<Cell*> Module::AddCell(Cell cell) {
-  auto status_or_cell = ResolveCell(cell.name());
-  if (status_or_cell.status().ok()) {
+  if (cells_by_name_.contains(cell.name())) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a cell with name: ", cell.name()));
   }
 
-  cells_.push_back(absl::make_unique<Cell>(cell));
-  return cells_.back().get();
+  cells_.push_back(absl::make_unique<Cell>(std::move(cell)));
+  Cell* cell_ptr = cells_.back().get();
+  cells_by_name_[cell_ptr->name()] = cell_ptr;
+  return cell_ptr;
+}
+
+absl::string_view Module::InternName(absl::string_view name) {
+  constexpr int64 kNameBlockSize = 64 * 1024;
+  if (name.size() > name_block_free_) {
+    int64 block_size = std::max<int64>(kNameBlockSize, name.size());
+    name_blocks_.push_back(absl::make_unique<char[]>(block_size));
+    name_block_next_ = name_blocks_.back().get();
+    name_block_free_ = block_size;
+  }
+  char* interned = name_block_next_;
+  std::memcpy(interned, name.data(), name.size());
+  name_block_next_ += name.size();
+  name_block_free_ -= name.size();
+  return absl::string_view(interned, name.size());
 }
 
 absl::Status Module::AddNetDecl(NetDeclKind kind, absl::string_view name) {
-  auto status_or_net = ResolveNet(name);
-  if (status_or_net.status().ok()) {
+  if (nets_by_name_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a net/wire decl with name: ", name));
   }
 
-  nets_.emplace_back(absl::make_unique<NetDef>(name));
-  NetRef ref = nets_.back().get();
+  net_defs_.emplace_back(InternName(name), nets_.size());
+  NetRef ref = &net_defs_.back();
+  nets_.push_back(ref);
+  nets_by_name_[ref->name()] = ref;
   switch (kind) {
     case NetDeclKind::kInput:
       inputs_.push_back(ref);
@@ -138,7 +156,7 @@ xabsl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
     const CellLibraryEntry* cell_library_entry, absl::string_view name,
     const absl::flat_hash_map<std::string, NetRef>& named_parameter_assignments,
     absl::optional<NetRef> clock, const NetRef dummy_net) {
-  auto sorted_key_str = [named_parameter_assignments]() -> std::string {
+  auto sorted_key_str = [&named_parameter_assignments]() -> std::string {
     std::vector<std::string> keys;
     for (const auto& item : named_parameter_assignments) {
       keys.push_back(item.first);
@@ -148,6 +166,7 @@ xabsl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
   };
 
   std::vector<Pin> cell_inputs;
+  cell_inputs.reserve(cell_library_entry->input_names().size());
   for (const std::string& input : cell_library_entry->input_names()) {
     auto it = named_parameter_assignments.find(input);
     if (it == named_parameter_assignments.end()) {
@@ -158,12 +177,13 @@ xabsl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
     Pin cell_input;
     cell_input.name = input;
     cell_input.netref = it->second;
-    cell_inputs.push_back(cell_input);
+    cell_inputs.push_back(std::move(cell_input));
   }
 
   const CellLibraryEntry::OutputPinToFunction& output_pins =
       cell_library_entry->output_pin_to_function();
   std::vector<Pin> cell_outputs;
+  cell_outputs.reserve(output_pins.size());
   for (const auto& kv : output_pins) {
     Pin cell_output;
     cell_output.name = kv.first;
@@ -173,7 +193,7 @@ xabsl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
     } else {
       cell_output.netref = it->second;
     }
-    cell_outputs.push_back(cell_output);
+    cell_outputs.push_back(std::move(cell_output));
   }
 
   std::vector<Pin> internal_pins;
@@ -184,7 +204,7 @@ xabsl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
       pin.name = signal;
       // Synthesize "fake" wire?
       pin.netref = nullptr;
-      internal_pins.push_back(pin);
+      internal_pins.push_back(std::move(pin));
     }
   }
 
@@ -18,12 +18,16 @@
 #ifndef XLS_NETLIST_NETLIST_H_
 #define XLS_NETLIST_NETLIST_H_
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "xls/common/integral_types.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/statusor.h"
@@ -36,7 +40,7 @@ namespace rtl {
 // Forward declaration for use in NetRef.
 class NetDef;
 
-// Refers to an ID inside the module's wires_ array.
+// Refers to a net of a module. The net's index in the module is its id().
 using NetRef = NetDef*;
 
 // Represents a cell instantiated in the netlist.
@@ -76,8 +80,8 @@ class Cell {
 
  private:
   Cell(const CellLibraryEntry* cell_library_entry, absl::string_view name,
-       const std::vector<Pin>& inputs, const std::vector<Pin>& outputs,
-       const std::vector<Pin>& internal_pins, absl::optional<NetRef> clock)
+       std::vector<Pin> inputs, std::vector<Pin> outputs,
+       std::vector<Pin> internal_pins, absl::optional<NetRef> clock)
       : cell_library_entry_(cell_library_entry),
         name_(name),
         inputs_(std::move(inputs)),
@@ -97,9 +101,14 @@ class Cell {
 // future.
 class NetDef {
  public:
-  explicit NetDef(absl::string_view name) : name_(name) {}
+  // "name" must outlive the net; Module interns the names of its nets.
+  NetDef(absl::string_view name, int64 id) : name_(name), id_(id) {}
 
-  const std::string& name() const { return name_; }
+  absl::string_view name() const { return name_; }
+
+  // Index of the net in Module::nets(). Ids are dense, so side tables for the
+  // nets of a module can be vectors.
+  int64 id() const { return id_; }
 
   // Called to note that a cell is connected to this net.
   void NoteConnectedCell(Cell* cell) { connected_cells_.push_back(cell); }
@@ -114,7 +123,8 @@ class NetDef {
       Cell* to_remove) const;
 
  private:
-  std::string name_;
+  absl::string_view name_;
+  int64 id_;
   std::vector<Cell*> connected_cells_;
 };
 
@@ -170,19 +180,34 @@ class Module {
 
   xabsl::StatusOr<Cell*> ResolveCell(absl::string_view name) const;
 
-  absl::Span<const std::unique_ptr<NetDef>> nets() const { return nets_; }
+  // Returns the nets of the module, in order of id.
+  absl::Span<const NetRef> nets() const { return nets_; }
   absl::Span<const std::unique_ptr<Cell>> cells() const { return cells_; }
 
   const std::vector<NetRef>& inputs() const { return inputs_; }
   const std::vector<NetRef>& outputs() const { return outputs_; }
 
  private:
+  // Returns a copy of "name" in name_blocks_, which lives as long as the
+  // module.
+  absl::string_view InternName(absl::string_view name);
+
   std::string name_;
   std::vector<NetRef> inputs_;
   std::vector<NetRef> outputs_;
   std::vector<NetRef> wires_;
-  std::vector<std::unique_ptr<NetDef>> nets_;
+
+  // Nets are stored in a deque so NetRefs stay valid as nets are added, and
+  // their names are packed into large blocks instead of allocated one by one.
+  std::deque<NetDef> net_defs_;
+  std::vector<NetRef> nets_;
+  absl::flat_hash_map<absl::string_view, NetRef> nets_by_name_;
+  std::vector<std::unique_ptr<char[]>> name_blocks_;
+  char* name_block_next_ = nullptr;
+  int64 name_block_free_ = 0;
+
   std::vector<std::unique_ptr<Cell>> cells_;
+  absl::flat_hash_map<absl::string_view, Cell*> cells_by_name_;
   NetRef zero_;
   NetRef one_;
   NetRef dummy_;
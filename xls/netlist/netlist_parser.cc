@@ -17,6 +17,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/variant.h"
 #include "xls/common/logging/logging.h"
@@ -134,9 +135,7 @@ xabsl::StatusOr<Token> Scanner::Pop() {
   return result;
 }
 
-xabsl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
-  std::string chars;
-  chars.push_back(startc);
+xabsl::StatusOr<Token> Scanner::ScanNumber(int64 start, Pos pos) {
   bool seen_separator = false;
   auto is_hex_char = [](char c) {
     return absl::ascii_isxdigit(absl::ascii_toupper(c));
@@ -151,20 +150,19 @@ xabsl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     if (is_hex_char(c)) {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else if (c == '\'' && !seen_separator) {
       // If we see a base separator, pop it, then the optional signedness
       // indicator (s|S), then the base indicator (d|b|o|h|D|B|O|H).
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
       XLS_RET_CHECK(!AtEofInternal()) << "Saw EOF while scanning number base!";
-      chars.push_back(PopCharOrDie());
-      if (chars.back() == 's' || chars.back() == 'S') {
+      c = PopCharOrDie();
+      if (c == 's' || c == 'S') {
         XLS_RET_CHECK(!AtEofInternal())
             << "Saw EOF while scanning number base (post-signedness)!";
-        chars.push_back(PopCharOrDie());
+        c = PopCharOrDie();
       }
 
-      c = chars.back();
       XLS_RET_CHECK(c == 'd' || c == 'b' || c == 'o' || c == 'h' || c == 'D' ||
                     c == 'B' || c == 'O' || c == 'H')
           << "Expected [dbohDBOH], saw '" << c << "'";
@@ -175,24 +173,22 @@ xabsl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
     }
   }
 
-  return Token{TokenKind::kNumber, pos, chars};
+  return Token{TokenKind::kNumber, pos, text_.substr(start, index_ - start)};
 }
 
-xabsl::StatusOr<Token> Scanner::ScanName(char startc, Pos pos,
+xabsl::StatusOr<Token> Scanner::ScanName(int64 start, Pos pos,
                                          bool is_escaped) {
-  std::string chars;
-  chars.push_back(startc);
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     bool is_whitespace = c == ' ' || c == '\t' || c == '\n';
     if ((is_escaped && !is_whitespace) || isalpha(c) || isdigit(c) ||
         c == '_') {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else {
       break;
     }
   }
-  return Token{TokenKind::kName, pos, chars};
+  return Token{TokenKind::kName, pos, text_.substr(start, index_ - start)};
 }
 
 xabsl::StatusOr<Token> Scanner::PeekInternal() {
@@ -221,17 +217,17 @@ xabsl::StatusOr<Token> Scanner::PeekInternal() {
       return Token{TokenKind::kColon, pos};
     default:
       if (isdigit(c)) {
-        return ScanNumber(c, pos);
+        return ScanNumber(index_ - 1, pos);
       }
       if (isalpha(c) || c == '\\') {
-        return ScanName(c, pos, c == '\\');
+        return ScanName(index_ - 1, pos, c == '\\');
       }
       return absl::UnimplementedError(absl::StrFormat(
           "Unsupported character: '%c' (%#x) @ %s", c, c, pos.ToHumanString()));
   }
 }
 
-xabsl::StatusOr<std::string> Parser::PopNameOrError() {
+xabsl::StatusOr<absl::string_view> Parser::PopNameOrError() {
   XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
   if (token.kind == TokenKind::kName) {
     return token.value;
@@ -245,10 +241,12 @@ xabsl::StatusOr<int64> Parser::PopNumberOrError() {
   XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
   if (token.kind == TokenKind::kNumber) {
     // Check for the big version first.
+    static const LazyRE2 kSizedNumberRe = {
+        R"(([0-9]+)'([Ss]?)([bodhBODH])([0-9a-f]+))"};
     std::string width_string, signed_string, base_string, value_string;
-    if (RE2::FullMatch(
-            token.value, R"(([0-9]+)'([Ss]?)([bodhBODH])([0-9a-f]+))",
-            &width_string, &signed_string, &base_string, &value_string)) {
+    if (RE2::FullMatch(re2::StringPiece(token.value.data(), token.value.size()),
+                       *kSizedNumberRe, &width_string, &signed_string,
+                       &base_string, &value_string)) {
       int64 width;
       XLS_RET_CHECK(absl::numbers_internal::safe_strto64_base(
           width_string, reinterpret_cast<int64_t*>(&width), 10))
@@ -283,8 +281,8 @@ xabsl::StatusOr<int64> Parser::PopNumberOrError() {
 
     int64 result;
     if (!absl::SimpleAtoi(token.value, &result)) {
-      return absl::InternalError(
-          "Number token's value cannot be parsed as an int64: " + token.value);
+      return absl::InternalError(absl::StrCat(
+          "Number token's value cannot be parsed as an int64: ", token.value));
     }
     return result;
   }
@@ -292,7 +290,7 @@ xabsl::StatusOr<int64> Parser::PopNumberOrError() {
                                     token.ToString());
 }
 
-xabsl::StatusOr<absl::variant<std::string, int64>>
+xabsl::StatusOr<absl::variant<absl::string_view, int64>>
 Parser::PopNameOrNumberOrError() {
   TokenKind kind = scanner_->Peek()->kind;
   if (kind == TokenKind::kName) {
@@ -326,8 +324,8 @@ xabsl::StatusOr<std::vector<std::string>> Parser::PopParenNameList() {
       XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
       break;
     }
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
-    results.push_back(name);
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
+    results.push_back(std::string(name));
     must_end = !TryDropToken(TokenKind::kComma);
   }
   return results;
@@ -344,8 +342,8 @@ absl::Status Parser::DropKeywordOrError(absl::string_view target) {
 
 xabsl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
     Netlist& netlist) {
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
-  auto status_or_module = netlist.GetModule(name);
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
+  auto status_or_module = netlist.GetModule(std::string(name));
   if (status_or_module.ok()) {
     return status_or_module.value()->AsCellLibraryEntry();
   }
@@ -353,18 +351,18 @@ xabsl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
 }
 
 xabsl::StatusOr<NetRef> Parser::ParseNetRef(Module* module) {
-  using TokenT = absl::variant<std::string, int64>;
+  using TokenT = absl::variant<absl::string_view, int64>;
   XLS_ASSIGN_OR_RETURN(TokenT token, PopNameOrNumberOrError());
   if (absl::holds_alternative<int64>(token)) {
     int64 value = absl::get<int64>(token);
     return module->AddOrResolveNumber(value);
   }
 
-  std::string name = absl::get<std::string>(token);
+  absl::string_view name = absl::get<absl::string_view>(token);
   if (TryDropToken(TokenKind::kOpenBracket)) {
     XLS_ASSIGN_OR_RETURN(int64 index, PopNumberOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseBracket));
-    absl::StrAppend(&name, "[", index, "]");
+    return module->ResolveNet(absl::StrCat(name, "[", index, "]"));
   }
   return module->ResolveNet(name);
 }
@@ -374,20 +372,22 @@ absl::Status Parser::ParseInstance(Module* module, Netlist& netlist) {
   const Pos pos = peek.pos;
 
   XLS_ASSIGN_OR_RETURN(const CellLibraryEntry* cle, ParseCellModule(netlist));
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
   // LRM 23.3.2 Calls these "named parameter assignments".
   absl::flat_hash_map<std::string, NetRef> named_parameter_assignments;
   while (true) {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kDot));
-    XLS_ASSIGN_OR_RETURN(std::string pin_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view pin_name, PopNameOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
     XLS_ASSIGN_OR_RETURN(NetRef net, ParseNetRef(module));
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
     XLS_VLOG(3) << "Adding named parameter assignment: " << pin_name;
-    bool is_new = named_parameter_assignments.insert({pin_name, net}).second;
+    bool is_new =
+        named_parameter_assignments.insert({std::string(pin_name), net}).second;
     if (!is_new) {
-      return absl::InvalidArgumentError("Duplicate port seen: " + pin_name);
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate port seen: ", pin_name));
     }
     if (!TryDropToken(TokenKind::kComma)) {
       break;
@@ -461,9 +461,9 @@ absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
     range = {high, low};
   }
 
-  std::vector<std::string> names;
+  std::vector<absl::string_view> names;
   do {
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
     names.push_back(name);
   } while (TryDropToken(TokenKind::kComma));
 
@@ -476,7 +476,7 @@ absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
         "Multiple declarations for a ranged net is not yet supported.");
   }
 
-  for (const std::string& name : names) {
+  for (absl::string_view name : names) {
     if (range.has_value()) {
       for (int64 i = range->second; i <= range->first; ++i) {
         XLS_RETURN_IF_ERROR(
@@ -504,7 +504,7 @@ absl::Status Parser::ParseModuleStatement(Module* module, Netlist& netlist) {
 
 xabsl::StatusOr<std::unique_ptr<Module>> Parser::ParseModule(Netlist& netlist) {
   XLS_RETURN_IF_ERROR(DropKeywordOrError("module"));
-  XLS_ASSIGN_OR_RETURN(std::string module_name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view module_name, PopNameOrError());
   auto module = std::make_unique<Module>(module_name);
   XLS_ASSIGN_OR_RETURN(std::vector<std::string> ports, PopParenNameList());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kSemicolon));
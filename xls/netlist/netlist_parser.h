@@ -16,6 +16,8 @@
 #define XLS_NETLIST_NETLIST_PARSER_H_
 
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/variant.h"
 #include "xls/common/status/statusor.h"
 #include "xls/netlist/netlist.h"
 
@@ -49,15 +51,18 @@ struct Pos {
 };
 
 // Represents a scanned token (that comes from scanning a character stream).
+// The value of a name or number token refers to the scanned text.
 struct Token {
   TokenKind kind;
   Pos pos;
-  std::string value;
+  absl::string_view value;
 
   std::string ToString() const;
 };
 
-// Token scanner for netlist files.
+// Token scanner for netlist files. Tokens refer to "text", which must outlive
+// the scanner and its tokens; netlist files can be scanned straight from a
+// MappedFile.
 class Scanner {
  public:
   explicit Scanner(absl::string_view text) : text_(text) {}
@@ -72,8 +77,10 @@ class Scanner {
   }
 
  private:
-  xabsl::StatusOr<Token> ScanName(char startc, Pos pos, bool is_escaped);
-  xabsl::StatusOr<Token> ScanNumber(char startc, Pos pos);
+  // Scan the rest of a name or number, whose first character is at index
+  // "start".
+  xabsl::StatusOr<Token> ScanName(int64 start, Pos pos, bool is_escaped);
+  xabsl::StatusOr<Token> ScanNumber(int64 start, Pos pos);
   xabsl::StatusOr<Token> PeekInternal();
 
   void DropCommentsAndWhitespace();
@@ -99,7 +106,8 @@ class Scanner {
 class Parser {
  public:
   // Parses a netlist with the given cell library and token scanner.
-  // Returns a status on parse error.
+  // Returns a status on parse error. The netlist does not refer to the
+  // scanned text, which may be released once parsing is done.
   static xabsl::StatusOr<std::unique_ptr<Netlist>> ParseNetlist(
       CellLibrary* cell_library, Scanner* scanner);
 
@@ -128,14 +136,15 @@ class Parser {
 
   // Pops a name token and returns its contents or gives an error status if a
   // name token is not immediately present in the stream.
-  xabsl::StatusOr<std::string> PopNameOrError();
+  xabsl::StatusOr<absl::string_view> PopNameOrError();
 
   // Pops a name token and returns its value or gives an error status if a
   // number token is not immediately present in the stream.
   xabsl::StatusOr<int64> PopNumberOrError();
 
   // Pops either a name or number token or returns an error.
-  xabsl::StatusOr<absl::variant<std::string, int64>> PopNameOrNumberOrError();
+  xabsl::StatusOr<absl::variant<absl::string_view, int64>>
+  PopNameOrNumberOrError();
 
   // Drops a token of kind target from the head of the stream or gives an error
   // status.
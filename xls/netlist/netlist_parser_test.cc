@@ -70,6 +70,34 @@ endmodule)";
   EXPECT_EQ("baz", baz->name());
 }
 
+TEST(NetlistParserTest, NetlistOutlivesText) {
+  auto netlist = absl::make_unique<std::string>(R"(module main(a, z);
+  input a;
+  output z;
+  wire [1:0] w;
+  INV inv_0(.A(a), .ZN(w[0]));
+  INV inv_1(.A(w[0]), .ZN(z));
+endmodule)");
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  std::unique_ptr<Netlist> n;
+  {
+    Scanner scanner(*netlist);
+    XLS_ASSERT_OK_AND_ASSIGN(n, Parser::ParseNetlist(&cell_library, &scanner));
+  }
+  netlist.reset();
+
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  for (int64 i = 0; i < m->nets().size(); ++i) {
+    EXPECT_EQ(m->nets()[i]->id(), i);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(NetRef w0, m->ResolveNet("w[0]"));
+  EXPECT_EQ("w[0]", w0->name());
+  XLS_ASSERT_OK_AND_ASSIGN(Cell * inv_1, m->ResolveCell("inv_1"));
+  EXPECT_EQ("inv_1", inv_1->name());
+  ASSERT_EQ(inv_1->inputs().size(), 1);
+  EXPECT_EQ(inv_1->inputs()[0].netref, w0);
+}
+
 TEST(NetlistParserTest, InverterModule) {
   std::string netlist = R"(module main(a, z);
   input a;
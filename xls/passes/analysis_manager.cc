@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+
+template <typename T>
+xabsl::StatusOr<T*> AnalysisManager::GetOrBuild(
+    Function* f, const std::string& key, bool incremental,
+    const std::function<xabsl::StatusOr<std::unique_ptr<T>>()>& build) {
+  {
+    absl::MutexLock lock(&mutex_);
+    Stats& stats = stats_[key];
+    FunctionAnalyses& analyses = analyses_[f];
+    auto it = analyses.find(key);
+    if (it != analyses.end()) {
+      ++stats.hits;
+      return static_cast<T*>(it->second.analysis.get());
+    }
+    ++stats.misses;
+  }
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<T> analysis, build());
+  absl::Duration duration = absl::Now() - start;
+  XLS_VLOG(3) << absl::StreamFormat("Built %s of function %s in %s", key,
+                                    f->name(), absl::FormatDuration(duration));
+  absl::MutexLock lock(&mutex_);
+  stats_[key].build_time += duration;
+  // Only the thread working on "f" builds its analyses, but keep an analysis
+  // which is already cached rather than free it from under its users.
+  CachedAnalysis cached{std::shared_ptr<void>(std::move(analysis)),
+                        incremental};
+  auto it = analyses_[f].emplace(key, std::move(cached)).first;
+  return static_cast<T*>(it->second.analysis.get());
+}
+
+xabsl::StatusOr<TernaryQueryEngine*> AnalysisManager::GetTernaryQueryEngine(
+    Function* f) {
+  if (!incremental_) {
+    return GetOrBuild<TernaryQueryEngine>(
+        f, "ternary", /*incremental=*/false,
+        [f] { return TernaryQueryEngine::Run(f); });
+  }
+  return GetOrBuild<TernaryQueryEngine>(
+      f, "ternary", /*incremental=*/true,
+      [f] { return TernaryQueryEngine::RunIncremental(f); });
+}
+
+xabsl::StatusOr<BddQueryEngine*> AnalysisManager::GetBddQueryEngine(
+    Function* f, int64 minterm_limit,
+    absl::Span<const Op> do_not_evaluate_ops) {
+  std::string key = absl::StrFormat("bdd(minterm_limit=%d", minterm_limit);
+  if (!do_not_evaluate_ops.empty()) {
+    absl::StrAppend(&key, ", do_not_evaluate=",
+                    absl::StrJoin(do_not_evaluate_ops, "|",
+                                  [](std::string* out, Op op) {
+                                    absl::StrAppend(out, OpToString(op));
+                                  }));
+  }
+  absl::StrAppend(&key, ")");
+  return GetOrBuild<BddQueryEngine>(f, key, /*incremental=*/false, [&] {
+    return BddQueryEngine::Run(f, minterm_limit, do_not_evaluate_ops);
+  });
+}
+
+xabsl::StatusOr<PostDominatorAnalysis*>
+AnalysisManager::GetPostDominatorAnalysis(Function* f) {
+  return GetOrBuild<PostDominatorAnalysis>(
+      f, "post_dominators", /*incremental=*/false,
+      [f] { return PostDominatorAnalysis::Run(f); });
+}
+
+void AnalysisManager::Discard(FunctionAnalyses* analyses,
+                              bool include_incremental) {
+  for (auto it = analyses->begin(); it != analyses->end();) {
+    if (include_incremental || !it->second.incremental) {
+      ++stats_[it->first].invalidations;
+      analyses->erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void AnalysisManager::Invalidate(Function* f) {
+  absl::MutexLock lock(&mutex_);
+  auto it = analyses_.find(f);
+  if (it != analyses_.end()) {
+    Discard(&it->second, /*include_incremental=*/false);
+  }
+}
+
+void AnalysisManager::InvalidateAll() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& pair : analyses_) {
+    Discard(&pair.second, /*include_incremental=*/false);
+  }
+}
+
+void AnalysisManager::Discard(Function* f) {
+  absl::MutexLock lock(&mutex_);
+  auto it = analyses_.find(f);
+  if (it != analyses_.end()) {
+    Discard(&it->second, /*include_incremental=*/true);
+    analyses_.erase(it);
+  }
+}
+
+std::string AnalysisManager::StatsToString() const {
+  absl::MutexLock lock(&mutex_);
+  std::string result = absl::StrFormat(
+      "%-48s %8s %8s %8s %14s\n", "analysis", "hits", "misses", "invalid",
+      "build time");
+  for (const auto& pair : stats_) {
+    const Stats& stats = pair.second;
+    absl::StrAppendFormat(&result, "%-48s %8d %8d %8d %14s\n", pair.first,
+                          stats.hits, stats.misses, stats.invalidations,
+                          absl::FormatDuration(stats.build_time));
+  }
+  return result;
+}
+
+}  // namespace xls
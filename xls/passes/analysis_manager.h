@@ -0,0 +1,154 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_ANALYSIS_MANAGER_H_
+#define XLS_PASSES_ANALYSIS_MANAGER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/status/statusor.h"
+#include "xls/ir/function.h"
+#include "xls/ir/op.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/post_dominator_analysis.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+// Caches analyses of functions (query engines, post-dominators) across the
+// passes of a pipeline. An analysis is built on first request and returned
+// from the cache on later requests until its function is invalidated.
+//
+// Analyses hold raw pointers to the nodes of the function, so most cached
+// analyses are only valid while their function is unchanged. FunctionPass::Run
+// invalidates every function for which RunOnFunction reports a change; passes
+// which change a function and then request an analysis of it must call
+// Invalidate themselves, and passes which remove a function from the package
+// must call Discard first. Analyses of different functions are independent.
+//
+// Incremental analyses (by default, the ternary query engine) listen to the
+// changes of their function and keep themselves up to date, so they survive
+// invalidation and stay accurate while a pass rewrites the function.
+//
+// Passes find the manager through PassOptions::analysis_manager. A manager
+// should only be shared by pass runs over the same package, and must be
+// invalidated if the package is modified outside of the passes.
+//
+// The methods may be called concurrently for different functions, as when
+// function passes run in parallel (PassOptions::function_threads), except for
+// stats(). Analyses are built outside of the lock.
+class AnalysisManager {
+ public:
+  // If "incremental" is false, all analyses are rebuilt after their function
+  // changes; this is only useful to measure the benefit of the incremental
+  // analyses.
+  explicit AnalysisManager(bool incremental = true)
+      : incremental_(incremental) {}
+  AnalysisManager(const AnalysisManager&) = delete;
+  AnalysisManager& operator=(const AnalysisManager&) = delete;
+
+  // Returns the analyses of "f", building them if they are not cached. The
+  // returned pointers remain valid until the analysis is discarded by
+  // Invalidate or Discard. Arguments are as for the respective Run methods.
+  xabsl::StatusOr<TernaryQueryEngine*> GetTernaryQueryEngine(Function* f);
+  xabsl::StatusOr<BddQueryEngine*> GetBddQueryEngine(
+      Function* f, int64 minterm_limit,
+      absl::Span<const Op> do_not_evaluate_ops = {});
+  xabsl::StatusOr<PostDominatorAnalysis*> GetPostDominatorAnalysis(
+      Function* f);
+
+  // Discards the cached analyses of "f", or of all functions, which do not
+  // keep themselves up to date.
+  void Invalidate(Function* f);
+  void InvalidateAll();
+
+  // Discards all cached analyses of "f". Must be called before "f" is deleted.
+  void Discard(Function* f);
+
+  // Statistics about the requests for a single kind of analysis.
+  struct Stats {
+    // Number of requests answered from the cache.
+    int64 hits = 0;
+    // Number of requests which built the analysis.
+    int64 misses = 0;
+    // Number of cached analyses discarded by invalidation (or Discard).
+    int64 invalidations = 0;
+    // Total time spent building the analysis.
+    absl::Duration build_time;
+  };
+
+  // Returns the statistics of each kind of analysis requested so far, keyed by
+  // a description of the analysis (e.g., "bdd(minterm_limit=4096)"). Must not
+  // be called while other threads use the manager.
+  const std::map<std::string, Stats>& stats() const
+      ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    return stats_;
+  }
+
+  // Returns a human-readable table of stats().
+  std::string StatsToString() const;
+
+ private:
+  // A cached analysis. Analyses are type-erased; the key under which they are
+  // cached determines the type.
+  struct CachedAnalysis {
+    std::shared_ptr<void> analysis;
+    // Whether the analysis keeps itself up to date as its function changes.
+    bool incremental;
+  };
+  using FunctionAnalyses = absl::flat_hash_map<std::string, CachedAnalysis>;
+
+  // Returns the analysis of "f" described by "key", building it with "build"
+  // if it is not cached.
+  template <typename T>
+  xabsl::StatusOr<T*> GetOrBuild(
+      Function* f, const std::string& key, bool incremental,
+      const std::function<xabsl::StatusOr<std::unique_ptr<T>>()>& build);
+
+  // Discards the analyses of "analyses" which are not incremental, or all of
+  // them if "include_incremental" is true.
+  void Discard(FunctionAnalyses* analyses, bool include_incremental)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const bool incremental_;
+
+  mutable absl::Mutex mutex_;
+
+  // The cached analyses of each function, keyed as in stats_.
+  absl::flat_hash_map<Function*, FunctionAnalyses> analyses_
+      ABSL_GUARDED_BY(mutex_);
+  std::map<std::string, Stats> stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the analysis manager in "options", or "fallback" if there is none.
+// Passes use this so that they share analyses when run in a pipeline, and
+// build them privately (in "fallback", usually a local) otherwise.
+inline AnalysisManager* GetAnalysisManager(const PassOptions& options,
+                                           AnalysisManager* fallback) {
+  return options.analysis_manager != nullptr ? options.analysis_manager
+                                             : fallback;
+}
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_ANALYSIS_MANAGER_H_
@@ -0,0 +1,156 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/narrowing_pass.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class AnalysisManagerTest : public IrTestBase {
+ protected:
+  static constexpr char kPackage[] = R"(
+package p
+
+fn live(x: bits[8], y: bits[8]) -> bits[8] {
+  ret and.1: bits[8] = and(x, y)
+}
+
+fn dead(x: bits[8], y: bits[8]) -> bits[8] {
+  neg.2: bits[8] = neg(x)
+  ret or.3: bits[8] = or(x, y)
+}
+)";
+};
+
+TEST_F(AnalysisManagerTest, CachesUntilInvalidated) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(kPackage));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("live"));
+  AnalysisManager manager(/*incremental=*/false);
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * first,
+                           manager.GetTernaryQueryEngine(f));
+  EXPECT_THAT(manager.GetTernaryQueryEngine(f), IsOkAndHolds(first));
+
+  const AnalysisManager::Stats& stats = manager.stats().at("ternary");
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.invalidations, 0);
+
+  manager.Invalidate(f);
+  XLS_ASSERT_OK(manager.GetTernaryQueryEngine(f).status());
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.invalidations, 1);
+}
+
+TEST_F(AnalysisManagerTest, BddEnginesAreKeyedByOptions) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(kPackage));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("live"));
+  AnalysisManager manager;
+  XLS_ASSERT_OK_AND_ASSIGN(BddQueryEngine * limited,
+                           manager.GetBddQueryEngine(f, 4096));
+  XLS_ASSERT_OK_AND_ASSIGN(BddQueryEngine * one_hot_opaque,
+                           manager.GetBddQueryEngine(f, 4096, {Op::kOneHot}));
+  XLS_ASSERT_OK_AND_ASSIGN(BddQueryEngine * unlimited,
+                           manager.GetBddQueryEngine(f, 0));
+  EXPECT_NE(limited, one_hot_opaque);
+  EXPECT_NE(limited, unlimited);
+  EXPECT_THAT(manager.GetBddQueryEngine(f, 4096), IsOkAndHolds(limited));
+  EXPECT_EQ(manager.stats().size(), 3);
+
+  manager.InvalidateAll();
+  for (const auto& pair : manager.stats()) {
+    EXPECT_EQ(pair.second.invalidations, 1) << pair.first;
+  }
+}
+
+TEST_F(AnalysisManagerTest, FunctionPassInvalidatesOnlyChangedFunctions) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(kPackage));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * live, p->GetFunction("live"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * dead, p->GetFunction("dead"));
+  AnalysisManager manager;
+  XLS_ASSERT_OK_AND_ASSIGN(PostDominatorAnalysis * live_analysis,
+                           manager.GetPostDominatorAnalysis(live));
+  XLS_ASSERT_OK(manager.GetPostDominatorAnalysis(dead).status());
+
+  PassOptions options;
+  options.analysis_manager = &manager;
+  PassResults results;
+  EXPECT_THAT(DeadCodeEliminationPass().Run(p.get(), options, &results),
+              IsOkAndHolds(true));
+  const AnalysisManager::Stats& stats = manager.stats().at("post_dominators");
+  EXPECT_EQ(stats.invalidations, 1);
+  EXPECT_THAT(manager.GetPostDominatorAnalysis(live),
+              IsOkAndHolds(live_analysis));
+  XLS_ASSERT_OK(manager.GetPostDominatorAnalysis(dead).status());
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 3);
+}
+
+TEST_F(AnalysisManagerTest, IncrementalAnalysesSurviveInvalidation) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(kPackage));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * dead, p->GetFunction("dead"));
+  AnalysisManager manager;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * engine,
+                           manager.GetTernaryQueryEngine(dead));
+
+  PassOptions options;
+  options.analysis_manager = &manager;
+  PassResults results;
+  EXPECT_THAT(DeadCodeEliminationPass().Run(p.get(), options, &results),
+              IsOkAndHolds(true));
+  EXPECT_THAT(manager.GetTernaryQueryEngine(dead), IsOkAndHolds(engine));
+  EXPECT_EQ(manager.stats().at("ternary").invalidations, 0);
+  for (Node* node : dead->nodes()) {
+    EXPECT_TRUE(engine->IsTracked(node)) << node->GetName();
+  }
+
+  manager.Discard(dead);
+  EXPECT_EQ(manager.stats().at("ternary").invalidations, 1);
+}
+
+TEST_F(AnalysisManagerTest, PassesShareAnalyses) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[8], y: bits[8]) -> bits[8] {
+       ret shll.1: bits[8] = shll(x, y)
+     }
+  )",
+                                                       p.get()));
+  AnalysisManager manager;
+  PassOptions options;
+  options.analysis_manager = &manager;
+  PassResults results;
+  // Nothing to narrow, so the second run reuses the first run's analysis.
+  EXPECT_THAT(NarrowingPass().Run(p.get(), options, &results),
+              IsOkAndHolds(false));
+  EXPECT_THAT(NarrowingPass().Run(p.get(), options, &results),
+              IsOkAndHolds(false));
+  EXPECT_EQ(manager.stats().at("ternary").misses, 1);
+  EXPECT_EQ(manager.stats().at("ternary").hits, 1);
+  EXPECT_EQ(f->node_count(), 3);
+}
+
+}  // namespace
+}  // namespace xls
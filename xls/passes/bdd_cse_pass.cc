@@ -27,7 +27,9 @@
 #include "xls/delay_model/delay_estimators.h"
 #include "xls/ir/node.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
 
 namespace xls {
 
@@ -98,9 +100,13 @@ xabsl::StatusOr<bool> BddCsePass::RunOnFunction(Function* f,
   XLS_VLOG(3) << "Before:";
   XLS_VLOG_LINES(3, f->DumpIr());
 
-  // TODO(meheff): Try tuning the minterm limit.
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BddFunction> bdd_function,
-                       BddFunction::Run(f, /*minterm_limit=*/4096));
+  // TODO(meheff): Try tuning the minterm limit. This is the same limit as
+  // BddSimplificationPass so that the two share the analysis when possible.
+  AnalysisManager local_analyses;
+  XLS_ASSIGN_OR_RETURN(BddQueryEngine * query_engine,
+                       GetAnalysisManager(options, &local_analyses)
+                           ->GetBddQueryEngine(f, /*minterm_limit=*/4096));
+  const BddFunction& bdd_function = query_engine->bdd_function();
 
   // To improve efficiency, bucket potentially common nodes together. The
   // bucketing is done via a int64 hash value of the BDD node indices of each
@@ -110,7 +116,7 @@ xabsl::StatusOr<bool> BddCsePass::RunOnFunction(Function* f,
     XLS_CHECK(n->GetType()->IsBits());
     std::vector<int64> values_to_hash;
     for (int64 i = 0; i < n->BitCountOrDie(); ++i) {
-      values_to_hash.push_back(bdd_function->GetBddNode(n, i).value());
+      values_to_hash.push_back(bdd_function.GetBddNode(n, i).value());
     }
     return hasher(values_to_hash);
   };
@@ -120,7 +126,7 @@ xabsl::StatusOr<bool> BddCsePass::RunOnFunction(Function* f,
       return false;
     }
     for (int64 i = 0; i < a->BitCountOrDie(); ++i) {
-      if (bdd_function->GetBddNode(a, i) != bdd_function->GetBddNode(b, i)) {
+      if (bdd_function.GetBddNode(a, i) != bdd_function.GetBddNode(b, i)) {
         return false;
       }
     }
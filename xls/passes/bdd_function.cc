@@ -14,8 +14,10 @@
 
 #include "xls/passes/bdd_function.h"
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -30,6 +32,7 @@
 #include "xls/ir/ir_interpreter.h"
 #include "xls/ir/node.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/node_map.h"
 
 namespace xls {
 namespace {
@@ -130,6 +133,9 @@ class SaturatingBddEvaluator
   BinaryDecisionDiagram* bdd_;
 };
 
+// The number of BDD nodes below which BddFunction::Run never garbage collects.
+constexpr int64 kMinGarbageCollectionThreshold = 1 << 16;
+
 // Returns whether the given op should be included in BDD computations.
 bool ShouldEvaluate(Node* node) {
   if (!node->GetType()->IsBits()) {
@@ -258,7 +264,8 @@ bool ShouldEvaluate(Node* node) {
   };
 
   XLS_VLOG(3) << "BDD expressions:";
-  absl::flat_hash_map<Node*, SaturatingBddNodeVector> values;
+  NodeMap<SaturatingBddNodeVector> values(f);
+  int64 gc_threshold = kMinGarbageCollectionThreshold;
   for (Node* node : TopoSort(f)) {
     if (!node->GetType()->IsBits()) {
       continue;
@@ -297,13 +304,34 @@ bool ShouldEvaluate(Node* node) {
               absl::get<BddNodeIndex>(values.at(node)[i]),
               /*minterm_limit=*/15));
     }
+
+    // Between nodes the only BDD expressions still needed are those in
+    // 'values', so intermediate expressions (e.g., those replaced by variables
+    // for exceeding the minterm limit) can be collected. Collect whenever the
+    // BDD has doubled in size since the last collection.
+    if (bdd_function->bdd().size() > gc_threshold) {
+      std::vector<BddNodeIndex> roots;
+      for (Node* n : f->nodes()) {
+        if (!values.contains(n)) {
+          continue;
+        }
+        for (const SaturatingBddNodeIndex& value : values.at(n)) {
+          roots.push_back(absl::get<BddNodeIndex>(value));
+        }
+      }
+      bdd_function->bdd().GarbageCollect(roots);
+      gc_threshold = std::max(kMinGarbageCollectionThreshold,
+                              2 * bdd_function->bdd().size());
+    }
   }
 
   // Copy over the vector and BDD variables into the node map which is exposed
   // via the BddFunction interface. At this point any TooManyMinterm sentinel
   // values have been replaced with new Bdd variables.
-  for (const auto& pair : values) {
-    bdd_function->node_map_[pair.first] = ToBddNodeVector(pair.second);
+  for (Node* node : f->nodes()) {
+    if (values.contains(node)) {
+      bdd_function->node_map_[node] = ToBddNodeVector(values.at(node));
+    }
   }
   return std::move(bdd_function);
 }
@@ -311,7 +339,7 @@ bool ShouldEvaluate(Node* node) {
 xabsl::StatusOr<Value> BddFunction::Evaluate(
     absl::Span<const Value> args) const {
   // Map containing the result of each node.
-  absl::flat_hash_map<const Node*, Value> values;
+  NodeMap<Value> values(func_);
   // Map of the BDD variable values.
   absl::flat_hash_map<BddNodeIndex, bool> bdd_variable_values;
   XLS_RET_CHECK_EQ(args.size(), func_->params().size());
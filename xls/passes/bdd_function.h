@@ -15,18 +15,18 @@
 #ifndef XLS_PASSES_BDD_FUNCTION_H_
 #define XLS_PASSES_BDD_FUNCTION_H_
 
-#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/statusor.h"
 #include "xls/data_structures/binary_decision_diagram.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/function.h"
+#include "xls/ir/node_map.h"
 #include "xls/ir/op.h"
 
 namespace xls {
 
 using BddNodeVector = std::vector<BddNodeIndex>;
-using NodeMap = absl::flat_hash_map<const Node*, BddNodeVector>;
 
 // A class which represents an XLS function using a binary decision diagram
 // (BDD). The BDD is constructed by an abstract evaluation of the operations in
@@ -69,14 +69,14 @@ class BddFunction {
   xabsl::StatusOr<Value> Evaluate(absl::Span<const Value> args) const;
 
  private:
-  explicit BddFunction(Function* f) : func_(f) {}
+  explicit BddFunction(Function* f) : func_(f), node_map_(f) {}
 
   Function* func_;
   BinaryDecisionDiagram bdd_;
 
   // A map from XLS Node to vector of BDD nodes representing the XLS Node's
   // expression.
-  NodeMap node_map_;
+  NodeMap<BddNodeVector> node_map_;
 
   // Map containing the Nodes whose expressions exceeded the maximum number of
   // minterms.
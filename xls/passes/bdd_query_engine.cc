@@ -28,7 +28,7 @@ namespace xls {
 xabsl::StatusOr<std::unique_ptr<BddQueryEngine>> BddQueryEngine::Run(
     Function* f, int64 minterm_limit,
     absl::Span<const Op> do_not_evaluate_ops) {
-  auto query_engine = absl::WrapUnique(new BddQueryEngine(minterm_limit));
+  auto query_engine = absl::WrapUnique(new BddQueryEngine(f, minterm_limit));
   XLS_ASSIGN_OR_RETURN(query_engine->bdd_function_,
                        BddFunction::Run(f, minterm_limit, do_not_evaluate_ops));
   // Construct the Bits objects indication which bit values are statically known
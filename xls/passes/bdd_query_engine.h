@@ -21,6 +21,7 @@
 #include "xls/common/status/statusor.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
+#include "xls/ir/node_map.h"
 #include "xls/ir/nodes.h"
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/query_engine.h"
@@ -69,8 +70,8 @@ class BddQueryEngine : public QueryEngine {
   const BddFunction& bdd_function() const { return *bdd_function_; }
 
  private:
-  explicit BddQueryEngine(int64 minterm_limit)
-      : minterm_limit_(minterm_limit) {}
+  BddQueryEngine(Function* f, int64 minterm_limit)
+      : minterm_limit_(minterm_limit), known_bits_(f), bits_values_(f) {}
 
   // Returns the underlying BDD. This method is const, but queries on a BDD
   // generally mutate the object. We sneakily avoid conflicts with C++ const
@@ -93,17 +94,17 @@ class BddQueryEngine : public QueryEngine {
   // the result of the query.
   bool ExceedsMintermLimit(BddNodeIndex node) const {
     return minterm_limit_ > 0 &&
-           bdd().GetNode(node).minterm_count > minterm_limit_;
+           bdd().minterm_count(node) > minterm_limit_;
   }
 
   // The maximum number of minterms in expression in the BDD before truncating.
   int64 minterm_limit_;
 
   // Indicates the bits at the output of each node which have known values.
-  absl::flat_hash_map<Node*, Bits> known_bits_;
+  NodeMap<Bits> known_bits_;
 
   // Indicates the values of bits at the output of each node (if known)
-  absl::flat_hash_map<Node*, Bits> bits_values_;
+  NodeMap<Bits> bits_values_;
 
   std::unique_ptr<BddFunction> bdd_function_;
 };
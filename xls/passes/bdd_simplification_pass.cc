@@ -32,6 +32,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/nodes.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/post_dominator_analysis.h"
 #include "xls/passes/query_engine.h"
@@ -322,11 +323,11 @@ xabsl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
   return false;
 }
 
-xabsl::StatusOr<bool> SimplifyOneHotMsb(Function* f) {
+xabsl::StatusOr<bool> SimplifyOneHotMsb(Function* f,
+                                        AnalysisManager* analyses) {
   bool changed = false;
-  XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<PostDominatorAnalysis> post_dominator_analysis,
-      PostDominatorAnalysis::Run(f));
+  XLS_ASSIGN_OR_RETURN(PostDominatorAnalysis * post_dominator_analysis,
+                       analyses->GetPostDominatorAnalysis(f));
   // We performa a variant of bdd analysis without analyzing OneHot nodes. This
   // is because we will check if a OneHot's MSB = 0 and LSBs = {0,...} implies
   // the same value for another node as MSB = 1 and LSBs = {0,...}.  However,
@@ -338,11 +339,12 @@ xabsl::StatusOr<bool> SimplifyOneHotMsb(Function* f) {
   // this is not necessary for the case MSB = 1. Performing BDD analysis
   // including OneHots in this case gives more information / opens up more
   // optimization opportunities.
+  XLS_ASSIGN_OR_RETURN(BddQueryEngine * bdd_query_engine_minus_one_hot,
+                       analyses->GetBddQueryEngine(f, /*minterm_limit=*/4096,
+                                                   {Op::kOneHot}));
   XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<BddQueryEngine> bdd_query_engine_minus_one_hot,
-      BddQueryEngine::Run(f, /*minterm_limit=*/4096, {Op::kOneHot}));
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BddQueryEngine> bdd_query_engine_default,
-                       BddQueryEngine::Run(f, /*minterm_limit=*/4096));
+      BddQueryEngine * bdd_query_engine_default,
+      analyses->GetBddQueryEngine(f, /*minterm_limit=*/4096));
 
   for (Node* node : f->nodes()) {
     // Check if one-hot's MSB affect the function's output.
@@ -441,14 +443,20 @@ xabsl::StatusOr<bool> BddSimplificationPass::RunOnFunction(
   XLS_VLOG(3) << "Before:";
   XLS_VLOG_LINES(3, f->DumpIr());
 
+  AnalysisManager local_analyses;
+  AnalysisManager* analyses = GetAnalysisManager(options, &local_analyses);
   bool one_hot_modified = false;
   if (split_ops_) {
-    XLS_ASSIGN_OR_RETURN(one_hot_modified, SimplifyOneHotMsb(f));
+    XLS_ASSIGN_OR_RETURN(one_hot_modified, SimplifyOneHotMsb(f, analyses));
+    if (one_hot_modified) {
+      // The analyses used above predate the replaced MSBs.
+      analyses->Invalidate(f);
+    }
   }
 
   // TODO(meheff): Try tuning the minterm limit.
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BddQueryEngine> query_engine,
-                       BddQueryEngine::Run(f, /*minterm_limit=*/4096));
+  XLS_ASSIGN_OR_RETURN(BddQueryEngine * query_engine,
+                       analyses->GetBddQueryEngine(f, /*minterm_limit=*/4096));
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
@@ -14,50 +14,45 @@
 
 #include "xls/passes/cse_pass.h"
 
-#include "absl/hash/hash.h"
+#include "absl/container/flat_hash_set.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/node_iterator.h"
 
 namespace xls {
 
+namespace {
+
+// Hash and equality of nodes for hash-consing: nodes are equal if they have
+// the same operands and are definitely equal.
+struct NodeHash {
+  size_t operator()(const Node* node) const { return node->StructuralHash(); }
+};
+
+struct NodeEq {
+  bool operator()(const Node* a, const Node* b) const {
+    return a->operands() == b->operands() && a->IsDefinitelyEqualTo(b);
+  }
+};
+
+}  // namespace
+
 xabsl::StatusOr<bool> CsePass::RunOnFunction(Function* f,
                                              const PassOptions& options,
                                              PassResults* results) const {
-  // To improve efficiency, bucket potentially common nodes together. The
-  // bucketing is done via an int64 hash value which is constructed from the
-  // op() of the node and the uid's of the node's operands.
-  auto hasher = absl::Hash<std::vector<int64>>();
-  auto node_hash = [&](Node* n) {
-    std::vector<int64> values_to_hash = {static_cast<int64>(n->op())};
-    for (Node* operand : n->operands()) {
-      values_to_hash.push_back(operand->id());
-    }
-    // If this is slow because of many literals, the Literal values could be
-    // combined into the hash. As is, all literals get the same hash value.
-    return hasher(values_to_hash);
-  };
+  // Visit the nodes in topological order and hash-cons them: a node equal to a
+  // previously visited node is replaced by it. The operands of the visited
+  // nodes are already canonical, so comparing operands by identity suffices.
+  // The structural hash covers the op-specific attributes (e.g., literal
+  // values), so unequal nodes rarely collide.
   bool changed = false;
-  absl::flat_hash_map<int64, std::vector<Node*>> node_buckets;
-  node_buckets.reserve(f->node_count());
+  absl::flat_hash_set<Node*, NodeHash, NodeEq> canonical_nodes;
+  canonical_nodes.reserve(f->node_count());
   for (Node* node : TopoSort(f)) {
-    int64 hash = node_hash(node);
-    if (!node_buckets.contains(hash)) {
-      node_buckets[hash].push_back(node);
-      continue;
-    }
-    bool replaced = false;
-    for (Node* candidate : node_buckets.at(hash)) {
-      if (node->operands() == candidate->operands() &&
-          node->IsDefinitelyEqualTo(candidate)) {
-        XLS_ASSIGN_OR_RETURN(bool node_changed,
-                             node->ReplaceUsesWith(candidate));
-        changed |= node_changed;
-        replaced = true;
-        break;
-      }
-    }
-    if (!replaced) {
-      node_buckets[hash].push_back(node);
+    auto insertion = canonical_nodes.insert(node);
+    if (!insertion.second) {
+      XLS_ASSIGN_OR_RETURN(bool node_changed,
+                           node->ReplaceUsesWith(*insertion.first));
+      changed |= node_changed;
     }
   }
 
@@ -0,0 +1,140 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the run time of common subexpression elimination on generated
+// functions with many literals and shared subexpressions.
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/package.h"
+#include "xls/passes/cse_pass.h"
+
+const char* kUsage = R"(
+Measures the run time of common subexpression elimination on a generated
+function. For each of --literals literals (with --distinct_values distinct
+values) the function adds the literal to its complement, slices and
+zero-extends the sum, and the results are combined by a balanced tree of xors.
+All expressions on equal literals are common. Usage:
+
+   cse_pass_benchmark --literals=100000 --distinct_values=10000
+)";
+
+ABSL_FLAG(int64, literals, 100000, "Number of literals in the function.");
+ABSL_FLAG(int64, distinct_values, 10000,
+          "Number of distinct values of the literals.");
+ABSL_FLAG(int64, runs, 3,
+          "Number of times to run the pass; the fastest run is reported.");
+
+namespace xls {
+namespace {
+
+xabsl::StatusOr<Function*> BuildFunction(int64 literals, int64 distinct_values,
+                                         Package* package) {
+  FunctionBuilder fb("many_literals", package);
+  std::vector<BValue> values;
+  for (int64 i = 0; i < literals; ++i) {
+    // Nodes with many users are slow to build, so the expressions do not share
+    // a parameter.
+    BValue literal = fb.Literal(UBits(i % distinct_values, 32));
+    BValue sum = fb.Add(literal, fb.Not(literal));
+    values.push_back(fb.ZeroExtend(fb.BitSlice(sum, i % 4, 16), 32));
+  }
+  while (values.size() > 1) {
+    std::vector<BValue> next;
+    for (int64 i = 0; i + 1 < values.size(); i += 2) {
+      next.push_back(fb.Xor(values[i], values[i + 1]));
+    }
+    if (values.size() % 2 == 1) {
+      next.push_back(values.back());
+    }
+    values = std::move(next);
+  }
+  return fb.BuildWithReturnValue(values.front());
+}
+
+// Returns the number of nodes the return value depends on. The nodes replaced
+// by CSE are dead but remain in the function.
+int64 LiveNodeCount(Function* f) {
+  absl::flat_hash_set<Node*> live = {f->return_value()};
+  std::vector<Node*> worklist = {f->return_value()};
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    for (Node* operand : node->operands()) {
+      if (live.insert(operand).second) {
+        worklist.push_back(operand);
+      }
+    }
+  }
+  return live.size();
+}
+
+absl::Status RealMain() {
+  const int64 literals = absl::GetFlag(FLAGS_literals);
+  const int64 distinct_values = absl::GetFlag(FLAGS_distinct_values);
+  XLS_RET_CHECK_GT(literals, 0);
+  XLS_RET_CHECK_GT(distinct_values, 0);
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_runs), 0);
+
+  absl::Duration best = absl::InfiniteDuration();
+  int64 nodes_before = 0;
+  int64 nodes_after = 0;
+  for (int64 i = 0; i < absl::GetFlag(FLAGS_runs); ++i) {
+    Package package("cse_pass_benchmark");
+    XLS_ASSIGN_OR_RETURN(Function * f,
+                         BuildFunction(literals, distinct_values, &package));
+    nodes_before = f->node_count();
+    PassResults results;
+    absl::Time start = absl::Now();
+    XLS_RETURN_IF_ERROR(
+        CsePass().RunOnFunction(f, PassOptions(), &results).status());
+    best = std::min(best, absl::Now() - start);
+    nodes_after = LiveNodeCount(f);
+  }
+  std::cout << absl::StreamFormat(
+      "literals: %d, distinct values: %d, nodes: %d, live nodes after cse: "
+      "%d, time: %s\n",
+      literals, distinct_values, nodes_before, nodes_after,
+      absl::FormatDuration(best));
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
@@ -20,6 +20,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/common/status/statusor.h"
 #include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/package.h"
 #include "xls/passes/dce_pass.h"
@@ -175,5 +176,28 @@ fn main(x: bits[11]) -> (bits[11], bits[11], bits[11]) {
             entry->DumpIr());
 }
 
+TEST_F(CsePassTest, ManyLiterals) {
+  // Literals with 100 distinct values, each repeated 10 times, and an add of
+  // each literal to a parameter.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  std::vector<BValue> sums;
+  for (int64 i = 0; i < 1000; ++i) {
+    sums.push_back(fb.Add(x, fb.Literal(UBits(i % 100, 32))));
+  }
+  fb.Tuple(sums);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  EXPECT_EQ(f->node_count(), 2002);
+
+  EXPECT_THAT(Run(f), IsOkAndHolds(true));
+
+  EXPECT_EQ(f->node_count(), 202);
+  for (int64 i = 0; i < 1000; ++i) {
+    EXPECT_EQ(f->return_value()->operand(i),
+              f->return_value()->operand(i % 100));
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -51,6 +51,11 @@ xabsl::StatusOr<bool> DeadCodeEliminationPass::RunOnFunction(
   }
 
   XLS_VLOG(2) << "Removed " << removed_count << " dead nodes";
+  if (removed_count > 0) {
+    // Reclaim the node indices of the removed nodes so side tables indexed by
+    // node index stay proportional to the size of the function.
+    f->CompactNodeIndices();
+  }
   return removed_count > 0;
 }
 
@@ -17,6 +17,7 @@
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/statusor.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/passes/analysis_manager.h"
 
 namespace xls {
 namespace {
@@ -68,6 +69,11 @@ xabsl::StatusOr<bool> DeadFunctionEliminationPass::Run(
     }
   }
   if (!to_unlink.empty()) {
+    if (options.analysis_manager != nullptr) {
+      for (Function* f : to_unlink) {
+        options.analysis_manager->Discard(f);
+      }
+    }
     p->DeleteDeadFunctions(to_unlink);
   }
   return !to_unlink.empty();
@@ -30,6 +30,9 @@ class DumpPass : public FunctionPass {
   DumpPass() : FunctionPass("DMP", "Dump IR") {}
   ~DumpPass() override = default;
 
+  // Dumps the functions in package order.
+  bool IsFunctionLocal() const override { return false; }
+
   // Dumps the IR and keeps it unmodified.
   xabsl::StatusOr<bool> RunOnFunction(Function* f, const PassOptions& options,
                                       PassResults* results) const override;
@@ -20,6 +20,7 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/op.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/query_engine.h"
 #include "xls/passes/ternary_query_engine.h"
 
@@ -424,8 +425,10 @@ xabsl::StatusOr<bool> MaybeNarrowMultiply(ArithOp* mul,
 xabsl::StatusOr<bool> NarrowingPass::RunOnFunction(Function* f,
                                                    const PassOptions& options,
                                                    PassResults* results) const {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<TernaryQueryEngine> query_engine,
-                       TernaryQueryEngine::Run(f));
+  AnalysisManager local_analyses;
+  XLS_ASSIGN_OR_RETURN(
+      TernaryQueryEngine * query_engine,
+      GetAnalysisManager(options, &local_analyses)->GetTernaryQueryEngine(f));
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
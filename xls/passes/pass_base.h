@@ -29,15 +29,19 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/status/statusor.h"
 #include "xls/ir/function.h"
 #include "xls/ir/package.h"
+#include "xls/passes/pass_profile.h"
 
 namespace xls {
 
+class AnalysisManager;
+
 // This file defines a set of base classes for building XLS compiler passes and
 // pass pipelines. The base classes are templated allowing polymorphism of the
 // data types the pass operates on.
@@ -57,6 +61,23 @@ struct PassOptions {
   // both run_only_passes and skip_passes are present, then only passes which
   // are present in run_only_passes and not present in skip_passes will be run.
   std::vector<std::string> skip_passes;
+
+  // If non-null, passes request analyses (query engines, etc) of functions
+  // from this manager so that they are shared between passes rather than
+  // rebuilt by each. See analysis_manager.h.
+  AnalysisManager* analysis_manager = nullptr;
+
+  // If greater than one, function-local passes run on the functions of the
+  // package in parallel with up to this many threads (see
+  // FunctionPass::IsFunctionLocal). The optimized IR is the same for any number
+  // of threads greater than one.
+  int64 function_threads = 1;
+
+  // How often VerifierChecker fully verifies the package. If 1, every run is a
+  // full verification. If greater than one, every full_verify_period-th run is
+  // a full verification and the other runs only verify the nodes changed since
+  // the previous run (see VerifyIncremental). If 0, every run is incremental.
+  int64 full_verify_period = 1;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -70,6 +91,10 @@ struct PassInvocation {
 
   // The run duration of the pass.
   absl::Duration run_duration;
+
+  // The number of nodes in the IR before and after the pass.
+  int64 nodes_before = 0;
+  int64 nodes_after = 0;
 };
 
 // A object to which metadata may be written in each pass invocation. This data
@@ -77,16 +102,21 @@ struct PassInvocation {
 struct PassResults {
   // This vector contains and entry for each invocation of each pass.
   std::vector<PassInvocation> invocations;
+
+  // Timeline of the runs of all passes, including compound passes and
+  // invariant checkers.
+  PassProfile profile;
 };
 
 // Base class for all compiler passes. Template parameters:
 //
 //   IrT : The data type that the pass operates on (e.g., xls::Package). The
-//     type should define 'DumpIr' and 'name' methods used for dumping and
-//     logging in compound passes. A pass which strictly operate on the XLS IR
-//     may use the xls::Package type as the IrT template argument. Passes which
-//     operate on the IR and a schedule may be instantiated on a data structure
-//     containing both an xls::Package and a schedule.
+//     type should define 'DumpIr', 'name' and 'GetNodeCount' methods used for
+//     dumping, logging and profiling in compound passes. A pass which strictly
+//     operate on the XLS IR may use the xls::Package type as the IrT template
+//     argument. Passes which operate on the IR and a schedule may be
+//     instantiated on a data structure containing both an xls::Package and a
+//     schedule.
 //
 //   OptionsT : Options type passed as an immutable object to each invocation of
 //     PassBase::Run. This type should be derived from PassOptions because
@@ -190,8 +220,14 @@ class CompoundPassBase : public PassBase<IrT, OptionsT, ResultsT> {
                                  "start",
                                  /*ordinal=*/0, /*changed=*/false));
     }
-    return RunInternal(ir, options, results, this->short_name(),
-                       /*invariant_checkers=*/{});
+    int64 span = results->profile.BeginSpan(
+        PassProfile::SpanKind::kCompoundPass, this->short_name(),
+        ir->GetNodeCount());
+    xabsl::StatusOr<bool> changed = RunInternal(
+        ir, options, results, this->short_name(), /*invariant_checkers=*/{});
+    results->profile.EndSpan(span, changed.ok() && changed.value(),
+                             ir->GetNodeCount());
+    return changed;
   }
 
   // Internal implementation of Run for compound passes. Invoked when a compound
@@ -263,6 +299,7 @@ xabsl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunInternal(
               << " compound pass on package " << ir->name();
   XLS_VLOG(2) << "Start of compound pass " << this->long_name() << ":";
   XLS_VLOG_LINES(5, ir->DumpIr());
+  results->profile.AddIteration();
 
   // Invariant checkers may be passed in from parent compound passes or
   // contained by this pass itself. Merge them together.
@@ -272,13 +309,22 @@ xabsl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunInternal(
                   invariant_checker_ptrs_.end());
   auto run_invariant_checkers =
       [&](absl::string_view str_context) -> absl::Status {
+    if (checkers.empty()) {
+      return absl::OkStatus();
+    }
+    int64 node_count = ir->GetNodeCount();
+    int64 span = results->profile.BeginSpan(
+        PassProfile::SpanKind::kInvariantCheckers, "invariant_checkers",
+        node_count);
     for (const auto& checker : checkers) {
       absl::Status status = checker->Run(ir, options, results);
       if (!status.ok()) {
+        results->profile.EndSpan(span, /*changed=*/false, node_count);
         return absl::Status(status.code(), absl::StrCat(status.message(), "; [",
                                                         str_context, "]"));
       }
     }
+    results->profile.EndSpan(span, /*changed=*/false, node_count);
     return absl::OkStatus();
   };
   XLS_RETURN_IF_ERROR(run_invariant_checkers(
@@ -313,6 +359,11 @@ xabsl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunInternal(
     // do not check it in optimized builds.
     std::string ir_before = ir->DumpIr();
 #endif
+    int64 nodes_before = ir->GetNodeCount();
+    int64 span = results->profile.BeginSpan(
+        pass->IsCompound() ? PassProfile::SpanKind::kCompoundPass
+                           : PassProfile::SpanKind::kPass,
+        pass->short_name(), nodes_before);
     absl::Time start = absl::Now();
     bool pass_changed;
     if (pass->IsCompound()) {
@@ -324,6 +375,8 @@ xabsl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunInternal(
       XLS_ASSIGN_OR_RETURN(pass_changed, pass->Run(ir, options, results));
     }
     absl::Duration duration = absl::Now() - start;
+    int64 nodes_after = ir->GetNodeCount();
+    results->profile.EndSpan(span, pass_changed, nodes_after);
 #ifdef DEBUG
     std::string ir_after = ir->DumpIr();
     if (pass_changed) {
@@ -346,7 +399,8 @@ xabsl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunInternal(
                 << (pass_changed ? " changed IR" : " did not change IR");
     if (!pass->IsCompound()) {
       results->invocations.push_back(
-          {pass->short_name(), pass_changed, duration});
+          {pass->short_name(), pass_changed, duration, nodes_before,
+           nodes_after});
     }
     if (!options.ir_dump_path.empty()) {
       XLS_RETURN_IF_ERROR(DumpIr(options.ir_dump_path, ir, top_level_name,
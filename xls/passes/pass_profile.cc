@@ -0,0 +1,220 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/pass_profile.h"
+
+#include <algorithm>
+#include <map>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/time/clock.h"
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace {
+
+absl::string_view SpanKindToString(PassProfile::SpanKind kind) {
+  switch (kind) {
+    case PassProfile::SpanKind::kPass:
+      return "pass";
+    case PassProfile::SpanKind::kCompoundPass:
+      return "compound_pass";
+    case PassProfile::SpanKind::kInvariantCheckers:
+      return "invariant_checkers";
+  }
+  XLS_LOG(FATAL) << "Invalid span kind: " << static_cast<int>(kind);
+}
+
+double Percent(absl::Duration part, absl::Duration whole) {
+  if (whole == absl::ZeroDuration()) {
+    return 0.0;
+  }
+  return 100.0 * absl::FDivDuration(part, whole);
+}
+
+}  // namespace
+
+int64 PassProfile::BeginSpan(SpanKind kind, absl::string_view name,
+                             int64 node_count) {
+  absl::Time now = absl::Now();
+  if (spans_.empty()) {
+    origin_ = now;
+  }
+  Span span;
+  span.kind = kind;
+  span.name = std::string(name);
+  span.parent = open_spans_.empty() ? -1 : open_spans_.back();
+  span.start = now - origin_;
+  span.nodes_before = node_count;
+  span.nodes_after = node_count;
+  spans_.push_back(std::move(span));
+  open_spans_.push_back(spans_.size() - 1);
+  return spans_.size() - 1;
+}
+
+void PassProfile::EndSpan(int64 index, bool changed, int64 node_count) {
+  XLS_CHECK(std::find(open_spans_.begin(), open_spans_.end(), index) !=
+            open_spans_.end())
+      << "Span " << index << " is not open";
+  absl::Duration end = absl::Now() - origin_;
+  while (true) {
+    Span& span = spans_[open_spans_.back()];
+    open_spans_.pop_back();
+    span.duration = end - span.start;
+    span.nodes_after = node_count;
+    if (&span == &spans_[index]) {
+      span.changed = changed;
+      return;
+    }
+  }
+}
+
+void PassProfile::AddIteration() {
+  if (!open_spans_.empty()) {
+    ++spans_[open_spans_.back()].iterations;
+  }
+}
+
+std::string PassProfile::SpanPath(int64 index,
+                                  absl::string_view separator) const {
+  std::vector<absl::string_view> names;
+  for (int64 i = index; i != -1; i = spans_[i].parent) {
+    names.push_back(spans_[i].name);
+  }
+  std::reverse(names.begin(), names.end());
+  return absl::StrJoin(names, separator);
+}
+
+std::string PassProfile::SummaryToString() const {
+  absl::Duration total_time;
+  absl::Duration pass_time;
+  absl::Duration checker_time;
+  struct PassStats {
+    int64 runs = 0;
+    int64 changed = 0;
+    absl::Duration time;
+    int64 node_delta = 0;
+  };
+  struct CompoundStats {
+    int64 runs = 0;
+    int64 iterations = 0;
+    int64 max_iterations = 0;
+  };
+  std::map<std::string, PassStats> pass_stats;
+  std::map<std::string, CompoundStats> compound_stats;
+  for (int64 i = 0; i < spans_.size(); ++i) {
+    const Span& span = spans_[i];
+    if (span.parent == -1) {
+      total_time += span.duration;
+    }
+    switch (span.kind) {
+      case SpanKind::kPass: {
+        pass_time += span.duration;
+        PassStats& stats = pass_stats[SpanPath(i, "/")];
+        ++stats.runs;
+        stats.changed += span.changed ? 1 : 0;
+        stats.time += span.duration;
+        stats.node_delta += span.nodes_after - span.nodes_before;
+        break;
+      }
+      case SpanKind::kCompoundPass: {
+        CompoundStats& stats = compound_stats[SpanPath(i, "/")];
+        ++stats.runs;
+        stats.iterations += span.iterations;
+        stats.max_iterations = std::max(stats.max_iterations, span.iterations);
+        break;
+      }
+      case SpanKind::kInvariantCheckers:
+        checker_time += span.duration;
+        break;
+    }
+  }
+
+  std::string result = absl::StrFormat(
+      "Total time %s: passes %s (%.1f%%), invariant checkers %s (%.1f%%)\n",
+      absl::FormatDuration(total_time), absl::FormatDuration(pass_time),
+      Percent(pass_time, total_time), absl::FormatDuration(checker_time),
+      Percent(checker_time, total_time));
+
+  std::vector<std::pair<std::string, PassStats>> passes(pass_stats.begin(),
+                                                        pass_stats.end());
+  std::stable_sort(passes.begin(), passes.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second.time > b.second.time;
+                   });
+  absl::StrAppendFormat(&result, "%-48s %6s %8s %14s %7s %10s\n", "pass",
+                        "runs", "changed", "time", "%", "nodes +/-");
+  for (const auto& pair : passes) {
+    const PassStats& stats = pair.second;
+    absl::StrAppendFormat(&result, "%-48s %6d %8d %14s %6.1f%% %+10d\n",
+                          pair.first, stats.runs, stats.changed,
+                          absl::FormatDuration(stats.time),
+                          Percent(stats.time, total_time), stats.node_delta);
+  }
+
+  absl::StrAppendFormat(&result, "%-48s %6s %10s %8s\n", "compound pass",
+                        "runs", "iterations", "max");
+  for (const auto& pair : compound_stats) {
+    const CompoundStats& stats = pair.second;
+    absl::StrAppendFormat(&result, "%-48s %6d %10d %8d\n", pair.first,
+                          stats.runs, stats.iterations, stats.max_iterations);
+  }
+  return result;
+}
+
+std::string PassProfile::ToChromeTrace() const {
+  std::vector<std::string> events;
+  for (const Span& span : spans_) {
+    std::string args = absl::StrFormat(
+        R"("changed": %s, "nodes_before": %d, "nodes_after": %d)",
+        span.changed ? "true" : "false", span.nodes_before, span.nodes_after);
+    if (span.kind == SpanKind::kCompoundPass) {
+      absl::StrAppendFormat(&args, R"(, "iterations": %d)", span.iterations);
+    }
+    events.push_back(absl::StrFormat(
+        R"({"name": "%s", "cat": "%s", "ph": "X", "ts": %.3f, "dur": %.3f, )"
+        R"("pid": 0, "tid": 0, "args": {%s}})",
+        absl::StrReplaceAll(span.name, {{"\\", "\\\\"}, {"\"", "\\\""}}),
+        SpanKindToString(span.kind), absl::ToDoubleMicroseconds(span.start),
+        absl::ToDoubleMicroseconds(span.duration), args));
+  }
+  return absl::StrCat("{\"traceEvents\": [\n", absl::StrJoin(events, ",\n"),
+                      "\n]}\n");
+}
+
+std::string PassProfile::ToFoldedStacks() const {
+  std::vector<absl::Duration> self_time(spans_.size());
+  for (int64 i = 0; i < spans_.size(); ++i) {
+    self_time[i] += spans_[i].duration;
+    if (spans_[i].parent != -1) {
+      self_time[spans_[i].parent] -= spans_[i].duration;
+    }
+  }
+  std::map<std::string, int64> stacks;
+  for (int64 i = 0; i < spans_.size(); ++i) {
+    stacks[SpanPath(i, ";")] += absl::ToInt64Microseconds(self_time[i]);
+  }
+  std::string result;
+  for (const auto& pair : stacks) {
+    if (pair.second > 0) {
+      absl::StrAppendFormat(&result, "%s %d\n", pair.first, pair.second);
+    }
+  }
+  return result;
+}
+
+}  // namespace xls
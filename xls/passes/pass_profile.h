@@ -0,0 +1,94 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_PASS_PROFILE_H_
+#define XLS_PASSES_PASS_PROFILE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/integral_types.h"
+
+namespace xls {
+
+// A timeline of a run of a pass pipeline, recorded by CompoundPassBase. It
+// holds a span for each run of a pass, of a compound pass and of the invariant
+// checkers, nested as the passes are, and can be rendered as a summary table,
+// as a Chrome trace or as folded stacks for flame graphs.
+class PassProfile {
+ public:
+  enum class SpanKind { kPass, kCompoundPass, kInvariantCheckers };
+
+  struct Span {
+    SpanKind kind;
+    // Short name of the pass, or "invariant_checkers".
+    std::string name;
+    // Index in spans() of the enclosing span, or -1 if there is none.
+    int64 parent;
+    // Start time relative to the start of the first span.
+    absl::Duration start;
+    absl::Duration duration;
+    // Number of nodes in the IR at the start and end of the span.
+    int64 nodes_before;
+    int64 nodes_after;
+    bool changed = false;
+    // For compound passes, the number of times the contained passes were run;
+    // more than one for fixed point compound passes.
+    int64 iterations = 0;
+  };
+
+  // Opens a span nested in the innermost open span and returns its index.
+  int64 BeginSpan(SpanKind kind, absl::string_view name, int64 node_count);
+
+  // Closes the span "index", and any spans nested in it which are still open
+  // (because their pass returned an error).
+  void EndSpan(int64 index, bool changed, int64 node_count);
+
+  // Counts an iteration of the innermost open span, if any.
+  void AddIteration();
+
+  absl::Span<const Span> spans() const { return spans_; }
+
+  // Returns the names of the spans enclosing "index" and of the span itself,
+  // outermost first, joined with "separator".
+  std::string SpanPath(int64 index, absl::string_view separator) const;
+
+  // Returns a human-readable report: the time spent in passes and in invariant
+  // checkers, a table of the passes aggregated by their position in the
+  // pipeline (run count, time, change in node count) in decreasing order of
+  // time, and the iteration counts of the compound passes.
+  std::string SummaryToString() const;
+
+  // Returns the spans in the Chrome trace event format, which can be viewed
+  // with chrome://tracing or Perfetto.
+  std::string ToChromeTrace() const;
+
+  // Returns the time spent in each stack of spans (excluding nested spans) in
+  // microseconds, one "outer;inner;innermost <time>" line per stack, as
+  // consumed by flamegraph.pl.
+  std::string ToFoldedStacks() const;
+
+ private:
+  absl::Time origin_;
+  std::vector<Span> spans_;
+  // Indices of the open spans, outermost first.
+  std::vector<int64> open_spans_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_PASS_PROFILE_H_
@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/pass_profile.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_split.h"
+#include "xls/common/integral_types.h"
+
+namespace xls {
+namespace {
+
+using ::testing::Contains;
+using ::testing::Each;
+using ::testing::HasSubstr;
+using ::testing::MatchesRegex;
+using ::testing::Not;
+
+using SpanKind = PassProfile::SpanKind;
+
+// Records the profile of a fixed point pass "top" running "dce" twice, with
+// the invariant checkers run around each pass.
+PassProfile MakeProfile() {
+  PassProfile profile;
+  int64 top = profile.BeginSpan(SpanKind::kCompoundPass, "top", 10);
+  for (int64 i = 0; i < 2; ++i) {
+    profile.AddIteration();
+    int64 checkers = profile.BeginSpan(SpanKind::kInvariantCheckers,
+                                       "invariant_checkers", 10 - i);
+    profile.EndSpan(checkers, /*changed=*/false, 10 - i);
+    int64 dce = profile.BeginSpan(SpanKind::kPass, "dce", 10 - i);
+    profile.EndSpan(dce, /*changed=*/i == 0, 9);
+  }
+  profile.EndSpan(top, /*changed=*/true, 9);
+  return profile;
+}
+
+TEST(PassProfileTest, NestsSpans) {
+  PassProfile profile = MakeProfile();
+  ASSERT_EQ(profile.spans().size(), 5);
+  const PassProfile::Span& top = profile.spans()[0];
+  EXPECT_EQ(top.parent, -1);
+  EXPECT_EQ(top.iterations, 2);
+  EXPECT_EQ(top.nodes_before, 10);
+  EXPECT_EQ(top.nodes_after, 9);
+  EXPECT_TRUE(top.changed);
+  for (int64 i = 1; i < 5; ++i) {
+    const PassProfile::Span& span = profile.spans()[i];
+    EXPECT_EQ(span.parent, 0);
+    EXPECT_GE(span.start, top.start);
+    EXPECT_LE(span.start + span.duration, top.start + top.duration);
+  }
+  EXPECT_EQ(profile.spans()[2].nodes_before, 10);
+  EXPECT_EQ(profile.spans()[2].nodes_after, 9);
+  EXPECT_TRUE(profile.spans()[2].changed);
+  EXPECT_FALSE(profile.spans()[4].changed);
+  EXPECT_EQ(profile.SpanPath(4, "/"), "top/dce");
+}
+
+TEST(PassProfileTest, EndSpanClosesNestedSpans) {
+  PassProfile profile;
+  int64 outer = profile.BeginSpan(SpanKind::kCompoundPass, "outer", 1);
+  profile.BeginSpan(SpanKind::kPass, "failed", 1);
+  profile.EndSpan(outer, /*changed=*/false, 1);
+  int64 next = profile.BeginSpan(SpanKind::kCompoundPass, "next", 1);
+  EXPECT_EQ(profile.spans()[next].parent, -1);
+}
+
+TEST(PassProfileTest, Summary) {
+  std::vector<std::string> lines =
+      absl::StrSplit(MakeProfile().SummaryToString(), '\n', absl::SkipEmpty());
+  EXPECT_THAT(lines, Contains(HasSubstr("invariant checkers")));
+  EXPECT_THAT(lines, Contains(MatchesRegex("top/dce +2 +1 .* -1")));
+  EXPECT_THAT(lines, Contains(MatchesRegex("top +1 +2 +2")));
+}
+
+TEST(PassProfileTest, ChromeTrace) {
+  std::string trace = MakeProfile().ToChromeTrace();
+  EXPECT_THAT(trace, HasSubstr(R"({"traceEvents": [)"));
+  EXPECT_THAT(trace, HasSubstr(R"("name": "top", "cat": "compound_pass")"));
+  EXPECT_THAT(trace, HasSubstr(R"("iterations": 2)"));
+  EXPECT_THAT(trace, HasSubstr(R"("name": "dce", "cat": "pass")"));
+  EXPECT_THAT(trace, HasSubstr(R"("changed": true, "nodes_before": 10, )"
+                               R"("nodes_after": 9)"));
+}
+
+TEST(PassProfileTest, FoldedStacks) {
+  std::vector<std::string> lines =
+      absl::StrSplit(MakeProfile().ToFoldedStacks(), '\n', absl::SkipEmpty());
+  EXPECT_THAT(lines, Each(MatchesRegex(
+                         "top(;dce|;invariant_checkers)? [1-9][0-9]*")));
+  EXPECT_THAT(lines, Each(Not(HasSubstr("top;top"))));
+}
+
+}  // namespace
+}  // namespace xls
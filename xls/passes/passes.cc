@@ -14,21 +14,176 @@
 
 #include "xls/passes/passes.h"
 
+#include <algorithm>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/passes/analysis_manager.h"
 
 namespace xls {
+namespace {
+
+// Returns the functions invoked, mapped or used as loop bodies by "f".
+absl::flat_hash_set<Function*> CalledFunctions(Function* f) {
+  absl::flat_hash_set<Function*> called;
+  for (Node* node : f->nodes()) {
+    if (node->Is<Invoke>()) {
+      called.insert(node->As<Invoke>()->to_apply());
+    } else if (node->Is<Map>()) {
+      called.insert(node->As<Map>()->to_apply());
+    } else if (node->Is<CountedFor>()) {
+      called.insert(node->As<CountedFor>()->body());
+    }
+  }
+  return called;
+}
+
+}  // namespace
 
 xabsl::StatusOr<bool> FunctionPass::Run(Package* p, const PassOptions& options,
                                         PassResults* results) const {
+  if (options.function_threads > 1 && IsFunctionLocal() &&
+      p->functions().size() > 1) {
+    return RunInParallel(p, options, results);
+  }
   bool changed = false;
   for (auto& f : p->functions()) {
     XLS_ASSIGN_OR_RETURN(bool function_changed,
                          RunOnFunction(f.get(), options, results));
+    if (function_changed && options.analysis_manager != nullptr) {
+      options.analysis_manager->Invalidate(f.get());
+    }
     changed |= function_changed;
   }
   return changed;
 }
 
+xabsl::StatusOr<bool> FunctionPass::RunInParallel(Package* p,
+                                                  const PassOptions& options,
+                                                  PassResults* results) const {
+  absl::Span<std::unique_ptr<Function>> functions = p->functions();
+  const int64 function_count = functions.size();
+  const int64 first_new_id = p->next_node_id();
+
+  // A pass may inspect the functions called by the function it runs on, so a
+  // function and its callees must not run concurrently. Process each such
+  // pair in package order so that every function sees the same callees as in
+  // a serial run.
+  absl::flat_hash_map<Function*, int64> function_index;
+  for (int64 i = 0; i < function_count; ++i) {
+    function_index[functions[i].get()] = i;
+  }
+  std::vector<std::vector<int64>> successors(function_count);
+  std::vector<int64> pending_predecessors(function_count, 0);
+  for (int64 i = 0; i < function_count; ++i) {
+    for (Function* callee : CalledFunctions(functions[i].get())) {
+      auto it = function_index.find(callee);
+      if (it == function_index.end() || it->second == i) {
+        continue;
+      }
+      int64 first = std::min(i, it->second);
+      int64 second = std::max(i, it->second);
+      successors[first].push_back(second);
+      ++pending_predecessors[second];
+    }
+  }
+
+  absl::Mutex mutex;
+  absl::CondVar function_finished;
+  // Functions which may run, lowest index first.
+  std::set<int64> ready;
+  for (int64 i = 0; i < function_count; ++i) {
+    if (pending_predecessors[i] == 0) {
+      ready.insert(i);
+    }
+  }
+  int64 unfinished_count = function_count;
+  // Index of the first function which failed. Functions after it are skipped
+  // as a serial run would not reach them; functions before it still run so
+  // that the error returned is the one a serial run would return.
+  int64 first_failure = function_count;
+
+  std::vector<xabsl::StatusOr<bool>> function_changed(function_count);
+  std::vector<PassResults> function_results(function_count);
+  auto work = [&]() {
+    while (true) {
+      int64 i;
+      bool skip;
+      {
+        absl::MutexLock lock(&mutex);
+        while (ready.empty() && unfinished_count > 0) {
+          function_finished.Wait(&mutex);
+        }
+        if (ready.empty()) {
+          return;
+        }
+        i = *ready.begin();
+        ready.erase(ready.begin());
+        skip = i > first_failure;
+      }
+      if (!skip) {
+        function_changed[i] =
+            RunOnFunction(functions[i].get(), options, &function_results[i]);
+      }
+      {
+        absl::MutexLock lock(&mutex);
+        if (!skip && !function_changed[i].ok()) {
+          first_failure = std::min(first_failure, i);
+        }
+        --unfinished_count;
+        for (int64 successor : successors[i]) {
+          if (--pending_predecessors[successor] == 0) {
+            ready.insert(successor);
+          }
+        }
+      }
+      function_finished.SignalAll();
+    }
+  };
+  std::vector<std::thread> threads;
+  int64 thread_count = std::min(options.function_threads, function_count);
+  for (int64 i = 1; i < thread_count; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Nodes get their ids in the order in which the threads create them.
+  // Renumber the new nodes in function order to make the ids deterministic.
+  int64 next_id = first_new_id;
+  for (auto& f : functions) {
+    for (Node* node : f->nodes()) {
+      if (node->id() >= first_new_id) {
+        node->set_id(next_id++);
+      }
+    }
+  }
+  p->set_next_node_id(next_id);
+
+  bool changed = false;
+  for (int64 i = 0; i < function_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(bool changed_function, function_changed[i]);
+    results->invocations.insert(results->invocations.end(),
+                                function_results[i].invocations.begin(),
+                                function_results[i].invocations.end());
+    if (changed_function && options.analysis_manager != nullptr) {
+      options.analysis_manager->Invalidate(functions[i].get());
+    }
+    changed |= changed_function;
+  }
+  return changed;
+}
+
 }  // namespace xls
@@ -50,9 +50,28 @@ class FunctionPass : public Pass {
                                               const PassOptions& options,
                                               PassResults* results) const = 0;
 
-  // Iterates over each function in the package calling RunOnFunction.
+  // Returns whether RunOnFunction only modifies the function it is given (and
+  // the types of the package), and only inspects that function and the
+  // functions it calls. Such passes may run on several functions of a package
+  // at once.
+  virtual bool IsFunctionLocal() const { return true; }
+
+  // Iterates over each function in the package calling RunOnFunction. Cached
+  // analyses of the functions which RunOnFunction changes are invalidated.
+  //
+  // If options.function_threads is greater than one and the pass is function
+  // local, functions are processed in parallel, except that a function and
+  // the functions it calls are processed in package order as in a serial run.
+  // The ids of the nodes created by the pass are then renumbered in function
+  // order so that the result does not depend on thread scheduling, and the
+  // invocations which RunOnFunction records in "results" are appended in
+  // function order.
   xabsl::StatusOr<bool> Run(Package* p, const PassOptions& options,
                             PassResults* results) const override;
+
+ private:
+  xabsl::StatusOr<bool> RunInParallel(Package* p, const PassOptions& options,
+                                      PassResults* results) const;
 };
 
 }  // namespace xls
@@ -14,9 +14,18 @@
 
 #include "xls/passes/passes.h"
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "xls/common/casts.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
@@ -28,6 +37,11 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
+#include "xls/passes/arith_simplification_pass.h"
+#include "xls/passes/constant_folding_pass.h"
+#include "xls/passes/cse_pass.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/inlining_pass.h"
 
 namespace xls {
 namespace {
@@ -395,5 +409,191 @@ TEST(PassesTest, RunOnlyAndSkipPassesOption) {
   }
 }
 
+TEST(PassesTest, ProfileRecordsNodeCountsAndIterations) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+  int64 node_count = p->GetNodeCount();
+  CompoundPass top("top", "Top level pass manager");
+  auto fixed_point = top.Add<FixedPointCompoundPass>("fp", "Fixed point");
+  fixed_point->Add<DeadCodeEliminationPass>();
+  top.AddInvariantChecker<PackageNameChecker>("bar");
+  PassResults results;
+  EXPECT_THAT(top.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+
+  // DCE removes the dead code on the first iteration of the fixed point pass,
+  // and changes nothing on the second.
+  ASSERT_EQ(results.invocations.size(), 2);
+  EXPECT_EQ(results.invocations[0].nodes_before, node_count);
+  EXPECT_EQ(results.invocations[0].nodes_after, p->GetNodeCount());
+  EXPECT_LT(p->GetNodeCount(), node_count);
+  EXPECT_EQ(results.invocations[1].nodes_before, p->GetNodeCount());
+  EXPECT_EQ(results.invocations[1].nodes_after, p->GetNodeCount());
+
+  std::vector<std::string> spans;
+  for (int64 i = 0; i < results.profile.spans().size(); ++i) {
+    spans.push_back(results.profile.SpanPath(i, "/"));
+  }
+  EXPECT_THAT(
+      spans,
+      ElementsAre("top", "top/invariant_checkers", "top/fp",
+                  "top/fp/invariant_checkers", "top/fp/dce",
+                  "top/fp/invariant_checkers", "top/fp/invariant_checkers",
+                  "top/fp/dce", "top/fp/invariant_checkers",
+                  "top/invariant_checkers"));
+  EXPECT_EQ(results.profile.spans()[0].iterations, 1);
+  EXPECT_EQ(results.profile.spans()[2].iterations, 2);
+}
+
+// Returns a package of "chain_count" independent chains of "chain_length"
+// functions, in which each function invokes the previous one of its chain,
+// and a function "main" which invokes the last function of every chain. Every
+// function has something for constant folding, arithmetic simplification and
+// CSE to do.
+std::string MakeCallChainsPackage(int64 chain_count, int64 chain_length) {
+  std::string ir = "package call_chains\n";
+  std::vector<std::string> chain_calls;
+  for (int64 c = 0; c < chain_count; ++c) {
+    absl::StrAppendFormat(&ir, R"(
+fn c%d_f0(x: bits[8]) -> bits[8] {
+  ret result: bits[8] = neg(x)
+}
+)",
+                          c);
+    for (int64 i = 1; i < chain_length; ++i) {
+      absl::StrAppendFormat(&ir, R"(
+fn c%d_f%d(x: bits[8]) -> bits[8] {
+  zero: bits[8] = literal(value=0)
+  three: bits[8] = literal(value=3)
+  x_plus_zero: bits[8] = add(x, zero)
+  call: bits[8] = invoke(three, to_apply=c%d_f%d)
+  a: bits[8] = and(x_plus_zero, call)
+  b: bits[8] = and(x_plus_zero, call)
+  ret result: bits[8] = or(a, b)
+}
+)",
+                            c, i, c, i - 1);
+    }
+    chain_calls.push_back(
+        absl::StrFormat("  call%d: bits[8] = invoke(x, to_apply=c%d_f%d)\n",
+                        c, c, chain_length - 1));
+  }
+  absl::StrAppend(&ir, "\nfn main(x: bits[8]) -> bits[8] {\n",
+                  absl::StrJoin(chain_calls, ""),
+                  "  ret result: bits[8] = xor(");
+  for (int64 c = 0; c < chain_count; ++c) {
+    absl::StrAppendFormat(&ir, "%scall%d", c == 0 ? "" : ", ", c);
+  }
+  absl::StrAppend(&ir, ")\n}\n");
+  return ir;
+}
+
+// Function pass which records the largest number of functions it was ever
+// running on at once. Each run sleeps briefly so that runs which can overlap
+// do.
+class OverlapRecordingPass : public FunctionPass {
+ public:
+  OverlapRecordingPass(std::atomic<int64>* active, std::atomic<int64>* peak)
+      : FunctionPass("overlap", "Records overlapping runs"),
+        active_(active),
+        peak_(peak) {}
+
+  xabsl::StatusOr<bool> RunOnFunction(Function* f, const PassOptions& options,
+                                      PassResults* results) const override {
+    int64 active = ++*active_;
+    int64 peak = peak_->load();
+    while (peak < active && !peak_->compare_exchange_weak(peak, active)) {
+    }
+    absl::SleepFor(absl::Milliseconds(10));
+    --*active_;
+    return false;
+  }
+
+ private:
+  std::atomic<int64>* active_;
+  std::atomic<int64>* peak_;
+};
+
+std::unique_ptr<CompoundPass> MakeFunctionPassPipeline(
+    std::atomic<int64>* active, std::atomic<int64>* peak) {
+  auto top = absl::make_unique<CompoundPass>("top", "Top level pass manager");
+  top->Add<OverlapRecordingPass>(active, peak);
+  auto simp = top->Add<FixedPointCompoundPass>("simp", "Simplification");
+  simp->Add<ConstantFoldingPass>();
+  simp->Add<ArithSimplificationPass>();
+  simp->Add<CsePass>();
+  simp->Add<DeadCodeEliminationPass>();
+  top->Add<InliningPass>();
+  top->Add<DeadCodeEliminationPass>();
+  return top;
+}
+
+TEST(PassesTest, FunctionPassesInParallel) {
+  std::vector<std::string> optimized_ir;
+  std::vector<std::vector<std::pair<std::string, bool>>> invocations;
+  for (int64 threads : {1, 2, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Package> p,
+        Parser::ParsePackage(MakeCallChainsPackage(/*chain_count=*/4,
+                                                   /*chain_length=*/4)));
+    PassOptions options;
+    options.function_threads = threads;
+    PassResults results;
+    std::atomic<int64> active(0);
+    std::atomic<int64> peak(0);
+    EXPECT_THAT(MakeFunctionPassPipeline(&active, &peak)
+                    ->Run(p.get(), options, &results),
+                IsOkAndHolds(true));
+    // The chains are independent, so with more than one thread functions of
+    // different chains are processed at the same time.
+    if (threads == 1) {
+      EXPECT_EQ(peak.load(), 1);
+    } else {
+      EXPECT_GT(peak.load(), 1) << threads << " threads";
+    }
+    optimized_ir.push_back(p->DumpIr());
+    invocations.emplace_back();
+    for (const PassInvocation& invocation : results.invocations) {
+      invocations.back().push_back(
+          {invocation.pass_name, invocation.ir_changed});
+    }
+  }
+  // Callees are simplified before their callers fold invocations of them, as
+  // in a serial run, so the results are the same.
+  EXPECT_EQ(optimized_ir[0], optimized_ir[1]);
+  EXPECT_EQ(optimized_ir[1], optimized_ir[2]);
+  EXPECT_EQ(invocations[0], invocations[1]);
+  EXPECT_EQ(invocations[1], invocations[2]);
+}
+
+// Function pass which fails on functions whose name starts with "bad".
+class FailingFunctionPass : public FunctionPass {
+ public:
+  FailingFunctionPass() : FunctionPass("failing", "Fails on bad functions") {}
+
+  xabsl::StatusOr<bool> RunOnFunction(Function* f, const PassOptions& options,
+                                      PassResults* results) const override {
+    if (absl::StartsWith(f->name(), "bad")) {
+      return absl::InternalError(absl::StrCat("Bad function ", f->name()));
+    }
+    return false;
+  }
+};
+
+TEST(PassesTest, FunctionPassesInParallelReturnFirstError) {
+  std::string ir = "package bad\n";
+  for (absl::string_view name : {"good0", "good1", "bad0", "good2", "bad1"}) {
+    absl::StrAppendFormat(
+        &ir, "fn %s(x: bits[8]) -> bits[8] {\n  ret y: bits[8] = neg(x)\n}\n",
+        name);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(ir));
+  PassOptions options;
+  options.function_threads = 4;
+  PassResults results;
+  EXPECT_THAT(FailingFunctionPass().Run(p.get(), options, &results),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Bad function bad0")));
+}
+
 }  // namespace
 }  // namespace xls
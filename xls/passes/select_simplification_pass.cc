@@ -31,6 +31,7 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
@@ -975,8 +976,10 @@ xabsl::StatusOr<bool> SelectSimplificationPass::RunOnFunction(
   XLS_VLOG(3) << "Before:";
   XLS_VLOG_LINES(3, func->DumpIr());
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<TernaryQueryEngine> query_engine,
-                       TernaryQueryEngine::Run(func));
+  AnalysisManager local_analyses;
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * query_engine,
+                       GetAnalysisManager(options, &local_analyses)
+                           ->GetTernaryQueryEngine(func));
   bool changed = false;
   for (Node* node : TopoSort(func)) {
     XLS_ASSIGN_OR_RETURN(bool node_changed,
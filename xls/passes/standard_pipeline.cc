@@ -17,6 +17,7 @@
 
 #include "xls/passes/standard_pipeline.h"
 
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/arith_simplification_pass.h"
 #include "xls/passes/array_simplification_pass.h"
 #include "xls/passes/bdd_cse_pass.h"
@@ -109,8 +110,11 @@ std::unique_ptr<CompoundPass> CreateStandardPassPipeline() {
 
 xabsl::StatusOr<bool> RunStandardPassPipeline(Package* package) {
   std::unique_ptr<CompoundPass> pipeline = CreateStandardPassPipeline();
+  AnalysisManager analysis_manager;
+  PassOptions options;
+  options.analysis_manager = &analysis_manager;
   PassResults results;
-  return pipeline->Run(package, PassOptions(), &results);
+  return pipeline->Run(package, options, &results);
 }
 
 std::unique_ptr<SchedulingCompoundPass> CreateStandardSchedulingPassPipeline() {
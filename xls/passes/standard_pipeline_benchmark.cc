@@ -0,0 +1,136 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the run time of the standard optimization pipeline on the
+// unoptimized IR of sample packages with and without shared analyses.
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
+#include "xls/common/logging/log_lines.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/package.h"
+#include "xls/passes/analysis_manager.h"
+#include "xls/passes/passes.h"
+#include "xls/passes/standard_pipeline.h"
+
+const char* kUsage = R"(
+Measures the run time of the standard optimization pipeline on sample packages
+in three configurations: without an analysis manager (every pass builds its own
+analyses), with an analysis manager which rebuilds analyses after every change,
+and with an analysis manager whose ternary query engine updates incrementally.
+Usage:
+
+   standard_pipeline_benchmark --benchmarks=sha256
+)";
+
+ABSL_FLAG(std::vector<std::string>, benchmarks, {"sha256"},
+          "Comma-separated list of sample packages to optimize, or \"all\".");
+ABSL_FLAG(int64, runs, 3,
+          "Number of times to run each configuration; the fastest run is "
+          "reported.");
+
+namespace xls {
+namespace {
+
+enum class AnalysisMode { kNone, kCached, kIncremental };
+
+// Optimizes a fresh copy of the package "name" and returns the optimized IR and
+// (via "duration") the time taken by the pipeline.
+xabsl::StatusOr<std::string> Optimize(const std::string& name,
+                                      AnalysisMode mode,
+                                      absl::Duration* duration) {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      sample_packages::GetBenchmark(name, /*optimized=*/false));
+  std::unique_ptr<CompoundPass> pipeline = CreateStandardPassPipeline();
+  AnalysisManager analysis_manager(
+      /*incremental=*/mode == AnalysisMode::kIncremental);
+  PassOptions options;
+  if (mode != AnalysisMode::kNone) {
+    options.analysis_manager = &analysis_manager;
+  }
+  PassResults results;
+  absl::Time start = absl::Now();
+  XLS_RETURN_IF_ERROR(pipeline->Run(package.get(), options, &results).status());
+  *duration = absl::Now() - start;
+  XLS_VLOG_LINES(1, analysis_manager.StatsToString());
+  return package->DumpIr();
+}
+
+absl::Status RunBenchmark(const std::string& name) {
+  std::vector<absl::Duration> best_times;
+  std::vector<std::string> optimized_ir;
+  for (AnalysisMode mode : {AnalysisMode::kNone, AnalysisMode::kCached,
+                            AnalysisMode::kIncremental}) {
+    absl::Duration best = absl::InfiniteDuration();
+    std::string ir;
+    for (int64 i = 0; i < absl::GetFlag(FLAGS_runs); ++i) {
+      absl::Duration duration;
+      XLS_ASSIGN_OR_RETURN(ir, Optimize(name, mode, &duration));
+      best = std::min(best, duration);
+    }
+    best_times.push_back(best);
+    optimized_ir.push_back(ir);
+  }
+  std::cout << absl::StreamFormat(
+      "%-40s %14s %14s %14s %8.2fx %s\n", name,
+      absl::FormatDuration(best_times[0]), absl::FormatDuration(best_times[1]),
+      absl::FormatDuration(best_times[2]),
+      absl::FDivDuration(best_times[0], best_times[2]),
+      optimized_ir[0] == optimized_ir[1] && optimized_ir[0] == optimized_ir[2]
+          ? "same"
+          : "different");
+  return absl::OkStatus();
+}
+
+absl::Status RealMain() {
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_runs), 0);
+  std::vector<std::string> names = absl::GetFlag(FLAGS_benchmarks);
+  if (names.size() == 1 && names.front() == "all") {
+    XLS_ASSIGN_OR_RETURN(names, sample_packages::GetBenchmarkNames());
+  }
+  std::cout << absl::StreamFormat("%-40s %14s %14s %14s %9s %s\n", "benchmark",
+                                  "no analyses", "cached",
+                                  "incremental", "speedup", "output");
+  for (const std::string& name : names) {
+    XLS_RETURN_IF_ERROR(RunBenchmark(name));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+  XLS_QCHECK_OK(xls::RealMain());
+  return EXIT_SUCCESS;
+}
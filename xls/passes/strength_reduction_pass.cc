@@ -23,6 +23,7 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/query_engine.h"
 #include "xls/passes/ternary_query_engine.h"
 
@@ -362,8 +363,10 @@ xabsl::StatusOr<bool> StrengthReduceNode(
 
 xabsl::StatusOr<bool> StrengthReductionPass::RunOnFunction(
     Function* f, const PassOptions& options, PassResults* results) const {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<TernaryQueryEngine> query_engine,
-                       TernaryQueryEngine::Run(f));
+  AnalysisManager local_analyses;
+  XLS_ASSIGN_OR_RETURN(
+      TernaryQueryEngine * query_engine,
+      GetAnalysisManager(options, &local_analyses)->GetTernaryQueryEngine(f));
   XLS_ASSIGN_OR_RETURN(absl::flat_hash_set<Node*> reducible_adds,
                        FindReducibleAdds(f, *query_engine));
   // Note: because we introduce new nodes into the graph that were not present
@@ -14,9 +14,13 @@
 
 #include "xls/passes/ternary_query_engine.h"
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/data_structures/leaf_type_tree.h"
@@ -27,6 +31,15 @@
 #include "xls/passes/ternary_evaluator.h"
 
 namespace xls {
+namespace {
+
+// Returns a vector of unknown values of the width of the bits-typed "node".
+TernaryEvaluator::Vector UnknownVector(Node* node) {
+  return TernaryEvaluator::Vector(node->BitCountOrDie(),
+                                  TernaryValue::kUnknown);
+}
+
+}  // namespace
 
 Bits TernaryVectorToKnownBits(const TernaryEvaluator::Vector& ternary_vector) {
   // Use InlinedVector to avoid std::vector<bool> specialization madness.
@@ -50,40 +63,132 @@ Bits TernaryVectorToValueBits(const TernaryEvaluator::Vector& ternary_vector) {
 /* static */
 xabsl::StatusOr<std::unique_ptr<TernaryQueryEngine>> TernaryQueryEngine::Run(
     Function* f) {
-  TernaryEvaluator evaluator;
-  absl::flat_hash_map<Node*, TernaryEvaluator::Vector> values;
+  auto engine = absl::WrapUnique(new TernaryQueryEngine());
   for (Node* node : TopoSort(f)) {
-    if (!node->GetType()->IsBits()) {
-      continue;
+    // TODO(meheff): Handle types other than bits.
+    if (node->GetType()->IsBits()) {
+      XLS_ASSIGN_OR_RETURN(TernaryEvaluator::Vector value,
+                           engine->EvaluateNode(node));
+      engine->SetValue(node, std::move(value));
     }
-    auto create_unknown_vector = [](Node* n) {
-      return TernaryEvaluator::Vector(n->BitCountOrDie(),
-                                      TernaryValue::kUnknown);
-    };
-    if (std::any_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return !o->GetType()->IsBits(); })) {
-      values[node] = create_unknown_vector(node);
-      continue;
+  }
+  return std::move(engine);
+}
+
+/* static */
+xabsl::StatusOr<std::unique_ptr<TernaryQueryEngine>>
+TernaryQueryEngine::RunIncremental(Function* f) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<TernaryQueryEngine> engine, Run(f));
+  engine->function_ = f;
+  f->RegisterChangeListener(engine.get());
+  return std::move(engine);
+}
+
+TernaryQueryEngine::~TernaryQueryEngine() {
+  if (function_ != nullptr) {
+    function_->UnregisterChangeListener(this);
+  }
+}
+
+xabsl::StatusOr<TernaryEvaluator::Vector> TernaryQueryEngine::EvaluateNode(
+    Node* node) const {
+  if (std::any_of(node->operands().begin(), node->operands().end(),
+                  [](Node* o) { return !o->GetType()->IsBits(); })) {
+    return UnknownVector(node);
+  }
+  std::vector<TernaryEvaluator::Vector> operand_values;
+  operand_values.reserve(node->operand_count());
+  for (Node* operand : node->operands()) {
+    operand_values.push_back(values_.at(operand));
+  }
+  TernaryEvaluator evaluator;
+  return AbstractEvaluate(node, operand_values, &evaluator,
+                          /*default_handler=*/UnknownVector);
+}
+
+bool TernaryQueryEngine::SetValue(Node* node,
+                                  TernaryEvaluator::Vector value) const {
+  auto it = values_.find(node);
+  if (it != values_.end() && it->second == value) {
+    return false;
+  }
+  known_bits_[node] = TernaryVectorToKnownBits(value);
+  bits_values_[node] = TernaryVectorToValueBits(value);
+  values_[node] = std::move(value);
+  return true;
+}
+
+void TernaryQueryEngine::PropagateDirtyNodes() const {
+  // Gather the transitive fanout of the dirty nodes, and the number of
+  // distinct operands each has within it.
+  std::vector<Node*> worklist(dirty_.begin(), dirty_.end());
+  absl::flat_hash_map<Node*, int64> pending_operands;
+  for (Node* node : worklist) {
+    pending_operands[node] = 0;
+  }
+  for (int64 i = 0; i < worklist.size(); ++i) {
+    for (Node* user : worklist[i]->users()) {
+      if (pending_operands.emplace(user, 0).second) {
+        worklist.push_back(user);
+      }
     }
-    std::vector<TernaryEvaluator::Vector> operand_values;
-    for (Node* operand : node->operands()) {
-      operand_values.push_back(values.at(operand));
+  }
+  for (auto& pair : pending_operands) {
+    absl::InlinedVector<Node*, 4> counted;
+    for (Node* operand : pair.first->operands()) {
+      if (pending_operands.contains(operand) &&
+          !absl::c_linear_search(counted, operand)) {
+        counted.push_back(operand);
+        ++pair.second;
+      }
     }
-    XLS_ASSIGN_OR_RETURN(
-        values[node],
-        AbstractEvaluate(node, operand_values, &evaluator,
-                         /*default_handler=*/create_unknown_vector));
   }
 
-  auto engine = absl::make_unique<TernaryQueryEngine>();
-  for (Node* node : f->nodes()) {
-    // TODO(meheff): Handle types other than bits.
-    if (node->GetType()->IsBits()) {
-      engine->known_bits_[node] = TernaryVectorToKnownBits(values.at(node));
-      engine->bits_values_[node] = TernaryVectorToValueBits(values.at(node));
+  // Visit the fanout in topological order, re-evaluating dirty nodes and
+  // those with an operand whose value changed.
+  worklist.clear();
+  for (const auto& pair : pending_operands) {
+    if (pair.second == 0) {
+      worklist.push_back(pair.first);
     }
   }
-  return std::move(engine);
+  absl::flat_hash_set<Node*> changed;
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    bool evaluate =
+        dirty_.contains(node) ||
+        std::any_of(node->operands().begin(), node->operands().end(),
+                    [&](Node* o) { return changed.contains(o); });
+    if (evaluate && node->GetType()->IsBits()) {
+      ++incremental_evaluation_count_;
+      xabsl::StatusOr<TernaryEvaluator::Vector> value = EvaluateNode(node);
+      // Nothing is known about a node which cannot be evaluated.
+      if (SetValue(node, value.ok() ? std::move(value).value()
+                                    : UnknownVector(node))) {
+        changed.insert(node);
+      }
+    }
+    for (Node* user : node->users()) {
+      if (--pending_operands.at(user) == 0) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  dirty_.clear();
+}
+
+void TernaryQueryEngine::NodeAdded(Node* node) { dirty_.insert(node); }
+
+void TernaryQueryEngine::NodeDeleted(Node* node) {
+  dirty_.erase(node);
+  values_.erase(node);
+  known_bits_.erase(node);
+  bits_values_.erase(node);
+}
+
+void TernaryQueryEngine::OperandChanged(Node* node, Node* old_operand) {
+  dirty_.insert(node);
 }
 
 bool TernaryQueryEngine::AtMostOneTrue(
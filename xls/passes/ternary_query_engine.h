@@ -15,12 +15,16 @@
 #ifndef XLS_PASSES_TERNARY_QUERY_ENGINE_H_
 #define XLS_PASSES_TERNARY_QUERY_ENGINE_H_
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/types/optional.h"
 #include "xls/common/status/statusor.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/change_listener.h"
 #include "xls/ir/function.h"
 #include "xls/ir/nodes.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/ternary_evaluator.h"
 
 namespace xls {
 
@@ -29,18 +33,33 @@ namespace xls {
 // and can expose statically known bit values in the function (known 0 or 1),
 // but provides limited insight into relationships between bit values in the
 // function (implications, equality, etc).
-class TernaryQueryEngine : public QueryEngine {
+class TernaryQueryEngine : public QueryEngine, public ChangeListener {
  public:
+  // Evaluates "f". The results describe the function at the time of the call
+  // and nodes added later are not tracked.
   static xabsl::StatusOr<std::unique_ptr<TernaryQueryEngine>> Run(Function* f);
 
+  // As Run, but the engine keeps itself up to date as "f" changes: it listens
+  // to the changes of "f" and, when next queried, re-evaluates the changed
+  // nodes and those in their transitive fanout whose operand values changed.
+  // "f" must outlive the engine. References returned by GetKnownBits and
+  // GetKnownBitsValues are invalidated by changes to "f".
+  static xabsl::StatusOr<std::unique_ptr<TernaryQueryEngine>> RunIncremental(
+      Function* f);
+
+  ~TernaryQueryEngine() override;
+
   bool IsTracked(Node* node) const override {
+    Propagate();
     return known_bits_.contains(node);
   }
 
   const Bits& GetKnownBits(Node* node) const override {
+    Propagate();
     return known_bits_.at(node);
   }
   const Bits& GetKnownBitsValues(Node* node) const override {
+    Propagate();
     return bits_values_.at(node);
   }
 
@@ -60,14 +79,58 @@ class TernaryQueryEngine : public QueryEngine {
     return absl::nullopt;
   }
 
+  // Returns the number of node evaluations performed to bring the engine up
+  // to date with changes of the function (i.e., excluding the initial
+  // evaluation).
+  int64 incremental_evaluation_count() const {
+    return incremental_evaluation_count_;
+  }
+
+  // ChangeListener implementation, used by engines created with
+  // RunIncremental.
+  void NodeAdded(Node* node) override;
+  void NodeDeleted(Node* node) override;
+  void OperandChanged(Node* node, Node* old_operand) override;
+
  private:
+  TernaryQueryEngine() = default;
+
+  // Returns the ternary value of the bits-typed "node" given the values of its
+  // operands.
+  xabsl::StatusOr<TernaryEvaluator::Vector> EvaluateNode(Node* node) const;
+
+  // Records "value" as the value of "node". Returns true if it changed.
+  bool SetValue(Node* node, TernaryEvaluator::Vector value) const;
+
+  // Brings the engine up to date with the changes of the function. The query
+  // methods are const, but the results are held in mutable members so that
+  // they can be updated lazily.
+  void Propagate() const {
+    if (!dirty_.empty()) {
+      PropagateDirtyNodes();
+    }
+  }
+  void PropagateDirtyNodes() const;
+
+  // The function listened to by an incremental engine, or nullptr.
+  Function* function_ = nullptr;
+
+  // The ternary value of each bits-typed node.
+  mutable absl::flat_hash_map<Node*, TernaryEvaluator::Vector> values_;
+
   // Holds which bits values are known for nodes in the function. A one in a bit
   // position indications the respective bit value in the respective node is
   // statically known.
-  absl::flat_hash_map<Node*, Bits> known_bits_;
+  mutable absl::flat_hash_map<Node*, Bits> known_bits_;
 
   // Holds the values of statically known bits of nodes in the function.
-  absl::flat_hash_map<Node*, Bits> bits_values_;
+  mutable absl::flat_hash_map<Node*, Bits> bits_values_;
+
+  // Nodes which were added or whose operands changed since they were last
+  // evaluated.
+  mutable absl::flat_hash_set<Node*> dirty_;
+
+  mutable int64 incremental_evaluation_count_ = 0;
 };
 
 }  // namespace xls
@@ -129,5 +129,45 @@ TEST_F(TernaryQueryEngineTest, Ne) {
   EXPECT_THAT(RunOnBinaryOp("0b011", "0b011", make_ne), IsOkAndHolds("0b0"));
 }
 
+TEST_F(TernaryQueryEngineTest, Incremental) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(x: bits[8], y: bits[8]) -> bits[8] {
+       literal.3: bits[8] = literal(value=0xf0)
+       literal.4: bits[8] = literal(value=0x0f)
+       and.5: bits[8] = and(x, literal.3)
+       neg.6: bits[8] = neg(y)
+       ret or.7: bits[8] = or(and.5, neg.6)
+     }
+  )",
+                                                       p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TernaryQueryEngine> engine,
+                           TernaryQueryEngine::RunIncremental(f));
+  Node* and_node = FindNode("and.5", f);
+  EXPECT_EQ(engine->ToString(and_node), "0bXXXX_0000");
+
+  // Changing the mask re-evaluates the and and its user, but not the neg.
+  XLS_ASSERT_OK(and_node->ReplaceOperandNumber(1, FindNode("literal.4", f)));
+  EXPECT_EQ(engine->ToString(and_node), "0b0000_XXXX");
+  EXPECT_EQ(engine->incremental_evaluation_count(), 2);
+
+  // New nodes are tracked, and deleted nodes are forgotten.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * masked,
+      f->MakeNode<NaryOp>(
+          and_node->loc(),
+          std::vector<Node*>{and_node, FindNode("literal.3", f)}, Op::kAnd));
+  EXPECT_EQ(engine->ToString(masked), "0b0000_0000");
+  XLS_ASSERT_OK(f->RemoveNode(masked));
+  EXPECT_FALSE(engine->IsTracked(masked));
+
+  // The result matches evaluating the function from scratch.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TernaryQueryEngine> fresh,
+                           TernaryQueryEngine::Run(f));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(engine->ToString(node), fresh->ToString(node)) << node;
+  }
+}
+
 }  // namespace
 }  // namespace xls
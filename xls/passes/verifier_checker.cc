@@ -14,13 +14,29 @@
 
 #include "xls/passes/verifier_checker.h"
 
+#include "xls/common/status/status_macros.h"
 #include "xls/ir/verifier.h"
 
 namespace xls {
 
 absl::Status VerifierChecker::Run(Package* p, const PassOptions& options,
                                   PassResults* results) const {
-  return Verify(p);
+  int64 run = run_count_++;
+  if (options.full_verify_period == 0 ||
+      (options.full_verify_period > 1 &&
+       (run + 1) % options.full_verify_period != 0)) {
+    return VerifyIncremental(p);
+  }
+  XLS_RETURN_IF_ERROR(Verify(p));
+  if (options.full_verify_period != 1) {
+    // Everything is verified, so the next incremental run only needs the
+    // changes from here on. With a period of one nothing reads the dirty
+    // nodes, so they aren't tracked.
+    for (auto& function : p->functions()) {
+      function->StartTrackingDirtyNodes();
+    }
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace xls
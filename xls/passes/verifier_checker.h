@@ -15,16 +15,23 @@
 #ifndef XLS_PASSES_VERIFIER_CHECKER_H_
 #define XLS_PASSES_VERIFIER_CHECKER_H_
 
+#include <atomic>
+
 #include "absl/status/status.h"
+#include "xls/common/integral_types.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
 
-// Invariant checker which just runs xls::Verifier.
+// Invariant checker which runs xls::Verify, or xls::VerifyIncremental on the
+// runs selected by PassOptions::full_verify_period.
 class VerifierChecker : public InvariantChecker {
  public:
   absl::Status Run(Package* p, const PassOptions& options,
                    PassResults* results) const override;
+
+ private:
+  mutable std::atomic<int64> run_count_{0};
 };
 
 }  // namespace xls
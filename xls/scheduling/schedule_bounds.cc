@@ -25,7 +25,9 @@ namespace sched {
 
 ScheduleBounds::ScheduleBounds(Function* f, int64 clock_period_ps,
                                const DelayEstimator& delay_estimator)
-    : clock_period_ps_(clock_period_ps), delay_estimator_(&delay_estimator) {
+    : clock_period_ps_(clock_period_ps),
+      delay_estimator_(&delay_estimator),
+      bounds_(f) {
   auto topo_sort_it = TopoSort(f);
   topo_sort_ = std::vector<Node*>(topo_sort_it.begin(), topo_sort_it.end());
   Reset();
@@ -36,7 +38,8 @@ ScheduleBounds::ScheduleBounds(Function* f, std::vector<Node*> topo_sort,
                                const DelayEstimator& delay_estimator)
     : topo_sort_(std::move(topo_sort)),
       clock_period_ps_(clock_period_ps),
-      delay_estimator_(&delay_estimator) {
+      delay_estimator_(&delay_estimator),
+      bounds_(f) {
   Reset();
 }
 
@@ -57,13 +60,9 @@ void ScheduleBounds::Reset() {
 
 std::string ScheduleBounds::ToString() const {
   std::string out = "Bounds:\n";
-  if (!bounds_.empty()) {
-    for (Node* node : TopoSort(bounds_.begin()->first->function())) {
-      if (bounds_.contains(node)) {
-        absl::StrAppendFormat(&out, "  %s : [%d, %d]\n", node->GetName(),
-                              lb(node), ub(node));
-      }
-    }
+  for (Node* node : topo_sort_) {
+    absl::StrAppendFormat(&out, "  %s : [%d, %d]\n", node->GetName(), lb(node),
+                          ub(node));
   }
   return out;
 }
@@ -72,7 +71,7 @@ absl::Status ScheduleBounds::PropagateLowerBounds() {
   XLS_VLOG(4) << "PropagateLowerBounds()";
   // The delay in picoseconds from the beginning of a cycle to the start of the
   // node.
-  absl::flat_hash_map<Node*, int64> in_cycle_delay;
+  NodeMap<int64> in_cycle_delay(bounds_.function());
 
   // Compute the lower bound of each node based on the lower bounds of the
   // operands of the node.
@@ -115,7 +114,7 @@ absl::Status ScheduleBounds::PropagateLowerBounds() {
 absl::Status ScheduleBounds::PropagateUpperBounds() {
   XLS_VLOG(4) << "PropagateUpperBounds()";
   // The delay in picoseconds from the end of a cycle to the end of the node.
-  absl::flat_hash_map<Node*, int64> in_cycle_delay;
+  NodeMap<int64> in_cycle_delay(bounds_.function());
 
   // Compute the upper bound of each node based on the upper bounds of the
   // users of the node.
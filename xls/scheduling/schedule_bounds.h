@@ -18,7 +18,6 @@
 #include <limits>
 #include <utility>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "xls/common/integral_types.h"
@@ -28,6 +27,7 @@
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
+#include "xls/ir/node_map.h"
 
 namespace xls {
 namespace sched {
@@ -117,7 +117,7 @@ class ScheduleBounds {
   const DelayEstimator* delay_estimator_;
 
   // The bounds of each node stored as a {lower, upper} pair.
-  absl::flat_hash_map<Node*, std::pair<int64, int64>> bounds_;
+  NodeMap<std::pair<int64, int64>> bounds_;
 
   int64 max_lower_bound_;
   int64 min_upper_bound_;
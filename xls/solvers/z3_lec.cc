@@ -355,7 +355,7 @@ absl::flat_hash_map<std::string, Z3_ast> Lec::FlattenNetlistInputs() {
 
       // Then plop its output in.
       for (const auto& output : status_or_cell.value()->outputs()) {
-        netlist_inputs[output.netref->name()] = bits[i];
+        netlist_inputs[std::string(output.netref->name())] = bits[i];
       }
     }
   }
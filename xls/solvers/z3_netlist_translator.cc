@@ -70,8 +70,9 @@ absl::Status NetlistTranslator::Init() {
   // Create a symbolic constant for each module input and make it available for
   // downstream nodes.
   for (const NetRef& input : module_->inputs()) {
+    std::string name(input->name());
     translated_[input] =
-        Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, input->name().c_str()),
+        Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, name.c_str()),
                     Z3_mk_bv_sort(ctx_, 1));
   }
 
@@ -237,13 +238,13 @@ absl::Status NetlistTranslator::TranslateCell(const Cell& cell) {
       XLS_ASSIGN_OR_RETURN(state_table_values, TranslateStateTable(cell));
     }
 
-    const CellLibraryEntry::OutputPinToFunction& pins =
-        entry->output_pin_to_function();
     for (const auto& output : cell.outputs()) {
-      XLS_ASSIGN_OR_RETURN(Ast ast, netlist::function::Parser::ParseFunction(
-                                        pins.at(output.name)));
-      XLS_ASSIGN_OR_RETURN(Z3_ast result,
-                           TranslateFunction(cell, ast, state_table_values));
+      XLS_ASSIGN_OR_RETURN(
+          const CellLibraryEntry::OutputPinFunction* function,
+          entry->GetOutputPinFunction(output.name));
+      XLS_ASSIGN_OR_RETURN(
+          Z3_ast result,
+          TranslateFunction(cell, function->ast, state_table_values));
       translated_[output.netref] = result;
     }
   }
@@ -253,7 +254,7 @@ absl::Status NetlistTranslator::TranslateCell(const Cell& cell) {
 
 // After all the above, this is the spot where any _ACTUAL_ translation happens.
 xabsl::StatusOr<Z3_ast> NetlistTranslator::TranslateFunction(
-    const Cell& cell, netlist::function::Ast ast,
+    const Cell& cell, const netlist::function::Ast& ast,
     const absl::flat_hash_map<std::string, Z3_ast>& state_table_values) {
   switch (ast.kind()) {
     case Ast::Kind::kAnd: {
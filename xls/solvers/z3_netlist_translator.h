@@ -88,7 +88,7 @@ class NetlistTranslator {
   absl::Status Translate();
   absl::Status TranslateCell(const netlist::rtl::Cell& cell);
   xabsl::StatusOr<Z3_ast> TranslateFunction(
-      const netlist::rtl::Cell& cell, const netlist::function::Ast ast,
+      const netlist::rtl::Cell& cell, const netlist::function::Ast& ast,
       const absl::flat_hash_map<std::string, Z3_ast>& state_table_values);
   xabsl::StatusOr<absl::flat_hash_map<std::string, Z3_ast>> TranslateStateTable(
       const netlist::rtl::Cell& cell);
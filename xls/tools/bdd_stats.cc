@@ -12,9 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <sys/resource.h>
+
+#include <algorithm>
 #include <limits>
 
 #include "absl/status/status.h"
+#include "absl/strings/str_format.h"
 #include "absl/time/clock.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
@@ -22,6 +26,7 @@
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/status/statusor.h"
+#include "xls/data_structures/binary_decision_diagram.h"
 #include "xls/examples/sample_packages.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
@@ -102,10 +107,20 @@ absl::Status RealMain(absl::string_view input_path) {
         BddFunction::Run(entry, absl::GetFlag(FLAGS_bdd_minterm_limit)));
     absl::Duration bdd_time = absl::Now() - start;
     total_time += bdd_time;
+    const BinaryDecisionDiagram& bdd = bdd_function->bdd();
     std::cout << "BDD construction time: " << bdd_time << "\n";
-    std::cout << "BDD node count: " << bdd_function->bdd().size() << "\n";
-    std::cout << "BDD variable count: " << bdd_function->bdd().variable_count()
+    std::cout << "BDD node count: " << bdd.size() << "\n";
+    std::cout << "BDD peak node count: " << bdd.peak_size() << "\n";
+    std::cout << "BDD variable count: " << bdd.variable_count() << "\n";
+    std::cout << "BDD garbage collections: " << bdd.garbage_collection_count()
               << "\n";
+    std::cout << absl::StreamFormat(
+        "BDD ITE cache hit rate: %.1f%% (%d lookups)\n",
+        bdd.ite_cache_lookups() == 0
+            ? 0.0
+            : 100.0 * bdd.ite_cache_hits() / bdd.ite_cache_lookups(),
+        bdd.ite_cache_lookups());
+    std::cout << "BDD memory usage (bytes): " << bdd.MemoryUsage() << "\n";
 
     int64 number_bits = 0;
     for (Node* node : entry->nodes()) {
@@ -114,9 +129,14 @@ absl::Status RealMain(absl::string_view input_path) {
     std::cout << "Bits in graph: " << number_bits << "\n";
 
     int64 max_minterms = 0;
-    for (int64 i = 0; i < bdd_function->bdd().size(); ++i) {
-      max_minterms = std::max(
-          max_minterms, bdd_function->bdd().minterm_count(BddNodeIndex(i)));
+    for (Node* node : entry->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      for (int64 i = 0; i < node->BitCountOrDie(); ++i) {
+        max_minterms = std::max(
+            max_minterms, bdd.minterm_count(bdd_function->GetBddNode(node, i)));
+      }
     }
     if (max_minterms == std::numeric_limits<int32>::max()) {
       std::cout << "Maximum minterms of any expression: INT32_MAX\n";
@@ -129,6 +149,10 @@ absl::Status RealMain(absl::string_view input_path) {
   if (packages.size() > 1) {
     std::cout << "\nTotal construction time: " << total_time << "\n";
   }
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    std::cout << "Peak RSS (KiB): " << usage.ru_maxrss << "\n";
+  }
 
   return absl::OkStatus();
 }
@@ -14,6 +14,7 @@
 
 #include <numeric>
 
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
@@ -29,12 +30,13 @@
 #include "xls/delay_model/analyze_critical_path.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/delay_model/delay_estimators.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
 #include "xls/scheduling/pipeline_schedule.h"
+#include "xls/tools/ir_file.h"
 
 // TODO(meheff): These codegen flags are duplicated from codegen_main. Might be
 // easier to wrap all the options into a proto or something codegen_main and
@@ -62,6 +64,8 @@ ABSL_FLAG(std::string, entry, "",
           "Entry function to use in lieu of the default.");
 ABSL_FLAG(std::string, delay_model, "",
           "Delay model name to use from registry.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -100,9 +104,11 @@ absl::Status RunOptimizationAndPrintStats(Package* package) {
   std::unique_ptr<CompoundPass> pipeline = CreateStandardPassPipeline();
 
   absl::Time start = absl::Now();
+  AnalysisManager analysis_manager;
+  PassOptions options;
+  options.analysis_manager = &analysis_manager;
   PassResults pass_results;
-  XLS_RETURN_IF_ERROR(
-      pipeline->Run(package, PassOptions(), &pass_results).status());
+  XLS_RETURN_IF_ERROR(pipeline->Run(package, options, &pass_results).status());
   absl::Duration total_time = absl::Now() - start;
   auto to_ms = [](absl::Duration d) { return d / absl::Milliseconds(1); };
   std::cout << absl::StreamFormat("Optimization time: %dms\n",
@@ -115,10 +121,13 @@ absl::Status RunOptimizationAndPrintStats(Package* package) {
   absl::flat_hash_map<std::string, absl::Duration> pass_times;
   absl::flat_hash_map<std::string, int64> pass_counts;
   absl::flat_hash_map<std::string, int64> changed_counts;
+  absl::flat_hash_map<std::string, int64> node_deltas;
   for (const PassInvocation& invocation : pass_results.invocations) {
     pass_times[invocation.pass_name] += invocation.run_duration;
     ++pass_counts[invocation.pass_name];
     changed_counts[invocation.pass_name] += invocation.ir_changed ? 1 : 0;
+    node_deltas[invocation.pass_name] +=
+        invocation.nodes_after - invocation.nodes_before;
   }
   std::vector<std::string> pass_names;
   for (const auto& pair : pass_times) {
@@ -129,12 +138,22 @@ absl::Status RunOptimizationAndPrintStats(Package* package) {
               return pass_times.at(a) > pass_times.at(b);
             });
   std::cout << "Pass run durations (# of times pass changed IR / # of times "
-               "pass was run):"
+               "pass was run, change in node count):"
             << std::endl;
   for (const std::string& name : pass_names) {
     std::cout << absl::StreamFormat(
-        "  %-20s : %-5dms (%3d / %3d)\n", name, to_ms(pass_times.at(name)),
-        changed_counts.at(name), pass_counts.at(name));
+        "  %-20s : %-5dms (%3d / %3d, %+d nodes)\n", name,
+        to_ms(pass_times.at(name)), changed_counts.at(name),
+        pass_counts.at(name), node_deltas.at(name));
+  }
+  std::cout << "Pass profile by position in the pipeline:" << std::endl;
+  std::cout << pass_results.profile.SummaryToString();
+  std::cout << "Analyses shared between passes:" << std::endl;
+  for (const auto& pair : analysis_manager.stats()) {
+    const AnalysisManager::Stats& stats = pair.second;
+    std::cout << absl::StreamFormat(
+        "  %-40s : %-5dms (%3d built / %3d requested)\n", pair.first,
+        to_ms(stats.build_time), stats.misses, stats.hits + stats.misses);
   }
   return absl::OkStatus();
 }
@@ -344,14 +363,11 @@ absl::Status RealMain(absl::string_view path,
                       absl::optional<int64> pipeline_stages,
                       absl::optional<int64> clock_margin_percent) {
   XLS_VLOG(1) << "Reading contents at path: " << path;
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
-  std::unique_ptr<Package> package;
-  if (absl::GetFlag(FLAGS_entry).empty()) {
-    XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackage(contents));
-  } else {
-    XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackageWithEntry(
-                                      contents, absl::GetFlag(FLAGS_entry)));
-  }
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      ReadPackageFile(path, ir_format, absl::GetFlag(FLAGS_entry)));
 
   XLS_RETURN_IF_ERROR(RunOptimizationAndPrintStats(package.get()));
   XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
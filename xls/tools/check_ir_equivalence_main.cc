@@ -22,7 +22,6 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/status/statusor.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/passes/inlining_pass.h"
 #include "xls/passes/map_inlining_pass.h"
@@ -31,6 +30,7 @@
 #include "xls/passes/unroll_pass.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_utils.h"
+#include "xls/tools/ir_file.h"
 #include "../z3/src/api/z3.h"
 #include "../z3/src/api/z3_api.h"
 
@@ -48,6 +48,8 @@ ABSL_FLAG(std::string, function, "",
           "and check an entry function for the package.");
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for any proof to complete.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 
@@ -71,10 +73,11 @@ xabsl::StatusOr<Z3_ast> CreateComparisonFunction(
 absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
                       const std::string& entry_function,
                       absl::Duration timeout) {
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
   std::vector<std::unique_ptr<Package>> packages;
   for (const auto ir_path : ir_paths) {
-    XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
-    XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+    XLS_ASSIGN_OR_RETURN(auto package, ReadPackageFile(ir_path, ir_format));
     packages.push_back(std::move(package));
   }
 
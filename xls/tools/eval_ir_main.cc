@@ -12,13 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <random>
+#include <thread>  // NOLINT
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
@@ -26,12 +32,14 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/status/statusor.h"
+#include "xls/ir/bytecode_interpreter.h"
 #include "xls/ir/ir_interpreter.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/jit/llvm_ir_jit.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
+#include "xls/tools/ir_file.h"
 
 const char kUsage[] = R"(
 Evaluates an IR file with user-specified or random inputs using the IR
@@ -65,6 +73,10 @@ Evaluate IR after every optimization pass:
 
 Evaluate IR using the JIT and with the interpreter and compare the results:
   eval_ir_main --test_llvm_jit --random_inputs=100  IR_FILE
+
+Evaluate many random inputs on all cores (results are identical to a
+single-threaded run):
+  eval_ir_main --test_llvm_jit --random_inputs=10000000 --threads=0 IR_FILE
 )";
 
 ABSL_FLAG(std::string, entry, "", "Entry function name to evaluate.");
@@ -98,6 +110,11 @@ ABSL_FLAG(bool, use_llvm_jit, true, "Use the LLVM IR JIT for execution.");
 ABSL_FLAG(bool, test_llvm_jit, false,
           "If true, then run the JIT and compare the results against the "
           "interpereter.");
+ABSL_FLAG(int64, threads, 1,
+          "Number of threads with which to evaluate the inputs (and generate "
+          "random inputs). If 0, uses one thread per core. Inputs are split "
+          "into fixed-size shards, so generated inputs, results and reported "
+          "miscompares do not depend on the number of threads.");
 ABSL_FLAG(int64, llvm_opt_level, 3,
           "The optimization level of the LLVM JIT. Valid values are from 0 (no "
           "optimizations) to 3 (maximum optimizations).");
@@ -106,6 +123,8 @@ ABSL_FLAG(
     std::string, test_only_inject_jit_result, "",
     "Test-only flag for injecting the result produced by the JIT. Used to "
     "force mismatches between JIT and interpreter for testing purposed.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -124,45 +143,171 @@ std::string ArgsToString(absl::Span<const Value> args) {
   });
 }
 
-// Evaluates the function with the given ArgSets. Returns an error if the result
-// does not match expectations (if any). 'actual_src' and 'expected_src' are
-// string descriptions of the sources of the actual results and expected
-// results, respectively. These strings are included in error messages.
+// Number of ArgSets in each unit of parallel work. Random inputs for each
+// shard are generated from their own seed, so this is also what makes random
+// inputs independent of the number of threads.
+constexpr int64 kShardSize = 1024;
+
+// Miscompares beyond this many are counted but not listed in the error.
+constexpr int64 kMaxReportedMiscompares = 16;
+
+int64 ShardCount(int64 item_count) {
+  return (item_count + kShardSize - 1) / kShardSize;
+}
+
+int64 ThreadCount() {
+  int64 threads = absl::GetFlag(FLAGS_threads);
+  XLS_QCHECK_GE(threads, 0) << "--threads must be non-negative";
+  if (threads == 0) {
+    threads = std::max<int64>(1, std::thread::hardware_concurrency());
+  }
+  return threads;
+}
+
+// Calls 'f(worker, shard)' for each shard in [0, shard_count) on up to
+// 'thread_count' worker threads, where 'worker' is the index of the calling
+// thread. Workers take shards in increasing order and stop taking new ones once
+// any call fails. Returns the error of the lowest-numbered failing shard, which
+// does not depend on scheduling as every lower shard has run to completion.
+absl::Status ForEachShard(
+    int64 shard_count, int64 thread_count,
+    const std::function<absl::Status(int64 worker, int64 shard)>& f) {
+  thread_count = std::min(thread_count, shard_count);
+  if (thread_count <= 1) {
+    for (int64 shard = 0; shard < shard_count; ++shard) {
+      XLS_RETURN_IF_ERROR(f(/*worker=*/0, shard));
+    }
+    return absl::OkStatus();
+  }
+
+  std::vector<absl::Status> statuses(shard_count);
+  std::atomic<int64> next_shard{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+  for (int64 worker = 0; worker < thread_count; ++worker) {
+    threads.emplace_back([&, worker]() {
+      while (!failed.load()) {
+        int64 shard = next_shard.fetch_add(1);
+        if (shard >= shard_count) {
+          return;
+        }
+        statuses[shard] = f(worker, shard);
+        if (!statuses[shard].ok()) {
+          failed.store(true);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+// How Eval evaluates the function.
+enum class Evaluator {
+  // The LLVM JIT, which is shared by all threads.
+  kJit,
+  // The IR interpreter (ir_interpreter::Run), the reference for the other
+  // evaluators.
+  kReferenceInterpreter,
+  // The IR interpreter with one thread. With more, each worker interprets with
+  // its own (faster) BytecodeInterpreter instead.
+  kInterpreter,
+};
+
+Evaluator JitOrInterpreter(bool use_jit) {
+  return use_jit ? Evaluator::kJit : Evaluator::kInterpreter;
+}
+
+// Evaluates the function with the given ArgSets, in parallel if --threads is
+// not 1. Results are printed in input order. Returns an error if any result
+// does not match expectations (if any), listing the miscompares in input order.
+// 'actual_src' and 'expected_src' are string descriptions of the sources of the
+// actual results and expected results, respectively. These strings are
+// included in error messages.
 xabsl::StatusOr<std::vector<Value>> Eval(
-    Function* f, absl::Span<const ArgSet> arg_sets, bool use_jit,
+    Function* f, absl::Span<const ArgSet> arg_sets, Evaluator evaluator,
     absl::string_view actual_src = "actual",
     absl::string_view expected_src = "expected") {
   std::unique_ptr<LlvmIrJit> jit;
-  if (use_jit) {
+  if (evaluator == Evaluator::kJit) {
     XLS_ASSIGN_OR_RETURN(
         jit, LlvmIrJit::Create(f, absl::GetFlag(FLAGS_llvm_opt_level)));
   }
 
-  std::vector<Value> results;
-  for (const ArgSet& arg_set : arg_sets) {
-    Value result;
-    if (use_jit) {
-      if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
-        XLS_ASSIGN_OR_RETURN(result, jit->Run(arg_set.args));
-      } else {
-        XLS_ASSIGN_OR_RETURN(result, Parser::ParseTypedValue(absl::GetFlag(
-                                         FLAGS_test_only_inject_jit_result)));
-      }
-    } else {
-      XLS_ASSIGN_OR_RETURN(result, ir_interpreter::Run(f, arg_set.args));
+  int64 thread_count = std::min(ThreadCount(), ShardCount(arg_sets.size()));
+  std::vector<std::unique_ptr<BytecodeInterpreter>> interpreters(thread_count);
+
+  std::vector<Value> results(arg_sets.size());
+  absl::Time start = absl::Now();
+  XLS_RETURN_IF_ERROR(ForEachShard(
+      ShardCount(arg_sets.size()), thread_count,
+      [&](int64 worker, int64 shard) -> absl::Status {
+        int64 end = std::min<int64>((shard + 1) * kShardSize, arg_sets.size());
+        for (int64 i = shard * kShardSize; i < end; ++i) {
+          const ArgSet& arg_set = arg_sets[i];
+          if (evaluator == Evaluator::kJit) {
+            if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
+              XLS_ASSIGN_OR_RETURN(results[i], jit->Run(arg_set.args));
+            } else {
+              XLS_ASSIGN_OR_RETURN(
+                  results[i],
+                  Parser::ParseTypedValue(
+                      absl::GetFlag(FLAGS_test_only_inject_jit_result)));
+            }
+          } else if (evaluator == Evaluator::kReferenceInterpreter ||
+                     thread_count == 1) {
+            XLS_ASSIGN_OR_RETURN(results[i],
+                                 ir_interpreter::Run(f, arg_set.args));
+          } else {
+            if (interpreters[worker] == nullptr) {
+              XLS_ASSIGN_OR_RETURN(interpreters[worker],
+                                   BytecodeInterpreter::Create(f));
+            }
+            XLS_ASSIGN_OR_RETURN(results[i],
+                                 interpreters[worker]->Run(arg_set.args));
+          }
+        }
+        return absl::OkStatus();
+      }));
+  absl::Duration elapsed = absl::Now() - start;
+
+  std::vector<std::string> miscompares;
+  int64 miscompare_count = 0;
+  for (int64 i = 0; i < arg_sets.size(); ++i) {
+    std::cout << results[i].ToString(FormatPreference::kHex) << "\n";
+    const ArgSet& arg_set = arg_sets[i];
+    if (!arg_set.expected.has_value() || results[i] == *arg_set.expected) {
+      continue;
     }
-    std::cout << result.ToString(FormatPreference::kHex) << std::endl;
-
-    if (arg_set.expected.has_value()) {
-      if (result != *arg_set.expected) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "Miscompare for input \"%s\"\n  %s: %s\n  %s: %s",
-            ArgsToString(arg_set.args), actual_src,
-            result.ToString(FormatPreference::kHex), expected_src,
-            arg_set.expected->ToString(FormatPreference::kHex)));
-      }
+    if (++miscompare_count <= kMaxReportedMiscompares) {
+      miscompares.push_back(absl::StrFormat(
+          "Miscompare for input \"%s\"\n  %s: %s\n  %s: %s",
+          ArgsToString(arg_set.args), actual_src,
+          results[i].ToString(FormatPreference::kHex), expected_src,
+          arg_set.expected->ToString(FormatPreference::kHex)));
+    }
+  }
+  std::cout.flush();
+  if (arg_sets.size() > 1) {
+    std::cerr << absl::StreamFormat(
+        "// Evaluated %d inputs with %d thread(s) in %s (%.0f "
+        "evaluations/second)\n",
+        arg_sets.size(), thread_count, absl::FormatDuration(elapsed),
+        arg_sets.size() / absl::ToDoubleSeconds(elapsed));
+  }
+  if (miscompare_count > 0) {
+    if (miscompare_count > kMaxReportedMiscompares) {
+      miscompares.push_back(absl::StrFormat(
+          "(%d more not shown)", miscompare_count - kMaxReportedMiscompares));
     }
-    results.push_back(result);
+    return absl::InvalidArgumentError(
+        absl::StrFormat("%d of %d results miscompared:\n%s", miscompare_count,
+                        arg_sets.size(), absl::StrJoin(miscompares, "\n")));
   }
   return results;
 }
@@ -178,7 +323,7 @@ class EvalInvariantChecker : public InvariantChecker {
     std::cerr << "// Evaluating entry function after pass\n";
     XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
     std::string actual_src = "before optimizations";
-    XLS_RETURN_IF_ERROR(Eval(f, arg_sets_, use_jit_,
+    XLS_RETURN_IF_ERROR(Eval(f, arg_sets_, JitOrInterpreter(use_jit_),
                              /*actual_src=*/results->invocations.empty()
                                  ? std::string("start of pipeline")
                                  : results->invocations.back().pass_name,
@@ -205,21 +350,22 @@ absl::Status Run(Package* package, absl::Span<const ArgSet> arg_sets_in) {
     XLS_QCHECK(!absl::GetFlag(FLAGS_optimize_ir))
         << "Cannot specify both --test_llvm_jit and --optimize_ir";
     XLS_ASSIGN_OR_RETURN(std::vector<Value> interpreter_results,
-                         Eval(f, arg_sets, /*use_jit=*/false));
+                         Eval(f, arg_sets, Evaluator::kReferenceInterpreter));
     for (int64 i = 0; i < arg_sets.size(); ++i) {
       XLS_QCHECK(!arg_sets[i].expected.has_value())
           << "Cannot specify expected values when using --test_llvm_jit";
       arg_sets[i].expected = interpreter_results[i];
     }
-    return Eval(f, arg_sets, /*use_jit=*/true, "JIT", "interpreter").status();
+    return Eval(f, arg_sets, Evaluator::kJit, "JIT", "interpreter").status();
   }
 
   // Run the argsets through the IR before any optimizations. Write in the
   // results as the expected values if the expected value is not already
   // set. These expected values are used in any later evaluation after
   // optimizations.
-  XLS_ASSIGN_OR_RETURN(std::vector<Value> results,
-                       Eval(f, arg_sets, absl::GetFlag(FLAGS_use_llvm_jit)));
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<Value> results,
+      Eval(f, arg_sets, JitOrInterpreter(absl::GetFlag(FLAGS_use_llvm_jit))));
   for (int64 i = 0; i < arg_sets.size(); ++i) {
     if (!arg_sets[i].expected.has_value()) {
       arg_sets[i].expected = results[i];
@@ -239,9 +385,10 @@ absl::Status Run(Package* package, absl::Span<const ArgSet> arg_sets_in) {
     XLS_RETURN_IF_ERROR(
         pipeline->Run(package, PassOptions(), &results).status());
 
-    XLS_RETURN_IF_ERROR(Eval(f, arg_sets, absl::GetFlag(FLAGS_use_llvm_jit),
-                             "before optimizations", "after optimizations")
-                            .status());
+    XLS_RETURN_IF_ERROR(
+        Eval(f, arg_sets, JitOrInterpreter(absl::GetFlag(FLAGS_use_llvm_jit)),
+             "before optimizations", "after optimizations")
+            .status());
   } else {
     XLS_RET_CHECK(!absl::GetFlag(FLAGS_eval_after_each_pass))
         << "Must specify --optimize_ir with --eval_after_each_pass";
@@ -261,18 +408,11 @@ xabsl::StatusOr<ArgSet> ArgSetFromString(absl::string_view args_string) {
 }
 
 absl::Status RealMain(absl::string_view input_path) {
-  if (input_path == "-") {
-    input_path = "/dev/stdin";
-  }
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
-  std::unique_ptr<Package> package;
-  if (absl::GetFlag(FLAGS_entry).empty()) {
-    XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackage(contents, input_path));
-  } else {
-    XLS_ASSIGN_OR_RETURN(package,
-                         Parser::ParsePackageWithEntry(
-                             contents, absl::GetFlag(FLAGS_entry), input_path));
-  }
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      ReadPackageFile(input_path, ir_format, absl::GetFlag(FLAGS_entry)));
   XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
 
   std::vector<ArgSet> arg_sets;
@@ -305,12 +445,27 @@ absl::Status RealMain(absl::string_view input_path) {
     XLS_QCHECK_NE(absl::GetFlag(FLAGS_random_inputs), 0)
         << "Must specify --input, --input_file, or --random_inputs.";
     arg_sets.resize(absl::GetFlag(FLAGS_random_inputs));
-    std::minstd_rand rng_engine;
-    for (ArgSet& arg_set : arg_sets) {
-      for (Param* param : f->params()) {
-        arg_set.args.push_back(RandomValue(param->GetType(), &rng_engine));
-      }
-    }
+    // Each shard has its own seed so the inputs can be generated in parallel
+    // and are the same for any number of threads. The shard number is mixed
+    // through a seed_seq, as consecutive seeds give correlated streams. Note
+    // that this makes the inputs differ from those generated by versions
+    // without --threads, which drew all of them from a single stream.
+    XLS_RETURN_IF_ERROR(ForEachShard(
+        ShardCount(arg_sets.size()), ThreadCount(),
+        [&](int64 worker, int64 shard) {
+          std::seed_seq seed{static_cast<uint32>(shard),
+                             static_cast<uint32>(shard >> 32)};
+          std::minstd_rand rng_engine(seed);
+          int64 end =
+              std::min<int64>((shard + 1) * kShardSize, arg_sets.size());
+          for (int64 i = shard * kShardSize; i < end; ++i) {
+            for (Param* param : f->params()) {
+              arg_sets[i].args.push_back(
+                  RandomValue(param->GetType(), &rng_engine));
+            }
+          }
+          return absl::OkStatus();
+        }));
   }
 
   if (!absl::GetFlag(FLAGS_expected).empty()) {
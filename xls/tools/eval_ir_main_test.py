@@ -168,6 +168,43 @@ class EvalMainTest(absltest.TestCase):
     # And with overwhelming probability they should all be different.
     self.assertLen(set(result.decode('utf-8').strip().split('\n')), 42)
 
+  def test_random_inputs_with_threads(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    # Use enough inputs to span several shards.
+    serial = subprocess.check_output([
+        EVAL_IR_MAIN_PATH, '--random_inputs=3000', '--use_llvm_jit=false',
+        ir_file.full_path
+    ])
+    parallel = subprocess.check_output([
+        EVAL_IR_MAIN_PATH, '--random_inputs=3000', '--use_llvm_jit=false',
+        '--threads=4', ir_file.full_path
+    ])
+    self.assertLen(parallel.decode('utf-8').strip().split('\n'), 3000)
+    self.assertEqual(serial, parallel)
+
+  def test_input_file_with_failed_expected_file_with_threads(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    input_file = self.create_tempfile(
+        content='\n'.join(('bits[32]:0x42; bits[32]:0x123',
+                           'bits[32]:0x10; bits[32]:0x00')))
+    expected_file = self.create_tempfile(content='\n'.join(('bits[32]:0x1',
+                                                            'bits[32]:0x2')))
+    comp = subprocess.run([
+        EVAL_IR_MAIN_PATH, '--input_file=' + input_file.full_path,
+        '--expected_file=' + expected_file.full_path, '--threads=4',
+        ir_file.full_path
+    ],
+                          stderr=subprocess.PIPE,
+                          check=False)
+    self.assertNotEqual(comp.returncode, 0)
+    stderr = comp.stderr.decode('utf-8')
+    self.assertIn('2 of 2 results miscompared', stderr)
+    # Miscompares are reported in input order.
+    first = stderr.find('Miscompare for input "bits[32]:0x42; bits[32]:0x123"')
+    second = stderr.find('Miscompare for input "bits[32]:0x10; bits[32]:0x0"')
+    self.assertNotEqual(first, -1)
+    self.assertGreater(second, first)
+
   def test_jit_result_injection(self):
     ir_file = self.create_tempfile(content=ADD_IR)
     result = subprocess.check_output([
@@ -199,6 +236,29 @@ class EvalMainTest(absltest.TestCase):
     self.assertIn('Miscompare for input "bits[32]:0x42; bits[32]:0x123"',
                   comp.stderr.decode('utf-8'))
 
+  def test_test_llvm_jit_with_threads(self):
+    ir_file = self.create_tempfile(content=TUPLE_IR)
+    serial = subprocess.run([
+        EVAL_IR_MAIN_PATH, '--random_inputs=5000', '--test_llvm_jit',
+        ir_file.full_path
+    ],
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE,
+                            check=True)
+    parallel = subprocess.run([
+        EVAL_IR_MAIN_PATH, '--random_inputs=5000', '--test_llvm_jit',
+        '--threads=4', ir_file.full_path
+    ],
+                              stdout=subprocess.PIPE,
+                              stderr=subprocess.PIPE,
+                              check=True)
+    # Both the reference interpreter and the JIT run on all four threads (the
+    # inputs span five shards).
+    self.assertEqual(
+        parallel.stderr.decode('utf-8').count(
+            'Evaluated 5000 inputs with 4 thread(s)'), 2)
+    self.assertEqual(serial.stdout, parallel.stdout)
+
 
 if __name__ == '__main__':
   test_base.main()
@@ -19,10 +19,10 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/scheduling/extract_stage.h"
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
+#include "xls/tools/ir_file.h"
 
 ABSL_FLAG(std::string, ir_path, "", "Path to the IR file to load.");
 ABSL_FLAG(std::string, function, "",
@@ -32,6 +32,10 @@ ABSL_FLAG(std::string, output_path, "", "Path to which to write output.");
 ABSL_FLAG(std::string, schedule_path, "",
           "Path to the function's pipeline schedule.");
 ABSL_FLAG(int, stage, -1, "Pipeline stage to extract.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
+ABSL_FLAG(std::string, output_ir_format, "text",
+          "Format of the output IR: \"text\" or \"binary\".");
 
 namespace xls {
 
@@ -39,8 +43,9 @@ absl::Status RealMain(const std::string& ir_path,
                       absl::optional<std::string> function_name,
                       const std::string& schedule_path, int stage,
                       const std::string& output_path) {
-  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
-  XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(auto package, ReadPackageFile(ir_path, ir_format));
   Function* function;
   if (function_name) {
     XLS_ASSIGN_OR_RETURN(function, package->GetFunction(function_name.value()));
@@ -55,7 +60,12 @@ absl::Status RealMain(const std::string& ir_path,
                        PipelineSchedule::FromProto(function, proto));
 
   XLS_RETURN_IF_ERROR(ExtractStage(function, schedule, stage).status());
-  XLS_RETURN_IF_ERROR(SetFileContents(output_path, package->DumpIr()));
+  XLS_ASSIGN_OR_RETURN(
+      IrFormat output_ir_format,
+      IrFormatFromString(absl::GetFlag(FLAGS_output_ir_format)));
+  XLS_ASSIGN_OR_RETURN(std::string output,
+                       FormatPackage(*package, output_ir_format));
+  XLS_RETURN_IF_ERROR(SetFileContents(output_path, output));
 
   return absl::OkStatus();
 }
@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/ir_file.h"
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_serializer.h"
+
+namespace xls {
+
+xabsl::StatusOr<IrFormat> IrFormatFromString(absl::string_view name) {
+  if (name == "text") {
+    return IrFormat::kText;
+  }
+  if (name == "binary") {
+    return IrFormat::kBinary;
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Invalid IR format \"%s\"; expected \"text\" or \"binary\"", name));
+}
+
+xabsl::StatusOr<std::unique_ptr<Package>> ParsePackageInIrFormat(
+    absl::string_view contents, IrFormat format,
+    absl::optional<absl::string_view> filename, absl::string_view entry) {
+  if (format == IrFormat::kBinary) {
+    if (entry.empty()) {
+      return DeserializePackage(contents);
+    }
+    return DeserializePackage(contents, entry);
+  }
+  if (!entry.empty()) {
+    return Parser::ParsePackageWithEntry(contents, entry, filename);
+  }
+  return Parser::ParsePackage(contents, filename);
+}
+
+xabsl::StatusOr<std::unique_ptr<Package>> ReadPackageFile(
+    absl::string_view path, IrFormat format, absl::string_view entry) {
+  if (path == "-") {
+    path = "/dev/stdin";
+  }
+  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+  return ParsePackageInIrFormat(contents, format, path, entry);
+}
+
+xabsl::StatusOr<std::string> FormatPackage(const Package& package,
+                                           IrFormat format) {
+  if (format == IrFormat::kBinary) {
+    return SerializePackage(package);
+  }
+  return package.DumpIr();
+}
+
+}  // namespace xls
@@ -0,0 +1,61 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reading and writing of IR packages by the command line tools, in either IR
+// format: "text" (Package::DumpIr) or "binary" (xls/ir/ir_serializer.h). Tools
+// select the format with their own --ir_format (input) and --output_ir_format
+// flags.
+
+#ifndef XLS_TOOLS_IR_FILE_H_
+#define XLS_TOOLS_IR_FILE_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/common/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+enum class IrFormat {
+  kText,
+  kBinary,
+};
+
+// Returns the IR format with the given name, "text" or "binary", e.g., the
+// value of a --ir_format flag.
+xabsl::StatusOr<IrFormat> IrFormatFromString(absl::string_view name);
+
+// Parses a package from "contents" in the given format. "filename" is only
+// used for source locations of text IR. If "entry" is non-empty, it is set as
+// the entry function of the package (as with the --entry flag of the tools).
+xabsl::StatusOr<std::unique_ptr<Package>> ParsePackageInIrFormat(
+    absl::string_view contents, IrFormat format,
+    absl::optional<absl::string_view> filename = absl::nullopt,
+    absl::string_view entry = "");
+
+// Reads the file at "path" and parses it as above. A path of "-" reads
+// standard input.
+xabsl::StatusOr<std::unique_ptr<Package>> ReadPackageFile(
+    absl::string_view path, IrFormat format, absl::string_view entry = "");
+
+// Returns the package in the given format.
+xabsl::StatusOr<std::string> FormatPackage(const Package& package,
+                                           IrFormat format);
+
+}  // namespace xls
+
+#endif  // XLS_TOOLS_IR_FILE_H_
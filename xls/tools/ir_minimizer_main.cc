@@ -38,6 +38,7 @@
 #include "xls/passes/dce_pass.h"
 #include "xls/passes/dfe_pass.h"
 #include "xls/passes/standard_pipeline.h"
+#include "xls/tools/ir_file.h"
 
 const char* kUsage = R"(
 Tool for reducing IR to a minimal test case based on an external test.
@@ -99,6 +100,8 @@ ABSL_FLAG(bool, simplify_with_optimization_pipeline, false,
           "simplification option during reduction. This option should *not* be "
           "used if trying to reduce a crash in the optimization pipeline "
           "itself as the minimizer will then crash.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -341,7 +344,13 @@ absl::Status CleanUp(Function* f, bool can_remove_params) {
 
 absl::Status RealMain(absl::string_view path, const int64 failed_attempt_limit,
                       const int64 total_attempt_limit) {
-  XLS_ASSIGN_OR_RETURN(std::string knownf_ir_text, GetFileContents(path));
+  // The input may be in either IR format (--ir_format), but the candidates
+  // handed to the test script are always text.
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> input_package,
+                       ReadPackageFile(path, ir_format));
+  std::string knownf_ir_text = input_package->DumpIr();
 
   // Parse inputs, if specified.
   absl::optional<std::vector<xls::Value>> inputs;
@@ -21,6 +21,7 @@
 #include "absl/strings/str_split.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -28,14 +29,14 @@
 #include "xls/common/subprocess.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/netlist/cell_library.h"
-#include "xls/netlist/function_extractor.h"
-#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/lazy_cell_library.h"
 #include "xls/netlist/netlist.h"
 #include "xls/netlist/netlist.pb.h"
 #include "xls/netlist/netlist_parser.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/solvers/z3_lec.h"
 #include "xls/solvers/z3_utils.h"
+#include "xls/tools/ir_file.h"
 #include "../z3/src/api/z3_api.h"
 
 ABSL_FLAG(std::string, cell_lib_path, "",
@@ -46,6 +47,10 @@ ABSL_FLAG(std::string, cell_proto_path, "",
           "This is a whole bunch faster than specifiying an unprocessed "
           "cell library and should be favored.\n"
           "Either this or --cell_lib_path should be set.");
+ABSL_FLAG(std::string, cell_lib_cache_dir, "",
+          "Directory in which to cache the cells extracted from "
+          "--cell_lib_path for later runs. Only the cells used by the netlist "
+          "are extracted.");
 ABSL_FLAG(std::string, constraints_file, "",
           "Optional path to a DSLX file containing a input parameter "
           "constraint function. This function must have the same signature as "
@@ -84,6 +89,8 @@ ABSL_FLAG(int32, stage, -1,
           "Pipeline stage to evaluate. Requires --schedule.\n"
           "If \"schedule\" is set, but this is not, then the entire module "
           "will be evaluated.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
@@ -92,31 +99,22 @@ using solvers::z3::IrTranslator;
 
 constexpr const char kIrConverterPath[] = "xls/dslx/ir_converter_main";
 
-// Loads a cell library, either from a raw Liberty file or a preprocessed
-// CellLibraryProto proto.
-xabsl::StatusOr<netlist::CellLibrary> GetCellLibrary(
-    absl::string_view cell_lib_path, absl::string_view cell_proto_path) {
-  if (!cell_proto_path.empty()) {
-    XLS_ASSIGN_OR_RETURN(std::string cell_proto_text,
-                         GetFileContents(cell_proto_path));
-    netlist::CellLibraryProto cell_proto;
-    XLS_RET_CHECK(cell_proto.ParseFromString(cell_proto_text));
-    return netlist::CellLibrary::FromProto(cell_proto);
-  } else {
-    XLS_ASSIGN_OR_RETURN(std::string lib_text, GetFileContents(cell_lib_path));
-    XLS_ASSIGN_OR_RETURN(auto stream,
-                         netlist::cell_lib::CharStream::FromText(lib_text));
-    XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto proto,
-                         netlist::function::ExtractFunctions(&stream));
-    return netlist::CellLibrary::FromProto(proto);
-  }
+// Loads a cell library from a preprocessed CellLibraryProto proto.
+xabsl::StatusOr<netlist::CellLibrary> GetCellLibraryFromProto(
+    absl::string_view cell_proto_path) {
+  XLS_ASSIGN_OR_RETURN(std::string cell_proto_text,
+                       GetFileContents(cell_proto_path));
+  netlist::CellLibraryProto cell_proto;
+  XLS_RET_CHECK(cell_proto.ParseFromString(cell_proto_text));
+  return netlist::CellLibrary::FromProto(cell_proto);
 }
 
 // Loads and parses a netlist from a file.
 xabsl::StatusOr<std::unique_ptr<netlist::rtl::Netlist>> GetNetlist(
     absl::string_view netlist_path, netlist::CellLibrary* cell_library) {
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file,
+                       MappedFile::Open(std::string(netlist_path)));
+  netlist::rtl::Scanner scanner(netlist_file.contents());
   return netlist::rtl::Parser::ParseNetlist(cell_library, &scanner);
 }
 
@@ -155,8 +153,9 @@ absl::Status RealMain(absl::string_view ir_path,
                       absl::string_view constraints_file,
                       absl::string_view schedule_path, int stage) {
   solvers::z3::LecParams lec_params;
-  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
-  XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(auto package, ReadPackageFile(ir_path, ir_format));
   lec_params.ir_package = package.get();
   if (entry_function_name.empty()) {
     XLS_ASSIGN_OR_RETURN(lec_params.ir_function,
@@ -166,9 +165,25 @@ absl::Status RealMain(absl::string_view ir_path,
         lec_params.ir_function,
         lec_params.ir_package->GetFunction(entry_function_name));
   }
-  XLS_ASSIGN_OR_RETURN(auto cell_library,
-                       GetCellLibrary(cell_lib_path, cell_proto_path));
-  XLS_ASSIGN_OR_RETURN(auto netlist, GetNetlist(netlist_path, &cell_library));
+  // A raw Liberty file is loaded lazily: only the cells used by the netlist are
+  // extracted from it.
+  netlist::CellLibrary proto_cell_library;
+  std::unique_ptr<netlist::LazyCellLibrary> liberty_cell_library;
+  netlist::CellLibrary* cell_library = &proto_cell_library;
+  if (!cell_proto_path.empty()) {
+    XLS_ASSIGN_OR_RETURN(proto_cell_library,
+                         GetCellLibraryFromProto(cell_proto_path));
+  } else {
+    XLS_ASSIGN_OR_RETURN(liberty_cell_library,
+                         netlist::LazyCellLibrary::Open(
+                             std::string(cell_lib_path),
+                             absl::GetFlag(FLAGS_cell_lib_cache_dir)));
+    cell_library = liberty_cell_library->cell_library();
+  }
+  XLS_ASSIGN_OR_RETURN(auto netlist, GetNetlist(netlist_path, cell_library));
+  if (liberty_cell_library != nullptr) {
+    XLS_RETURN_IF_ERROR(liberty_cell_library->UpdateCache());
+  }
   lec_params.netlist = netlist.get();
   lec_params.netlist_module_name = netlist_module_name;
   lec_params.high_cells = high_cells;
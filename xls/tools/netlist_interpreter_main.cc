@@ -13,13 +13,17 @@
 // limitations under the License.
 
 // Driver for NetlistInterpreter: loads a netlist from disk, feeds Value input
-// (taken from the command line) into it, and prints the result.
+// (taken from the command line or a file) into it, and prints the result.
+// Inputs are evaluated with the bit-parallel CompiledSimulator unless cell
+// values are to be dumped.
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "xls/codegen/flattening.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -28,9 +32,9 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value.h"
 #include "xls/netlist/cell_library.h"
-#include "xls/netlist/function_extractor.h"
+#include "xls/netlist/compiled_simulator.h"
 #include "xls/netlist/interpreter.h"
-#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/lazy_cell_library.h"
 #include "xls/netlist/netlist.pb.h"
 #include "xls/netlist/netlist_parser.h"
 
@@ -38,6 +42,9 @@ ABSL_FLAG(std::string, cell_library, "",
           "Cell library to use for interpretation.");
 ABSL_FLAG(std::string, cell_library_proto, "",
           "Preprocessed cell library proto to use for interpretation.");
+ABSL_FLAG(std::string, cell_library_cache_dir, "",
+          "Directory in which to cache the cells extracted from --cell_library "
+          "for later runs. Only the cells used by the netlist are extracted.");
 // TODO(rspringer): Eliminate the need for this flag.
 // This one is a hidden temporary flag until we can properly handle cells
 // with state_function attributes (e.g., some latches).
@@ -48,6 +55,10 @@ ABSL_FLAG(std::string, input, "",
           "The input to the function as a semicolon-separated list of typed "
           "values. For example: \"bits[32]:42; (bits[7]:0, bits[20]:4)\". "
           "Values must be listed in the same order as the module inputs.");
+ABSL_FLAG(std::string, input_file, "",
+          "Path to a file with one input per line, each in the format of "
+          "--input. All inputs are evaluated together, and one result is "
+          "printed per input.");
 ABSL_FLAG(std::string, output_type, "",
           "Type of the value as an XLS-formatted string. If un-set, then the "
           "output will be printed as flat uninterpreted bits.");
@@ -56,72 +67,34 @@ ABSL_FLAG(std::string, netlist, "", "Path to the netlist to interpret.");
 
 namespace xls {
 
-xabsl::StatusOr<netlist::CellLibrary> GetCellLibrary(
-    const std::string& cell_library_path,
+xabsl::StatusOr<netlist::CellLibrary> GetCellLibraryFromProto(
     const std::string& cell_library_proto_path) {
-  if (!cell_library_proto_path.empty()) {
-    XLS_ASSIGN_OR_RETURN(std::string proto_text,
-                         GetFileContents(cell_library_proto_path));
-    netlist::CellLibraryProto lib_proto;
-    XLS_RET_CHECK(lib_proto.ParseFromString(proto_text));
-    return netlist::CellLibrary::FromProto(lib_proto);
-  } else {
-    XLS_ASSIGN_OR_RETURN(std::string cell_library_text,
-                         GetFileContents(cell_library_path));
-    XLS_ASSIGN_OR_RETURN(
-        auto char_stream,
-        netlist::cell_lib::CharStream::FromText(cell_library_text));
-    XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto lib_proto,
-                         netlist::function::ExtractFunctions(&char_stream));
-    return netlist::CellLibrary::FromProto(lib_proto);
-  }
+  XLS_ASSIGN_OR_RETURN(std::string proto_text,
+                       GetFileContents(cell_library_proto_path));
+  netlist::CellLibraryProto lib_proto;
+  XLS_RET_CHECK(lib_proto.ParseFromString(proto_text));
+  return netlist::CellLibrary::FromProto(lib_proto);
 }
 
-absl::Status RealMain(const std::string& netlist_path,
-                      const std::string& cell_library_path,
-                      const std::string& cell_library_proto_path,
-                      const std::string& module_name,
-                      absl::Span<const std::string> inputs,
-                      const std::string& output_type_string,
-                      absl::Span<const std::string> dump_cells) {
-  XLS_ASSIGN_OR_RETURN(
-      netlist::CellLibrary cell_library,
-      GetCellLibrary(cell_library_path, cell_library_proto_path));
-
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
-  XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
-                                         &cell_library, &scanner));
-  XLS_ASSIGN_OR_RETURN(const auto* module, netlist->GetModule(module_name));
-
-  // Input values are listed in the same order as inputs are declared by
-  // Module::inputs().
+// Parses an input (see --input) into flat bits, in which bit i is the value of
+// input i of the module.
+xabsl::StatusOr<Bits> ParseInputBits(absl::string_view input,
+                                     const netlist::rtl::Module* module) {
   Bits input_bits;
-  for (const auto& input_string : inputs) {
+  for (absl::string_view input_string : absl::StrSplit(input, ';')) {
     XLS_ASSIGN_OR_RETURN(Value input, Parser::ParseTypedValue(input_string));
     Bits flat_value = FlattenValueToBits(input);
     input_bits = bits_ops::Concat({input_bits, flat_value});
   }
   input_bits = bits_ops::Reverse(input_bits);
+  XLS_RET_CHECK(module->inputs().size() == input_bits.bit_count());
+  return input_bits;
+}
 
-  absl::flat_hash_map<const netlist::rtl::NetRef, bool> input_nets;
-  const std::vector<netlist::rtl::NetRef>& module_inputs = module->inputs();
-  XLS_RET_CHECK(module_inputs.size() == input_bits.bit_count());
-
-  for (int i = 0; i < module->inputs().size(); i++) {
-    input_nets[module_inputs[i]] = input_bits.Get(i);
-  }
-
-  netlist::Interpreter interpreter(netlist.get());
-  XLS_ASSIGN_OR_RETURN(auto output_nets, interpreter.InterpretModule(
-                                             module, input_nets, dump_cells));
-
-  BitsRope rope(output_nets.size());
-  for (const netlist::rtl::NetRef ref : module->outputs()) {
-    rope.push_back(output_nets[ref]);
-  }
-  Bits output_bits = bits_ops::Reverse(rope.Build());
-
+// Prints the flat output bits, in which bit i is the value of output i of the
+// module, as a value of the given type (if any).
+absl::Status PrintResult(const Bits& output_bits,
+                         const std::string& output_type_string) {
   Value output;
   if (!output_type_string.empty()) {
     // This is a disposable package - it only exists to hold the type below.
@@ -129,9 +102,10 @@ absl::Status RealMain(const std::string& netlist_path,
     XLS_ASSIGN_OR_RETURN(Type * output_type,
                          Parser::ParseType(output_type_string, &package));
     XLS_ASSIGN_OR_RETURN(output,
-                         UnflattenBitsToValue(output_bits, output_type));
+                         UnflattenBitsToValue(bits_ops::Reverse(output_bits),
+                                              output_type));
   } else {
-    output = Value(output_bits);
+    output = Value(bits_ops::Reverse(output_bits));
   }
 
   std::cout << "Results: " << output.ToString(FormatPreference::kHex)
@@ -139,6 +113,75 @@ absl::Status RealMain(const std::string& netlist_path,
   return absl::OkStatus();
 }
 
+absl::Status RealMain(const std::string& netlist_path,
+                      const std::string& cell_library_path,
+                      const std::string& cell_library_proto_path,
+                      const std::string& module_name,
+                      absl::Span<const std::string> inputs,
+                      const std::string& output_type_string,
+                      absl::Span<const std::string> dump_cells) {
+  // A Liberty cell library is loaded lazily: only the cells used by the
+  // netlist are extracted from it.
+  netlist::CellLibrary proto_cell_library;
+  std::unique_ptr<netlist::LazyCellLibrary> liberty_cell_library;
+  netlist::CellLibrary* cell_library = &proto_cell_library;
+  if (!cell_library_proto_path.empty()) {
+    XLS_ASSIGN_OR_RETURN(proto_cell_library,
+                         GetCellLibraryFromProto(cell_library_proto_path));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        liberty_cell_library,
+        netlist::LazyCellLibrary::Open(
+            cell_library_path, absl::GetFlag(FLAGS_cell_library_cache_dir)));
+    cell_library = liberty_cell_library->cell_library();
+  }
+
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file, MappedFile::Open(netlist_path));
+  netlist::rtl::Scanner scanner(netlist_file.contents());
+  XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
+                                         cell_library, &scanner));
+  if (liberty_cell_library != nullptr) {
+    XLS_RETURN_IF_ERROR(liberty_cell_library->UpdateCache());
+  }
+  XLS_ASSIGN_OR_RETURN(const auto* module, netlist->GetModule(module_name));
+
+  std::vector<Bits> input_bits;
+  for (const std::string& input : inputs) {
+    XLS_ASSIGN_OR_RETURN(Bits bits, ParseInputBits(input, module));
+    input_bits.push_back(std::move(bits));
+  }
+
+  // Only the Interpreter can dump the values of cells.
+  if (!dump_cells.empty()) {
+    XLS_RET_CHECK_EQ(input_bits.size(), 1);
+    absl::flat_hash_map<const netlist::rtl::NetRef, bool> input_nets;
+    const std::vector<netlist::rtl::NetRef>& module_inputs = module->inputs();
+    for (int i = 0; i < module->inputs().size(); i++) {
+      input_nets[module_inputs[i]] = input_bits[0].Get(i);
+    }
+
+    netlist::Interpreter interpreter(netlist.get());
+    XLS_ASSIGN_OR_RETURN(auto output_nets, interpreter.InterpretModule(
+                                               module, input_nets, dump_cells));
+
+    BitsRope rope(output_nets.size());
+    for (const netlist::rtl::NetRef ref : module->outputs()) {
+      rope.push_back(output_nets[ref]);
+    }
+    return PrintResult(rope.Build(), output_type_string);
+  }
+
+  XLS_ASSIGN_OR_RETURN(
+      netlist::CompiledSimulator simulator,
+      netlist::CompiledSimulator::Compile(netlist.get(), module));
+  XLS_ASSIGN_OR_RETURN(std::vector<Bits> output_bits,
+                       simulator.RunVectors(input_bits));
+  for (const Bits& bits : output_bits) {
+    XLS_RETURN_IF_ERROR(PrintResult(bits, output_type_string));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace xls
 
 int main(int argc, char* argv[]) {
@@ -157,11 +200,25 @@ int main(int argc, char* argv[]) {
   XLS_QCHECK(!module_name.empty()) << "--module_name must be specified.";
 
   std::string input = absl::GetFlag(FLAGS_input);
-  XLS_QCHECK(!input.empty()) << "--input must be specified.";
-  std::vector<std::string> inputs = absl::StrSplit(input, ';');
+  std::string input_file = absl::GetFlag(FLAGS_input_file);
+  XLS_QCHECK(!input.empty() ^ !input_file.empty())
+      << "One (and only one) of --input or --input_file must be specified.";
+  std::vector<std::string> inputs;
+  if (input_file.empty()) {
+    inputs.push_back(input);
+  } else {
+    xabsl::StatusOr<std::string> input_text = xls::GetFileContents(input_file);
+    XLS_QCHECK_OK(input_text.status());
+    inputs = absl::StrSplit(input_text.value(), '\n', absl::SkipWhitespace());
+  }
 
   std::string dump_cells_str = absl::GetFlag(FLAGS_dump_cells);
-  std::vector<std::string> dump_cells = absl::StrSplit(dump_cells_str, ',');
+  std::vector<std::string> dump_cells;
+  if (!dump_cells_str.empty()) {
+    dump_cells = absl::StrSplit(dump_cells_str, ',');
+    XLS_QCHECK(input_file.empty())
+        << "--dump_cells can only be used with --input.";
+  }
 
   std::string output_type = absl::GetFlag(FLAGS_output_type);
 
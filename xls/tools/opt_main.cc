@@ -15,14 +15,20 @@
 // Takes in an IR file and produces an IR file that has been run through the
 // standard optimization pipeline.
 
+#include <algorithm>
+#include <thread>  // NOLINT
+
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/standard_pipeline.h"
+#include "xls/tools/ir_file.h"
 
 ABSL_FLAG(std::string, entry, "", "Entry function name to optimize.");
 ABSL_FLAG(std::string, ir_dump_path, "",
@@ -35,23 +41,48 @@ ABSL_FLAG(std::vector<std::string>, skip_passes, {},
           "pass names are skipped. If both --run_only_passes and --skip_passes "
           "are specified only passes which are present in --run_only_passes "
           "and not present in --skip_passes will be run.");
+ABSL_FLAG(bool, print_analysis_stats, false,
+          "If true, print to stderr how often the analyses shared between "
+          "passes (query engines, etc) were reused or rebuilt, and the time "
+          "spent building them.");
+ABSL_FLAG(int64, function_threads, 1,
+          "Number of threads with which to run function-local passes over the "
+          "functions of the package. If 0, uses one thread per core. The "
+          "output is the same for any number of threads greater than one.");
+ABSL_FLAG(int64, full_verify_period, 1,
+          "How often the IR verifier run between passes checks the whole "
+          "package. If 1, it always does. If N > 1, it does so every Nth run "
+          "and otherwise only checks the nodes changed since its previous "
+          "run. If 0, it only ever checks the changed nodes.");
+ABSL_FLAG(bool, print_pass_profile, false,
+          "If true, print to stderr the time spent in each pass (aggregated by "
+          "position in the pipeline) and in the invariant checkers, the change "
+          "in node count of each pass and the iteration counts of the "
+          "fixed-point passes.");
+ABSL_FLAG(std::string, pass_profile_chrome_trace, "",
+          "If non-empty, write a trace of the pass runs to this path in the "
+          "Chrome trace event format (viewable with chrome://tracing or "
+          "Perfetto).");
+ABSL_FLAG(std::string, pass_profile_folded_stacks, "",
+          "If non-empty, write the time spent in each nesting of passes to "
+          "this path as folded stacks, the input format of flamegraph.pl.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
+ABSL_FLAG(std::string, output_ir_format, "text",
+          "Format of the output IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace {
 
 absl::Status RealMain(absl::string_view input_path) {
-  if (input_path == "-") {
-    input_path = "/dev/stdin";
-  }
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
-  std::unique_ptr<Package> package;
-  if (absl::GetFlag(FLAGS_entry).empty()) {
-    XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackage(contents, input_path));
-  } else {
-    XLS_ASSIGN_OR_RETURN(package,
-                         Parser::ParsePackageWithEntry(
-                             contents, absl::GetFlag(FLAGS_entry), input_path));
-  }
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
+  XLS_ASSIGN_OR_RETURN(
+      IrFormat output_ir_format,
+      IrFormatFromString(absl::GetFlag(FLAGS_output_ir_format)));
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      ReadPackageFile(input_path, ir_format, absl::GetFlag(FLAGS_entry)));
   std::unique_ptr<CompoundPass> pipeline = CreateStandardPassPipeline();
   PassOptions options;
   options.ir_dump_path = absl::GetFlag(FLAGS_ir_dump_path);
@@ -61,9 +92,39 @@ absl::Status RealMain(absl::string_view input_path) {
   if (!absl::GetFlag(FLAGS_skip_passes).empty()) {
     options.skip_passes = absl::GetFlag(FLAGS_skip_passes);
   }
+  options.function_threads = absl::GetFlag(FLAGS_function_threads);
+  XLS_QCHECK_GE(options.function_threads, 0)
+      << "--function_threads must be non-negative";
+  if (options.function_threads == 0) {
+    options.function_threads =
+        std::max<int64>(1, std::thread::hardware_concurrency());
+  }
+  options.full_verify_period = absl::GetFlag(FLAGS_full_verify_period);
+  XLS_QCHECK_GE(options.full_verify_period, 0)
+      << "--full_verify_period must be non-negative";
+  AnalysisManager analysis_manager;
+  options.analysis_manager = &analysis_manager;
   PassResults results;
   XLS_RETURN_IF_ERROR(pipeline->Run(package.get(), options, &results).status());
-  std::cout << package->DumpIr();
+  if (absl::GetFlag(FLAGS_print_analysis_stats)) {
+    std::cerr << analysis_manager.StatsToString();
+  }
+  if (absl::GetFlag(FLAGS_print_pass_profile)) {
+    std::cerr << results.profile.SummaryToString();
+  }
+  if (!absl::GetFlag(FLAGS_pass_profile_chrome_trace).empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(absl::GetFlag(FLAGS_pass_profile_chrome_trace),
+                        results.profile.ToChromeTrace()));
+  }
+  if (!absl::GetFlag(FLAGS_pass_profile_folded_stacks).empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(absl::GetFlag(FLAGS_pass_profile_folded_stacks),
+                        results.profile.ToFoldedStacks()));
+  }
+  XLS_ASSIGN_OR_RETURN(std::string output,
+                       FormatPackage(*package, output_ir_format));
+  std::cout << output;
   return absl::OkStatus();
 }
 
@@ -13,30 +13,132 @@
 // limitations under the License.
 
 // Utility which parses files given specified as command-line arguments as XLS
-// IR text. If no argument given reads from stdin. Returns non-zero value on
-// failure and emits failing absl::Status message to stderr.
+// IR in the format given by --ir_format. If no argument given reads from stdin.
+// Returns non-zero value on failure and emits failing absl::Status message to
+// stderr.
+//
+// Files are memory-mapped rather than read into memory. With --benchmark, each
+// file is parsed --benchmark_runs times and the parse throughput is printed.
+// For text IR, the size and load time of the binary format of the same package
+// are printed as well.
+
+#include <sys/resource.h>
 
+#include <algorithm>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
-#include "xls/common/file/filesystem.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
-#include "xls/ir/ir_parser.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_serializer.h"
+#include "xls/ir/package.h"
+#include "xls/tools/ir_file.h"
+
+ABSL_FLAG(bool, benchmark, false,
+          "Print the parse time and throughput (MB/s) of each file.");
+ABSL_FLAG(int64, benchmark_runs, 3,
+          "Number of times to parse each file with --benchmark; the fastest "
+          "run is reported.");
+ABSL_FLAG(std::string, ir_format, "text",
+          "Format of the input IR: \"text\" or \"binary\".");
 
 namespace xls {
 namespace tools {
+namespace {
+
+// Parses "contents" with "parse" --benchmark_runs times. Returns the fastest
+// run and the last parsed package.
+template <typename ParseFn>
+xabsl::StatusOr<std::pair<absl::Duration, std::unique_ptr<Package>>>
+TimeFastestParse(ParseFn parse) {
+  XLS_RET_CHECK_GT(absl::GetFlag(FLAGS_benchmark_runs), 0);
+  absl::Duration best = absl::InfiniteDuration();
+  std::unique_ptr<Package> package;
+  for (int64 i = 0; i < absl::GetFlag(FLAGS_benchmark_runs); ++i) {
+    package.reset();
+    absl::Time start = absl::Now();
+    XLS_ASSIGN_OR_RETURN(package, parse());
+    best = std::min(best, absl::Now() - start);
+  }
+  return std::make_pair(best, std::move(package));
+}
+
+// Parses "file_name" --benchmark_runs times and prints the fastest run.
+absl::Status BenchmarkParse(absl::string_view file_name,
+                            absl::string_view contents, IrFormat ir_format) {
+  XLS_ASSIGN_OR_RETURN(auto parsed, TimeFastestParse([&] {
+                         return ParsePackageInIrFormat(contents, ir_format);
+                       }));
+  int64 node_count = 0;
+  for (const std::unique_ptr<Function>& f : parsed.second->functions()) {
+    node_count += f->node_count();
+  }
+  double megabytes = static_cast<double>(contents.size()) / (1024 * 1024);
+  std::cout << absl::StreamFormat(
+      "%s: %.2f MB, %d nodes, parse time %s, %.1f MB/s\n", file_name,
+      megabytes, node_count, absl::FormatDuration(parsed.first),
+      megabytes / absl::ToDoubleSeconds(parsed.first));
+  if (ir_format != IrFormat::kText) {
+    return absl::OkStatus();
+  }
+
+  // Compare against loading the same package from the binary format.
+  XLS_ASSIGN_OR_RETURN(std::string serialized,
+                       SerializePackage(*parsed.second));
+  parsed.second.reset();
+  XLS_ASSIGN_OR_RETURN(auto loaded, TimeFastestParse([&] {
+                         return DeserializePackage(serialized);
+                       }));
+  std::cout << absl::StreamFormat(
+      "%s: binary %.2f MB (%.1f%% of text), load time %s (%.1fx faster)\n",
+      file_name, static_cast<double>(serialized.size()) / (1024 * 1024),
+      100.0 * serialized.size() / std::max<int64>(1, contents.size()),
+      absl::FormatDuration(loaded.first),
+      absl::ToDoubleSeconds(parsed.first) /
+          absl::ToDoubleSeconds(loaded.first));
+  return absl::OkStatus();
+}
+
+}  // namespace
 
 absl::Status RealMain(absl::Span<const absl::string_view> args) {
+  XLS_ASSIGN_OR_RETURN(IrFormat ir_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_ir_format)));
   if (args.empty()) {
     // If no arguments are given, read from stdin.
-    return Parser::ParsePackage(
+    return ParsePackageInIrFormat(
                std::string{std::istreambuf_iterator<char>(std::cin),
-                           std::istreambuf_iterator<char>()})
+                           std::istreambuf_iterator<char>()},
+               ir_format)
         .status();
   }
   for (absl::string_view arg : args) {
-    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(arg));
-    XLS_RETURN_IF_ERROR(Parser::ParsePackage(contents).status());
+    XLS_ASSIGN_OR_RETURN(MappedFile file, MappedFile::Open(std::string(arg)));
+    if (absl::GetFlag(FLAGS_benchmark)) {
+      XLS_RETURN_IF_ERROR(BenchmarkParse(arg, file.contents(), ir_format));
+    } else {
+      XLS_RETURN_IF_ERROR(
+          ParsePackageInIrFormat(file.contents(), ir_format).status());
+    }
+  }
+  if (absl::GetFlag(FLAGS_benchmark)) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+      std::cout << "Peak RSS (KiB): " << usage.ru_maxrss << "\n";
+    }
   }
   return absl::OkStatus();
 }
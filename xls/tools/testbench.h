@@ -15,7 +15,12 @@
 #ifndef XLS_TOOLS_TESTBENCH_H_
 #define XLS_TOOLS_TESTBENCH_H_
 
+#include <cmath>
 #include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "absl/base/internal/sysinfo.h"
 #include "absl/status/status.h"
@@ -27,17 +32,25 @@
 namespace xls {
 
 // Testbench is a helper class to test an XLS module (or...anything, really)
-// across a range of inputs. This class creates a set of worker threads and
-// divides the input across them, and sets them to go until complete.
-// Execution status (percent complete, number of result mismatches) will be
-// periodically printed to the terminal, as this class' primary use is for
-// exploring large test spaces.
+// across a range of inputs. This class creates a set of worker threads which
+// pull chunks of the input space from a shared work queue until it's
+// exhausted. Execution status (percent complete, number of result mismatches,
+// per-thread throughput) will be periodically printed to the terminal, as this
+// class' primary use is for exploring large test spaces.
 //
-// Presently, work is parititioned uniformly across threads at startup. This can
-// lead to work imbalance if certain areas of the input space execute faster
-// than others. More advanced strategies can be explored in the future if this
-// becomes a problem.
-template <typename JitWrapperT, typename InputT, typename ResultT>
+// Chunks shrink as the remaining input space does, so threads which hit
+// faster-executing areas of the input space simply claim more chunks, and all
+// threads finish at about the same time.
+//
+// The callables are template parameters, defaulting to std::functions. To
+// avoid the type erasure on every sample, construct with MakeTestbench(),
+// which deduces the callables' types.
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT = std::function<InputT(uint64)>,
+          typename ComputeExpectedT = std::function<ResultT(InputT)>,
+          typename ComputeActualT =
+              std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>,
+          typename CompareResultsT = std::function<bool(ResultT, ResultT)>>
 class Testbench {
  public:
   // Args:
@@ -59,11 +72,8 @@ class Testbench {
   // TODO(rspringer): Update Testbench & TestbenchThread to use the JIT
   // wrappers once they're fully implemented.
   Testbench(uint64 start, uint64 end, uint64 max_failures,
-            std::function<InputT(uint64)> index_to_input,
-            std::function<ResultT(InputT)> compute_expected,
-            std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>
-                compute_actual,
-            std::function<bool(ResultT, ResultT)> compare_results);
+            IndexToInputT index_to_input, ComputeExpectedT compute_expected,
+            ComputeActualT compute_actual, CompareResultsT compare_results);
 
   // Sets the number of threads to use. Must be called before Run().
   absl::Status SetNumThreads(int num_threads) {
@@ -80,6 +90,10 @@ class Testbench {
   absl::Status Run();
 
  private:
+  using ThreadT =
+      TestbenchThread<JitWrapperT, InputT, ResultT, IndexToInputT,
+                      ComputeExpectedT, ComputeActualT, CompareResultsT>;
+
   // How many seconds to wait before printing status (at most).
   static constexpr absl::Duration kPrintInterval = absl::Seconds(5);
 
@@ -94,72 +108,103 @@ class Testbench {
   absl::Mutex mutex_;
   absl::CondVar wake_me_;
 
-  std::vector<std::unique_ptr<TestbenchThread<JitWrapperT, InputT, ResultT>>>
-      threads_;
+  std::unique_ptr<TestbenchWorkQueue> work_queue_;
+  std::vector<std::unique_ptr<ThreadT>> threads_;
 
   bool started_;
   int num_threads_;
   absl::Time start_time_;
+  absl::Time last_print_time_;
   uint64 start_;
   uint64 end_;
   uint64 max_failures_;
   uint64 num_samples_processed_;
-  std::function<InputT(uint64)> index_to_input_;
-  std::function<ResultT(InputT)> compute_expected_;
-  std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>
-      compute_actual_;
-  std::function<bool(ResultT, ResultT)> compare_results_;
+  // The number of samples each thread had processed at the last print.
+  std::vector<uint64> thread_samples_processed_;
+  IndexToInputT index_to_input_;
+  ComputeExpectedT compute_expected_;
+  ComputeActualT compute_actual_;
+  CompareResultsT compare_results_;
 };
 
+// Creates a Testbench which calls the given callables directly, rather than
+// through std::functions. Only the JIT wrapper type needs to be specified;
+// the input and result types are those returned by "index_to_input" and
+// "compute_expected". Pass lambdas rather than function names: a function
+// decays to a pointer, which is still called indirectly on every sample,
+// while each lambda has its own type and can be inlined.
+//
+//   auto testbench = MakeTestbench<Fpadd2x32>(
+//       0, num_samples, /*max_failures=*/1,
+//       [](uint64 index) { return IndexToInput(index); },
+//       [](Float2x32 input) { return ComputeExpected(input); },
+//       [](Fpadd2x32* jit, absl::Span<uint8> buffer, Float2x32 input) {
+//         return ComputeActual(jit, buffer, input);
+//       },
+//       [](float a, float b) { return CompareResults(a, b); });
+template <typename JitWrapperT, typename IndexToInputT,
+          typename ComputeExpectedT, typename ComputeActualT,
+          typename CompareResultsT,
+          typename InputT = std::decay_t<std::invoke_result_t<IndexToInputT&,
+                                                              uint64>>,
+          typename ResultT = std::decay_t<
+              std::invoke_result_t<ComputeExpectedT&, const InputT&>>>
+Testbench<JitWrapperT, InputT, ResultT, IndexToInputT, ComputeExpectedT,
+          ComputeActualT, CompareResultsT>
+MakeTestbench(uint64 start, uint64 end, uint64 max_failures,
+              IndexToInputT index_to_input, ComputeExpectedT compute_expected,
+              ComputeActualT compute_actual, CompareResultsT compare_results) {
+  return Testbench<JitWrapperT, InputT, ResultT, IndexToInputT,
+                   ComputeExpectedT, ComputeActualT, CompareResultsT>(
+      start, end, max_failures, std::move(index_to_input),
+      std::move(compute_expected), std::move(compute_actual),
+      std::move(compare_results));
+}
+
 // INTERNAL IMPL ---------------------------------
 
-template <typename JitWrapperT, typename InputT, typename ResultT>
-Testbench<JitWrapperT, InputT, ResultT>::Testbench(
-    uint64 start, uint64 end, uint64 max_failures,
-    std::function<InputT(uint64)> index_to_input,
-    std::function<ResultT(InputT)> compute_expected,
-    std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>
-        compute_actual,
-    std::function<bool(ResultT, ResultT)> compare_results)
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT, typename ComputeExpectedT,
+          typename ComputeActualT, typename CompareResultsT>
+Testbench<JitWrapperT, InputT, ResultT, IndexToInputT, ComputeExpectedT,
+          ComputeActualT, CompareResultsT>::
+    Testbench(uint64 start, uint64 end, uint64 max_failures,
+              IndexToInputT index_to_input, ComputeExpectedT compute_expected,
+              ComputeActualT compute_actual, CompareResultsT compare_results)
     : started_(false),
       num_threads_(absl::base_internal::NumCPUs()),
       start_(start),
       end_(end),
       max_failures_(max_failures),
       num_samples_processed_(0),
-      index_to_input_(index_to_input),
-      compute_expected_(compute_expected),
-      compute_actual_(compute_actual),
-      compare_results_(compare_results) {}
-
-template <typename JitWrapperT, typename InputT, typename ResultT>
-absl::Status Testbench<JitWrapperT, InputT, ResultT>::Run() {
+      index_to_input_(std::move(index_to_input)),
+      compute_expected_(std::move(compute_expected)),
+      compute_actual_(std::move(compute_actual)),
+      compare_results_(std::move(compare_results)) {}
+
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT, typename ComputeExpectedT,
+          typename ComputeActualT, typename CompareResultsT>
+absl::Status Testbench<JitWrapperT, InputT, ResultT, IndexToInputT,
+                       ComputeExpectedT, ComputeActualT,
+                       CompareResultsT>::Run() {
   // Lock before spawning threads to prevent missing any early wakeup signals
   // here.
   mutex_.Lock();
   started_ = true;
   start_time_ = absl::Now();
+  last_print_time_ = start_time_;
 
-  // Set up all the workers.
-  uint64 chunk_size = (end_ - start_) / num_threads_;
-  uint64 chunk_remainder = (end_ - start_) % chunk_size;
-  uint64 first = 0;
-  uint64 last;
+  // Set up all the workers. They share the work queue, so no thread is left
+  // idle while there's still work to do.
+  work_queue_ = std::make_unique<TestbenchWorkQueue>(start_, end_,
+                                                     num_threads_);
+  thread_samples_processed_.assign(num_threads_, 0);
   for (int i = 0; i < num_threads_; i++) {
-    last = first + chunk_size;
-    // Distribute any remainder evenly amongst the threads.
-    if (chunk_remainder > 0) {
-      last++;
-      chunk_remainder--;
-    }
-
-    threads_.push_back(
-        std::make_unique<TestbenchThread<JitWrapperT, InputT, ResultT>>(
-            &mutex_, &wake_me_, first, last, max_failures_, index_to_input_,
-            compute_expected_, compute_actual_, compare_results_));
+    threads_.push_back(std::make_unique<ThreadT>(
+        &mutex_, &wake_me_, work_queue_.get(), max_failures_, index_to_input_,
+        compute_expected_, compute_actual_, compare_results_));
     threads_.back()->Run();
-
-    first = last + 1;
   }
 
   // Now monitor them.
@@ -204,54 +249,58 @@ absl::Status Testbench<JitWrapperT, InputT, ResultT>::Run() {
   return absl::OkStatus();
 }
 
-template <typename JitWrapperT, typename InputT, typename ResultT>
-void Testbench<JitWrapperT, InputT, ResultT>::PrintStatus() {
-  // Get the remainder-adjusted chunk size for this thread.
-  auto thread_chunk_size = [this](int thread_index) {
-    uint64 total_size = end_ - start_;
-    uint64 chunk_size = total_size / threads_.size();
-    uint64 remainder = total_size % chunk_size;
-    if (thread_index < remainder) {
-      chunk_size++;
-    }
-    return chunk_size;
-  };
-
-  // Ignore remainder issues here. It shouldn't matter much at all.
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT, typename ComputeExpectedT,
+          typename ComputeActualT, typename CompareResultsT>
+void Testbench<JitWrapperT, InputT, ResultT, IndexToInputT, ComputeExpectedT,
+               ComputeActualT, CompareResultsT>::PrintStatus() {
   absl::Time now = absl::Now();
   auto delta = now - start_time_;
+  double seconds_this_print = absl::ToDoubleSeconds(now - last_print_time_);
+  uint64 total_size = end_ - start_;
   uint64 total_done = 0;
   for (int64 i = 0; i < threads_.size(); ++i) {
     uint64 num_passes = threads_[i]->num_passes();
     uint64 num_failures = threads_[i]->num_failures();
     uint64 thread_done = num_passes + num_failures;
-    uint64 chunk_size = thread_chunk_size(i);
     total_done += thread_done;
+    // Threads claim work as they go, so report each thread's share of the
+    // total rather than its progress through a fixed range.
+    double thread_throughput =
+        (thread_done - thread_samples_processed_[i]) / seconds_this_print;
     std::cout << absl::StreamFormat(
-                     "thread %02d: %f%% @ %.1f us/sample :: failures %d", i,
-                     static_cast<double>(thread_done) / chunk_size * 100.0,
+                     "thread %02d: %.2f%% of samples in %d chunks @ %.1f "
+                     "us/sample; %.2f Kisamples/s :: failures %d",
+                     i, static_cast<double>(thread_done) / total_size * 100.0,
+                     threads_[i]->num_chunks(),
                      absl::ToDoubleMicroseconds(delta) / thread_done,
-                     num_failures)
+                     thread_throughput / 1024, num_failures)
               << "\n";
+    thread_samples_processed_[i] = thread_done;
   }
   double done_per_second = total_done / absl::ToDoubleSeconds(delta);
-  int64 remaining = end_ - start_ - total_done;
+  int64 remaining = total_size - total_done;
   auto estimate = absl::Seconds(remaining / done_per_second);
   double throughput_this_print =
       static_cast<double>(total_done - num_samples_processed_) /
-      ToInt64Seconds(kPrintInterval);
+      seconds_this_print;
   std::cout << absl::StreamFormat(
-                   "--- ^ after %s elapsed; %.2f Misamples/s; estimate %s "
-                   "remaining ...",
+                   "--- ^ after %s elapsed; %.2f%% complete; %.2f "
+                   "Misamples/s; estimate %s remaining ...",
                    absl::FormatDuration(delta),
+                   static_cast<double>(total_done) / total_size * 100.0,
                    throughput_this_print / std::pow(2, 20),
                    absl::FormatDuration(estimate))
             << std::endl;
   num_samples_processed_ = total_done;
+  last_print_time_ = now;
 }
 
-template <typename JitWrapperT, typename InputT, typename ResultT>
-void Testbench<JitWrapperT, InputT, ResultT>::Cancel() {
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT, typename ComputeExpectedT,
+          typename ComputeActualT, typename CompareResultsT>
+void Testbench<JitWrapperT, InputT, ResultT, IndexToInputT, ComputeExpectedT,
+               ComputeActualT, CompareResultsT>::Cancel() {
   for (int i = 0; i < threads_.size(); i++) {
     threads_[i]->Cancel();
   }
@@ -0,0 +1,136 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/testbench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+
+// Stand-ins for a JIT wrapper, providing just what TestbenchThread uses.
+class FakeJit {
+ public:
+  int64 GetReturnTypeSize() { return sizeof(uint32); }
+};
+
+class FakeJitWrapper {
+ public:
+  static xabsl::StatusOr<std::unique_ptr<FakeJitWrapper>> Create() {
+    return std::make_unique<FakeJitWrapper>();
+  }
+
+  FakeJit* jit() { return &jit_; }
+
+ private:
+  FakeJit jit_;
+};
+
+TEST(TestbenchWorkQueueTest, ChunksCoverRangeOnce) {
+  constexpr uint64 kStart = 7;
+  constexpr uint64 kEnd = 1000003;
+  constexpr int kNumThreads = 8;
+  TestbenchWorkQueue queue(kStart, kEnd, kNumThreads);
+
+  absl::Mutex mutex;
+  std::vector<std::pair<uint64, uint64>> chunks;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&]() {
+      uint64 first;
+      uint64 last;
+      while (queue.Next(&first, &last)) {
+        absl::MutexLock lock(&mutex);
+        chunks.push_back({first, last});
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::sort(chunks.begin(), chunks.end());
+  ASSERT_FALSE(chunks.empty());
+  EXPECT_EQ(chunks.front().first, kStart);
+  EXPECT_EQ(chunks.back().second, kEnd);
+  for (int64 i = 1; i < chunks.size(); ++i) {
+    EXPECT_EQ(chunks[i - 1].second, chunks[i].first);
+  }
+  // Chunks shrink as the range is consumed.
+  EXPECT_GT(chunks.front().second - chunks.front().first,
+            chunks.back().second - chunks.back().first);
+  uint64 first;
+  uint64 last;
+  EXPECT_FALSE(queue.Next(&first, &last));
+}
+
+TEST(TestbenchWorkQueueTest, EmptyRange) {
+  TestbenchWorkQueue queue(5, 5, 4);
+  uint64 first;
+  uint64 last;
+  EXPECT_FALSE(queue.Next(&first, &last));
+}
+
+TEST(TestbenchTest, EvaluatesEveryIndexOnce) {
+  constexpr uint64 kNumSamples = 100000;
+  std::vector<std::atomic<int>> evaluations(kNumSamples);
+  for (std::atomic<int>& count : evaluations) {
+    count.store(0);
+  }
+  auto testbench = MakeTestbench<FakeJitWrapper>(
+      0, kNumSamples, /*max_failures=*/1,
+      [](uint64 index) { return index; },
+      [](uint64 input) { return static_cast<uint32>(input * 3); },
+      [&](FakeJitWrapper* jit_wrapper, absl::Span<uint8> result_buffer,
+          uint64 input) {
+        evaluations[input].fetch_add(1);
+        return static_cast<uint32>(input * 3);
+      },
+      [](uint32 expected, uint32 actual) { return expected == actual; });
+  XLS_ASSERT_OK(testbench.SetNumThreads(4));
+  XLS_ASSERT_OK(testbench.Run());
+  for (uint64 i = 0; i < kNumSamples; ++i) {
+    EXPECT_EQ(evaluations[i].load(), 1) << "index " << i;
+  }
+}
+
+TEST(TestbenchTest, ReportsMismatch) {
+  Testbench<FakeJitWrapper, uint64, uint32> testbench(
+      0, 100000, /*max_failures=*/1, [](uint64 index) { return index; },
+      [](uint64 input) { return static_cast<uint32>(input); },
+      [](FakeJitWrapper* jit_wrapper, absl::Span<uint8> result_buffer,
+         uint64 input) {
+        return static_cast<uint32>(input == 12345 ? 0 : input);
+      },
+      [](uint32 expected, uint32 actual) { return expected == actual; });
+  XLS_ASSERT_OK(testbench.SetNumThreads(4));
+  EXPECT_THAT(testbench.Run(), StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(testbench.SetNumThreads(2),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+}  // namespace
+}  // namespace xls
@@ -15,13 +15,17 @@
 #ifndef XLS_TOOLS_TESTBENCH_THREAD_H_
 #define XLS_TOOLS_TESTBENCH_THREAD_H_
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <thread>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "xls/common/integral_types.h"
 #include "xls/common/logging/logging.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
@@ -29,15 +33,68 @@
 
 namespace xls {
 
+// TestbenchWorkQueue hands out chunks of the index space [start, end) to
+// TestbenchThreads as they ask for more work. Each chunk is a fraction of the
+// remaining indices, so chunks start out large (and cheap to claim) and shrink
+// towards the end of the range, where they keep every thread busy until the
+// space is exhausted.
+class TestbenchWorkQueue {
+ public:
+  TestbenchWorkQueue(uint64 start, uint64 end, int num_threads)
+      : end_(end),
+        divisor_(kChunksPerThread * std::max(num_threads, 1)),
+        next_(start) {}
+
+  // Claims the next chunk of indices as [*first, *last). Returns false if the
+  // index space has been exhausted. Thread-safe.
+  bool Next(uint64* first, uint64* last) {
+    uint64 next = next_.load(std::memory_order_relaxed);
+    uint64 chunk_size;
+    do {
+      if (next >= end_) {
+        return false;
+      }
+      uint64 remaining = end_ - next;
+      chunk_size =
+          std::min(remaining, std::max(kMinChunkSize, remaining / divisor_));
+    } while (!next_.compare_exchange_weak(next, next + chunk_size,
+                                          std::memory_order_relaxed));
+    *first = next;
+    *last = next + chunk_size;
+    return true;
+  }
+
+ private:
+  // Chunks are sized so that each thread would take about this many more
+  // chunks if the remaining work were split evenly.
+  static constexpr uint64 kChunksPerThread = 4;
+  // Below this many indices, the cost of claiming a chunk starts to show.
+  static constexpr uint64 kMinChunkSize = 256;
+
+  const uint64 end_;
+  const uint64 divisor_;
+  std::atomic<uint64> next_;
+};
+
 // TestbenchThread handles the work of _actually_ running tests.
-// It simply iterates over its given range of the index space and calls the
-// expected/actual calculators.
-template <typename JitWrapperT, typename InputT, typename ResultT>
+// It repeatedly claims a chunk of the index space from the shared work queue
+// and calls the expected/actual calculators for each index in it.
+//
+// The callables are template parameters so that they're invoked directly on
+// every sample; the std::function defaults keep the original interface.
+template <typename JitWrapperT, typename InputT, typename ResultT,
+          typename IndexToInputT = std::function<InputT(uint64)>,
+          typename GenerateExpectedT = std::function<ResultT(InputT)>,
+          typename GenerateActualT =
+              std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>,
+          typename CompareResultsT = std::function<bool(ResultT, ResultT)>>
 class TestbenchThread {
  public:
   // All specified functions must be thread-safe.
   //  - wake_parent_mutex: A mutex that protects:
   //  - wake_parent: A condvar to kick the parent when this thread has finished.
+  //  - work_queue: The source of the indices to evaluate; shared by all
+  //                threads of the testbench.
   //  - max_failures: The number of failures that will cause us to bail out.
   //                  If 0, then there will be no limit.
   //  - index_to_input: A function that can convert an index to an input to the
@@ -45,35 +102,34 @@ class TestbenchThread {
   //  - generate_expected: Given an input, generates the "expected" value.
   //  - generate_actual: Given an input, generates a value from the module
   //                     under test.
-  TestbenchThread(
-      absl::Mutex* wake_parent_mutex, absl::CondVar* wake_parent,
-      uint64 start_index, uint64 end_index, uint64 max_failures,
-      std::function<InputT(uint64)> index_to_input,
-      std::function<ResultT(InputT)> generate_expected,
-      std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>
-          generate_actual,
-      std::function<bool(ResultT, ResultT)> compare_results)
+  TestbenchThread(absl::Mutex* wake_parent_mutex, absl::CondVar* wake_parent,
+                  TestbenchWorkQueue* work_queue, uint64 max_failures,
+                  IndexToInputT index_to_input,
+                  GenerateExpectedT generate_expected,
+                  GenerateActualT generate_actual,
+                  CompareResultsT compare_results)
       : wake_parent_mutex_(wake_parent_mutex),
         wake_parent_(wake_parent),
         cancelled_(false),
         running_(false),
-        start_index_(start_index),
-        end_index_(end_index),
+        work_queue_(work_queue),
         max_failures_(max_failures),
+        num_chunks_(0),
         num_passes_(0),
         num_failures_(0),
-        index_to_input_(index_to_input),
-        generate_expected_(generate_expected),
-        generate_actual_(generate_actual),
-        compare_results_(compare_results) {}
+        index_to_input_(std::move(index_to_input)),
+        generate_expected_(std::move(generate_expected)),
+        generate_actual_(std::move(generate_actual)),
+        compare_results_(std::move(compare_results)) {}
 
   // Starts the thread. Silently returns if it's already running.
-  // If the tax of calling index_to_input_ every iter is too high, we can
-  // specialize this for simple cases, like uint64 -> uint64.
   void Run() {
     if (thread_) {
       return;
     }
+    // Mark the thread as running before it starts, so the parent never sees
+    // a thread that has yet to start as one that has finished.
+    running_.store(true);
     thread_ = absl::make_unique<std::thread>([this]() { RunInternal(); });
   }
 
@@ -87,6 +143,7 @@ class TestbenchThread {
   void RunInternal() {
     absl::Status return_status;
     if (cancelled_.load()) {
+      Finish(absl::CancelledError("This thread was cancelled."));
       return;
     }
 
@@ -99,47 +156,56 @@ class TestbenchThread {
     absl::Span<uint8> result_span(result_buffer.get(),
                                   jit_wrapper_->jit()->GetReturnTypeSize());
 
-    running_.store(true);
-    for (uint64 i = start_index_; i < end_index_; i++) {
-      // Don't check for cancelled on every iteration; it's a touch slow.
-      if (i % 128 == 0 && cancelled_.load()) {
-        return_status = absl::CancelledError("This thread was cancelled.");
-        break;
-      }
-
-      InputT input = index_to_input_(i);
-      ResultT expected = generate_expected_(input);
-      ResultT actual = generate_actual_(jit_wrapper_.get(), result_span, input);
-      if (!compare_results_(expected, actual)) {
-        num_failures_.store(num_failures_.load() + 1);
-        std::string error = absl::StrFormat(
-            "Value mismatch at index %d:\n"
-            "  Expected: 0x%x\n"
-            "  Actual  : 0x%x",
-            i, absl::bit_cast<uint32>(expected),
-            absl::bit_cast<uint32>(actual));
-        XLS_LOG(ERROR) << error;
-        if (max_failures_ <= num_failures_.load()) {
-          return_status = absl::InternalError(error);
+    uint64 first;
+    uint64 last;
+    while (return_status.ok() && work_queue_->Next(&first, &last)) {
+      // Only this thread writes the counters, so there's no need for a
+      // read-modify-write.
+      num_chunks_.store(num_chunks_.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+      for (uint64 i = first; i < last; i++) {
+        // Don't check for cancelled on every iteration; it's a touch slow.
+        if (i % 128 == 0 && cancelled_.load(std::memory_order_relaxed)) {
+          return_status = absl::CancelledError("This thread was cancelled.");
           break;
         }
-      } else {
-        num_passes_.store(num_passes_.load() + 1);
+
+        InputT input = index_to_input_(i);
+        ResultT expected = generate_expected_(input);
+        ResultT actual =
+            generate_actual_(jit_wrapper_.get(), result_span, input);
+        if (!compare_results_(expected, actual)) {
+          uint64 num_failures =
+              num_failures_.load(std::memory_order_relaxed) + 1;
+          num_failures_.store(num_failures, std::memory_order_relaxed);
+          std::string error = absl::StrFormat(
+              "Value mismatch at index %d:\n"
+              "  Expected: 0x%x\n"
+              "  Actual  : 0x%x",
+              i, absl::bit_cast<uint32>(expected),
+              absl::bit_cast<uint32>(actual));
+          XLS_LOG(ERROR) << error;
+          if (max_failures_ <= num_failures) {
+            return_status = absl::InternalError(error);
+            break;
+          }
+        } else {
+          num_passes_.store(num_passes_.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        }
       }
     }
 
-    running_.store(false);
-    {
-      absl::MutexLock lock(&mutex_);
-      status_ = return_status;
-    }
-    WakeParent();
+    Finish(return_status);
   }
 
   void Cancel() { cancelled_.store(true); }
 
   bool running() { return running_.load(); }
 
+  // The number of chunks claimed from the work queue.
+  uint64 num_chunks() { return num_chunks_.load(); }
+
   uint64 num_failures() { return num_failures_.load(); }
 
   uint64 num_passes() { return num_passes_.load(); }
@@ -150,6 +216,16 @@ class TestbenchThread {
   }
 
  private:
+  // Records the final status of this thread and wakes the parent.
+  void Finish(const absl::Status& status) {
+    {
+      absl::MutexLock lock(&mutex_);
+      status_ = status;
+    }
+    running_.store(false);
+    WakeParent();
+  }
+
   // Kicks the parent threads's condvar to indicate that this thread has
   // finished its work (successfully or otherwise).
   void WakeParent() {
@@ -169,19 +245,19 @@ class TestbenchThread {
   std::atomic<bool> cancelled_;
   std::atomic<bool> running_;
 
-  uint64 start_index_;
-  uint64 end_index_;
+  // Parent-owned; shared with the other threads.
+  TestbenchWorkQueue* work_queue_;
 
   // Bookkeeping data.
   uint64 max_failures_;
+  std::atomic<uint64> num_chunks_;
   std::atomic<uint64> num_passes_;
   std::atomic<uint64> num_failures_;
 
-  std::function<InputT(uint64)> index_to_input_;
-  std::function<ResultT(InputT)> generate_expected_;
-  std::function<ResultT(JitWrapperT*, absl::Span<uint8>, InputT)>
-      generate_actual_;
-  std::function<bool(ResultT, ResultT)> compare_results_;
+  IndexToInputT index_to_input_;
+  GenerateExpectedT generate_expected_;
+  GenerateActualT generate_actual_;
+  CompareResultsT compare_results_;
 
   std::string ir_text_;
   std::string entry_fn_;